@@ -154,6 +154,10 @@ std::map<std::string, GmxapiType> simulationParameterTypeMap()
         { "nstenergy", GmxapiType::INT64 },
         { "nstxout-compressed", GmxapiType::INT64 },
         { "compressed-x-precision", GmxapiType::FLOAT64 },
+        { "nstvout-compressed", GmxapiType::INT64 },
+        { "nstfout-compressed", GmxapiType::INT64 },
+        { "compressed-v-precision", GmxapiType::FLOAT64 },
+        { "compressed-f-precision", GmxapiType::FLOAT64 },
         { "cutoff-scheme", GmxapiType::STRING },
         { "nstlist", GmxapiType::INT64 },
         { "ns-type", GmxapiType::STRING },
@@ -198,6 +202,8 @@ std::map<std::string, int t_inputrec::*> int32Params()
         { "nstcalcenergy", &t_inputrec::nstcalcenergy },
         { "nstenergy", &t_inputrec::nstenergy },
         { "nstxout-compressed", &t_inputrec::nstxout_compressed },
+        { "nstvout-compressed", &t_inputrec::nstvout_compressed },
+        { "nstfout-compressed", &t_inputrec::nstfout_compressed },
         { "nstlist", &t_inputrec::nstlist },
         //            ...
     };
@@ -227,6 +233,8 @@ std::map<std::string, real t_inputrec::*> compatibleRealParams()
         { "fcstep", &t_inputrec::fc_stepsize },
         { "rtpi", &t_inputrec::rtpi },
         { "compressed-x-precision", &t_inputrec::x_compression_precision },
+        { "compressed-v-precision", &t_inputrec::v_compression_precision },
+        { "compressed-f-precision", &t_inputrec::f_compression_precision },
         //            ...
 
     };
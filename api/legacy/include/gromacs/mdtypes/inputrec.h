@@ -369,6 +369,10 @@ struct t_inputrec // NOLINT (clang-analyzer-optin.performance.Padding)
     int nstenergy = 0;
     //! Number of steps after which compressed trj (.xtc,.tng) is output
     int nstxout_compressed = 0;
+    //! Number of steps after which compressed V is output
+    int nstvout_compressed = 0;
+    //! Number of steps after which compressed F is output
+    int nstfout_compressed = 0;
     //! Initial time (ps)
     double init_t = 0;
     //! Time step (ps)
@@ -379,6 +383,10 @@ struct t_inputrec // NOLINT (clang-analyzer-optin.performance.Padding)
     std::vector<gmx::MtsLevel> mtsLevels;
     //! Precision of x in compressed trajectory file
     real x_compression_precision = 0;
+    //! Precision of v in compressed velocity and force file
+    real v_compression_precision = 0;
+    //! Precision of f in compressed velocity and force file
+    real f_compression_precision = 0;
     //! Requested fourier_spacing, when nk? not set
     real fourier_spacing = 0;
     //! Number of k vectors in x dimension for fourier methods for long range electrost.
@@ -46,6 +46,8 @@
 
 #include "config.h"
 
+#include <vector>
+
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -552,6 +554,51 @@ static void dd_cell_sizes_dlb_root_enforce_limits(gmx_domdec_t*      dd,
 }
 
 
+void computeLoadEqualizingCellSizes(gmx::ArrayRef<const real> cellFrac,
+                                    gmx::ArrayRef<const real> load,
+                                    gmx::ArrayRef<real>       targetSize)
+{
+    const int numCells = load.ssize();
+
+    /* Avoid a zero load density, as the cumulative load can then not be inverted */
+    constexpr real c_minRelativeLoad = 0.01;
+
+    real totalLoad = 0;
+    for (int i = 0; i < numCells; i++)
+    {
+        totalLoad += load[i];
+    }
+    const real minLoad = c_minRelativeLoad * std::max(totalLoad, GMX_REAL_MIN) / numCells;
+
+    std::vector<real> cellLoad(numCells);
+    totalLoad = 0;
+    for (int i = 0; i < numCells; i++)
+    {
+        cellLoad[i] = std::max(load[i], minLoad);
+        totalLoad += cellLoad[i];
+    }
+
+    /* Find the boundaries where the cumulative load reaches i/numCells of the total */
+    real boundaryLower  = cellFrac[0];
+    real cumulativeLoad = 0;
+    int  cell           = 0;
+    for (int i = 0; i < numCells - 1; i++)
+    {
+        const real loadAtBoundary = (i + 1) * totalLoad / numCells;
+        while (cell < numCells - 1 && cumulativeLoad + cellLoad[cell] < loadAtBoundary)
+        {
+            cumulativeLoad += cellLoad[cell];
+            cell++;
+        }
+        const real loadDensity = cellLoad[cell] / (cellFrac[cell + 1] - cellFrac[cell]);
+        const real boundary    = std::min(
+                cellFrac[cell] + (loadAtBoundary - cumulativeLoad) / loadDensity, cellFrac[cell + 1]);
+        targetSize[i] = boundary - boundaryLower;
+        boundaryLower = boundary;
+    }
+    targetSize[numCells - 1] = cellFrac[numCells] - boundaryLower;
+}
+
 static void set_dd_cell_sizes_dlb_root(gmx_domdec_t*      dd,
                                        int                d,
                                        int                dim,
@@ -563,7 +610,11 @@ static void set_dd_cell_sizes_dlb_root(gmx_domdec_t*      dd,
 {
     gmx_domdec_comm_t* comm    = dd->comm.get();
     constexpr real     c_relax = 0.5;
-    int                range[] = { 0, 0 };
+    /* The load-equalizing sizes are an estimate of the balanced sizes,
+     * so we only need a little underrelaxation to damp the timing noise.
+     */
+    constexpr real c_relaxLoadDensity = 0.8;
+    int            range[]            = { 0, 0 };
 
     /* Convert the maximum change from the input percentage to a fraction */
     const real change_limit = comm->ddSettings.dlb_scale_lim * 0.01;
@@ -588,33 +639,56 @@ static void set_dd_cell_sizes_dlb_root(gmx_domdec_t*      dd,
     }
     else if (dd_load_count(comm) > 0)
     {
-        real load_aver  = comm->load[d].sum_m / ncd;
+        /* The relative change of the cell sizes without relaxation */
+        std::vector<real> relativeChange(ncd);
+        if (comm->ddSettings.useLoadDensityForDlb)
+        {
+            std::vector<real> load(ncd);
+            for (int i = 0; i < ncd; i++)
+            {
+                load[i] = comm->load[d].load[i * comm->load[d].nload + 2];
+            }
+            computeLoadEqualizingCellSizes(
+                    gmx::constArrayRefFromArray(rowCoordinator->cellFrac.data(), ncd + 1), load, cell_size);
+            for (int i = 0; i < ncd; i++)
+            {
+                relativeChange[i] =
+                        cell_size[i] / (rowCoordinator->cellFrac[i + 1] - rowCoordinator->cellFrac[i]) - 1;
+            }
+        }
+        else
+        {
+            real load_aver = comm->load[d].sum_m / ncd;
+            for (int i = 0; i < ncd; i++)
+            {
+                /* Determine the relative imbalance of cell i */
+                const real load_i    = comm->load[d].load[i * comm->load[d].nload + 2];
+                const real imbalance = (load_i - load_aver) / (load_aver > 0 ? load_aver : 1);
+                relativeChange[i]    = -imbalance;
+            }
+        }
+        const real relax = comm->ddSettings.useLoadDensityForDlb ? c_relaxLoadDensity : c_relax;
+
         real change_max = 0;
         for (int i = 0; i < ncd; i++)
         {
-            /* Determine the relative imbalance of cell i */
-            const real load_i    = comm->load[d].load[i * comm->load[d].nload + 2];
-            const real imbalance = (load_i - load_aver) / (load_aver > 0 ? load_aver : 1);
             /* Determine the change of the cell size using underrelaxation */
-            const real change = -c_relax * imbalance;
+            const real change = relax * relativeChange[i];
             change_max        = std::max(change_max, std::max(change, -change));
         }
         /* Limit the amount of scaling.
          * We need to use the same rescaling for all cells in one row,
          * otherwise the load balancing might not converge.
          */
-        real sc = c_relax;
+        real sc = relax;
         if (change_max > change_limit)
         {
             sc *= change_limit / change_max;
         }
         for (int i = 0; i < ncd; i++)
         {
-            /* Determine the relative imbalance of cell i */
-            const real load_i    = comm->load[d].load[i * comm->load[d].nload + 2];
-            const real imbalance = (load_i - load_aver) / (load_aver > 0 ? load_aver : 1);
             /* Determine the change of the cell size using underrelaxation */
-            const real change = -sc * imbalance;
+            const real change = sc * relativeChange[i];
             cell_size[i] = (rowCoordinator->cellFrac[i + 1] - rowCoordinator->cellFrac[i]) * (1 + change);
         }
     }
@@ -76,6 +76,30 @@ real grid_jump_limit(const gmx_domdec_comm_t* comm, real cutoff, int dim_ind);
 gmx::ArrayRef<const std::vector<real>>
 set_dd_cell_sizes_slb(gmx_domdec_t* dd, const gmx_ddbox_t* ddbox, int setmode, ivec numPulses);
 
+/*! \brief Computes the cell sizes along a row that equalize the measured load
+ *
+ * The load of each cell is assumed to be distributed uniformly over
+ * the cell. The new boundaries are placed where the cumulative load
+ * reaches equal fractions of the total load. For strongly inhomogeneous
+ * systems, e.g. with vacuum or a dense slab, this gives a much larger
+ * change of boundaries over regions with little load than the linear
+ * response of the cell size to the imbalance.
+ *
+ * These are target sizes. Dynamic load balancing applies them with
+ * slight underrelaxation and limits the relative change of the cell
+ * sizes per step to GMX_DLB_MAX_BOX_SCALING, by default 50% with this
+ * scheme. The minimum cell size, the limit that a boundary moves at most
+ * halfway into a neighboring cell and, for staggered dimensions, the
+ * grid jump limit are still applied, as these are needed for correctness.
+ *
+ * \param[in]  cellFrac    The current cell boundaries, size numCells + 1
+ * \param[in]  load        The load of each cell
+ * \param[out] targetSize  The cell sizes that equalize the load
+ */
+void computeLoadEqualizingCellSizes(gmx::ArrayRef<const real> cellFrac,
+                                    gmx::ArrayRef<const real> load,
+                                    gmx::ArrayRef<real>       targetSize);
+
 /*! \brief General cell size adjustment, possibly applying dynamic load balancing */
 void set_dd_cell_sizes(gmx_domdec_t*      dd,
                        const gmx_ddbox_t* ddbox,
@@ -261,7 +261,7 @@ void dd_collect_vec(gmx_domdec_t*                  dd,
 }
 
 
-void dd_collect_state(gmx_domdec_t* dd, const t_state* state_local, t_state* state)
+void dd_collect_state_non_atom_entries(const gmx_domdec_t& dd, const t_state* state_local, t_state* state)
 {
     int nh = state_local->nhchainlength;
 
@@ -303,6 +303,12 @@ void dd_collect_state(gmx_domdec_t* dd, const t_state* state_local, t_state* sta
         state->baros_integral     = state_local->baros_integral;
         state->pull_com_prev_step = state_local->pull_com_prev_step;
     }
+}
+
+void dd_collect_state(gmx_domdec_t* dd, const t_state* state_local, t_state* state)
+{
+    dd_collect_state_non_atom_entries(*dd, state_local, state);
+
     if (state_local->hasEntry(StateEntry::X))
     {
         auto globalXRef = state ? state->x : gmx::ArrayRef<gmx::RVec>();
@@ -60,6 +60,12 @@ void dd_collect_vec(gmx_domdec_t*                  dd,
                     gmx::ArrayRef<const gmx::RVec> localVector,
                     gmx::ArrayRef<gmx::RVec>       globalVector);
 
+/*! \brief Copies the entries of \p localState that are not per atom to \p globalState on the main rank
+ *
+ * This is a local operation, \p globalState is only accessed on the main rank.
+ */
+void dd_collect_state_non_atom_entries(const gmx_domdec_t& dd, const t_state* localState, t_state* globalState);
+
 /*! \brief Gathers state \p localState to \p globalState on the main rank */
 void dd_collect_state(gmx_domdec_t* dd, const t_state* localState, t_state* globalState);
 
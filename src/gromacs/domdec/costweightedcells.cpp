@@ -0,0 +1,373 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief This file defines functions for setting the initial domain
+ * decomposition cell sizes based on the estimated computational cost.
+ *
+ * \ingroup module_domdec
+ */
+
+#include "gmxpre.h"
+
+#include "costweightedcells.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/math/functions.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxassert.h"
+
+#include "domdec_struct.h"
+#include "utility.h"
+
+/*! \brief The estimated costs of interactions in units of a non-bonded pair interaction
+ *
+ * These are rough estimates, they only need to be accurate enough to give
+ * a better starting point for the cell sizes than a uniform grid.
+ * \{
+ */
+//! The cost of a listed interaction, including restraints
+static constexpr real c_listedInteractionCost = 10;
+//! The cost of a constraint, we assume a few LINCS or SHAKE iterations
+static constexpr real c_constraintCost = 10;
+//! The cost of a virtual site construction and force spreading
+static constexpr real c_virtualSiteCost = 4;
+//! \}
+
+//! The maximum number of density grid cells along one dimension
+static constexpr int c_maxNumDensityGridCells = 100;
+
+//! The number of histogram bins per DD cell used for locating the cell boundaries
+static constexpr int c_numBinsPerCell = 100;
+
+//! Returns the estimated cost of an interaction of type \p ftype
+static real interactionCost(const int ftype)
+{
+    const unsigned int flags = interaction_function[ftype].flags;
+    if (ftype == F_SETTLE)
+    {
+        // A settle constrains three distances
+        return 3 * c_constraintCost;
+    }
+    else if (flags & IF_CONSTRAINT)
+    {
+        return c_constraintCost;
+    }
+    else if (flags & IF_VSITE)
+    {
+        return c_virtualSiteCost;
+    }
+    else if (flags & IF_BOND)
+    {
+        return c_listedInteractionCost;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+//! Adds the costs of the interactions in \p ilists, divided over their atoms, to \p atomCosts
+static void addInteractionCosts(const InteractionLists& ilists,
+                                const int               atomOffset,
+                                gmx::ArrayRef<real>     atomCosts)
+{
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        const real cost = interactionCost(ftype);
+        if (cost == 0)
+        {
+            continue;
+        }
+
+        const InteractionList& il          = ilists[ftype];
+        const int              nral        = NRAL(ftype);
+        const real             costPerAtom = cost / nral;
+        for (int i = 0; i < il.size(); i += 1 + nral)
+        {
+            for (int a = 0; a < nral; a++)
+            {
+                atomCosts[atomOffset + il.iatoms[i + 1 + a]] += costPerAtom;
+            }
+        }
+    }
+}
+
+std::vector<gmx::RVec> getDDFrameCoordinates(gmx::ArrayRef<const gmx::RVec> x,
+                                             const matrix                   box,
+                                             const gmx_ddbox_t&             ddbox,
+                                             const ivec                     numDomains)
+{
+    matrix triclinicCorrectionMatrix;
+    make_tric_corr_matrix(ddbox.npbcdim, box, triclinicCorrectionMatrix);
+
+    std::vector<gmx::RVec> ddCoordinates(x.size());
+    for (gmx::Index i = 0; i < x.ssize(); i++)
+    {
+        // As in the atom distribution, we go down in dimension, so that
+        // shifts over box vectors are applied before lower dimensions.
+        gmx::RVec position = x[i];
+        for (int d = DIM - 1; d >= 0; d--)
+        {
+            real pos_d = position[d];
+            if (d < ddbox.npbcdim)
+            {
+                if (ddbox.tric_dir[d] && numDomains[d] > 1)
+                {
+                    for (int j = d + 1; j < DIM; j++)
+                    {
+                        pos_d += position[j] * triclinicCorrectionMatrix[j][d];
+                    }
+                }
+                while (pos_d >= box[d][d])
+                {
+                    pos_d -= box[d][d];
+                    rvec_dec(position, box[d]);
+                }
+                while (pos_d < 0)
+                {
+                    pos_d += box[d][d];
+                    rvec_inc(position, box[d]);
+                }
+            }
+            else
+            {
+                pos_d = std::clamp(pos_d, ddbox.box0[d], ddbox.box0[d] + ddbox.box_size[d]);
+            }
+            ddCoordinates[i][d] = pos_d;
+        }
+    }
+
+    return ddCoordinates;
+}
+
+std::vector<real> estimateAtomCosts(const gmx_mtop_t&              mtop,
+                                    const gmx_ddbox_t&             ddbox,
+                                    const real                     pairlistCutoff,
+                                    gmx::ArrayRef<const gmx::RVec> ddCoordinates)
+{
+    GMX_RELEASE_ASSERT(ddCoordinates.ssize() == mtop.natoms,
+                       "We need coordinates for all atoms in the system");
+
+    std::vector<real> atomCosts(mtop.natoms, 0);
+
+    /* The non-bonded pair cost, estimated from the local atom density
+     * on a grid with cells of about the size of the pair-list cut-off.
+     */
+    ivec numGridCells;
+    real gridCellVolume = 1;
+    for (int d = 0; d < DIM; d++)
+    {
+        numGridCells[d] = std::clamp(static_cast<int>(ddbox.box_size[d] / pairlistCutoff),
+                                     1,
+                                     c_maxNumDensityGridCells);
+        gridCellVolume *= ddbox.box_size[d] / numGridCells[d];
+    }
+    std::vector<int> gridCellIndices(mtop.natoms);
+    std::vector<int> gridCellCounts(numGridCells[XX] * numGridCells[YY] * numGridCells[ZZ], 0);
+    for (int a = 0; a < mtop.natoms; a++)
+    {
+        ivec cell;
+        for (int d = 0; d < DIM; d++)
+        {
+            const real relativePosition = (ddCoordinates[a][d] - ddbox.box0[d]) / ddbox.box_size[d];
+            cell[d]                     = std::clamp(
+                    static_cast<int>(relativePosition * numGridCells[d]), 0, numGridCells[d] - 1);
+        }
+        gridCellIndices[a] = (cell[XX] * numGridCells[YY] + cell[YY]) * numGridCells[ZZ] + cell[ZZ];
+        gridCellCounts[gridCellIndices[a]]++;
+    }
+    // Each pair is shared by two atoms
+    const real pairsPerDensity = 0.5 * 4.0 / 3.0 * M_PI * gmx::power3(pairlistCutoff);
+    for (int a = 0; a < mtop.natoms; a++)
+    {
+        atomCosts[a] = pairsPerDensity * gridCellCounts[gridCellIndices[a]] / gridCellVolume;
+    }
+
+    /* The listed interactions, constraints and virtual sites */
+    std::vector<std::vector<real>> moleculeTypeCosts(mtop.moltype.size());
+    for (size_t mb = 0; mb < mtop.molblock.size(); mb++)
+    {
+        const gmx_molblock_t& molblock = mtop.molblock[mb];
+        const gmx_moltype_t&  moltype  = mtop.moltype[molblock.type];
+
+        std::vector<real>& moleculeCosts = moleculeTypeCosts[molblock.type];
+        if (moleculeCosts.empty())
+        {
+            moleculeCosts.resize(moltype.atoms.nr, 0);
+            addInteractionCosts(moltype.ilist, 0, moleculeCosts);
+        }
+
+        int atomOffset = mtop.moleculeBlockIndices[mb].globalAtomStart;
+        for (int mol = 0; mol < molblock.nmol; mol++)
+        {
+            for (int a = 0; a < moltype.atoms.nr; a++)
+            {
+                atomCosts[atomOffset + a] += moleculeCosts[a];
+            }
+            atomOffset += moltype.atoms.nr;
+        }
+    }
+    if (mtop.bIntermolecularInteractions)
+    {
+        GMX_RELEASE_ASSERT(mtop.intermolecular_ilist,
+                           "We should have an ilist when intermolecular interactions are on");
+        addInteractionCosts(*mtop.intermolecular_ilist, 0, atomCosts);
+    }
+
+    return atomCosts;
+}
+
+std::vector<real> cellFractionsEqualizingCost(gmx::ArrayRef<const real> positions,
+                                              gmx::ArrayRef<const real> costs,
+                                              const int                 numCells,
+                                              const real                lowerBound,
+                                              const real                size,
+                                              const real                minCellFraction)
+{
+    GMX_RELEASE_ASSERT(positions.size() == costs.size(), "Need one cost per position");
+    GMX_RELEASE_ASSERT(numCells >= 1, "Need at least one cell");
+    GMX_RELEASE_ASSERT(minCellFraction * numCells <= 1 + GMX_REAL_EPS,
+                       "The minimum cell fraction should not be larger than the uniform fraction");
+
+    const real uniformFraction = 1 / static_cast<real>(numCells);
+
+    /* Histogram the cost along the dimension */
+    const int           numBins = c_numBinsPerCell * numCells;
+    std::vector<double> binCosts(numBins, 0);
+    double              totalCost = 0;
+    for (gmx::Index i = 0; i < positions.ssize(); i++)
+    {
+        const int bin = std::clamp(
+                static_cast<int>((positions[i] - lowerBound) / size * numBins), 0, numBins - 1);
+        binCosts[bin] += costs[i];
+        totalCost += costs[i];
+    }
+
+    std::vector<real> fractions(numCells, uniformFraction);
+    if (numCells == 1 || totalCost <= 0)
+    {
+        return fractions;
+    }
+
+    /* Place the boundaries at equal cumulative cost, interpolating within bins */
+    std::vector<double> boundaries(numCells + 1);
+    boundaries[0]        = 0;
+    boundaries[numCells] = 1;
+    double costBelowBin  = 0;
+    int    bin           = 0;
+    for (int c = 1; c < numCells; c++)
+    {
+        const double targetCost = c * totalCost / numCells;
+        while (bin < numBins && costBelowBin + binCosts[bin] < targetCost)
+        {
+            costBelowBin += binCosts[bin];
+            bin++;
+        }
+        if (bin < numBins)
+        {
+            boundaries[c] = (bin + (targetCost - costBelowBin) / binCosts[bin]) / numBins;
+        }
+        else
+        {
+            boundaries[c] = 1;
+        }
+    }
+
+    /* Mix in the uniform grid as far as needed to obey the minimum fraction */
+    real uniformWeight = 0;
+    for (int c = 0; c < numCells; c++)
+    {
+        fractions[c] = boundaries[c + 1] - boundaries[c];
+        if (fractions[c] < minCellFraction)
+        {
+            const real weight = (minCellFraction - fractions[c]) / (uniformFraction - fractions[c]);
+            uniformWeight     = std::max(uniformWeight, weight);
+        }
+    }
+    uniformWeight = std::min<real>(uniformWeight, 1);
+    for (real& fraction : fractions)
+    {
+        fraction = (1 - uniformWeight) * fraction + uniformWeight * uniformFraction;
+    }
+
+    return fractions;
+}
+
+std::array<std::vector<real>, DIM> getCostWeightedCellFractions(const gmx_mtop_t& mtop,
+                                                                gmx::ArrayRef<const gmx::RVec> x,
+                                                                const matrix       box,
+                                                                const gmx_ddbox_t& ddbox,
+                                                                const ivec         numDomains,
+                                                                const real         pairlistCutoff,
+                                                                const real         cellSizeLimit)
+{
+    const std::vector<gmx::RVec> ddCoordinates = getDDFrameCoordinates(x, box, ddbox, numDomains);
+    const std::vector<real>      atomCosts =
+            estimateAtomCosts(mtop, ddbox, pairlistCutoff, ddCoordinates);
+
+    std::array<std::vector<real>, DIM> cellFractions;
+    std::vector<real>                  positions(ddCoordinates.size());
+    for (int d = 0; d < DIM; d++)
+    {
+        const int numCells = numDomains[d];
+        if (numCells == 1)
+        {
+            continue;
+        }
+
+        for (size_t a = 0; a < ddCoordinates.size(); a++)
+        {
+            positions[a] = ddCoordinates[a][d];
+        }
+        /* Cells should not be smaller than the limit, unless the uniform
+         * cells are smaller, and never smaller than half the uniform size.
+         */
+        const real uniformFraction = 1 / static_cast<real>(numCells);
+        const real minCellFraction = std::clamp(cellSizeLimit / (ddbox.box_size[d] * ddbox.skew_fac[d]),
+                                                uniformFraction / 2,
+                                                uniformFraction);
+        cellFractions[d] = cellFractionsEqualizingCost(
+                positions, atomCosts, numCells, ddbox.box0[d], ddbox.box_size[d], minCellFraction);
+    }
+
+    return cellFractions;
+}
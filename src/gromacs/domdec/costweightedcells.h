@@ -0,0 +1,124 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief This file declares functions for setting the initial domain
+ * decomposition cell sizes based on the estimated computational cost.
+ *
+ * \ingroup module_domdec
+ */
+
+#ifndef GMX_DOMDEC_COSTWEIGHTEDCELLS_H
+#define GMX_DOMDEC_COSTWEIGHTEDCELLS_H
+
+#include <array>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+struct gmx_ddbox_t;
+struct gmx_mtop_t;
+
+namespace gmx
+{
+template<typename>
+class ArrayRef;
+}
+
+/*! \brief Returns the estimated computational cost of each atom
+ *
+ * The cost is given in units of the cost of one non-bonded pair
+ * interaction. It includes the non-bonded pairs within \p pairlistCutoff,
+ * estimated from the local atom density on a grid, the listed
+ * interactions including restraints, the constraints and the virtual
+ * sites. The costs of interactions are divided equally over their atoms.
+ *
+ * \param[in] mtop            The system topology
+ * \param[in] ddbox           The DD box
+ * \param[in] pairlistCutoff  The pair-list cut-off
+ * \param[in] ddCoordinates   The coordinates in the DD frame, see getDDFrameCoordinates()
+ */
+std::vector<real> estimateAtomCosts(const gmx_mtop_t&              mtop,
+                                    const gmx_ddbox_t&             ddbox,
+                                    real                           pairlistCutoff,
+                                    gmx::ArrayRef<const gmx::RVec> ddCoordinates);
+
+/*! \brief Returns the coordinates in the frame used for assigning atoms to DD cells
+ *
+ * For triclinic dimensions with more than one cell, the coordinates are
+ * lattice coordinates. Along dimensions with PBC, the coordinates are put
+ * in the unit cell, along other dimensions they are limited to the DD box.
+ */
+std::vector<gmx::RVec> getDDFrameCoordinates(gmx::ArrayRef<const gmx::RVec> x,
+                                             const matrix                   box,
+                                             const gmx_ddbox_t&             ddbox,
+                                             const ivec                     numDomains);
+
+/*! \brief Returns cell size fractions along one dimension that equalize the cost per cell
+ *
+ * \param[in] positions        The position of each atom along the dimension
+ * \param[in] costs            The cost of each atom
+ * \param[in] numCells         The number of cells
+ * \param[in] lowerBound       The lower bound of the positions
+ * \param[in] size             The size of the range of positions
+ * \param[in] minCellFraction  The minimum fraction for a cell, should be <= 1/numCells
+ * \returns The fraction of \p size for each cell, the fractions add up to 1
+ */
+std::vector<real> cellFractionsEqualizingCost(gmx::ArrayRef<const real> positions,
+                                              gmx::ArrayRef<const real> costs,
+                                              int                       numCells,
+                                              real                      lowerBound,
+                                              real                      size,
+                                              real                      minCellFraction);
+
+/*! \brief Returns for each dimension the cell size fractions that equalize the estimated cost
+ *
+ * Dimensions with a single cell get an empty list. The fractions are
+ * limited such that cells are not smaller than the cut-off \p cellSizeLimit
+ * or half the uniform cell size, whichever is larger, so that the number
+ * of communication pulses does not increase. When the uniform cells are
+ * smaller than \p cellSizeLimit, the uniform size is the limit.
+ *
+ * Should only be called on the main rank, which has the global coordinates \p x.
+ */
+std::array<std::vector<real>, DIM> getCostWeightedCellFractions(const gmx_mtop_t& mtop,
+                                                                gmx::ArrayRef<const gmx::RVec> x,
+                                                                const matrix       box,
+                                                                const gmx_ddbox_t& ddbox,
+                                                                const ivec         numDomains,
+                                                                real               pairlistCutoff,
+                                                                real               cellSizeLimit);
+
+#endif
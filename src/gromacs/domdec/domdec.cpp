@@ -57,6 +57,7 @@
 #include "gromacs/domdec/domdec_network.h"
 #include "gromacs/domdec/ga2la.h"
 #include "gromacs/domdec/gpuhaloexchange.h"
+#include "gromacs/domdec/halocoordinatecodec.h"
 #include "gromacs/domdec/localtopologychecker.h"
 #include "gromacs/domdec/options.h"
 #include "gromacs/domdec/partition.h"
@@ -112,6 +113,7 @@
 #include "atomdistribution.h"
 #include "box.h"
 #include "cellsizes.h"
+#include "costweightedcells.h"
 #include "distribute.h"
 #include "domdec_constraints.h"
 #include "domdec_internal.h"
@@ -260,133 +262,390 @@ void dd_get_constraint_range(const gmx_domdec_t& dd, int* at_start, int* at_end)
     *at_end   = dd.comm->atomRanges.end(DDAtomRanges::Type::Constraints);
 }
 
-void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+/*! \brief Packs the coordinates to send for pulse \p ind along DD dimension index \p d
+ *
+ * Applies the periodic shift, and the rotation for screw PBC, when
+ * the coordinates are sent over a periodic boundary.
+ */
+static void packHaloCoordinates(const gmx_domdec_t&            dd,
+                                int                            d,
+                                const gmx_domdec_ind_t&        ind,
+                                const matrix                   box,
+                                gmx::ArrayRef<const gmx::RVec> x,
+                                gmx::ArrayRef<gmx::RVec>       sendBuffer)
 {
-    wallcycle_start(wcycle, WallCycleCounter::MoveX);
+    const bool bPBC   = (dd.ci[dd.dim[d]] == 0);
+    const bool bScrew = (bPBC && dd.unitCellInfo.haveScrewPBC && dd.dim[d] == XX);
 
     rvec shift = { 0, 0, 0 };
+    if (bPBC)
+    {
+        copy_rvec(box[dd.dim[d]], shift);
+    }
+
+    int n = 0;
+    if (!bPBC)
+    {
+        for (int j : ind.index)
+        {
+            sendBuffer[n] = x[j];
+            n++;
+        }
+    }
+    else if (!bScrew)
+    {
+        for (int j : ind.index)
+        {
+            /* We need to shift the coordinates */
+            for (int d = 0; d < DIM; d++)
+            {
+                sendBuffer[n][d] = x[j][d] + shift[d];
+            }
+            n++;
+        }
+    }
+    else
+    {
+        for (int j : ind.index)
+        {
+            /* Shift x */
+            sendBuffer[n][XX] = x[j][XX] + shift[XX];
+            /* Rotate y and z.
+             * This operation requires a special shift force
+             * treatment, which is performed in calc_vir.
+             */
+            sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
+            sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
+            n++;
+        }
+    }
+}
 
+//! Copies the received coordinates for pulse \p ind to \p x, used when not receiving in place
+static void unpackHaloCoordinates(const gmx_domdec_ind_t&        ind,
+                                  int                            nzone,
+                                  gmx::ArrayRef<const gmx::RVec> receiveBuffer,
+                                  gmx::ArrayRef<gmx::RVec>       x)
+{
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            x[i] = receiveBuffer[j++];
+        }
+    }
+}
+
+/*! \brief Sends the packed halo coordinates in \p sendBuffer and receives into \p receiveBuffer
+ *
+ * With reduced-precision halo coordinates, the coordinates are encoded
+ * before sending and decoded after receiving.
+ */
+static void sendReceiveHaloCoordinates(gmx_domdec_t*            dd,
+                                       int                      d,
+                                       gmx::ArrayRef<gmx::RVec> sendBuffer,
+                                       gmx::ArrayRef<gmx::RVec> receiveBuffer)
+{
+    gmx_domdec_comm_t* comm = dd->comm.get();
+
+    if (comm->haloCoordinateCodec)
+    {
+        const gmx::HaloCoordinateCodec& codec = *comm->haloCoordinateCodec;
+
+        DDBufferAccess<uint8_t> sendAccess(comm->encodedSendBuffer,
+                                           codec.encodedSize(sendBuffer.ssize()));
+        DDBufferAccess<uint8_t> receiveAccess(comm->encodedReceiveBuffer,
+                                              codec.encodedSize(receiveBuffer.ssize()));
+
+        codec.encode(sendBuffer, sendAccess.buffer);
+        ddSendrecv(dd, d, dddirBackward, sendAccess.buffer, receiveAccess.buffer);
+        codec.decode(receiveAccess.buffer, receiveBuffer);
+    }
+    else
+    {
+        ddSendrecv(dd, d, dddirBackward, sendBuffer, receiveBuffer);
+    }
+}
+
+/*! \brief Communicates the halo coordinates for all pulses along all dimensions
+ *
+ * When \p firstPulseIsDone is true, the first pulse along the first
+ * dimension has already been communicated by dd_move_x_begin/finish.
+ */
+static void moveHaloCoordinates(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, bool firstPulseIsDone)
+{
     gmx_domdec_comm_t* comm = dd->comm.get();
 
     int nzone   = 1;
     int nat_tot = comm->atomRanges.numHomeAtoms();
     for (int d = 0; d < dd->ndim; d++)
     {
-        const bool bPBC   = (dd->ci[dd->dim[d]] == 0);
-        const bool bScrew = (bPBC && dd->unitCellInfo.haveScrewPBC && dd->dim[d] == XX);
-        if (bPBC)
-        {
-            copy_rvec(box[dd->dim[d]], shift);
-        }
         gmx_domdec_comm_dim_t* cd = &comm->cd[d];
-        for (const gmx_domdec_ind_t& ind : cd->ind)
+        for (int p = 0; p < cd->numPulses(); p++)
         {
-            DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
-            int                       n          = 0;
-            if (!bPBC)
+            const gmx_domdec_ind_t& ind = cd->ind[p];
+
+            if (!(firstPulseIsDone && d == 0 && p == 0))
             {
-                for (int j : ind.index)
+                DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
+                gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
+                packHaloCoordinates(*dd, d, ind, box, x, sendBuffer);
+
+                DDBufferAccess<gmx::RVec> receiveBufferAccess(
+                        comm->rvecBuffer2, cd->receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
+
+                gmx::ArrayRef<gmx::RVec> receiveBuffer;
+                if (cd->receiveInPlace)
                 {
-                    sendBuffer[n] = x[j];
-                    n++;
+                    receiveBuffer = gmx::arrayRefFromArray(x.data() + nat_tot, ind.nrecv[nzone + 1]);
                 }
-            }
-            else if (!bScrew)
-            {
-                for (int j : ind.index)
+                else
                 {
-                    /* We need to shift the coordinates */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        sendBuffer[n][d] = x[j][d] + shift[d];
-                    }
-                    n++;
+                    receiveBuffer = receiveBufferAccess.buffer;
                 }
-            }
-            else
-            {
-                for (int j : ind.index)
+                /* Send and receive the coordinates */
+                sendReceiveHaloCoordinates(dd, d, sendBuffer, receiveBuffer);
+
+                if (!cd->receiveInPlace)
                 {
-                    /* Shift x */
-                    sendBuffer[n][XX] = x[j][XX] + shift[XX];
-                    /* Rotate y and z.
-                     * This operation requires a special shift force
-                     * treatment, which is performed in calc_vir.
-                     */
-                    sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
-                    sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
-                    n++;
+                    unpackHaloCoordinates(ind, nzone, receiveBuffer, x);
                 }
             }
+            nat_tot += ind.nrecv[nzone + 1];
+        }
+        nzone += nzone;
+    }
+}
+
+void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveX);
+
+    moveHaloCoordinates(dd, box, x, false);
+
+    wallcycle_stop(wcycle, WallCycleCounter::MoveX);
+}
+
+void dd_move_x_begin(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveX);
+
+    gmx_domdec_comm_t*   comm    = dd->comm.get();
+    HaloExchangeOverlap& overlap = comm->xHaloOverlap;
+    GMX_ASSERT(!overlap.isActive, "dd_move_x_begin should be followed by dd_move_x_finish");
+
+    if (dd->ndim > 0)
+    {
+        /* The first pulse only sends home atoms, so it does not depend on other pulses */
+        const gmx_domdec_comm_dim_t& cd    = comm->cd[0];
+        const gmx_domdec_ind_t&      ind   = cd.ind[0];
+        const int                    nzone = 1;
+
+        overlap.sendBuffer.resize(ind.nsend[nzone + 1]);
+        packHaloCoordinates(*dd, 0, ind, box, x, overlap.sendBuffer);
+
+        gmx::ArrayRef<gmx::RVec> receiveBuffer;
+        if (cd.receiveInPlace)
+        {
+            receiveBuffer = gmx::arrayRefFromArray(x.data() + comm->atomRanges.numHomeAtoms(),
+                                                   ind.nrecv[nzone + 1]);
+        }
+        else
+        {
+            overlap.receiveBuffer.resize(ind.nrecv[nzone + 1]);
+            receiveBuffer = overlap.receiveBuffer;
+        }
+        if (comm->haloCoordinateCodec)
+        {
+            /* Decoding into receiveBuffer happens in dd_move_x_finish */
+            const gmx::HaloCoordinateCodec& codec = *comm->haloCoordinateCodec;
+            overlap.encodedSendBuffer.resize(codec.encodedSize(overlap.sendBuffer.size()));
+            codec.encode(overlap.sendBuffer, overlap.encodedSendBuffer);
+            overlap.encodedReceiveBuffer.resize(codec.encodedSize(receiveBuffer.ssize()));
+            overlap.numRequests = ddIsendrecv<uint8_t>(dd,
+                                                       0,
+                                                       dddirBackward,
+                                                       overlap.encodedSendBuffer,
+                                                       overlap.encodedReceiveBuffer,
+                                                       overlap.requests.data());
+        }
+        else
+        {
+            overlap.numRequests = ddIsendrecv<gmx::RVec>(dd,
+                                                         0,
+                                                         dddirBackward,
+                                                         overlap.sendBuffer,
+                                                         receiveBuffer,
+                                                         overlap.requests.data());
+        }
+        overlap.isActive = true;
+    }
 
-            DDBufferAccess<gmx::RVec> receiveBufferAccess(
-                    comm->rvecBuffer2, cd->receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
+    wallcycle_stop(wcycle, WallCycleCounter::MoveX);
+}
+
+void dd_move_x_finish(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveX);
 
+    gmx_domdec_comm_t*   comm    = dd->comm.get();
+    HaloExchangeOverlap& overlap = comm->xHaloOverlap;
+
+    if (dd->ndim > 0)
+    {
+        GMX_ASSERT(overlap.isActive, "dd_move_x_finish should be preceded by dd_move_x_begin");
+
+        ddWaitRequests(overlap.numRequests, overlap.requests.data());
+        const gmx_domdec_ind_t& ind   = comm->cd[0].ind[0];
+        const int               nzone = 1;
+        if (comm->haloCoordinateCodec)
+        {
             gmx::ArrayRef<gmx::RVec> receiveBuffer;
-            if (cd->receiveInPlace)
+            if (comm->cd[0].receiveInPlace)
             {
-                receiveBuffer = gmx::arrayRefFromArray(x.data() + nat_tot, ind.nrecv[nzone + 1]);
+                receiveBuffer = gmx::arrayRefFromArray(
+                        x.data() + comm->atomRanges.numHomeAtoms(), ind.nrecv[nzone + 1]);
             }
             else
             {
-                receiveBuffer = receiveBufferAccess.buffer;
+                receiveBuffer = overlap.receiveBuffer;
             }
-            /* Send and receive the coordinates */
-            ddSendrecv(dd, d, dddirBackward, sendBuffer, receiveBuffer);
-
-            if (!cd->receiveInPlace)
-            {
-                int j = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        x[i] = receiveBuffer[j++];
-                    }
-                }
-            }
-            nat_tot += ind.nrecv[nzone + 1];
+            comm->haloCoordinateCodec->decode(overlap.encodedReceiveBuffer, receiveBuffer);
         }
-        nzone += nzone;
+        if (!comm->cd[0].receiveInPlace)
+        {
+            unpackHaloCoordinates(ind, nzone, overlap.receiveBuffer, x);
+        }
+        overlap.isActive = false;
     }
 
+    moveHaloCoordinates(dd, box, x, true);
+
     wallcycle_stop(wcycle, WallCycleCounter::MoveX);
 }
 
-void dd_move_f(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+//! Copies the forces on the halo atoms of pulse \p ind to \p sendBuffer, used when not receiving in place
+static void packHaloForces(const gmx_domdec_ind_t&        ind,
+                           int                            nzone,
+                           gmx::ArrayRef<const gmx::RVec> f,
+                           gmx::ArrayRef<gmx::RVec>       sendBuffer)
 {
-    wallcycle_start(wcycle, WallCycleCounter::MoveF);
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            sendBuffer[j++] = f[i];
+        }
+    }
+}
 
+/*! \brief Adds the forces received for pulse \p ind along DD dimension index \p d to \p f
+ *
+ * Also updates the shift forces, when the forces were sent over
+ * a periodic boundary and the virial is computed.
+ */
+static void addReceivedHaloForces(const gmx_domdec_t&            dd,
+                                  int                            d,
+                                  const gmx_domdec_ind_t&        ind,
+                                  gmx::ArrayRef<const gmx::RVec> receiveBuffer,
+                                  gmx::ForceWithShiftForces*     forceWithShiftForces)
+{
     gmx::ArrayRef<gmx::RVec> f      = forceWithShiftForces->force();
     gmx::ArrayRef<gmx::RVec> fshift = forceWithShiftForces->shiftForces();
 
+    /* Only forces in domains near the PBC boundaries need to
+       consider PBC in the treatment of fshift */
+    const bool shiftForcesNeedPbc =
+            (forceWithShiftForces->computeVirial() && dd.ci[dd.dim[d]] == 0);
+    const bool applyScrewPbc =
+            (shiftForcesNeedPbc && dd.unitCellInfo.haveScrewPBC && dd.dim[d] == XX);
+    /* Determine which shift vector we need */
+    ivec vis       = { 0, 0, 0 };
+    vis[dd.dim[d]] = 1;
+    const int is   = gmx::ivecToShiftIndex(vis);
+
+    int n = 0;
+    if (!shiftForcesNeedPbc)
+    {
+        for (int j : ind.index)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                f[j][d] += receiveBuffer[n][d];
+            }
+            n++;
+        }
+    }
+    else if (!applyScrewPbc)
+    {
+        for (int j : ind.index)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                f[j][d] += receiveBuffer[n][d];
+            }
+            /* Add this force to the shift force */
+            for (int d = 0; d < DIM; d++)
+            {
+                fshift[is][d] += receiveBuffer[n][d];
+            }
+            n++;
+        }
+    }
+    else
+    {
+        for (int j : ind.index)
+        {
+            /* Rotate the force */
+            f[j][XX] += receiveBuffer[n][XX];
+            f[j][YY] -= receiveBuffer[n][YY];
+            f[j][ZZ] -= receiveBuffer[n][ZZ];
+            if (shiftForcesNeedPbc)
+            {
+                /* Add this force to the shift force */
+                for (int d = 0; d < DIM; d++)
+                {
+                    fshift[is][d] += receiveBuffer[n][d];
+                }
+            }
+            n++;
+        }
+    }
+}
+
+/*! \brief Communicates and sums the halo forces for all pulses along all dimensions
+ *
+ * When \p firstPulseIsDone is true, the last pulse along the last
+ * dimension, which is communicated first, has already been done
+ * by dd_move_f_begin/finish.
+ */
+static void moveHaloForces(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, bool firstPulseIsDone)
+{
+    gmx::ArrayRef<gmx::RVec> f = forceWithShiftForces->force();
+
     gmx_domdec_comm_t& comm    = *dd->comm;
     int                nzone   = comm.zones.n / 2;
     int                nat_tot = comm.atomRanges.end(DDAtomRanges::Type::Zones);
     for (int d = dd->ndim - 1; d >= 0; d--)
     {
-        /* Only forces in domains near the PBC boundaries need to
-           consider PBC in the treatment of fshift */
-        const bool shiftForcesNeedPbc =
-                (forceWithShiftForces->computeVirial() && dd->ci[dd->dim[d]] == 0);
-        const bool applyScrewPbc =
-                (shiftForcesNeedPbc && dd->unitCellInfo.haveScrewPBC && dd->dim[d] == XX);
-        /* Determine which shift vector we need */
-        ivec vis        = { 0, 0, 0 };
-        vis[dd->dim[d]] = 1;
-        const int is    = gmx::ivecToShiftIndex(vis);
-
         /* Loop over the pulses */
         const gmx_domdec_comm_dim_t& cd = comm.cd[d];
         for (int p = cd.numPulses() - 1; p >= 0; p--)
         {
-            const gmx_domdec_ind_t&   ind = cd.ind[p];
-            DDBufferAccess<gmx::RVec> receiveBufferAccess(comm.rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>& receiveBuffer = receiveBufferAccess.buffer;
+            const gmx_domdec_ind_t& ind = cd.ind[p];
 
             nat_tot -= ind.nrecv[nzone + 1];
 
+            if (firstPulseIsDone && d == dd->ndim - 1 && p == cd.numPulses() - 1)
+            {
+                continue;
+            }
+
+            DDBufferAccess<gmx::RVec> receiveBufferAccess(comm.rvecBuffer, ind.nsend[nzone + 1]);
+            gmx::ArrayRef<gmx::RVec>& receiveBuffer = receiveBufferAccess.buffer;
+
             DDBufferAccess<gmx::RVec> sendBufferAccess(
                     comm.rvecBuffer2, cd.receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
 
@@ -398,68 +657,86 @@ void dd_move_f(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces
             else
             {
                 sendBuffer = sendBufferAccess.buffer;
-                int j      = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        sendBuffer[j++] = f[i];
-                    }
-                }
+                packHaloForces(ind, nzone, f, sendBuffer);
             }
             /* Communicate the forces */
             ddSendrecv(dd, d, dddirForward, sendBuffer, receiveBuffer);
             /* Add the received forces */
-            int n = 0;
-            if (!shiftForcesNeedPbc)
-            {
-                for (int j : ind.index)
-                {
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        f[j][d] += receiveBuffer[n][d];
-                    }
-                    n++;
-                }
-            }
-            else if (!applyScrewPbc)
-            {
-                for (int j : ind.index)
-                {
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        f[j][d] += receiveBuffer[n][d];
-                    }
-                    /* Add this force to the shift force */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        fshift[is][d] += receiveBuffer[n][d];
-                    }
-                    n++;
-                }
-            }
-            else
-            {
-                for (int j : ind.index)
-                {
-                    /* Rotate the force */
-                    f[j][XX] += receiveBuffer[n][XX];
-                    f[j][YY] -= receiveBuffer[n][YY];
-                    f[j][ZZ] -= receiveBuffer[n][ZZ];
-                    if (shiftForcesNeedPbc)
-                    {
-                        /* Add this force to the shift force */
-                        for (int d = 0; d < DIM; d++)
-                        {
-                            fshift[is][d] += receiveBuffer[n][d];
-                        }
-                    }
-                    n++;
-                }
-            }
+            addReceivedHaloForces(*dd, d, ind, receiveBuffer, forceWithShiftForces);
         }
         nzone /= 2;
     }
+}
+
+void dd_move_f(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveF);
+
+    moveHaloForces(dd, forceWithShiftForces, false);
+
+    wallcycle_stop(wcycle, WallCycleCounter::MoveF);
+}
+
+void dd_move_f_begin(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveF);
+
+    gmx_domdec_comm_t&   comm    = *dd->comm;
+    HaloExchangeOverlap& overlap = comm.fHaloOverlap;
+    GMX_ASSERT(!overlap.isActive, "dd_move_f_begin should be followed by dd_move_f_finish");
+
+    if (dd->ndim > 0)
+    {
+        /* The last pulse along the last dimension is communicated first
+         * and only sends forces computed locally, so it can be started
+         * while other forces on home atoms are still being computed.
+         */
+        gmx::ArrayRef<gmx::RVec>     f     = forceWithShiftForces->force();
+        const int                    d     = dd->ndim - 1;
+        const gmx_domdec_comm_dim_t& cd    = comm.cd[d];
+        const gmx_domdec_ind_t&      ind   = cd.ind[cd.numPulses() - 1];
+        const int                    nzone = comm.zones.n / 2;
+
+        const int numAtomsToSend = ind.nrecv[nzone + 1];
+        if (cd.receiveInPlace)
+        {
+            const int atomStart = comm.atomRanges.end(DDAtomRanges::Type::Zones) - numAtomsToSend;
+            overlap.sendBuffer.assign(f.begin() + atomStart, f.begin() + atomStart + numAtomsToSend);
+        }
+        else
+        {
+            overlap.sendBuffer.resize(numAtomsToSend);
+            packHaloForces(ind, nzone, f, overlap.sendBuffer);
+        }
+        overlap.receiveBuffer.resize(ind.nsend[nzone + 1]);
+        overlap.numRequests = ddIsendrecv<gmx::RVec>(
+                dd, d, dddirForward, overlap.sendBuffer, overlap.receiveBuffer, overlap.requests.data());
+        overlap.isActive = true;
+    }
+
+    wallcycle_stop(wcycle, WallCycleCounter::MoveF);
+}
+
+void dd_move_f_finish(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::MoveF);
+
+    gmx_domdec_comm_t&   comm    = *dd->comm;
+    HaloExchangeOverlap& overlap = comm.fHaloOverlap;
+
+    if (dd->ndim > 0)
+    {
+        GMX_ASSERT(overlap.isActive, "dd_move_f_finish should be preceded by dd_move_f_begin");
+
+        ddWaitRequests(overlap.numRequests, overlap.requests.data());
+        const int                    d  = dd->ndim - 1;
+        const gmx_domdec_comm_dim_t& cd = comm.cd[d];
+        addReceivedHaloForces(*dd, d, cd.ind[cd.numPulses() - 1], overlap.receiveBuffer, forceWithShiftForces);
+        overlap.isActive = false;
+    }
+
+    moveHaloForces(dd, forceWithShiftForces, true);
+
     wallcycle_stop(wcycle, WallCycleCounter::MoveF);
 }
 
@@ -865,6 +1142,11 @@ bool ddUsesUpdateGroups(const gmx_domdec_t& dd)
     return dd.comm->systemInfo.useUpdateGroups;
 }
 
+bool ddUsesCpuHaloOverlap(const gmx_domdec_t& dd)
+{
+    return dd.comm->ddSettings.useCpuHaloOverlap;
+}
+
 void dd_cycles_add(const gmx_domdec_t* dd, float cycles, int ddCycl)
 {
     /* Note that the cycles value can be incorrect, either 0 or some
@@ -2246,17 +2528,18 @@ static DDRankSetup getDDRankSetup(const gmx::MDLogger& mdlog,
 }
 
 /*! \brief Set the cell size and interaction limits */
-static void set_dd_limits(const gmx::MDLogger& mdlog,
-                          DDRole               ddRole,
-                          gmx_domdec_t*        dd,
-                          const DomdecOptions& options,
-                          const DDSettings&    ddSettings,
-                          const DDSystemInfo&  systemInfo,
-                          const DDGridSetup&   ddGridSetup,
-                          const int            numPPRanks,
-                          const gmx_mtop_t&    mtop,
-                          const t_inputrec&    ir,
-                          const gmx_ddbox_t&   ddbox)
+static void set_dd_limits(const gmx::MDLogger&              mdlog,
+                          DDRole                            ddRole,
+                          gmx_domdec_t*                     dd,
+                          const DomdecOptions&              options,
+                          const DDSettings&                 ddSettings,
+                          const DDSystemInfo&               systemInfo,
+                          const DDGridSetup&                ddGridSetup,
+                          const int                         numPPRanks,
+                          const gmx_mtop_t&                 mtop,
+                          const t_inputrec&                 ir,
+                          const gmx_ddbox_t&                ddbox,
+                          ArrayRef<const std::vector<real>> costWeightedCellFractions)
 {
     gmx_domdec_comm_t* comm = dd->comm.get();
     comm->ddSettings        = ddSettings;
@@ -2303,6 +2586,26 @@ static void set_dd_limits(const gmx::MDLogger& mdlog,
         comm->slb_frac[ZZ] = get_slb_frac(mdlog, "z", dd->numCells[ZZ], options.cellSizeZ);
     }
 
+    if (!isDlbOn(comm->dlbState))
+    {
+        /* Use the cost-weighted cell sizes along dimensions without user supplied sizes */
+        for (int d = 0; d < DIM; d++)
+        {
+            if (comm->slb_frac[d].empty() && !costWeightedCellFractions[d].empty())
+            {
+                comm->slb_frac[d] = costWeightedCellFractions[d];
+
+                std::string relativeCellSizes = gmx::formatString(
+                        "Relative cell sizes from the estimated cost along %c:", dim2char(d));
+                for (const real fraction : comm->slb_frac[d])
+                {
+                    relativeCellSizes += gmx::formatString(" %5.3f", fraction);
+                }
+                GMX_LOG(mdlog.info).appendText(relativeCellSizes);
+            }
+        }
+    }
+
     /* Set the multi-body cut-off and cellsize limit for DLB */
     comm->cutoff_mbody   = systemInfo.minCutoffForMultiBody;
     comm->cellsize_limit = systemInfo.cellsizeLimit;
@@ -2691,6 +2994,71 @@ static void set_ddgrid_parameters(const gmx::MDLogger& mdlog,
     dd->ga2la = std::make_unique<gmx_ga2la_t>(natoms_tot, static_cast<int>(vol_frac * natoms_tot));
 }
 
+/*! \brief Returns the maximum error for reduced-precision halo coordinates
+ *
+ * The error is chosen negligible compared to the pair-list buffer.
+ * Returns 0 when there is no buffer, the coordinates are then sent in full
+ * precision. The number of bits is chosen at each partitioning, as it
+ * depends on the box and the number of pulses.
+ */
+static real getHaloCoordinateMaxError(const gmx::MDLogger& mdlog, const t_inputrec& ir)
+{
+    /* The maximum quantization error relative to the pair-list buffer */
+    constexpr real c_maxErrorRelativeToBuffer = 1e-3;
+
+    const real pairlistBuffer = ir.rlist - std::max(ir.rvdw, ir.rcoulomb);
+    if (pairlistBuffer <= 0)
+    {
+        GMX_LOG(mdlog.info)
+                .appendText(
+                        "NOTE: Not using reduced-precision halo coordinates, as the pair list "
+                        "has no buffer");
+        return 0;
+    }
+
+    return c_maxErrorRelativeToBuffer * pairlistBuffer;
+}
+
+/*! \brief Returns the initial cell size fractions that equalize the cost estimated on the main rank
+ *
+ * The cells are not made smaller than the cut-off or than the cell size
+ * limit with a margin, so DLB can still be turned on later.
+ */
+static std::array<std::vector<real>, DIM>
+determineCostWeightedCellFractions(DDRole                         ddRole,
+                                   MPI_Comm                       communicator,
+                                   const gmx_mtop_t&              mtop,
+                                   const t_inputrec&              ir,
+                                   const matrix                   box,
+                                   gmx::ArrayRef<const gmx::RVec> xGlobal,
+                                   const gmx_ddbox_t&             ddbox,
+                                   const DDGridSetup&             ddGridSetup,
+                                   const DDSystemInfo&            systemInfo)
+{
+    /* Turning on DLB requires a margin of 5% above the cell size limit,
+     * which is at least the cut-off when a single pulse is used.
+     */
+    const real cellSizeLimit = 1.05_real * std::max(systemInfo.cutoff, systemInfo.cellsizeLimit);
+
+    std::array<std::vector<real>, DIM> cellFractions;
+    if (ddRole == DDRole::Main)
+    {
+        cellFractions = getCostWeightedCellFractions(
+                mtop, xGlobal, box, ddbox, ddGridSetup.numDomains, ir.rlist, cellSizeLimit);
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        if (ddGridSetup.numDomains[d] > 1)
+        {
+            cellFractions[d].resize(ddGridSetup.numDomains[d]);
+            gmx_bcast(
+                    cellFractions[d].size() * sizeof(real), cellFractions[d].data(), communicator);
+        }
+    }
+
+    return cellFractions;
+}
+
 /*! \brief Get some important DD parameters which can be modified by env.vars */
 static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
                                 const DomdecOptions&     options,
@@ -2701,15 +3069,25 @@ static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
 {
     DDSettings ddSettings;
 
-    ddSettings.useSendRecv2        = (dd_getenv(mdlog, "GMX_DD_USE_SENDRECV2", 0) != 0);
-    ddSettings.dlb_scale_lim       = dd_getenv(mdlog, "GMX_DLB_MAX_BOX_SCALING", 10);
-    ddSettings.useDDOrderZYX       = bool(dd_getenv(mdlog, "GMX_DD_ORDER_ZYX", 0));
-    ddSettings.useCartesianReorder = bool(dd_getenv(mdlog, "GMX_NO_CART_REORDER", 1));
-    ddSettings.eFlop               = dd_getenv(mdlog, "GMX_DLB_BASED_ON_FLOPS", 0);
-    const int recload              = dd_getenv(mdlog, "GMX_DD_RECORD_LOAD", 1);
-    ddSettings.nstDDDump           = dd_getenv(mdlog, "GMX_DD_NST_DUMP", 0);
-    ddSettings.nstDDDumpGrid       = dd_getenv(mdlog, "GMX_DD_NST_DUMP_GRID", 0);
-    ddSettings.DD_debug            = dd_getenv(mdlog, "GMX_DD_DEBUG", 0);
+    ddSettings.useSendRecv2             = (dd_getenv(mdlog, "GMX_DD_USE_SENDRECV2", 0) != 0);
+    ddSettings.useCpuHaloOverlap        = bool(dd_getenv(mdlog, "GMX_DD_HALO_OVERLAP", 0));
+    ddSettings.useHilbertCurveAtomOrder = bool(dd_getenv(mdlog, "GMX_DD_HILBERT_ORDER", 0));
+    ddSettings.useCostWeightedCellSizes = bool(dd_getenv(mdlog, "GMX_DD_COST_WEIGHTED_CELLS", 0));
+    ddSettings.useDDOrderZYX            = bool(dd_getenv(mdlog, "GMX_DD_ORDER_ZYX", 0));
+    ddSettings.useCartesianReorder      = bool(dd_getenv(mdlog, "GMX_NO_CART_REORDER", 1));
+    ddSettings.eFlop                    = dd_getenv(mdlog, "GMX_DLB_BASED_ON_FLOPS", 0);
+    const int recload                   = dd_getenv(mdlog, "GMX_DD_RECORD_LOAD", 1);
+    ddSettings.nstDDDump                = dd_getenv(mdlog, "GMX_DD_NST_DUMP", 0);
+    ddSettings.nstDDDumpGrid            = dd_getenv(mdlog, "GMX_DD_NST_DUMP_GRID", 0);
+    ddSettings.DD_debug                 = dd_getenv(mdlog, "GMX_DD_DEBUG", 0);
+    const bool useHaloCompression       = bool(dd_getenv(mdlog, "GMX_DD_HALO_COMPRESSION", 0));
+
+    /* With the load density the target cell sizes are an estimate of the balanced
+     * sizes instead of a linear response, so we allow larger changes by default.
+     */
+    ddSettings.useLoadDensityForDlb = bool(dd_getenv(mdlog, "GMX_DLB_LOAD_DENSITY", 0));
+    ddSettings.dlb_scale_lim =
+            dd_getenv(mdlog, "GMX_DLB_MAX_BOX_SCALING", ddSettings.useLoadDensityForDlb ? 50 : 10);
 
     if (ddSettings.useSendRecv2)
     {
@@ -2720,6 +3098,35 @@ static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
                         "communication");
     }
 
+    if (ddSettings.useCpuHaloOverlap)
+    {
+        GMX_LOG(mdlog.info)
+                .appendText(
+                        "Will overlap the first stage of the CPU coordinate and force halo "
+                        "exchange with computation");
+    }
+
+    if (useHaloCompression)
+    {
+        ddSettings.haloCoordinateMaxError = getHaloCoordinateMaxError(mdlog, ir);
+    }
+
+    if (ddSettings.useHilbertCurveAtomOrder)
+    {
+        GMX_LOG(mdlog.info)
+                .appendText(
+                        "Will order the home atoms with the non-bonded grid columns along a "
+                        "Hilbert curve");
+    }
+
+    if (ddSettings.useCostWeightedCellSizes)
+    {
+        GMX_LOG(mdlog.info)
+                .appendText(
+                        "Will set the initial cell sizes to equalize the cost estimated from the "
+                        "topology and the coordinates");
+    }
+
     if (ddSettings.eFlop)
     {
         GMX_LOG(mdlog.info).appendText("Will load balance based on FLOP count");
@@ -2811,6 +3218,8 @@ public:
     std::vector<int> pmeRanks_;
     //! Contains a valid Cartesian-communicator-based setup, or defaults.
     CartesianRankSetup cartSetup_;
+    //! The cost-weighted initial cell size fractions, empty for dimensions without them
+    std::array<std::vector<real>, DIM> costWeightedCellFractions_;
     //! }
 };
 
@@ -2914,6 +3323,20 @@ DomainDecompositionBuilder::Impl::Impl(const MDLogger&                   mdlog,
                      gridSetupCellsizeLimit,
                      ddbox_);
 
+    if (ddSettings_.useCostWeightedCellSizes && !isDlbOn(ddSettings_.initialDlbState))
+    {
+        costWeightedCellFractions_ =
+                determineCostWeightedCellFractions(MAIN(cr_) ? DDRole::Main : DDRole::Agent,
+                                                   cr->mpiDefaultCommunicator,
+                                                   mtop_,
+                                                   ir_,
+                                                   box,
+                                                   xGlobal,
+                                                   ddbox_,
+                                                   ddGridSetup_,
+                                                   systemInfo_);
+    }
+
     cr_->npmenodes = ddGridSetup_.numPmeOnlyRanks;
 
     ddRankSetup_ = getDDRankSetup(
@@ -2948,7 +3371,8 @@ std::unique_ptr<gmx_domdec_t> DomainDecompositionBuilder::Impl::build(LocalAtomS
                   ddRankSetup_.numPPRanks,
                   mtop_,
                   ir_,
-                  ddbox_);
+                  ddbox_,
+                  costWeightedCellFractions_);
 
     setupGroupCommunication(mdlog_, ddSettings_, pmeRanks_, cr_, mtop_.natoms, dd.get());
 
@@ -147,6 +147,9 @@ int dd_pme_maxshift_y(const gmx_domdec_t& dd);
 /*! \brief Return whether update groups are used */
 bool ddUsesUpdateGroups(const gmx_domdec_t& dd);
 
+/*! \brief Return whether the CPU halo exchange should overlap with computation */
+bool ddUsesCpuHaloOverlap(const gmx_domdec_t& dd);
+
 /*! \brief Returns whether molecules are always whole, i.e. not broken by PBC */
 bool dd_moleculesAreAlwaysWhole(const gmx_domdec_t& dd);
 
@@ -197,6 +200,17 @@ void dd_cycles_add(const gmx_domdec_t* dd, float cycles, int ddCycl);
 /*! \brief Communicate the coordinates to the neighboring cells and do pbc. */
 void dd_move_x(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
 
+/*! \brief Start communicating the coordinates to the neighboring cells without blocking
+ *
+ * Only the home atom coordinates in \p x are accessed. The halo coordinates
+ * are available after calling dd_move_x_finish(), which completes the
+ * communication. The local computation can overlap with the first pulse.
+ */
+void dd_move_x_begin(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
+
+/*! \brief Completes the coordinate communication started by dd_move_x_begin() */
+void dd_move_x_finish(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
+
 /*! \brief Sum the forces over the neighboring cells.
  *
  * When fshift!=NULL the shift forces are updated to obtain
@@ -204,6 +218,20 @@ void dd_move_x(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVe
  */
 void dd_move_f(struct gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle);
 
+/*! \brief Start summing the forces over the neighboring cells without blocking
+ *
+ * Should be called when all forces on halo atoms have been computed.
+ * Until dd_move_f_finish() is called, forces can still be added to home atoms.
+ */
+void dd_move_f_begin(struct gmx_domdec_t*       dd,
+                     gmx::ForceWithShiftForces* forceWithShiftForces,
+                     gmx_wallcycle*             wcycle);
+
+/*! \brief Completes the force summation started by dd_move_f_begin() */
+void dd_move_f_finish(struct gmx_domdec_t*       dd,
+                      gmx::ForceWithShiftForces* forceWithShiftForces,
+                      gmx_wallcycle*             wcycle);
+
 /*! \brief Reset all the statistics and counters for total run counting */
 void reset_dd_statistics_counters(struct gmx_domdec_t* dd);
 
@@ -111,64 +111,54 @@ void dd_clear_local_constraint_indices(gmx_domdec_t* dd)
     }
 }
 
-/*! \brief Walks over the constraints out from the local atoms into the non-local atoms and adds them to a list */
-static void walk_out(int                       con,
-                     int                       con_offset,
-                     int                       a,
-                     int                       offset,
-                     int                       nrec,
-                     gmx::ArrayRef<const int>  ia1,
-                     gmx::ArrayRef<const int>  ia2,
-                     const ListOfLists<int>&   at2con,
-                     const gmx_ga2la_t&        ga2la,
-                     gmx_bool                  bHomeConnect,
-                     gmx_domdec_constraints_t* dc,
-                     gmx_domdec_specat_comm_t* dcc,
-                     InteractionList*          il_local,
-                     std::vector<int>*         ireq)
+/*! \brief Walks over the constraints out from the local atoms into the non-local atoms and adds them to a list
+ *
+ * Constraints and atoms can be added multiple times, duplicates are
+ * removed in combineThreadConstraints().
+ */
+static void walk_out(int                      con,
+                     int                      con_offset,
+                     int                      a,
+                     int                      offset,
+                     int                      nrec,
+                     gmx::ArrayRef<const int> ia1,
+                     gmx::ArrayRef<const int> ia2,
+                     const ListOfLists<int>&  at2con,
+                     const gmx_ga2la_t&       ga2la,
+                     gmx_bool                 bHomeConnect,
+                     DDThreadConstraints*     found)
 {
-    if (!dc->gc_req[con_offset + con])
+    /* Add this non-home constraint to the list */
+    found->con_gl.push_back(con_offset + con);
+    found->con_nlocat.push_back(bHomeConnect ? 1 : 0);
+    const int*         iap           = constr_iatomptr(ia1, ia2, con);
+    const int          parameterType = iap[0];
+    const int          a1_gl         = offset + iap[1];
+    const int          a2_gl         = offset + iap[2];
+    std::array<int, 2> atoms;
+    /* The following indexing code can probably be optizimed */
+    if (const int* a_loc = ga2la.findHome(a1_gl))
     {
-        /* Add this non-home constraint to the list */
-        dc->con_gl.push_back(con_offset + con);
-        dc->con_nlocat.push_back(bHomeConnect ? 1 : 0);
-        dc->gc_req[con_offset + con]     = true;
-        const int*         iap           = constr_iatomptr(ia1, ia2, con);
-        const int          parameterType = iap[0];
-        const int          a1_gl         = offset + iap[1];
-        const int          a2_gl         = offset + iap[2];
-        std::array<int, 2> atoms;
-        /* The following indexing code can probably be optizimed */
-        if (const int* a_loc = ga2la.findHome(a1_gl))
-        {
-            atoms[0] = *a_loc;
-        }
-        else
-        {
-            /* We set this index later */
-            atoms[0] = -a1_gl - 1;
-        }
-        if (const int* a_loc = ga2la.findHome(a2_gl))
-        {
-            atoms[1] = *a_loc;
-        }
-        else
-        {
-            /* We set this index later */
-            atoms[1] = -a2_gl - 1;
-        }
-        il_local->push_back(parameterType, atoms);
-        dc->ncon++;
+        atoms[0] = *a_loc;
+    }
+    else
+    {
+        /* We set this index later */
+        atoms[0] = -a1_gl - 1;
+    }
+    if (const int* a_loc = ga2la.findHome(a2_gl))
+    {
+        atoms[1] = *a_loc;
     }
-    /* Check to not ask for the same atom more than once */
-    if (!dc->ga2la->find(offset + a))
+    else
     {
-        assert(dcc);
-        /* Add this non-home atom to the list */
-        ireq->push_back(offset + a);
-        /* Temporarily mark with -2, we get the index later */
-        dc->ga2la->insert(offset + a, -2);
+        /* We set this index later */
+        atoms[1] = -a2_gl - 1;
     }
+    found->ilc.push_back(parameterType, atoms);
+
+    /* Add this non-home atom to the list */
+    found->requestedGlobalAtomIndices.push_back(offset + a);
 
     if (nrec > 0)
     {
@@ -182,7 +172,7 @@ static void walk_out(int                       con,
                 const int  b   = (a == iap[1]) ? iap[2] : iap[1];
                 if (!ga2la.findHome(offset + b))
                 {
-                    walk_out(coni, con_offset, b, offset, nrec - 1, ia1, ia2, at2con, ga2la, FALSE, dc, dcc, il_local, ireq);
+                    walk_out(coni, con_offset, b, offset, nrec - 1, ia1, ia2, at2con, ga2la, FALSE, found);
                 }
             }
         }
@@ -264,30 +254,31 @@ static void atoms_to_settles(gmx_domdec_t*                         dd,
     }
 }
 
-/*! \brief Looks up constraint for the local atoms */
-static void atoms_to_constraints(gmx_domdec_t*                         dd,
+/*! \brief Looks up constraint for the local atoms in the range \p atomStart to \p atomEnd */
+static void atoms_to_constraints(const gmx_domdec_t&                   dd,
                                  const gmx_mtop_t&                     mtop,
                                  gmx::ArrayRef<const int64_t>          atomInfo,
                                  gmx::ArrayRef<const ListOfLists<int>> at2con_mt,
                                  int                                   nrec,
-                                 InteractionList*                      ilc_local,
-                                 std::vector<int>*                     ireq)
+                                 int                                   atomStart,
+                                 int                                   atomEnd,
+                                 DDThreadConstraints*                  found)
 {
-    gmx_domdec_constraints_t* dc  = dd->constraints.get();
-    gmx_domdec_specat_comm_t* dcc = dd->constraint_comm.get();
+    const gmx_domdec_constraints_t& dc = *dd.constraints;
 
-    const gmx_ga2la_t& ga2la = *dd->ga2la;
+    const gmx_ga2la_t& ga2la = *dd.ga2la;
 
-    dc->con_gl.clear();
-    dc->con_nlocat.clear();
+    found->con_gl.clear();
+    found->con_nlocat.clear();
+    found->ilc.clear();
+    found->requestedGlobalAtomIndices.clear();
 
-    int mb    = 0;
-    int nhome = 0;
-    for (int a = 0; a < dd->numHomeAtoms; a++)
+    int mb = 0;
+    for (int a = atomStart; a < atomEnd; a++)
     {
         if (atomInfo[a] & gmx::sc_atomInfo_Constraint)
         {
-            int a_gl  = dd->globalAtomIndices[a];
+            int a_gl  = dd.globalAtomIndices[a];
             int molnr = 0;
             int a_mol = 0;
             mtopGetMolblockIndex(mtop, a_gl, &mb, &molnr, &a_mol);
@@ -301,7 +292,7 @@ static void atoms_to_constraints(gmx_domdec_t*                         dd,
              * This is only required for the global index to make sure
              * that we use each constraint only once.
              */
-            const int con_offset = dc->molb_con_offset[mb] + molnr * dc->molb_ncon_mol[mb];
+            const int con_offset = dc.molb_con_offset[mb] + molnr * dc.molb_ncon_mol[mb];
 
             /* The global atom number offset for this molecule */
             const int offset = a_gl - a_mol;
@@ -324,16 +315,14 @@ static void atoms_to_constraints(gmx_domdec_t*                         dd,
                     /* Add this fully home constraint at the first atom */
                     if (a_mol < b_mol)
                     {
-                        dc->con_gl.push_back(con_offset + con);
-                        dc->con_nlocat.push_back(2);
+                        found->con_gl.push_back(con_offset + con);
+                        found->con_nlocat.push_back(2);
                         const int          b_lo          = *a_loc;
                         const int          parameterType = iap[0];
                         std::array<int, 2> atoms;
                         atoms[0] = (a_gl == iap[1] ? a : b_lo);
                         atoms[1] = (a_gl == iap[1] ? b_lo : a);
-                        ilc_local->push_back(parameterType, atoms);
-                        dc->ncon++;
-                        nhome++;
+                        found->ilc.push_back(parameterType, atoms);
                     }
                 }
                 else
@@ -344,8 +333,62 @@ static void atoms_to_constraints(gmx_domdec_t*                         dd,
                      * Therefore we call walk_out with nrec recursions to go
                      * after this first call.
                      */
-                    walk_out(con, con_offset, b_mol, offset, nrec, ia1, ia2, at2con, ga2la, TRUE, dc, dcc, ilc_local, ireq);
+                    walk_out(con, con_offset, b_mol, offset, nrec, ia1, ia2, at2con, ga2la, TRUE, found);
+                }
+            }
+        }
+    }
+}
+
+/*! \brief Combines the constraints and atom requests found by the threads
+ *
+ * Processes the thread results in order and only keeps the first
+ * occurrence of each constraint and requested atom. This gives the same
+ * result as a search over all home atoms by a single thread.
+ */
+static void combineThreadConstraints(gmx_domdec_constraints_t* dc,
+                                     int                       numThreads,
+                                     InteractionList*          ilc_local,
+                                     std::vector<int>*         ireq)
+{
+    dc->con_gl.clear();
+    dc->con_nlocat.clear();
+
+    int nhome = 0;
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        const DDThreadConstraints& found = dc->threadConstraints[thread];
+        for (size_t i = 0; i < found.con_gl.size(); i++)
+        {
+            const int  con    = found.con_gl[i];
+            const int  nlocat = found.con_nlocat[i];
+            const bool isHome = (nlocat == 2);
+            if (isHome || !dc->gc_req[con])
+            {
+                if (isHome)
+                {
+                    nhome++;
+                }
+                else
+                {
+                    dc->gc_req[con] = true;
                 }
+                dc->con_gl.push_back(con);
+                dc->con_nlocat.push_back(nlocat);
+                const int* iap = found.ilc.iatoms.data() + i * (1 + NRAL(F_CONSTR));
+                ilc_local->push_back(iap[0], NRAL(F_CONSTR), iap + 1);
+                dc->ncon++;
+            }
+        }
+
+        for (const int a : found.requestedGlobalAtomIndices)
+        {
+            /* Check to not ask for the same atom more than once */
+            if (!dc->ga2la->find(a))
+            {
+                ireq->push_back(a);
+                /* Temporarily mark with -2, we get the index later */
+                dc->ga2la->insert(a, -2);
             }
         }
     }
@@ -361,7 +404,28 @@ static void atoms_to_constraints(gmx_domdec_t*                         dd,
                 "Constraints: home %3d border %3d atoms: %3zu\n",
                 nhome,
                 dc->ncon - nhome,
-                dd->constraint_comm ? ireq->size() : 0);
+                ireq->size());
+    }
+}
+
+//! Replaces the temporary indices -global-1 of non-home atoms in \p il by local indices
+static void fillInMissingIndices(InteractionList* il, int nral, const gmx::HashedMap<int>& ga2la_specat)
+{
+    const int numEntries = il->size() / (1 + nral);
+    const int numThreads = numThreadsForSpecialAtoms(numEntries);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < numEntries; i++)
+    {
+        int* iap = il->iatoms.data() + i * (1 + nral);
+        for (int j = 1; j < 1 + nral; j++)
+        {
+            if (iap[j] < 0)
+            {
+                const int* a = ga2la_specat.find(-iap[j] - 1);
+                GMX_ASSERT(a, "We have checked before that this atom index has been set");
+                iap[j] = *a;
+            }
+        }
     }
 }
 
@@ -416,57 +480,58 @@ int dd_make_local_constraints(gmx_domdec_t*                  dd,
         ils_local->clear();
     }
 
-    if (at2settle_mt.empty())
-    {
-        atoms_to_constraints(dd, mtop, atomInfo, at2con_mt, nrec, ilc_local, ireq);
-    }
-    else
+    /* Each thread searches the constraints and settles of a part of the home atoms.
+     * Settles are stored directly in the output on the first thread.
+     */
+    const int numThreads = dc->nthread;
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
     {
-        /* Do the constraints, if present, on the first thread.
-         * Do the settles on all other threads.
-         */
-        const int t0_set = ((!at2con_mt.empty() && dc->nthread > 1) ? 1 : 0);
-
-#pragma omp parallel for num_threads(dc->nthread) schedule(static)
-        for (int thread = 0; thread < dc->nthread; thread++)
+        try
         {
-            try
-            {
-                if (!at2con_mt.empty() && thread == 0)
-                {
-                    atoms_to_constraints(dd, mtop, atomInfo, at2con_mt, nrec, ilc_local, ireq);
-                }
-
-                if (thread >= t0_set)
-                {
-                    /* Distribute the settle check+assignments over
-                     * dc->nthread or dc->nthread-1 threads.
-                     */
-                    const int cg0 = (dd->numHomeAtoms * (thread - t0_set)) / (dc->nthread - t0_set);
-                    const int cg1 = (dd->numHomeAtoms * (thread - t0_set + 1)) / (dc->nthread - t0_set);
+            const int atomStart = (dd->numHomeAtoms * thread) / numThreads;
+            const int atomEnd   = (dd->numHomeAtoms * (thread + 1)) / numThreads;
 
-                    InteractionList* ilst = (thread == t0_set) ? ils_local : &dc->ils[thread];
-                    ilst->clear();
+            if (!at2con_mt.empty())
+            {
+                atoms_to_constraints(*dd,
+                                     mtop,
+                                     atomInfo,
+                                     at2con_mt,
+                                     nrec,
+                                     atomStart,
+                                     atomEnd,
+                                     &dc->threadConstraints[thread]);
+            }
 
-                    std::vector<int>& ireqt = dc->requestedGlobalAtomIndices[thread];
-                    if (thread > 0)
-                    {
-                        ireqt.clear();
-                    }
+            if (!at2settle_mt.empty())
+            {
+                InteractionList* ilst = (thread == 0) ? ils_local : &dc->ils[thread];
+                ilst->clear();
 
-                    atoms_to_settles(dd, mtop, atomInfo, at2settle_mt, cg0, cg1, ilst, &ireqt);
+                std::vector<int>& ireqt = dc->requestedGlobalAtomIndices[thread];
+                if (thread > 0)
+                {
+                    ireqt.clear();
                 }
+
+                atoms_to_settles(dd, mtop, atomInfo, at2settle_mt, atomStart, atomEnd, ilst, &ireqt);
             }
-            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    if (!at2con_mt.empty())
+    {
+        combineThreadConstraints(dc, numThreads, ilc_local, ireq);
+    }
 
+    if (!at2settle_mt.empty())
+    {
         /* Combine the generate settles and requested indices */
-        for (int thread = 1; thread < dc->nthread; thread++)
+        for (int thread = 1; thread < numThreads; thread++)
         {
-            if (thread > t0_set)
-            {
-                ils_local->append(dc->ils[thread]);
-            }
+            ils_local->append(dc->ils[thread]);
 
             const std::vector<int>& ireqt = dc->requestedGlobalAtomIndices[thread];
             ireq->insert(ireq->end(), ireqt.begin(), ireqt.end());
@@ -491,37 +556,9 @@ int dd_make_local_constraints(gmx_domdec_t*                  dd,
                                             " or lincs-order");
 
         /* Fill in the missing indices */
-        gmx::HashedMap<int>* ga2la_specat = dd->constraints->ga2la.get();
-
-        int nral1 = 1 + NRAL(F_CONSTR);
-        for (int i = 0; i < ilc_local->size(); i += nral1)
-        {
-            int* iap = ilc_local->iatoms.data() + i;
-            for (int j = 1; j < nral1; j++)
-            {
-                if (iap[j] < 0)
-                {
-                    const int* a = ga2la_specat->find(-iap[j] - 1);
-                    GMX_ASSERT(a, "We have checked before that this atom index has been set");
-                    iap[j] = *a;
-                }
-            }
-        }
-
-        nral1 = 1 + NRAL(F_SETTLE);
-        for (int i = 0; i < ils_local->size(); i += nral1)
-        {
-            int* iap = ils_local->iatoms.data() + i;
-            for (int j = 1; j < nral1; j++)
-            {
-                if (iap[j] < 0)
-                {
-                    const int* a = ga2la_specat->find(-iap[j] - 1);
-                    GMX_ASSERT(a, "We have checked before that this atom index has been set");
-                    iap[j] = *a;
-                }
-            }
-        }
+        const gmx::HashedMap<int>& ga2la_specat = *dd->constraints->ga2la;
+        fillInMissingIndices(ilc_local, NRAL(F_CONSTR), ga2la_specat);
+        fillInMissingIndices(ils_local, NRAL(F_SETTLE), ga2la_specat);
     }
     else
     {
@@ -568,6 +605,7 @@ void init_domdec_constraints(gmx_domdec_t* dd, const gmx_mtop_t& mtop)
 
     dc->nthread = gmx_omp_nthreads_get(ModuleMultiThread::Domdec);
     dc->ils.resize(dc->nthread);
+    dc->threadConstraints.resize(dc->nthread);
 
     dd->constraint_comm = std::make_unique<gmx_domdec_specat_comm_t>();
 
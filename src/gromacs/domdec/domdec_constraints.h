@@ -44,8 +44,10 @@
 #define GMX_DOMDEC_DOMDEC_CONSTRAINTS_H
 
 #include <memory>
+#include <vector>
 
 #include "gromacs/domdec/hashedmap.h"
+#include "gromacs/topology/idef.h"
 #include "gromacs/utility/arrayref.h"
 
 namespace gmx
@@ -55,7 +57,21 @@ class Constraints;
 
 struct gmx_domdec_t;
 struct gmx_mtop_t;
-struct InteractionList;
+
+/*! \internal \brief Constraints and atom requests found by one thread during constraint setup
+ *
+ * Constraints with non-home atoms and the requested atoms can be found
+ * by multiple threads. Duplicates are removed when combining the results.
+ */
+struct DDThreadConstraints
+{
+    //! @cond Doxygen_Suppress
+    std::vector<int> con_gl;     /**< Global constraint indices */
+    std::vector<int> con_nlocat; /**< Number of local atoms (2/1/0) for each constraint */
+    InteractionList  ilc;        /**< The constraints, non-home atoms are stored as -index-1 */
+    std::vector<int> requestedGlobalAtomIndices; /**< Non-home atoms to request, may contain duplicates */
+    //! @endcond
+};
 
 /*! \brief Struct used during constraint setup with domain decomposition */
 struct gmx_domdec_constraints_t
@@ -75,8 +91,9 @@ struct gmx_domdec_constraints_t
     std::unique_ptr<gmx::HashedMap<int>> ga2la; /**< Global to local communicated constraint atom only index */
 
     /* Multi-threading stuff */
-    int                          nthread; /**< Number of threads used for DD constraint setup */
-    std::vector<InteractionList> ils;     /**< Constraint ilist working arrays, size \p nthread */
+    int                              nthread; /**< Number of threads used for DD constraint setup */
+    std::vector<InteractionList>     ils; /**< Constraint ilist working arrays, size \p nthread */
+    std::vector<DDThreadConstraints> threadConstraints; /**< Search results, size \p nthread */
 
     /* Buffers for requesting atoms */
     std::vector<std::vector<int>> requestedGlobalAtomIndices; /**< Buffers for requesting global atom indices, one per thread */
@@ -47,6 +47,8 @@
 #include "gromacs/domdec/dlbtiming.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/domdec/ga2la.h"
+#include "gromacs/domdec/halocoordinatecodec.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/topology/block.h"
@@ -457,6 +459,29 @@ struct DDSystemInfo
     bool increaseMultiBodyCutoff = false;
 };
 
+/*! \brief Stage of the halo exchange that is in flight while the CPU computes
+ *
+ * Only the first stage of the coordinate and of the force halo exchange
+ * can be overlapped, as later stages forward data received in earlier stages.
+ */
+struct HaloExchangeOverlap
+{
+    //! Buffer with the coordinates or forces to send
+    std::vector<gmx::RVec> sendBuffer;
+    //! Buffer for the received coordinates or forces, used when not receiving in place
+    std::vector<gmx::RVec> receiveBuffer;
+    //! Buffer with the encoded coordinates to send, used with reduced-precision coordinates
+    std::vector<uint8_t> encodedSendBuffer;
+    //! Buffer for the received encoded coordinates, used with reduced-precision coordinates
+    std::vector<uint8_t> encodedReceiveBuffer;
+    //! The requests of the non-blocking send and receive
+    std::array<MPI_Request, 2> requests;
+    //! The number of active requests
+    int numRequests = 0;
+    //! Whether the stage has been started and not yet finished
+    bool isActive = false;
+};
+
 /*! \brief Settings that affect the behavior of the domain decomposition
  *
  * These settings depend on options chosen by the user, set by enviroment
@@ -469,10 +494,20 @@ struct DDSettings
 {
     //! Use MPI_Sendrecv communication instead of non-blocking calls
     bool useSendRecv2 = false;
+    //! Overlap the first coordinate and force halo exchange stage with computation on the CPU
+    bool useCpuHaloOverlap = false;
+    //! The maximum error of reduced-precision halo coordinates, 0 means sending full precision
+    real haloCoordinateMaxError = 0;
+    //! Order the home atoms with the non-bonded grid columns along a Hilbert curve
+    bool useHilbertCurveAtomOrder = false;
+    //! Set the initial static cell sizes to equalize the cost estimated from the topology
+    bool useCostWeightedCellSizes = false;
 
     /* Information for managing the dynamic load balancing */
     //! Maximum DLB scaling per load balancing step in percent
     int dlb_scale_lim = 0;
+    //! Whether DLB sets cell sizes from the load density instead of the relative imbalance
+    bool useLoadDensityForDlb = false;
     //! Flop counter (0=no,1=yes,2=with (eFlop-1)*5% noise
     int eFlop = 0;
 
@@ -662,6 +697,9 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /** Array for signalling if atoms have moved to another domain */
     std::vector<int> movedBuffer;
 
+    /** Buffer for the global to local atom entries to insert */
+    std::vector<gmx_ga2la_t::Entry> ga2laEntryBuffer;
+
     /** Communication int buffer for general use */
     DDBuffer<int> intBuffer;
 
@@ -676,6 +714,20 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /**< Another rvec comm. buffer */
     DDBuffer<gmx::RVec> rvecBuffer2;
 
+    /**< Codec for reduced-precision halo coordinates, nullptr with full precision */
+    std::unique_ptr<gmx::HaloCoordinateCodec> haloCoordinateCodec;
+    /**< The number of bits per halo coordinate, 0 is full precision, -1 is not yet chosen */
+    int haloCoordinateNumBits = -1;
+    /**< Buffer for encoded halo coordinates to send */
+    DDBuffer<uint8_t> encodedSendBuffer;
+    /**< Buffer for received encoded halo coordinates */
+    DDBuffer<uint8_t> encodedReceiveBuffer;
+
+    /**< The coordinate halo exchange stage overlapping with computation */
+    HaloExchangeOverlap xHaloOverlap;
+    /**< The force halo exchange stage overlapping with computation */
+    HaloExchangeOverlap fHaloOverlap;
+
     /* Communication buffers for local redistribution */
     /**< Charge group flag comm. buffers */
     std::array<std::vector<int>, DIM * 2> cggl_flag;
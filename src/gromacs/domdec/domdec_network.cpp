@@ -136,6 +136,75 @@ template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<int>, gmx:
 template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<real>, gmx::ArrayRef<real>);
 //! Specialization of extern template for gmx::RVec
 template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<gmx::RVec>, gmx::ArrayRef<gmx::RVec>);
+//! Specialization of extern template for uint8_t
+template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<uint8_t>, gmx::ArrayRef<uint8_t>);
+
+template<typename T>
+int ddIsendrecv(const gmx_domdec_t gmx_unused*    dd,
+                int gmx_unused                    ddDimensionIndex,
+                int gmx_unused                    direction,
+                gmx::ArrayRef<const T> gmx_unused sendBuffer,
+                gmx::ArrayRef<T> gmx_unused       receiveBuffer,
+                MPI_Request gmx_unused*           requests)
+{
+    int numRequests = 0;
+#if GMX_MPI
+    const int sendRank    = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 0 : 1];
+    const int receiveRank = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 1 : 0];
+
+    /* Use a tag that differs from the blocking halo communication,
+     * so other communication can not be matched while this is in flight.
+     */
+    constexpr int mpiTag = 2;
+    if (!receiveBuffer.empty())
+    {
+        MPI_Irecv(receiveBuffer.data(),
+                  receiveBuffer.size() * sizeof(T),
+                  MPI_BYTE,
+                  receiveRank,
+                  mpiTag,
+                  dd->mpi_comm_all,
+                  &requests[numRequests++]);
+    }
+    if (!sendBuffer.empty())
+    {
+        MPI_Isend(const_cast<T*>(sendBuffer.data()),
+                  sendBuffer.size() * sizeof(T),
+                  MPI_BYTE,
+                  sendRank,
+                  mpiTag,
+                  dd->mpi_comm_all,
+                  &requests[numRequests++]);
+    }
+#endif
+
+    return numRequests;
+}
+
+//! Specialization of extern template for gmx::RVec
+template int ddIsendrecv(const gmx_domdec_t*,
+                         int,
+                         int,
+                         gmx::ArrayRef<const gmx::RVec>,
+                         gmx::ArrayRef<gmx::RVec>,
+                         MPI_Request*);
+//! Specialization of extern template for uint8_t
+template int ddIsendrecv(const gmx_domdec_t*,
+                         int,
+                         int,
+                         gmx::ArrayRef<const uint8_t>,
+                         gmx::ArrayRef<uint8_t>,
+                         MPI_Request*);
+
+void ddWaitRequests(int gmx_unused numRequests, MPI_Request gmx_unused* requests)
+{
+#if GMX_MPI
+    if (numRequests > 0)
+    {
+        MPI_Waitall(numRequests, requests, MPI_STATUSES_IGNORE);
+    }
+#endif
+}
 
 void dd_sendrecv2_rvec(const struct gmx_domdec_t gmx_unused* dd,
                        int gmx_unused                        ddimind,
@@ -47,7 +47,10 @@
 #ifndef GMX_DOMDEC_DOMDEC_NETWORK_H
 #define GMX_DOMDEC_DOMDEC_NETWORK_H
 
+#include <cstdint>
+
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/gmxmpi.h"
 
 struct gmx_domdec_t;
 
@@ -97,6 +100,49 @@ extern template void ddSendrecv<gmx::RVec>(const gmx_domdec_t*      dd,
                                            gmx::ArrayRef<gmx::RVec> sendBuffer,
                                            gmx::ArrayRef<gmx::RVec> receiveBuffer);
 
+//! Extern declaration for uint8_t specialization
+extern template void ddSendrecv<uint8_t>(const gmx_domdec_t*    dd,
+                                         int                    ddDimensionIndex,
+                                         int                    direction,
+                                         gmx::ArrayRef<uint8_t> sendBuffer,
+                                         gmx::ArrayRef<uint8_t> receiveBuffer);
+
+/*! \brief Starts moving a view of T values in the comm. region one cell along the decomposition
+ *
+ * Posts a non-blocking receive into \p receiveBuffer and a non-blocking
+ * send of \p sendBuffer, in the same direction as ddSendrecv() would.
+ * The buffers should not be accessed until ddWaitRequests() has been
+ * called with the returned requests.
+ *
+ * \returns The number of requests stored in \p requests, at most 2.
+ */
+template<typename T>
+int ddIsendrecv(const gmx_domdec_t*    dd,
+                int                    ddDimensionIndex,
+                int                    direction,
+                gmx::ArrayRef<const T> sendBuffer,
+                gmx::ArrayRef<T>       receiveBuffer,
+                MPI_Request*           requests);
+
+//! Extern declaration for gmx::RVec specialization
+extern template int ddIsendrecv<gmx::RVec>(const gmx_domdec_t*            dd,
+                                           int                            ddDimensionIndex,
+                                           int                            direction,
+                                           gmx::ArrayRef<const gmx::RVec> sendBuffer,
+                                           gmx::ArrayRef<gmx::RVec>       receiveBuffer,
+                                           MPI_Request*                   requests);
+
+//! Extern declaration for uint8_t specialization
+extern template int ddIsendrecv<uint8_t>(const gmx_domdec_t*          dd,
+                                         int                          ddDimensionIndex,
+                                         int                          direction,
+                                         gmx::ArrayRef<const uint8_t> sendBuffer,
+                                         gmx::ArrayRef<uint8_t>       receiveBuffer,
+                                         MPI_Request*                 requests);
+
+//! Waits for the \p numRequests requests started by ddIsendrecv() to complete
+void ddWaitRequests(int numRequests, MPI_Request* requests);
+
 /*! \brief Move revc's in the comm. region one cell along the domain decomposition
  *
  * Moves in dimension indexed by ddimind, simultaneously in the forward
@@ -50,7 +50,10 @@
 #include <cmath>
 #include <cstdio>
 
+#include <algorithm>
 #include <numeric>
+#include <string>
+#include <vector>
 
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
@@ -67,9 +70,16 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/timing/walltime_accounting.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
 #include "gromacs/utility/logger.h"
+#include "gromacs/utility/real.h"
+#include "gromacs/utility/strconvert.h"
 #include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+#include "gromacs/utility/textwriter.h"
 
 #include "atomdistribution.h"
 #include "box.h"
@@ -82,6 +92,276 @@ using gmx::DomdecOptions;
 /*! \brief Margin for setting up the DD grid */
 #define DD_GRID_MARGIN_PRES_SCALE 1.05
 
+//! The number of atoms used in the cost model calibration benchmarks
+static constexpr int c_costCalibrationNumAtoms = 20000;
+//! The number of repeats of the calibration benchmarks, the minimum time is used
+static constexpr int c_costCalibrationNumRepeats = 5;
+
+DDCostModel readDDCostProfile(const std::string& fileName)
+{
+    DDCostModel costModel;
+
+    gmx::TextReader reader(fileName);
+    reader.setTrimLeadingWhiteSpace(true);
+    reader.setTrimTrailingWhiteSpace(true);
+    reader.setTrimTrailingComment(true, '#');
+    std::string line;
+    while (reader.readLine(&line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        const auto tokens = gmx::splitAndTrimDelimitedString(line, '=');
+        if (tokens.size() != 2)
+        {
+            GMX_THROW(gmx::InvalidInputError(gmx::formatString(
+                    "Line '%s' in DD cost profile %s is not of the form 'key = value'",
+                    line.c_str(),
+                    fileName.c_str())));
+        }
+        const float value = gmx::fromString<float>(tokens[1]);
+        if (!(value > 0))
+        {
+            GMX_THROW(gmx::InvalidInputError(gmx::formatString(
+                    "The value of %s in DD cost profile %s should be positive",
+                    tokens[0].c_str(),
+                    fileName.c_str())));
+        }
+        if (tokens[0] == "pbcdx-rect-factor")
+        {
+            costModel.pbcdxRectFactor = value;
+        }
+        else if (tokens[0] == "pbcdx-tric-factor")
+        {
+            costModel.pbcdxTricFactor = value;
+        }
+        else if (tokens[0] == "pme-load-factor")
+        {
+            costModel.pmeLoadFactor = value;
+        }
+        else
+        {
+            GMX_THROW(gmx::InvalidInputError(gmx::formatString(
+                    "Unknown key '%s' in DD cost profile %s", tokens[0].c_str(), fileName.c_str())));
+        }
+    }
+
+    return costModel;
+}
+
+//! Writes the cost model factors to the profile file \p fileName
+static void writeDDCostProfile(const std::string& fileName, const DDCostModel& costModel)
+{
+    gmx::TextWriter writer(fileName);
+    writer.writeLine("# GROMACS domain decomposition cost profile for this machine");
+    writer.writeLine("# The pbc_dx costs are relative to communicating the coordinate and force of an atom");
+    writer.writeLineFormatted("pbcdx-rect-factor = %g", costModel.pbcdxRectFactor);
+    writer.writeLineFormatted("pbcdx-tric-factor = %g", costModel.pbcdxTricFactor);
+    writer.writeLine("# Scaling of the estimated PME load, this is not measured.");
+    writer.writeLine("# Set it to the ratio of the measured and the estimated PME load in the log file.");
+    writer.writeLineFormatted("pme-load-factor = %g", costModel.pmeLoadFactor);
+    writer.close();
+}
+
+/*! \brief Returns the minimum time per atom for sending coordinates to and receiving forces from a neighbor
+ *
+ * This is a collective call over \p communicator, which should have
+ * multiple ranks. The atoms are passed around a ring of ranks, as a halo
+ * exchange would do.
+ */
+static double timeHaloExchangePerAtom(MPI_Comm gmx_unused communicator)
+{
+    std::vector<gmx::RVec> sendBuffer(c_costCalibrationNumAtoms, { 1.0_real, 2.0_real, 3.0_real });
+    std::vector<gmx::RVec> receiveBuffer(c_costCalibrationNumAtoms);
+
+    double minTime = GMX_DOUBLE_MAX;
+#if GMX_MPI
+    int numRanks = 1;
+    int rank     = 0;
+    MPI_Comm_size(communicator, &numRanks);
+    MPI_Comm_rank(communicator, &rank);
+    GMX_RELEASE_ASSERT(numRanks > 1, "The halo exchange can only be timed with multiple ranks");
+    const int numBytes = c_costCalibrationNumAtoms * sizeof(gmx::RVec);
+    const int forward  = (rank + 1) % numRanks;
+    const int backward = (rank - 1 + numRanks) % numRanks;
+
+    for (int repeat = 0; repeat < c_costCalibrationNumRepeats; repeat++)
+    {
+        MPI_Barrier(communicator);
+        const double startTime = gmx_gettime();
+        // Coordinates are sent forward, forces backward
+        MPI_Sendrecv(sendBuffer.data(),
+                     numBytes,
+                     MPI_BYTE,
+                     forward,
+                     0,
+                     receiveBuffer.data(),
+                     numBytes,
+                     MPI_BYTE,
+                     backward,
+                     0,
+                     communicator,
+                     MPI_STATUS_IGNORE);
+        MPI_Sendrecv(receiveBuffer.data(),
+                     numBytes,
+                     MPI_BYTE,
+                     backward,
+                     1,
+                     sendBuffer.data(),
+                     numBytes,
+                     MPI_BYTE,
+                     forward,
+                     1,
+                     communicator,
+                     MPI_STATUS_IGNORE);
+        minTime = std::min(minTime, gmx_gettime() - startTime);
+    }
+#else
+    GMX_RELEASE_ASSERT(false, "The halo exchange can only be timed with MPI");
+#endif
+
+    return minTime / c_costCalibrationNumAtoms;
+}
+
+//! Returns the minimum time per pbc_dx_aiuc call for the unit cell \p box
+static double timePbcdxPerCall(const matrix box)
+{
+    t_pbc pbc;
+    set_pbc(&pbc, PbcType::Xyz, box);
+
+    // Spread the atoms quasi-randomly over the unit cell using additive recurrences
+    std::vector<gmx::RVec> x(c_costCalibrationNumAtoms);
+    for (int i = 0; i < c_costCalibrationNumAtoms; i++)
+    {
+        const real fracX = std::fmod(i * 0.7548776662_real, 1.0_real);
+        const real fracY = std::fmod(i * 0.5698402910_real, 1.0_real);
+        const real fracZ = std::fmod(i * 0.3819660113_real, 1.0_real);
+        for (int d = 0; d < DIM; d++)
+        {
+            x[i][d] = fracX * box[XX][d] + fracY * box[YY][d] + fracZ * box[ZZ][d];
+        }
+    }
+
+    double minTime = GMX_DOUBLE_MAX;
+    real   sum     = 0;
+    for (int repeat = 0; repeat < c_costCalibrationNumRepeats; repeat++)
+    {
+        const double startTime = gmx_gettime();
+        for (int i = 0; i < c_costCalibrationNumAtoms; i++)
+        {
+            // Pair each atom with a distant atom in the list, as bonded interactions
+            // crossing the periodic boundaries would do
+            const int j = (i + c_costCalibrationNumAtoms / 2) % c_costCalibrationNumAtoms;
+            rvec      dx;
+            pbc_dx_aiuc(&pbc, x[i], x[j], dx);
+            sum += dx[XX] + dx[YY] + dx[ZZ];
+        }
+        minTime = std::min(minTime, gmx_gettime() - startTime);
+    }
+    // Use the result, so the compiler can not optimize the pbc_dx calls away
+    GMX_RELEASE_ASSERT(std::isfinite(sum), "The pbc_dx results should be finite");
+
+    return minTime / c_costCalibrationNumAtoms;
+}
+
+/*! \brief Measures the machine dependent factors of the DD cost model
+ *
+ * This is a collective call over \p communicator, the result is only valid on the main rank.
+ */
+static DDCostModel calibrateDDCostModel(DDRole ddRole, MPI_Comm communicator)
+{
+    const double haloTime = timeHaloExchangePerAtom(communicator);
+
+    DDCostModel costModel;
+    if (ddRole == DDRole::Main)
+    {
+        const matrix rectBox = { { 5, 0, 0 }, { 0, 5, 0 }, { 0, 0, 5 } };
+        const matrix tricBox = { { 5, 0, 0 }, { 1.5, 5, 0 }, { 1.5, 1.5, 4.5 } };
+
+        costModel.pbcdxRectFactor = timePbcdxPerCall(rectBox) / haloTime;
+        costModel.pbcdxTricFactor = timePbcdxPerCall(tricBox) / haloTime;
+    }
+
+    return costModel;
+}
+
+/*! \brief Returns the cost model for the DD grid and PME rank choice
+ *
+ * When the environment variable GMX_DD_COST_PROFILE is set, the cost
+ * factors are read from the file it names. When this file does not
+ * exist, the machine dependent factors are measured and the file is written.
+ * The halo exchange can only be measured with multiple ranks, so with
+ * a single rank the defaults are used and no file is written.
+ * This is a collective call over \p communicator.
+ */
+static DDCostModel getDDCostModel(const gmx::MDLogger& mdlog, DDRole ddRole, MPI_Comm communicator, int numRanks)
+{
+    enum class ProfileAction : int
+    {
+        None,
+        Read,
+        Calibrate
+    };
+
+    // The main rank decides, so all ranks take the same action
+    const char*   profileFileName = getenv("GMX_DD_COST_PROFILE");
+    ProfileAction action          = ProfileAction::None;
+    if (ddRole == DDRole::Main && profileFileName != nullptr)
+    {
+        if (gmx_fexist(profileFileName))
+        {
+            action = ProfileAction::Read;
+        }
+        else if (numRanks > 1)
+        {
+            action = ProfileAction::Calibrate;
+        }
+        else
+        {
+            GMX_LOG(mdlog.info)
+                    .appendTextFormatted(
+                            "DD cost profile %s does not exist, but the DD cost factors can not be "
+                            "measured with a single rank. Using the default DD cost factors.",
+                            profileFileName);
+        }
+    }
+    gmx_bcast(sizeof(action), &action, communicator);
+
+    DDCostModel costModel;
+    if (action == ProfileAction::Read)
+    {
+        // All ranks read the file, so an invalid file gives an error on all ranks
+        costModel = readDDCostProfile(profileFileName);
+        GMX_LOG(mdlog.info).appendTextFormatted("Read DD cost profile %s", profileFileName);
+    }
+    else if (action == ProfileAction::Calibrate)
+    {
+        costModel = calibrateDDCostModel(ddRole, communicator);
+        if (ddRole == DDRole::Main)
+        {
+            writeDDCostProfile(profileFileName, costModel);
+            GMX_LOG(mdlog.info)
+                    .appendTextFormatted("Measured the DD cost factors and wrote them to %s",
+                                         profileFileName);
+        }
+    }
+    gmx_bcast(sizeof(costModel), &costModel, communicator);
+
+    if (action != ProfileAction::None)
+    {
+        GMX_LOG(mdlog.info)
+                .appendTextFormatted(
+                        "Using DD cost factors: pbc_dx rectangular %.3f, pbc_dx triclinic %.3f, "
+                        "PME load %.3f",
+                        costModel.pbcdxRectFactor,
+                        costModel.pbcdxTricFactor,
+                        costModel.pmeLoadFactor);
+    }
+
+    return costModel;
+}
+
 /*! \brief Factorize \p n.
  *
  * \param[in]    n     Value to factorize
@@ -173,9 +453,10 @@ static int guess_npme(const gmx::MDLogger& mdlog,
                       const gmx_mtop_t&    mtop,
                       const t_inputrec&    ir,
                       const matrix         box,
+                      const DDCostModel&   costModel,
                       int                  nrank_tot)
 {
-    float ratio = pme_load_estimate(mtop, ir, box);
+    float ratio = pme_load_estimate(mtop, ir, box) * costModel.pmeLoadFactor;
 
     GMX_LOG(mdlog.info).appendTextFormatted("Guess for relative PME load: %.2f", ratio);
 
@@ -330,19 +611,12 @@ static float comm_cost_est(real               limit,
                            const int64_t      natoms,
                            const t_inputrec&  ir,
                            float              pbcdxr,
+                           const DDCostModel& costModel,
                            int                npme_tot,
                            const gmx::IVec&   nc)
 {
     gmx::IVec npme = { 1, 1, 1 };
     rvec      bt;
-    /* This is the cost of a pbc_dx call relative to the cost
-     * of communicating the coordinate and force of an atom.
-     * This will be machine dependent.
-     * These factors are for x86 with SMP or Infiniband.
-     */
-    float pbcdx_rect_fac = 0.1;
-    float pbcdx_tric_fac = 0.2;
-
     /* Check the DD algorithm restrictions */
     if ((ir.pbcType == PbcType::XY && ir.nwall < 2 && nc[ZZ] > 1)
         || (ir.pbcType == PbcType::Screw && (nc[XX] == 1 || nc[YY] > 1 || nc[ZZ] > 1)))
@@ -515,11 +789,11 @@ static float comm_cost_est(real               limit,
     {
         if ((ddbox.tric_dir[XX] && nc[XX] == 1) || (ddbox.tric_dir[YY] && nc[YY] == 1))
         {
-            cost_pbcdx = pbcdxr * pbcdx_tric_fac;
+            cost_pbcdx = pbcdxr * costModel.pbcdxTricFactor;
         }
         else
         {
-            cost_pbcdx = pbcdxr * pbcdx_rect_fac;
+            cost_pbcdx = pbcdxr * costModel.pbcdxRectFactor;
         }
     }
 
@@ -550,6 +824,7 @@ static void assign_factors(const real         limit,
                            int                natoms,
                            const t_inputrec&  ir,
                            float              pbcdxr,
+                           const DDCostModel& costModel,
                            int                npme,
                            int                ndiv,
                            const int*         div,
@@ -562,10 +837,12 @@ static void assign_factors(const real         limit,
     if (ndiv == 0)
     {
 
-        const float ce = comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, ir_try);
+        const float ce = comm_cost_est(
+                limit, cutoff, box, ddbox, natoms, ir, pbcdxr, costModel, npme, ir_try);
         if (ce >= 0
             && ((*opt)[XX] == 0
-                || ce < comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, *opt)))
+                || ce < comm_cost_est(
+                               limit, cutoff, box, ddbox, natoms, ir, pbcdxr, costModel, npme, *opt)))
         {
             *opt = ir_try;
         }
@@ -591,8 +868,20 @@ static void assign_factors(const real         limit,
             }
 
             /* recurse */
-            assign_factors(
-                    limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, ndiv - 1, div + 1, mdiv + 1, irTryPtr, opt);
+            assign_factors(limit,
+                           cutoff,
+                           box,
+                           ddbox,
+                           natoms,
+                           ir,
+                           pbcdxr,
+                           costModel,
+                           npme,
+                           ndiv - 1,
+                           div + 1,
+                           mdiv + 1,
+                           irTryPtr,
+                           opt);
 
             for (int i = 0; i < mdiv[0] - x - y; i++)
             {
@@ -623,7 +912,8 @@ static gmx::IVec optimizeDDCells(const gmx::MDLogger& mdlog,
                                  const matrix         box,
                                  const gmx_ddbox_t&   ddbox,
                                  const t_inputrec&    ir,
-                                 const DDSystemInfo&  systemInfo)
+                                 const DDSystemInfo&  systemInfo,
+                                 const DDCostModel&   costModel)
 {
     double pbcdxr = 0;
 
@@ -703,6 +993,7 @@ static gmx::IVec optimizeDDCells(const gmx::MDLogger& mdlog,
                    mtop.natoms,
                    ir,
                    pbcdxr,
+                   costModel,
                    numRanksDoingPmeWork,
                    div.size(),
                    div.data(),
@@ -871,6 +1162,7 @@ static int getNumPmeOnlyRanksToUse(const gmx::MDLogger&                  mdlog,
                                    const t_inputrec&                     ir,
                                    const gmx::SeparatePmeRanksPermitted& separatePmeRanksPermitted,
                                    const matrix                          box,
+                                   const DDCostModel&                    costModel,
                                    const int                             numRanksRequested)
 {
     int numPmeOnlyRanks = 0;
@@ -901,7 +1193,7 @@ static int getNumPmeOnlyRanksToUse(const gmx::MDLogger&                  mdlog,
             }
             else
             {
-                numPmeOnlyRanks = guess_npme(mdlog, mtop, ir, box, numRanksRequested);
+                numPmeOnlyRanks = guess_npme(mdlog, mtop, ir, box, costModel, numRanksRequested);
                 extraMessage += ", as guessed by mdrun";
             }
         }
@@ -968,8 +1260,10 @@ DDGridSetup getDDGridSetup(const gmx::MDLogger&                  mdlog,
                            gmx::ArrayRef<const gmx::RVec>        xGlobal,
                            gmx_ddbox_t*                          ddbox)
 {
+    const DDCostModel costModel = getDDCostModel(mdlog, ddRole, communicator, numRanksRequested);
+
     int numPmeOnlyRanks = getNumPmeOnlyRanksToUse(
-            mdlog, options, mtop, ir, separatePmeRanksPermitted, box, numRanksRequested);
+            mdlog, options, mtop, ir, separatePmeRanksPermitted, box, costModel, numRanksRequested);
 
     gmx::IVec numDomains;
     if (options.numCells[XX] > 0)
@@ -984,8 +1278,16 @@ DDGridSetup getDDGridSetup(const gmx::MDLogger&                  mdlog,
 
         if (ddRole == DDRole::Main)
         {
-            numDomains = optimizeDDCells(
-                    mdlog, numRanksRequested, numPmeOnlyRanks, cellSizeLimit, mtop, box, *ddbox, ir, systemInfo);
+            numDomains = optimizeDDCells(mdlog,
+                                         numRanksRequested,
+                                         numPmeOnlyRanks,
+                                         cellSizeLimit,
+                                         mtop,
+                                         box,
+                                         *ddbox,
+                                         ir,
+                                         systemInfo,
+                                         costModel);
         }
     }
 
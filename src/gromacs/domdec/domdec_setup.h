@@ -41,6 +41,8 @@
 #ifndef GMX_DOMDEC_DOMDEC_SETUP_H
 #define GMX_DOMDEC_DOMDEC_SETUP_H
 
+#include <string>
+
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/gmxmpi.h"
 
@@ -62,6 +64,35 @@ template<typename T>
 class ArrayRef;
 } // namespace gmx
 
+/*! \internal
+ * \brief Machine dependent factors of the cost model for the DD grid and PME rank choice
+ *
+ * The defaults are for x86 with SMP or Infiniband. Measured or tuned values
+ * can be provided through a cost profile file named by GMX_DD_COST_PROFILE.
+ */
+struct DDCostModel
+{
+    //! The cost of a pbc_dx call with a rectangular box relative to communicating the coordinate and force of an atom
+    float pbcdxRectFactor = 0.1;
+    //! The cost of a pbc_dx call with a triclinic box relative to communicating the coordinate and force of an atom
+    float pbcdxTricFactor = 0.2;
+    /*! \brief Scaling factor for the analytical estimate of the relative PME load
+     *
+     * This factor is not measured by the calibration. It can be set in
+     * the profile from the measured and estimated PME load in the log file.
+     */
+    float pmeLoadFactor = 1.0;
+};
+
+/*! \brief Reads the cost model factors from the profile file \p fileName
+ *
+ * Factors that are not present in the file keep their default value.
+ *
+ * \throws FileIOError when the file can not be opened.
+ * \throws InvalidInputError when the file contains unknown keys or invalid values.
+ */
+DDCostModel readDDCostProfile(const std::string& fileName);
+
 /*! \brief Returns the volume fraction of the system that is communicated */
 real comm_box_frac(const gmx::IVec& dd_nc, real cutoff, const gmx_ddbox_t& ddbox);
 
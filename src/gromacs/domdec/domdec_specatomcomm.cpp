@@ -57,11 +57,150 @@
 #include "gromacs/domdec/hashedmap.h"
 #include "gromacs/domdec/partition.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 
+int numThreadsForSpecialAtoms(const int numElements)
+{
+    /* With fewer elements per thread the threading overhead dominates */
+    constexpr int c_minNumElementsPerThread = 256;
+
+    return std::max(1,
+                    std::min(gmx_omp_nthreads_get(ModuleMultiThread::Domdec),
+                             numElements / c_minNumElementsPerThread));
+}
+
+/*! \brief Adds the forces in \p buffer to the forces of \p atoms
+ *
+ * \param[in]     atoms              The local atom indices
+ * \param[in]     buffer             The forces to add, in the order of \p atoms
+ * \param[in,out] f                  The force buffer
+ * \param[in]     rotate             Whether to rotate the forces for screw PBC
+ * \param[in,out] fshift             The shift force to add the sum of the buffer to, can be nullptr
+ * \param[in,out] threadShiftForces  Work buffer for the shift force contributions of the threads
+ */
+static void addForcesFromBuffer(gmx::ArrayRef<const int> atoms,
+                                const gmx::RVec*         buffer,
+                                gmx::RVec*               f,
+                                const bool               rotate,
+                                gmx::RVec*               fshift,
+                                std::vector<gmx::RVec>*  threadShiftForces)
+{
+    const int numAtoms   = atoms.ssize();
+    const int numThreads = numThreadsForSpecialAtoms(numAtoms);
+
+    if (fshift)
+    {
+        threadShiftForces->assign(numThreads, { 0, 0, 0 });
+    }
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        const int begin = (numAtoms * thread) / numThreads;
+        const int end   = (numAtoms * (thread + 1)) / numThreads;
+        if (rotate)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                const int a = atoms[i];
+                f[a][XX] += buffer[i][XX];
+                f[a][YY] -= buffer[i][YY];
+                f[a][ZZ] -= buffer[i][ZZ];
+            }
+        }
+        else
+        {
+            for (int i = begin; i < end; i++)
+            {
+                f[atoms[i]] += buffer[i];
+            }
+        }
+        if (fshift)
+        {
+            /* The shift force is the force before rotation */
+            gmx::RVec sum = { 0, 0, 0 };
+            for (int i = begin; i < end; i++)
+            {
+                sum += buffer[i];
+            }
+            (*threadShiftForces)[thread] = sum;
+        }
+    }
+
+    if (fshift)
+    {
+        /* Reduce in a fixed order for reproducibility */
+        for (const gmx::RVec& threadShiftForce : *threadShiftForces)
+        {
+            *fshift += threadShiftForce;
+        }
+    }
+}
+
+//! The transformation to apply when putting coordinates in the send buffer
+enum class CoordinateTransform
+{
+    Copy,          //!< Only copy
+    Shift,         //!< Add a shift vector
+    ShiftAndRotate //!< Rotate for screw PBC and add a shift vector
+};
+
+//! Copies the coordinates of \p atoms into \p buffer, applying \p transform
+static void packCoordinates(gmx::ArrayRef<const int> atoms,
+                            const gmx::RVec*         x,
+                            gmx::RVec*               buffer,
+                            const CoordinateTransform transform,
+                            const gmx::RVec&         shift,
+                            const matrix             box)
+{
+    const int numAtoms   = atoms.ssize();
+    const int numThreads = numThreadsForSpecialAtoms(numAtoms);
+
+    switch (transform)
+    {
+        case CoordinateTransform::Copy:
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+            for (int i = 0; i < numAtoms; i++)
+            {
+                buffer[i] = x[atoms[i]];
+            }
+            break;
+        case CoordinateTransform::Shift:
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+            for (int i = 0; i < numAtoms; i++)
+            {
+                buffer[i] = x[atoms[i]] + shift;
+            }
+            break;
+        case CoordinateTransform::ShiftAndRotate:
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+            for (int i = 0; i < numAtoms; i++)
+            {
+                const int a  = atoms[i];
+                buffer[i][XX] = x[a][XX] + shift[XX];
+                buffer[i][YY] = box[YY][YY] - x[a][YY] + shift[YY];
+                buffer[i][ZZ] = box[ZZ][ZZ] - x[a][ZZ] + shift[ZZ];
+            }
+            break;
+    }
+}
+
+//! Copies \p numAtoms coordinates from \p buffer to \p x
+static void unpackCoordinates(const gmx::RVec* buffer, gmx::RVec* x, const int numAtoms)
+{
+    const int numThreads = numThreadsForSpecialAtoms(numAtoms);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < numAtoms; i++)
+    {
+        x[i] = buffer[i];
+    }
+}
+
 void dd_move_f_specat(const gmx_domdec_t* dd, gmx_domdec_specat_comm_t* spac, gmx::RVec* f, gmx::RVec* fshift)
 {
     ivec vis;
@@ -89,6 +228,7 @@ void dd_move_f_specat(const gmx_domdec_t* dd, gmx_domdec_specat_comm_t* spac, gm
                               n1,
                               vbuf + spas[0].a.size(),
                               spas[1].a.size());
+            int bufferOffset = 0;
             for (int dir = 0; dir < 2; dir++)
             {
                 bool bPBC   = ((dir == 0 && dd->ci[dim] == 0)
@@ -96,46 +236,23 @@ void dd_move_f_specat(const gmx_domdec_t* dd, gmx_domdec_specat_comm_t* spac, gm
                 bool bScrew = (bPBC && dd->unitCellInfo.haveScrewPBC && dim == XX);
 
                 const gmx_specatsend_t* spas = &spac->spas[d][dir];
-                /* Sum the buffer into the required forces */
-                if (!bPBC || (!bScrew && fshift == nullptr))
-                {
-                    for (int a : spas->a)
-                    {
-                        rvec_inc(f[a], *vbuf);
-                        vbuf++;
-                    }
-                }
-                else
+                /* Sum the buffer into the required forces, with PBC also
+                 * into the shift forces, when requested
+                 */
+                gmx::RVec* fshiftEntry = nullptr;
+                if (bPBC && fshift != nullptr)
                 {
                     clear_ivec(vis);
-                    vis[dim] = (dir == 0 ? 1 : -1);
-                    int is   = gmx::ivecToShiftIndex(vis);
-                    if (!bScrew)
-                    {
-                        /* Sum and add to shift forces */
-                        for (int a : spas->a)
-                        {
-                            rvec_inc(f[a], *vbuf);
-                            rvec_inc(fshift[is], *vbuf);
-                            vbuf++;
-                        }
-                    }
-                    else
-                    {
-                        /* Rotate the forces */
-                        for (int a : spas->a)
-                        {
-                            f[a][XX] += (*vbuf)[XX];
-                            f[a][YY] -= (*vbuf)[YY];
-                            f[a][ZZ] -= (*vbuf)[ZZ];
-                            if (fshift)
-                            {
-                                rvec_inc(fshift[is], *vbuf);
-                            }
-                            vbuf++;
-                        }
-                    }
+                    vis[dim]    = (dir == 0 ? 1 : -1);
+                    fshiftEntry = &fshift[gmx::ivecToShiftIndex(vis)];
                 }
+                addForcesFromBuffer(spas->a,
+                                    spac->vbuf.data() + bufferOffset,
+                                    f,
+                                    bScrew,
+                                    fshiftEntry,
+                                    &spac->threadShiftForces);
+                bufferOffset += spas->a.size();
             }
         }
         else
@@ -150,28 +267,10 @@ void dd_move_f_specat(const gmx_domdec_t* dd, gmx_domdec_specat_comm_t* spac, gm
                        gmx::arrayRefFromArray(f + n, spas->nrecv),
                        gmx::arrayRefFromArray(spac->vbuf.data(), spas->a.size()));
             /* Sum the buffer into the required forces */
-            if (dd->unitCellInfo.haveScrewPBC && dim == XX
-                && (dd->ci[dim] == 0 || dd->ci[dim] == dd->numCells[dim] - 1))
-            {
-                int i = 0;
-                for (int a : spas->a)
-                {
-                    /* Rotate the force */
-                    f[a][XX] += spac->vbuf[i][XX];
-                    f[a][YY] -= spac->vbuf[i][YY];
-                    f[a][ZZ] -= spac->vbuf[i][ZZ];
-                    i++;
-                }
-            }
-            else
-            {
-                int i = 0;
-                for (int a : spas->a)
-                {
-                    rvec_inc(f[a], spac->vbuf[i]);
-                    i++;
-                }
-            }
+            const bool rotate = (dd->unitCellInfo.haveScrewPBC && dim == XX
+                                 && (dd->ci[dim] == 0 || dd->ci[dim] == dd->numCells[dim] - 1));
+            addForcesFromBuffer(
+                    spas->a, spac->vbuf.data(), f, rotate, nullptr, &spac->threadShiftForces);
         }
     }
 }
@@ -223,35 +322,21 @@ void dd_move_x_specat(const gmx_domdec_t*       dd,
                 {
                     gmx::RVec* x = (v == 0 ? x0 : x1);
                     /* Copy the required coordinates to the send buffer */
+                    CoordinateTransform transform;
                     if (!bPBC || (v == 1 && !bX1IsCoord))
                     {
-                        /* Only copy */
-                        for (int a : spas->a)
-                        {
-                            *vbuf = x[a];
-                            vbuf++;
-                        }
+                        transform = CoordinateTransform::Copy;
                     }
                     else if (!bScrew)
                     {
-                        /* Shift coordinates */
-                        for (int a : spas->a)
-                        {
-                            *vbuf = x[a] + shift;
-                            vbuf++;
-                        }
+                        transform = CoordinateTransform::Shift;
                     }
                     else
                     {
-                        /* Shift and rotate coordinates */
-                        for (int a : spas->a)
-                        {
-                            (*vbuf)[XX] = x[a][XX] + shift[XX];
-                            (*vbuf)[YY] = box[YY][YY] - x[a][YY] + shift[YY];
-                            (*vbuf)[ZZ] = box[ZZ][ZZ] - x[a][ZZ] + shift[ZZ];
-                            vbuf++;
-                        }
+                        transform = CoordinateTransform::ShiftAndRotate;
                     }
+                    packCoordinates(spas->a, x, vbuf, transform, shift, box);
+                    vbuf += spas->a.size();
                 }
             }
             /* Send and receive the coordinates */
@@ -271,9 +356,17 @@ void dd_move_x_specat(const gmx_domdec_t*       dd,
             {
                 rvec* vbuf = as_rvec_array(spac->vbuf.data());
                 /* Communicate both vectors in one buffer */
-                rvec* rbuf = as_rvec_array(spac->vbuf2.data());
-                dd_sendrecv2_rvec(
-                        dd, d, vbuf + 2 * ns0, 2 * ns1, rbuf, 2 * nr1, vbuf, 2 * ns0, rbuf + 2 * nr1, 2 * nr0);
+                gmx::RVec* rbuf = spac->vbuf2.data();
+                dd_sendrecv2_rvec(dd,
+                                  d,
+                                  vbuf + 2 * ns0,
+                                  2 * ns1,
+                                  as_rvec_array(rbuf),
+                                  2 * nr1,
+                                  vbuf,
+                                  2 * ns0,
+                                  as_rvec_array(rbuf + 2 * nr1),
+                                  2 * nr0);
                 /* Split the buffer into the two vectors */
                 int nn = n;
                 for (int dir = 1; dir >= 0; dir--)
@@ -282,11 +375,8 @@ void dd_move_x_specat(const gmx_domdec_t*       dd,
                     for (int v = 0; v < 2; v++)
                     {
                         gmx::RVec* x = (v == 0 ? x0 : x1);
-                        for (int i = 0; i < nr; i++)
-                        {
-                            x[nn + i] = *rbuf;
-                            rbuf++;
-                        }
+                        unpackCoordinates(rbuf, x + nn, nr);
+                        rbuf += nr;
                     }
                     nn += nr;
                 }
@@ -307,22 +397,13 @@ void dd_move_x_specat(const gmx_domdec_t*       dd,
                     /* Here we only perform the rotation, the rest of the pbc
                      * is handled in the constraint or viste routines.
                      */
-                    for (int a : spas->a)
-                    {
-                        (*vbuf)[XX] = x[a][XX];
-                        (*vbuf)[YY] = box[YY][YY] - x[a][YY];
-                        (*vbuf)[ZZ] = box[ZZ][ZZ] - x[a][ZZ];
-                        vbuf++;
-                    }
+                    packCoordinates(spas->a, x, vbuf, CoordinateTransform::ShiftAndRotate, { 0, 0, 0 }, box);
                 }
                 else
                 {
-                    for (int a : spas->a)
-                    {
-                        *vbuf = x[a];
-                        vbuf++;
-                    }
+                    packCoordinates(spas->a, x, vbuf, CoordinateTransform::Copy, shift, box);
                 }
+                vbuf += spas->a.size();
             }
             /* Send and receive the coordinates */
             if (nvec == 1)
@@ -348,11 +429,8 @@ void dd_move_x_specat(const gmx_domdec_t*       dd,
                 for (int v = 0; v < 2; v++)
                 {
                     gmx::RVec* x = (v == 0 ? x0 : x1);
-                    for (int i = 0; i < nr; i++)
-                    {
-                        x[n + i] = *rbuf;
-                        rbuf++;
-                    }
+                    unpackCoordinates(rbuf, x + n, nr);
+                    rbuf += nr;
                 }
             }
             n += spas->nrecv;
@@ -459,27 +537,34 @@ int setup_specat_communication(gmx_domdec_t*             dd,
             spas->a.clear();
             spac->ibuf.clear();
             nsend[0] = 0;
+            /* Look up the local indices of the requested atoms, -1 when not present.
+             * The lookups only read the index maps, so we can use threads.
+             */
+            spac->localIndices.resize(nr);
+            const gmx_ga2la_t& ga2la      = *dd->ga2la;
+            const int          numThreads = numThreadsForSpecialAtoms(nr);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
             for (int i = 0; i < nr; i++)
             {
                 const int indr = (*ireq)[start + i];
-                int       ind  = 0;
-                /* Check if this is a home atom and if so ind will be set */
-                if (const int* homeIndex = dd->ga2la->findHome(indr))
+                /* Check if this is a home atom, otherwise search in the communicated atoms */
+                if (const int* homeIndex = ga2la.findHome(indr))
+                {
+                    spac->localIndices[i] = *homeIndex;
+                }
+                else if (const int* a = ga2la_specat->find(indr))
                 {
-                    ind = *homeIndex;
+                    spac->localIndices[i] = *a;
                 }
                 else
                 {
-                    /* Search in the communicated atoms */
-                    if (const int* a = ga2la_specat->find(indr))
-                    {
-                        ind = *a;
-                    }
-                    else
-                    {
-                        ind = -1;
-                    }
+                    spac->localIndices[i] = -1;
                 }
+            }
+            for (int i = 0; i < nr; i++)
+            {
+                const int indr = (*ireq)[start + i];
+                const int ind  = spac->localIndices[i];
                 if (ind >= 0)
                 {
                     if (i < n0 || !spac->sendAtom[ind])
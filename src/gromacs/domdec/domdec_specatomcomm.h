@@ -77,11 +77,21 @@ struct gmx_domdec_specat_comm_t
     std::vector<int>       ibuf;  /**< Integer send buffer */
     std::vector<gmx::RVec> vbuf;  /**< rvec send buffer */
     std::vector<gmx::RVec> vbuf2; /**< rvec send buffer */
+    /* Work buffers for multi-threading */
+    std::vector<int>       localIndices;      /**< Local indices of requested atoms, -1 when absent */
+    std::vector<gmx::RVec> threadShiftForces; /**< Shift force contributions per thread */
     /* The range in the local buffer(s) for received atoms */
     int at_start; /**< Start index of received atoms */
     int at_end;   /**< End index of received atoms */
 };
 
+/*! \brief Returns the number of OpenMP threads to use for a loop over \p numElements special atoms
+ *
+ * Uses the DD thread count, but only as many threads as there is
+ * sufficient work for.
+ */
+int numThreadsForSpecialAtoms(int numElements);
+
 /*! \brief Communicates the force for special atoms, the shift forces are reduced with \p fshift != NULL */
 void dd_move_f_specat(const gmx_domdec_t* dd, gmx_domdec_specat_comm_t* spac, gmx::RVec* f, gmx::RVec* fshift);
 
@@ -208,6 +208,7 @@ struct gmx_domdec_t
     std::unique_ptr<gmx::HashedMap<int>>      ga2la_vsite;
     std::unique_ptr<gmx_domdec_specat_comm_t> vsite_comm;
     std::vector<int>                          vsite_requestedGlobalAtomIndices;
+    std::vector<std::vector<int>>             vsite_threadRequestedGlobalAtomIndices;
 
     /* Constraint stuff */
     std::unique_ptr<gmx_domdec_constraints_t> constraints;
@@ -58,6 +58,7 @@
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/mtop_util.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 
@@ -109,45 +110,103 @@ void dd_clear_local_vsite_indices(gmx_domdec_t* dd)
     }
 }
 
-int dd_make_local_vsites(gmx_domdec_t* dd, int at_start, gmx::ArrayRef<InteractionList> lil)
+//! Returns the number of vsites in \p lil
+static int numVsitesInLists(gmx::ArrayRef<const InteractionList> lil)
 {
-    std::vector<int>&    ireq         = dd->vsite_requestedGlobalAtomIndices;
-    gmx::HashedMap<int>* ga2la_specat = dd->ga2la_vsite.get();
-
-    ireq.clear();
-    /* Loop over all the home vsites */
+    int numVsites = 0;
     for (int ftype = 0; ftype < F_NRE; ftype++)
     {
         if (interaction_function[ftype].flags & IF_VSITE)
         {
-            const int              nral = NRAL(ftype);
-            const InteractionList& lilf = lil[ftype];
-            for (int i = 0; i < lilf.size(); i += 1 + nral)
+            numVsites += lil[ftype].size() / (1 + NRAL(ftype));
+        }
+    }
+
+    return numVsites;
+}
+
+void collectNonHomeVsiteAtoms(gmx::ArrayRef<const InteractionList> lil,
+                              gmx::ArrayRef<std::vector<int>>      threadRequests)
+{
+    const int numVsites  = numVsitesInLists(lil);
+    const int numThreads = threadRequests.ssize();
+
+    /* Each thread handles a range of the vsites of all types in order */
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            std::vector<int>& requests = threadRequests[thread];
+            requests.clear();
+            const int begin = (numVsites * thread) / numThreads;
+            const int end   = (numVsites * (thread + 1)) / numThreads;
+            /* The index of the first vsite of ftype in the order over all types */
+            int offset = 0;
+            for (int ftype = 0; ftype < F_NRE; ftype++)
             {
-                const int* iatoms = lilf.iatoms.data() + i;
-                /* Check if we have the other atoms */
-                for (int j = 1; j < 1 + nral; j++)
+                if (interaction_function[ftype].flags & IF_VSITE)
                 {
-                    if (iatoms[j] < 0)
+                    const int              nral       = NRAL(ftype);
+                    const InteractionList& lilf       = lil[ftype];
+                    const int              numEntries = lilf.size() / (1 + nral);
+                    const int              beginType  = std::max(begin - offset, 0);
+                    const int              endType    = std::min(end - offset, numEntries);
+                    for (int i = beginType; i < endType; i++)
                     {
-                        /* This is not a home atom,
-                         * we need to ask our neighbors.
-                         */
-                        int a = -iatoms[j] - 1;
-                        /* Check to not ask for the same atom more than once */
-                        if (!dd->ga2la_vsite->find(a))
+                        const int* iatoms = lilf.iatoms.data() + i * (1 + nral);
+                        /* Check if we have the other atoms */
+                        for (int j = 1; j < 1 + nral; j++)
                         {
-                            /* Add this non-home atom to the list */
-                            ireq.push_back(a);
-                            /* Temporarily mark with -2,
-                             * we get the index later.
-                             */
-                            ga2la_specat->insert(a, -2);
+                            if (iatoms[j] < 0)
+                            {
+                                /* This is not a home atom,
+                                 * we need to ask our neighbors.
+                                 */
+                                requests.push_back(-iatoms[j] - 1);
+                            }
                         }
                     }
+                    offset += numEntries;
                 }
             }
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+int dd_make_local_vsites(gmx_domdec_t* dd, int at_start, gmx::ArrayRef<InteractionList> lil)
+{
+    std::vector<int>&    ireq         = dd->vsite_requestedGlobalAtomIndices;
+    gmx::HashedMap<int>* ga2la_specat = dd->ga2la_vsite.get();
+
+    const int numThreads = numThreadsForSpecialAtoms(numVsitesInLists(lil));
+
+    std::vector<std::vector<int>>& threadRequests = dd->vsite_threadRequestedGlobalAtomIndices;
+    if (gmx::ssize(threadRequests) < numThreads)
+    {
+        threadRequests.resize(numThreads);
+    }
+
+    /* Loop over all the home vsites and collect the non-home atoms */
+    collectNonHomeVsiteAtoms(lil, gmx::arrayRefFromArray(threadRequests.data(), numThreads));
+
+    ireq.clear();
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        for (const int a : threadRequests[thread])
+        {
+            /* Check to not ask for the same atom more than once */
+            if (!ga2la_specat->find(a))
+            {
+                /* Add this non-home atom to the list */
+                ireq.push_back(a);
+                /* Temporarily mark with -2,
+                 * we get the index later.
+                 */
+                ga2la_specat->insert(a, -2);
+            }
+        }
     }
 
     int at_end = setup_specat_communication(
@@ -158,11 +217,14 @@ int dd_make_local_vsites(gmx_domdec_t* dd, int at_start, gmx::ArrayRef<Interacti
     {
         if (interaction_function[ftype].flags & IF_VSITE)
         {
-            const int        nral = NRAL(ftype);
-            InteractionList& lilf = lil[ftype];
-            for (int i = 0; i < lilf.size(); i += 1 + nral)
+            const int        nral             = NRAL(ftype);
+            InteractionList& lilf             = lil[ftype];
+            const int        numEntries       = lilf.size() / (1 + nral);
+            const int        numThreadsFillIn = numThreadsForSpecialAtoms(numEntries);
+#pragma omp parallel for num_threads(numThreadsFillIn) schedule(static)
+            for (int i = 0; i < numEntries; i++)
             {
-                t_iatom* iatoms = lilf.iatoms.data() + i;
+                t_iatom* iatoms = lilf.iatoms.data() + i * (1 + nral);
                 for (int j = 1; j < 1 + nral; j++)
                 {
                     if (iatoms[j] < 0)
@@ -43,6 +43,8 @@
 #ifndef GMX_DOMDEC_DOMDEC_VSITE_H
 #define GMX_DOMDEC_DOMDEC_VSITE_H
 
+#include <vector>
+
 #include "gromacs/utility/arrayref.h"
 
 struct gmx_domdec_t;
@@ -51,6 +53,16 @@ struct InteractionList;
 /*! \brief Clears the local indices for the virtual site communication setup */
 void dd_clear_local_vsite_indices(struct gmx_domdec_t* dd);
 
+/*! \brief Collects the global indices of the non-home constructing atoms of the vsites in \p lil
+ *
+ * The vsites of all types are split over the threads by their index in
+ * the order over all types, each thread stores its atoms in its entry of
+ * \p threadRequests. The concatenated lists of the threads thus have
+ * the same order for any number of threads. Atoms can occur more than once.
+ */
+void collectNonHomeVsiteAtoms(gmx::ArrayRef<const InteractionList> lil,
+                              gmx::ArrayRef<std::vector<int>>      threadRequests);
+
 /*! \brief Sets up communication and atom indices for all local vsites */
 int dd_make_local_vsites(struct gmx_domdec_t* dd, int at_start, gmx::ArrayRef<InteractionList> lil);
 
@@ -44,6 +44,10 @@
 
 #include "ga2la.h"
 
+#include <algorithm>
+
+#include "gromacs/utility/exceptions.h"
+
 /*! \brief Returns whether to use a direct list only
  *
  * There are two methods implemented for finding the local atom number
@@ -79,3 +83,49 @@ gmx_ga2la_t::gmx_ga2la_t(int numAtomsTotal, int numAtomsLocal) :
         new (&(data_.hashed)) gmx::HashedMap<Entry>(numAtomsLocal);
     }
 }
+
+void gmx_ga2la_t::insertConcurrently(gmx::ArrayRef<const int>   globalAtomIndices,
+                                     gmx::ArrayRef<const Entry> entries,
+                                     int                        numThreads)
+{
+    GMX_ASSERT(globalAtomIndices.size() == entries.size(), "Need as many entries as atoms");
+
+    /* Below this number of atoms per thread, the overhead of threading
+     * and of sorting the atoms over threads is larger than the gain.
+     */
+    constexpr int c_minNumAtomsPerThread = 1024;
+
+    numThreads = std::min(numThreads,
+                          static_cast<int>(globalAtomIndices.ssize() / c_minNumAtomsPerThread));
+    if (numThreads <= 1)
+    {
+        for (gmx::Index i = 0; i < globalAtomIndices.ssize(); i++)
+        {
+            insert(globalAtomIndices[i], entries[i]);
+        }
+    }
+    else if (usingDirect_)
+    {
+        /* Each global atom has its own entry, so we can insert directly */
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (gmx::Index i = 0; i < globalAtomIndices.ssize(); i++)
+        {
+            insert(globalAtomIndices[i], entries[i]);
+        }
+    }
+    else
+    {
+        data_.hashed.insertConcurrently(
+                globalAtomIndices, entries, numThreads, [numThreads](const auto& task) {
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+                    for (int thread = 0; thread < numThreads; thread++)
+                    {
+                        try
+                        {
+                            task(thread);
+                        }
+                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                    }
+                });
+    }
+}
@@ -48,6 +48,7 @@
 #include <vector>
 
 #include "gromacs/domdec/hashedmap.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/gmxassert.h"
 
 /*! \libinternal \brief Global to local atom mapping
@@ -93,6 +94,18 @@ public:
         }
     }
 
+    /*! \brief Inserts entries for a list of global atoms using multiple OpenMP threads
+     *
+     * There should not already be entries for any of the global atoms.
+     *
+     * \param[in] globalAtomIndices  The global atom indices
+     * \param[in] entries            The entries for the global atoms
+     * \param[in] numThreads         The number of OpenMP threads to use
+     */
+    void insertConcurrently(gmx::ArrayRef<const int>   globalAtomIndices,
+                            gmx::ArrayRef<const Entry> entries,
+                            int                        numThreads);
+
     //! Delete the entry for global atom a_gl
     void erase(int a_gl)
     {
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief This file defines a codec for reduced-precision halo coordinates.
+ *
+ * \ingroup module_domdec
+ */
+
+#include "gmxpre.h"
+
+#include "halocoordinatecodec.h"
+
+#include <cstring>
+
+#include <algorithm>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxassert.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! The number of reals in the header: the lower corner and the step size
+constexpr int c_numHeaderReals = 2 * DIM;
+
+//! The size in bytes of the header
+constexpr size_t c_headerSize = c_numHeaderReals * sizeof(real);
+
+} // namespace
+
+HaloCoordinateCodec::HaloCoordinateCodec(int numBitsPerCoordinate) :
+    numBitsPerCoordinate_(numBitsPerCoordinate),
+    numBytesPerAtom_((DIM * numBitsPerCoordinate + 7) / 8),
+    maxValue_((uint64_t(1) << numBitsPerCoordinate) - 1)
+{
+    GMX_RELEASE_ASSERT(numBitsPerCoordinate >= 1 && DIM * numBitsPerCoordinate <= 64,
+                       "The coordinates of an atom should fit in 64 bits");
+}
+
+real HaloCoordinateCodec::maxError(real extent) const
+{
+    /* Rounding to the nearest fixed-point value gives an error of at most half a step */
+    return 0.5 * extent / static_cast<real>(maxValue_);
+}
+
+int haloCoordinateCompressionBits(real extent, int numEncodings, real maxError)
+{
+    for (int numBits : { 16, 21 })
+    {
+        if (numEncodings * HaloCoordinateCodec(numBits).maxError(extent) <= maxError)
+        {
+            return numBits;
+        }
+    }
+
+    return 0;
+}
+
+size_t HaloCoordinateCodec::encodedSize(int numCoordinates) const
+{
+    return (numCoordinates > 0 ? c_headerSize + size_t(numCoordinates) * numBytesPerAtom_ : 0);
+}
+
+void HaloCoordinateCodec::encode(ArrayRef<const RVec> x, ArrayRef<uint8_t> buffer) const
+{
+    GMX_ASSERT(buffer.size() == encodedSize(x.ssize()), "The buffer should match the encoded size");
+
+    if (x.empty())
+    {
+        return;
+    }
+
+    RVec lower = x[0];
+    RVec upper = x[0];
+    for (const RVec& coordinates : x)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            lower[d] = std::min(lower[d], coordinates[d]);
+            upper[d] = std::max(upper[d], coordinates[d]);
+        }
+    }
+
+    real header[c_numHeaderReals];
+    RVec invStep;
+    for (int d = 0; d < DIM; d++)
+    {
+        const real step = (upper[d] - lower[d]) / static_cast<real>(maxValue_);
+        header[d]       = lower[d];
+        header[DIM + d] = step;
+        invStep[d]      = (step > 0 ? 1 / step : 0);
+    }
+    std::memcpy(buffer.data(), header, c_headerSize);
+
+    uint8_t* data = buffer.data() + c_headerSize;
+    for (const RVec& coordinates : x)
+    {
+        uint64_t packed = 0;
+        for (int d = 0; d < DIM; d++)
+        {
+            /* Round to the nearest value, the minimum guards against rounding errors */
+            const uint64_t value =
+                    static_cast<uint64_t>((coordinates[d] - lower[d]) * invStep[d] + real(0.5));
+            packed |= std::min(value, maxValue_) << (d * numBitsPerCoordinate_);
+        }
+        for (int b = 0; b < numBytesPerAtom_; b++)
+        {
+            data[b] = static_cast<uint8_t>(packed >> (8 * b));
+        }
+        data += numBytesPerAtom_;
+    }
+}
+
+void HaloCoordinateCodec::decode(ArrayRef<const uint8_t> buffer, ArrayRef<RVec> x) const
+{
+    GMX_ASSERT(buffer.size() == encodedSize(x.ssize()), "The buffer should match the encoded size");
+
+    if (x.empty())
+    {
+        return;
+    }
+
+    real header[c_numHeaderReals];
+    std::memcpy(header, buffer.data(), c_headerSize);
+
+    const uint8_t* data = buffer.data() + c_headerSize;
+    for (RVec& coordinates : x)
+    {
+        uint64_t packed = 0;
+        for (int b = 0; b < numBytesPerAtom_; b++)
+        {
+            packed |= uint64_t(data[b]) << (8 * b);
+        }
+        for (int d = 0; d < DIM; d++)
+        {
+            const uint64_t value = (packed >> (d * numBitsPerCoordinate_)) & maxValue_;
+            coordinates[d]       = header[d] + value * header[DIM + d];
+        }
+        data += numBytesPerAtom_;
+    }
+}
+
+} // namespace gmx
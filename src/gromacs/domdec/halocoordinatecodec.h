@@ -0,0 +1,118 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief This file declares a codec for reduced-precision halo coordinates.
+ *
+ * \ingroup module_domdec
+ */
+
+#ifndef GMX_DOMDEC_HALOCOORDINATECODEC_H
+#define GMX_DOMDEC_HALOCOORDINATECODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+template<typename>
+class ArrayRef;
+
+/*! \internal \brief Encodes and decodes halo coordinates as fixed-point offsets
+ *
+ * The coordinates are stored as offsets with respect to the lower corner
+ * of their bounding box, with \p numBitsPerCoordinate bits per dimension.
+ * The bounding box corner and the step size of the fixed-point values
+ * are stored at the start of the encoded buffer, so the decoding side
+ * only needs to know the number of coordinates.
+ * With 21 bits, three coordinates fit into 8 bytes instead of 12 bytes
+ * for single precision floats, with 16 bits they fit into 6 bytes.
+ */
+class HaloCoordinateCodec
+{
+public:
+    /*! \brief Constructor
+     *
+     * \param[in] numBitsPerCoordinate  The number of bits per coordinate, between 1 and 21
+     */
+    explicit HaloCoordinateCodec(int numBitsPerCoordinate);
+
+    //! Returns the number of bits per coordinate
+    int numBitsPerCoordinate() const { return numBitsPerCoordinate_; }
+
+    //! Returns the maximum error, apart from rounding, for coordinates spanning at most \p extent
+    real maxError(real extent) const;
+
+    //! Returns the size in bytes of \p numCoordinates encoded coordinates
+    size_t encodedSize(int numCoordinates) const;
+
+    /*! \brief Encodes the coordinates in \p x into \p buffer
+     *
+     * \param[in]  x       The coordinates
+     * \param[out] buffer  The encoded coordinates, size should be encodedSize(x.size())
+     */
+    void encode(ArrayRef<const RVec> x, ArrayRef<uint8_t> buffer) const;
+
+    /*! \brief Decodes the coordinates in \p buffer into \p x
+     *
+     * \param[in]  buffer  The encoded coordinates, size should be encodedSize(x.size())
+     * \param[out] x       The decoded coordinates
+     */
+    void decode(ArrayRef<const uint8_t> buffer, ArrayRef<RVec> x) const;
+
+private:
+    //! The number of bits per coordinate
+    int numBitsPerCoordinate_;
+    //! The number of bytes for the three coordinates of an atom
+    int numBytesPerAtom_;
+    //! The maximum fixed-point value
+    uint64_t maxValue_;
+};
+
+/*! \brief Returns the number of bits per coordinate that give at most \p maxError
+ *
+ * Forwarded halo coordinates are decoded and encoded again at every pulse,
+ * so the errors of up to \p numEncodings encodings of coordinates spanning
+ * at most \p extent add up.
+ *
+ * \returns 16 or 21, or 0 when 21 bits do not give sufficient precision
+ */
+int haloCoordinateCompressionBits(real extent, int numEncodings, real maxError);
+
+} // namespace gmx
+
+#endif
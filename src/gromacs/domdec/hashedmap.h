@@ -47,12 +47,14 @@
 #define GMX_DOMDEC_HASHEDMAP_H
 
 #include <climits>
+#include <cstdint>
 
 #include <algorithm>
 #include <utility>
 #include <vector>
 
 #include "gromacs/compat/utility.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/exceptions.h"
 
@@ -219,6 +221,143 @@ public:
      */
     void insert_or_assign(int key, const T& value) { insert_assign<true>(key, value); }
 
+    /*! \brief Inserts entries using multiple, possibly concurrent, tasks; keys should not be present
+     *
+     * The hash buckets are divided into \p numTasks contiguous ranges,
+     * each owned by one task. The keys are sorted by owner, after which
+     * each task stores its keys in the buckets it owns and puts the keys
+     * that collide in its own block of list entries appended to the table.
+     * Thus no entry is ever written by more than one task and no locks
+     * or atomic operations are needed. Lookups give the same results as
+     * after inserting the keys one by one with insert().
+     *
+     * \tparam    TaskRunner  Callable taking a callable \c task, which should call \c task(t) for all t in [0, \p numTasks), possibly concurrently, and return when all calls have completed
+     * \param[in] keys      The keys to insert, should be >= 0
+     * \param[in] values    The values for the keys
+     * \param[in] numTasks  The number of tasks to divide the work over
+     * \param[in] runTasks  Runs the tasks
+     */
+    template<typename TaskRunner>
+    void insertConcurrently(ArrayRef<const int> keys, ArrayRef<const T> values, int numTasks, TaskRunner runTasks)
+    {
+        GMX_RELEASE_ASSERT(keys.size() == values.size(), "Need as many values as keys");
+        GMX_RELEASE_ASSERT(numTasks >= 1, "Need at least one task");
+
+        const int numKeys        = keys.ssize();
+        const int bucketsPerTask = (bucket_count() + numTasks - 1) / numTasks;
+
+        /* Remove unused list entries at the end of the table, so the new
+         * list entries of all tasks can be appended after the used ones.
+         */
+        while (table_.size() > static_cast<size_t>(bucket_count()) && table_.back().key < 0)
+        {
+            table_.pop_back();
+        }
+        startIndexForSpaceForListEntry_ =
+                std::min(startIndexForSpaceForListEntry_, static_cast<int>(table_.size()));
+
+        /* For each pair of task and owner, the number of keys in the key
+         * range of the task with buckets of the owner, which is converted
+         * to the offset in the list of key indices sorted by owner
+         */
+        concurrentInsertOffsets_.assign(numTasks * numTasks, 0);
+        concurrentInsertOrder_.resize(numKeys);
+        concurrentInsertOwnerStart_.resize(numTasks + 1);
+        concurrentInsertListStart_.resize(numTasks + 1);
+
+        const auto keyRangeBegin = [numKeys, numTasks](int task) {
+            return static_cast<int>((static_cast<int64_t>(numKeys) * task) / numTasks);
+        };
+
+        /* Count the keys per owner in the key range of each task */
+        runTasks([&](int task) {
+            int* counts = concurrentInsertOffsets_.data() + task * numTasks;
+            for (int i = keyRangeBegin(task); i < keyRangeBegin(task + 1); i++)
+            {
+                GMX_ASSERT(keys[i] >= 0, "Only keys >= 0 are supported");
+                counts[(keys[i] & bitMask_) / bucketsPerTask]++;
+            }
+        });
+
+        /* Convert the counts to offsets, ordered by owner and then by task */
+        int offset = 0;
+        for (int owner = 0; owner < numTasks; owner++)
+        {
+            concurrentInsertOwnerStart_[owner] = offset;
+            for (int task = 0; task < numTasks; task++)
+            {
+                const int count = concurrentInsertOffsets_[task * numTasks + owner];
+                concurrentInsertOffsets_[task * numTasks + owner] = offset;
+                offset += count;
+            }
+        }
+        concurrentInsertOwnerStart_[numTasks] = offset;
+
+        /* Sort the key indices by owner, the order within an owner is preserved */
+        runTasks([&](int task) {
+            int* offsets = concurrentInsertOffsets_.data() + task * numTasks;
+            for (int i = keyRangeBegin(task); i < keyRangeBegin(task + 1); i++)
+            {
+                concurrentInsertOrder_[offsets[(keys[i] & bitMask_) / bucketsPerTask]++] = i;
+            }
+        });
+
+        /* Each owner stores its keys in its free buckets. The indices of
+         * the keys that collide are compacted at the start of the owner range.
+         */
+        runTasks([&](int owner) {
+            const int ownerStart    = concurrentInsertOwnerStart_[owner];
+            int       numCollisions = 0;
+            for (int j = ownerStart; j < concurrentInsertOwnerStart_[owner + 1]; j++)
+            {
+                const int  i     = concurrentInsertOrder_[j];
+                hashEntry& entry = table_[keys[i] & bitMask_];
+                GMX_ASSERT(entry.key != keys[i], "The key to be inserted should not be present");
+                if (entry.key < 0)
+                {
+                    entry.key   = keys[i];
+                    entry.value = values[i];
+                }
+                else
+                {
+                    concurrentInsertOrder_[ownerStart + numCollisions++] = i;
+                }
+            }
+            concurrentInsertListStart_[owner + 1] = numCollisions;
+        });
+
+        /* Append a block of list entries for each owner to the table */
+        concurrentInsertListStart_[0] = table_.size();
+        for (int owner = 0; owner < numTasks; owner++)
+        {
+            concurrentInsertListStart_[owner + 1] += concurrentInsertListStart_[owner];
+        }
+        table_.resize(concurrentInsertListStart_[numTasks]);
+
+        /* Each owner links the colliding keys to the lists of its buckets */
+        runTasks([&](int owner) {
+            const int ownerStart = concurrentInsertOwnerStart_[owner];
+            int       listIndex  = concurrentInsertListStart_[owner];
+            for (int j = ownerStart; listIndex < concurrentInsertListStart_[owner + 1]; j++)
+            {
+                const int i   = concurrentInsertOrder_[j];
+                int       ind = (keys[i] & bitMask_);
+                while (table_[ind].next >= 0)
+                {
+                    ind = table_[ind].next;
+                    GMX_ASSERT(table_[ind].key != keys[i],
+                               "The key to be inserted should not be present");
+                }
+                table_[listIndex].key   = keys[i];
+                table_[listIndex].value = values[i];
+                table_[ind].next        = listIndex;
+                listIndex++;
+            }
+        });
+
+        numElements_ += numKeys;
+    }
+
     /*! \brief Delete the entry for key \p key, when present
      *
      * \param[in] key  The key
@@ -328,6 +467,14 @@ private:
     int startIndexForSpaceForListEntry_ = 0;
     /*! \brief The number of elements currently stored in the table */
     int numElements_ = 0;
+    /*! \brief Work buffer for insertConcurrently(), offsets per task and owner */
+    std::vector<int> concurrentInsertOffsets_;
+    /*! \brief Work buffer for insertConcurrently(), key indices sorted by owner */
+    std::vector<int> concurrentInsertOrder_;
+    /*! \brief Work buffer for insertConcurrently(), start of each owner in the sorted key indices */
+    std::vector<int> concurrentInsertOwnerStart_;
+    /*! \brief Work buffer for insertConcurrently(), start of the list entries of each owner */
+    std::vector<int> concurrentInsertListStart_;
 };
 
 } // namespace gmx
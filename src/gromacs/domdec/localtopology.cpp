@@ -46,7 +46,9 @@
 #include "gromacs/domdec/localtopology.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <numeric>
 #include <vector>
 
 #include "gromacs/domdec/domdec_internal.h"
@@ -64,6 +66,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/topology/topsort.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/listoflists.h"
@@ -943,6 +946,208 @@ static int make_local_bondeds_excls(const gmx_domdec_t&       dd,
     return numBondedInteractions;
 }
 
+/*! \brief Renumbers the atoms in \p il and orders the interactions by their first atom
+ *
+ * The interactions are stored under their first atom in the reverse
+ * topology, so this gives the same order as make_local_bondeds_excls().
+ * The sort is stable, so interactions with the same first atom keep
+ * their relative order.
+ */
+static void renumberAndSortInteractions(InteractionList* il, int nral, ArrayRef<const int> newLocalIndex)
+{
+    const int numInteractions = il->size() / (1 + nral);
+    if (numInteractions == 0)
+    {
+        return;
+    }
+
+    std::vector<int>& iatoms = il->iatoms;
+    for (int i = 0; i < numInteractions; i++)
+    {
+        for (int a = 1; a <= nral; a++)
+        {
+            iatoms[i * (1 + nral) + a] = newLocalIndex[iatoms[i * (1 + nral) + a]];
+        }
+    }
+
+    std::vector<int> order(numInteractions);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&iatoms, nral](int i, int j) {
+        return iatoms[i * (1 + nral) + 1] < iatoms[j * (1 + nral) + 1];
+    });
+
+    std::vector<int> sortedIatoms(iatoms.size());
+    for (int i = 0; i < numInteractions; i++)
+    {
+        std::copy_n(iatoms.begin() + order[i] * (1 + nral), 1 + nral, sortedIatoms.begin() + i * (1 + nral));
+    }
+    iatoms.swap(sortedIatoms);
+}
+
+/*! \brief Updates the local topology of a single domain for the current local atom order
+ *
+ * With a single domain all interactions and exclusions are assigned to
+ * the local domain, so the local topology only changes by a permutation
+ * of the atom indices between partitionings. We renumber the previous
+ * local topology instead of generating it again from the reverse
+ * topology. This gives the same topology as make_local_bondeds_excls()
+ * at a fraction of the cost.
+ *
+ * \returns Whether the update could be done, when not, the local topology should be generated
+ */
+static bool updateSingleDomainLocalTopology(ArrayRef<const int>            globalAtomIndices,
+                                            const gmx_ga2la_t&             ga2la,
+                                            const ReverseTopOptions&       rtOptions,
+                                            int                            numThreads,
+                                            const LocalTopologyUpdateData& updateData,
+                                            gmx_localtop_t*                ltop)
+{
+    const int numAtoms = globalAtomIndices.ssize();
+
+    if (updateData.localTopology != ltop || gmx::ssize(updateData.globalAtomIndices) != numAtoms
+        || !(ltop->excls.empty() || ltop->excls.ssize() == numAtoms))
+    {
+        return false;
+    }
+
+    // The new local index for each previous local index and the reverse
+    std::vector<int> newLocalIndex(numAtoms);
+    std::vector<int> previousLocalIndex(numAtoms);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        const auto* entry = ga2la.find(updateData.globalAtomIndices[a]);
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        newLocalIndex[a]              = entry->la;
+        previousLocalIndex[entry->la] = a;
+    }
+
+    InteractionDefinitions* idef = &ltop->idef;
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        try
+        {
+            if ((ftype == F_CONSTR && !rtOptions.includeConstraints_)
+                || (ftype == F_SETTLE && !rtOptions.includeSettles_))
+            {
+                /* These are not in the reverse topology, but are assigned
+                 * by dd_make_local_constraints() after this call.
+                 */
+                idef->il[ftype].clear();
+            }
+            else
+            {
+                renumberAndSortInteractions(&idef->il[ftype], NRAL(ftype), newLocalIndex);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    if (!ltop->excls.empty())
+    {
+        const ListOfLists<int>& excls = ltop->excls;
+
+        std::vector<int> listRanges(numAtoms + 1);
+        listRanges[0] = 0;
+        for (int a = 0; a < numAtoms; a++)
+        {
+            listRanges[a + 1] = listRanges[a] + excls[previousLocalIndex[a]].ssize();
+        }
+        std::vector<int> elements(listRanges[numAtoms]);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int a = 0; a < numAtoms; a++)
+        {
+            int pos = listRanges[a];
+            for (const int excludedAtom : excls[previousLocalIndex[a]])
+            {
+                elements[pos++] = newLocalIndex[excludedAtom];
+            }
+        }
+        ltop->excls = ListOfLists<int>(std::move(listRanges), std::move(elements));
+    }
+
+    return true;
+}
+
+/*! \brief Returns whether the interaction lists \p a and \p b are identical
+ *
+ * Position restraint parameters are local, so for those the parameters
+ * are compared instead of the parameter indices.
+ */
+static bool interactionListsAreEqual(const InteractionDefinitions& a, const InteractionDefinitions& b, int ftype)
+{
+    const std::vector<int>& iatomsA = a.il[ftype].iatoms;
+    const std::vector<int>& iatomsB = b.il[ftype].iatoms;
+    if (iatomsA.size() != iatomsB.size())
+    {
+        return false;
+    }
+    if (ftype != F_POSRES && ftype != F_FBPOSRES)
+    {
+        return iatomsA == iatomsB;
+    }
+
+    const int                     nral     = NRAL(ftype);
+    const std::vector<t_iparams>& iparamsA = (ftype == F_POSRES ? a.iparams_posres : a.iparams_fbposres);
+    const std::vector<t_iparams>& iparamsB = (ftype == F_POSRES ? b.iparams_posres : b.iparams_fbposres);
+    for (size_t i = 0; i < iatomsA.size(); i += 1 + nral)
+    {
+        if (!std::equal(iatomsA.begin() + i + 1, iatomsA.begin() + i + 1 + nral, iatomsB.begin() + i + 1)
+            || std::memcmp(&iparamsA[iatomsA[i]], &iparamsB[iatomsB[i]], sizeof(t_iparams)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! \brief Checks that the updated local topology \p ltop matches the generated \p reference
+ *
+ * Produces a fatal error when the topologies differ.
+ */
+static void checkUpdatedLocalTopology(const InteractionDefinitions& reference,
+                                      const ListOfLists<int>&       referenceExcls,
+                                      const gmx_localtop_t&         ltop)
+{
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        if (!interactionListsAreEqual(ltop.idef, reference, ftype))
+        {
+            gmx_fatal(FARGS,
+                      "The updated local topology differs from the generated local topology for "
+                      "interaction type %s",
+                      interaction_function[ftype].longname);
+        }
+    }
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        if (reference.ilsort == ilsortFE_SORTED && (interaction_function[ftype].flags & IF_BOND)
+            && ltop.idef.numNonperturbedInteractions[ftype] != reference.numNonperturbedInteractions[ftype])
+        {
+            gmx_fatal(FARGS,
+                      "The updated local topology has a different number of unperturbed "
+                      "interactions than the generated local topology for interaction type %s",
+                      interaction_function[ftype].longname);
+        }
+    }
+    bool exclusionsAreEqual = (ltop.excls.ssize() == referenceExcls.ssize());
+    for (gmx::Index a = 0; a < referenceExcls.ssize() && exclusionsAreEqual; a++)
+    {
+        const auto excls         = ltop.excls[a];
+        const auto referenceList = referenceExcls[a];
+        exclusionsAreEqual       = (excls.size() == referenceList.size()
+                              && std::equal(excls.begin(), excls.end(), referenceList.begin()));
+    }
+    if (!exclusionsAreEqual)
+    {
+        gmx_fatal(FARGS, "The updated local exclusions differ from the generated local exclusions");
+    }
+}
+
 int dd_make_local_top(const gmx_domdec_t&          dd,
                       const gmx_domdec_zones_t&    zones,
                       int                          npbcdim,
@@ -1020,7 +1225,28 @@ int dd_make_local_top(const gmx_domdec_t&          dd,
         }
     }
 
-    int numBondedInteractionsToReduce = make_local_bondeds_excls(dd,
+    /* With a single domain we can reuse the previous local topology */
+    const bool               haveSingleDomain = (zones.n == 1);
+    LocalTopologyUpdateData* updateData       = dd.reverse_top->localTopologyUpdateData();
+    ArrayRef<const int>      globalAtomIndices =
+            gmx::constArrayRefFromArray(dd.globalAtomIndices.data(), zones.cg_range[zones.n]);
+
+    int  numBondedInteractionsToReduce = 0;
+    bool haveUpdatedLocalTopology      = false;
+    if (haveSingleDomain
+        && updateSingleDomainLocalTopology(globalAtomIndices,
+                                           *dd.ga2la,
+                                           dd.reverse_top->options(),
+                                           dd.reverse_top->threadWorkObjects().ssize(),
+                                           *updateData,
+                                           ltop))
+    {
+        numBondedInteractionsToReduce = updateData->numBondedInteractions;
+        haveUpdatedLocalTopology      = true;
+    }
+    else
+    {
+        numBondedInteractionsToReduce = make_local_bondeds_excls(dd,
                                                                  zones,
                                                                  mtop,
                                                                  fr->atomInfo,
@@ -1032,6 +1258,18 @@ int dd_make_local_top(const gmx_domdec_t&          dd,
                                                                  coordinates,
                                                                  &ltop->idef,
                                                                  &ltop->excls);
+    }
+
+    if (haveSingleDomain)
+    {
+        updateData->localTopology = ltop;
+        updateData->globalAtomIndices.assign(globalAtomIndices.begin(), globalAtomIndices.end());
+        updateData->numBondedInteractions = numBondedInteractionsToReduce;
+    }
+    else
+    {
+        updateData->localTopology = nullptr;
+    }
 
     if (dd.reverse_top->doListedForcesSorting())
     {
@@ -1042,5 +1280,36 @@ int dd_make_local_top(const gmx_domdec_t&          dd,
         ltop->idef.ilsort = ilsortNO_FE;
     }
 
+    if (haveUpdatedLocalTopology && updateData->checkUpdate)
+    {
+        InteractionDefinitions referenceIdef(mtop.ffparams);
+        ListOfLists<int>       referenceExcls;
+        const int              numBondedInteractions = make_local_bondeds_excls(dd,
+                                                                   zones,
+                                                                   mtop,
+                                                                   fr->atomInfo,
+                                                                   checkDistanceMultiBody,
+                                                                   rcheck,
+                                                                   checkDistanceTwoBody,
+                                                                   rc,
+                                                                   pbc_null,
+                                                                   coordinates,
+                                                                   &referenceIdef,
+                                                                   &referenceExcls);
+        if (dd.reverse_top->doListedForcesSorting())
+        {
+            gmx_sort_ilist_fe(&referenceIdef, atomInfo);
+        }
+        if (numBondedInteractions != numBondedInteractionsToReduce)
+        {
+            gmx_fatal(FARGS,
+                      "The updated local topology has %d bonded interactions, whereas the "
+                      "generated local topology has %d",
+                      numBondedInteractionsToReduce,
+                      numBondedInteractions);
+        }
+        checkUpdatedLocalTopology(referenceIdef, referenceExcls, *ltop);
+    }
+
     return numBondedInteractionsToReduce;
 }
@@ -47,6 +47,7 @@
 #include "config.h"
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 
 #include <algorithm>
@@ -510,36 +511,40 @@ static void make_dd_indices(gmx_domdec_t* dd, const int atomStart)
     }
 
     /* Make the local to global and global to local atom index */
-    int a = atomStart;
-    globalAtomIndices.resize(a);
-    for (int zone = 0; zone < numZones; zone++)
+    const int numAtoms = zone2cg[numZones];
+    globalAtomIndices.resize(numAtoms);
+    std::vector<gmx_ga2la_t::Entry>& ga2laEntries = dd->comm->ga2laEntryBuffer;
+    ga2laEntries.resize(numAtoms - atomStart);
+
+    const int numThreads = gmx_omp_nthreads_get(ModuleMultiThread::Domdec);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
     {
-        int cg0;
-        if (zone == 0)
-        {
-            cg0 = atomStart;
-        }
-        else
-        {
-            cg0 = zone2cg[zone];
-        }
-        int cg1    = zone2cg[zone + 1];
-        int cg1_p1 = cg0 + zone_ncg1[zone];
+        const int atomBegin = atomStart + ((numAtoms - atomStart) * int64_t(thread)) / numThreads;
+        const int atomEnd   = atomStart + ((numAtoms - atomStart) * int64_t(thread + 1)) / numThreads;
 
-        for (int cg = cg0; cg < cg1; cg++)
+        int zone = 0;
+        for (int a = atomBegin; a < atomEnd; a++)
         {
+            while (a >= zone2cg[zone + 1])
+            {
+                zone++;
+            }
             int zone1 = zone;
-            if (cg >= cg1_p1)
+            if (a >= zone2cg[zone] + zone_ncg1[zone])
             {
                 /* Signal that this cg is from more than one pulse away */
                 zone1 += numZones;
             }
-            int cg_gl = globalAtomGroupIndices[cg];
-            globalAtomIndices.push_back(cg_gl);
-            ga2la.insert(cg_gl, { a, zone1 });
-            a++;
+            globalAtomIndices[a]        = globalAtomGroupIndices[a];
+            ga2laEntries[a - atomStart] = { a, zone1 };
         }
     }
+
+    ga2la.insertConcurrently(
+            gmx::constArrayRefFromArray(globalAtomIndices.data() + atomStart, numAtoms - atomStart),
+            ga2laEntries,
+            numThreads);
 }
 
 //! Checks whether global and local atom indices are consistent.
@@ -1268,7 +1273,7 @@ static void turn_on_dlb(const gmx::MDLogger& mdlog, gmx_domdec_t* dd, int64_t st
 
     /* We can set the required cell size info here,
      * so we do not need to communicate this.
-     * The grid is completely uniform.
+     * The grid is the same for all rows: uniform or the static grid.
      */
     for (int d = 0; d < dd->ndim; d++)
     {
@@ -1278,17 +1283,30 @@ static void turn_on_dlb(const gmx::MDLogger& mdlog, gmx_domdec_t* dd, int64_t st
         {
             comm->load[d].sum_m = comm->load[d].sum;
 
+            const std::vector<real>& staticFractions = comm->slb_frac[dd->dim[d]];
+
             int nc = dd->numCells[dd->dim[d]];
             for (int i = 0; i < nc; i++)
             {
-                rowCoordinator->cellFrac[i] = i / static_cast<real>(nc);
-                if (d > 0)
+                if (staticFractions.empty())
                 {
-                    rowCoordinator->bounds[i].cellFracLowerMax = i / static_cast<real>(nc);
-                    rowCoordinator->bounds[i].cellFracUpperMin = (i + 1) / static_cast<real>(nc);
+                    rowCoordinator->cellFrac[i] = i / static_cast<real>(nc);
+                }
+                else
+                {
+                    rowCoordinator->cellFrac[i] =
+                            (i == 0 ? 0 : rowCoordinator->cellFrac[i - 1] + staticFractions[i - 1]);
                 }
             }
             rowCoordinator->cellFrac[nc] = 1.0;
+            if (d > 0)
+            {
+                for (int i = 0; i < nc; i++)
+                {
+                    rowCoordinator->bounds[i].cellFracLowerMax = rowCoordinator->cellFrac[i];
+                    rowCoordinator->bounds[i].cellFracUpperMin = rowCoordinator->cellFrac[i + 1];
+                }
+            }
         }
     }
 }
@@ -2743,6 +2761,75 @@ void print_dd_statistics(const t_commrec* cr, const t_inputrec& inputrec, FILE*
     }
 }
 
+/*! \brief Sets the precision of the halo coordinates for the current box and number of pulses
+ *
+ * Forwarded halo coordinates are encoded again at every pulse, so the
+ * error bound is multiplied by the total number of pulses. The box and
+ * the number of pulses can change at every partitioning, so we check
+ * the precision every time. Both only depend on global data, so all
+ * ranks choose the same number of bits.
+ */
+static void updateHaloCoordinateCodec(const gmx::MDLogger& mdlog, gmx_domdec_t* dd, const matrix box)
+{
+    gmx_domdec_comm_t* comm = dd->comm.get();
+
+    /* Margin on the box size for the extent of the coordinates in one pulse,
+     * which covers periodic shifts and box changes until the next partitioning
+     */
+    constexpr real c_extentMargin = 1.5;
+
+    real maxExtent = 0;
+    for (int d = 0; d < DIM; d++)
+    {
+        real extent = 0;
+        for (int j = 0; j < DIM; j++)
+        {
+            extent += std::fabs(box[j][d]);
+        }
+        maxExtent = std::max(maxExtent, extent);
+    }
+    maxExtent *= c_extentMargin;
+
+    int numPulses = 0;
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        numPulses += comm->cd[d].numPulses();
+    }
+
+    const int numBits = gmx::haloCoordinateCompressionBits(
+            maxExtent, numPulses, comm->ddSettings.haloCoordinateMaxError);
+
+    if (numBits == comm->haloCoordinateNumBits)
+    {
+        return;
+    }
+    comm->haloCoordinateNumBits = numBits;
+
+    if (numBits > 0)
+    {
+        comm->haloCoordinateCodec = std::make_unique<gmx::HaloCoordinateCodec>(numBits);
+        GMX_LOG(mdlog.info)
+                .appendTextFormatted(
+                        "Will send halo coordinates with %d bits per dimension, the maximum "
+                        "error over %d pulse%s is %.1e nm",
+                        numBits,
+                        numPulses,
+                        numPulses == 1 ? "" : "s",
+                        numPulses * comm->haloCoordinateCodec->maxError(maxExtent));
+    }
+    else
+    {
+        comm->haloCoordinateCodec.reset();
+        GMX_LOG(mdlog.info)
+                .appendTextFormatted(
+                        "NOTE: Sending halo coordinates in full precision, as 21 bits per "
+                        "dimension do not give sufficient precision for this box size with %d "
+                        "pulse%s",
+                        numPulses,
+                        numPulses == 1 ? "" : "s");
+    }
+}
+
 //!\brief TODO Remove fplog when group scheme and charge groups are gone
 void dd_partition_system(FILE*                     fplog,
                          const gmx::MDLogger&      mdlog,
@@ -3043,6 +3130,11 @@ void dd_partition_system(FILE*                     fplog,
 
     set_dd_cell_sizes(dd, &ddbox, dd->unitCellInfo.ddBoxIsDynamic, bMainState, bDoDLB, step, wcycle);
 
+    if (comm->ddSettings.haloCoordinateMaxError > 0)
+    {
+        updateHaloCoordinateCodec(mdlog, dd, state_local->box);
+    }
+
     if (comm->ddSettings.nstDDDumpGrid > 0 && step % comm->ddSettings.nstDDDumpGrid == 0)
     {
         write_dd_grid_pdb("dd_grid", step, dd, state_local->box, &ddbox);
@@ -3117,6 +3209,7 @@ void dd_partition_system(FILE*                     fplog,
 
         set_zones_size(dd, state_local->box, &ddbox, 0, 1, ncg_moved);
 
+        fr->nbv->setUseHilbertCurveAtomOrder(dd->comm->ddSettings.useHilbertCurveAtomOrder);
         nbnxn_put_on_grid(fr->nbv.get(),
                           state_local->box,
                           0,
@@ -45,6 +45,9 @@
 
 #include <cstring>
 
+#include <array>
+#include <vector>
+
 #include "gromacs/domdec/domdec_network.h"
 #include "gromacs/domdec/ga2la.h"
 #include "gromacs/gmxlib/nrnb.h"
@@ -80,47 +83,82 @@ static inline int DD_FLAG_BW(int d)
     return 1 << (16 + d * 2 + 1);
 }
 
-static void copyMovedAtomsToBufferPerAtom(gmx::ArrayRef<const int> move,
-                                          int                      nvec,
-                                          int                      vec,
-                                          rvec*                    src,
-                                          gmx_domdec_comm_t*       comm)
+/*! \brief Returns the index in the DIM*2 communication buffers for a move flag computed
+ * by computeMoveFlag() */
+static inline int moveBufferIndex(int moveFlag)
 {
-    int pos_vec[DIM * 2] = { 0 };
+    // The lower bits tell which is the first dimension that the group
+    // needs to be moved along and in which direction, in the range [0,6)
+    return moveFlag & DD_FLAG_NRCG;
+}
 
-    for (gmx::Index i = 0; i < move.ssize(); i++)
+/*! \brief Counts the moved atoms per communication buffer for atoms in [start, end) */
+static void countMovedAtoms(gmx::ArrayRef<const int> move, int start, int end, int* numMoved)
+{
+    for (int a = start; a < end; a++)
     {
-        /* Skip moved atoms */
-        const int m = move[i];
-        if (m >= 0)
+        if (move[a] >= 0)
         {
-            /* Copy to the communication buffer */
-            pos_vec[m] += 1 + vec;
-            copy_rvec(src[i], comm->cgcm_state[m][pos_vec[m]++]);
-            pos_vec[m] += nvec - vec - 1;
+            numMoved[moveBufferIndex(move[a])]++;
         }
     }
 }
 
-static void copyMovedUpdateGroupCogs(gmx::ArrayRef<const int>       move,
-                                     int                            nvec,
-                                     gmx::ArrayRef<const gmx::RVec> coordinates,
-                                     gmx_domdec_comm_t*             comm)
+/*! \brief Copies the moved atoms in range [start, end) to the communication buffers
+ *
+ * The atoms are stored from the positions given by \p bufferPos on,
+ * so ranges of atoms can be copied in parallel while the buffer
+ * contents are identical to a serial copy. Each buffer entry consists
+ * of the global atom (group) index with the move flag and of the COG
+ * followed by the \p nvec state vectors. The move entries are set to
+ * the buffer index.
+ *
+ * With update groups we send over their COGs.
+ * Without update groups we send the moved atom coordinates
+ * over twice. This is so the code further down can be used
+ * without many conditionals both with and without update groups.
+ */
+static void copyMovedAtomsToBuffers(gmx::ArrayRef<int>       move,
+                                    int                      start,
+                                    int                      end,
+                                    int*                     bufferPos,
+                                    int                      nvec,
+                                    gmx::ArrayRef<const int> globalAtomGroupIndices,
+                                    const t_state&           state,
+                                    gmx_domdec_comm_t*       comm)
 {
-    int pos_vec[DIM * 2] = { 0 };
+    const bool bV   = state.hasEntry(StateEntry::V);
+    const bool bCGP = state.hasEntry(StateEntry::Cgp);
 
-    for (gmx::Index g = 0; g < move.ssize(); g++)
+    for (int a = start; a < end; a++)
     {
-        /* Skip moved atoms */
-        const int m = move[g];
-        if (m >= 0)
+        if (move[a] >= 0)
         {
-            /* Copy to the communication buffer */
+            // The value in move[a] was computed by computeMoveFlags
+            // and describes how this atom should move between domains.
+            const int flag = move[a] & ~DD_FLAG_NRCG;
+            const int mc   = moveBufferIndex(move[a]);
+            move[a]        = mc;
+
+            const int pos                           = bufferPos[mc]++;
+            comm->cggl_flag[mc][pos * DD_CGIBS]     = globalAtomGroupIndices[a];
+            comm->cggl_flag[mc][pos * DD_CGIBS + 1] = flag;
+
+            rvec* buffer = as_rvec_array(comm->cgcm_state[mc].data()) + pos * (1 + nvec);
             const gmx::RVec& cog =
-                    (comm->systemInfo.useUpdateGroups ? comm->updateGroupsCog->cogForAtom(g)
-                                                      : coordinates[g]);
-            copy_rvec(cog, comm->cgcm_state[m][pos_vec[m]]);
-            pos_vec[m] += 1 + nvec;
+                    (comm->systemInfo.useUpdateGroups ? comm->updateGroupsCog->cogForAtom(a)
+                                                      : state.x[a]);
+            copy_rvec(cog, buffer[0]);
+            int vectorIndex = 1;
+            copy_rvec(state.x[a], buffer[vectorIndex++]);
+            if (bV)
+            {
+                copy_rvec(state.v[a], buffer[vectorIndex++]);
+            }
+            if (bCGP)
+            {
+                copy_rvec(state.cg_p[a], buffer[vectorIndex++]);
+            }
         }
     }
 }
@@ -673,34 +711,42 @@ void dd_redistribute_cg(FILE*         fplog,
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
 
+    int nvec = 1;
+    if (bV)
+    {
+        nvec++;
+    }
+    if (bCGP)
+    {
+        nvec++;
+    }
+
+    /* Count the atoms to move per thread, so we can pack the atoms
+     * into the communication buffers in parallel while keeping the
+     * order of a serial pack.
+     */
+    std::vector<std::array<int, DIM * 2>> threadBufferPos(nthread);
+#pragma omp parallel for num_threads(nthread) schedule(static)
+    for (int thread = 0; thread < nthread; thread++)
+    {
+        threadBufferPos[thread] = { 0 };
+        countMovedAtoms(move,
+                        (thread * dd->numHomeAtoms) / nthread,
+                        ((thread + 1) * dd->numHomeAtoms) / nthread,
+                        threadBufferPos[thread].data());
+    }
+
     // The counts of atoms to move, forward or backward, over the
-    // possible DIM dimensions.
+    // possible DIM dimensions. We convert the thread counts to
+    // the starting positions in the buffers for each thread.
     int nat[DIM * 2] = { 0 };
-    for (int cg = 0; cg < dd->numHomeAtoms; cg++)
+    for (int thread = 0; thread < nthread; thread++)
     {
-        if (move[cg] >= 0)
+        for (int mc = 0; mc < DIM * 2; mc++)
         {
-            // The value in move[cg] was computed by computeMoveFlags
-            // and describes how this atom should move between domains.
-            const int flag = move[cg] & ~DD_FLAG_NRCG;
-            // mc contains 4 bits that tell which is the first
-            // dimension (bit 1,2,3) that the group needs to be moved
-            // along, and in which direction (bit 0; not set for fw
-            // and set for bw). However the value is always in
-            // the range [0,6)
-            const int mc = move[cg] & DD_FLAG_NRCG;
-            move[cg]     = mc;
-
-            std::vector<int>& cggl_flag = comm->cggl_flag[mc];
-
-            /* TODO: See if we can use push_back instead */
-            if ((nat[mc] + 1) * DD_CGIBS > gmx::Index(cggl_flag.size()))
-            {
-                cggl_flag.resize((nat[mc] + 1) * DD_CGIBS);
-            }
-            cggl_flag[nat[mc] * DD_CGIBS]     = dd->globalAtomGroupIndices[cg];
-            cggl_flag[nat[mc] * DD_CGIBS + 1] = flag;
-            nat[mc]++;
+            const int numMoved          = threadBufferPos[thread][mc];
+            threadBufferPos[thread][mc] = nat[mc];
+            nat[mc] += numMoved;
         }
     }
 
@@ -713,19 +759,13 @@ void dd_redistribute_cg(FILE*         fplog,
         *ncg_moved += nat[i];
     }
 
-    int nvec = 1;
-    if (bV)
-    {
-        nvec++;
-    }
-    if (bCGP)
-    {
-        nvec++;
-    }
-
     /* Make sure the communication buffers are large enough */
     for (int mc = 0; mc < dd->ndim * 2; mc++)
     {
+        if (nat[mc] * DD_CGIBS > gmx::Index(comm->cggl_flag[mc].size()))
+        {
+            comm->cggl_flag[mc].resize(nat[mc] * DD_CGIBS);
+        }
         size_t nvr = nat[mc] * (1 + nvec);
         if (nvr > comm->cgcm_state[mc].size())
         {
@@ -733,22 +773,21 @@ void dd_redistribute_cg(FILE*         fplog,
         }
     }
 
-    /* With update groups we send over their COGs.
-     * Without update groups we send the moved atom coordinates
-     * over twice. This is so the code further down can be used
-     * without many conditionals both with and without update groups.
-     */
-    copyMovedUpdateGroupCogs(move, nvec, state->x, comm);
-
-    int vectorIndex = 0;
-    copyMovedAtomsToBufferPerAtom(move, nvec, vectorIndex++, state->x.rvec_array(), comm);
-    if (bV)
+#pragma omp parallel for num_threads(nthread) schedule(static)
+    for (int thread = 0; thread < nthread; thread++)
     {
-        copyMovedAtomsToBufferPerAtom(move, nvec, vectorIndex++, state->v.rvec_array(), comm);
-    }
-    if (bCGP)
-    {
-        copyMovedAtomsToBufferPerAtom(move, nvec, vectorIndex++, state->cg_p.rvec_array(), comm);
+        try
+        {
+            copyMovedAtomsToBuffers(move,
+                                    (thread * dd->numHomeAtoms) / nthread,
+                                    ((thread + 1) * dd->numHomeAtoms) / nthread,
+                                    threadBufferPos[thread].data(),
+                                    nvec,
+                                    dd->globalAtomGroupIndices,
+                                    *state,
+                                    comm);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
 
     int* moved = getMovedBuffer(comm, 0, dd->numHomeAtoms);
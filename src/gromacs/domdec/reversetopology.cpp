@@ -46,6 +46,7 @@
 #include "gromacs/domdec/reversetopology.h"
 
 #include <cstdio>
+#include <cstdlib>
 
 #include <memory>
 #include <vector>
@@ -100,6 +101,8 @@ struct gmx_reverse_top_t::Impl
     /* Work data structures for multi-threading */
     //! \brief Thread work array for local topology generation
     std::vector<thread_work_t> th_work;
+    //! \brief Data for updating the local topology of a single domain
+    LocalTopologyUpdateData localTopologyUpdateData;
     //! @endcond
 };
 
@@ -325,6 +328,11 @@ ArrayRef<thread_work_t> gmx_reverse_top_t::threadWorkObjects() const
     return impl_->th_work;
 }
 
+LocalTopologyUpdateData* gmx_reverse_top_t::localTopologyUpdateData() const
+{
+    return &impl_->localTopologyUpdateData;
+}
+
 bool gmx_reverse_top_t::doListedForcesSorting() const
 {
     return impl_->doListedForcesSorting;
@@ -339,6 +347,7 @@ gmx_reverse_top_t::Impl::Impl(const gmx_mtop_t&        mtop,
     bInterAtomicInteractions(mtop.bIntermolecularInteractions)
 {
     bInterAtomicInteractions = mtop.bIntermolecularInteractions;
+    localTopologyUpdateData.checkUpdate = (getenv("GMX_DD_CHECK_LOCAL_TOPOLOGY_UPDATE") != nullptr);
     ril_mt.resize(mtop.moltype.size());
     ril_mt_tot_size = 0;
     for (size_t mt = 0; mt < mtop.moltype.size(); mt++)
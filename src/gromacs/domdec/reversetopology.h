@@ -54,6 +54,7 @@
 
 struct gmx_domdec_t;
 struct gmx_ffparams_t;
+struct gmx_localtop_t;
 struct gmx_mtop_t;
 struct t_atoms;
 struct t_inputrec;
@@ -102,6 +103,24 @@ struct thread_work_t
     gmx::ListOfLists<int> excl;                  /**< List of exclusions */
 };
 
+/*! \internal \brief Data for updating the local topology of a single domain
+ *
+ * With a single domain, all interactions are local and the local
+ * topology only changes by a permutation of the atom order between
+ * partitionings. It can then be updated instead of generated again.
+ */
+struct LocalTopologyUpdateData
+{
+    //! The local topology that was generated last, nullptr when there is none
+    const gmx_localtop_t* localTopology = nullptr;
+    //! The global atom indices of the local atoms at the last generation of the local topology
+    std::vector<int> globalAtomIndices;
+    //! The number of bonded interactions in the local topology
+    int numBondedInteractions = 0;
+    //! Whether to check each update against a full generation of the local topology
+    bool checkUpdate = false;
+};
+
 /*! \internal \brief Options for setting up gmx_reverse_top_t */
 struct ReverseTopOptions
 {
@@ -150,6 +169,8 @@ public:
     bool hasPositionRestraints() const;
     //! Returns the per-thread working structures for making the local topology
     gmx::ArrayRef<thread_work_t> threadWorkObjects() const;
+    //! Returns the data for updating the local topology of a single domain
+    LocalTopologyUpdateData* localTopologyUpdateData() const;
     //! Returns whether the local topology listed-forces interactions should be sorted
     bool doListedForcesSorting() const;
 
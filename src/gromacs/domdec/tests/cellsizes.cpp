@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the load-equalizing DLB cell sizes.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/cellsizes.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+TEST(LoadEqualizingCellSizes, UniformLoadKeepsCellSizes)
+{
+    const std::vector<real> cellFrac = { 0, 0.1, 0.5, 0.6, 1 };
+    const std::vector<real> load     = { 2, 2, 2, 2 };
+    std::vector<real>       targetSize(load.size());
+
+    computeLoadEqualizingCellSizes(cellFrac, load, targetSize);
+
+    for (size_t i = 0; i < load.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(cellFrac[i + 1] - cellFrac[i], targetSize[i], defaultRealTolerance())
+                << "cell " << i;
+    }
+}
+
+TEST(LoadEqualizingCellSizes, EqualizesNonUniformLoad)
+{
+    // The first cell has half of the total load, so its load density is
+    // three times that of the others. A quarter of the total load
+    // corresponds to half of the first cell or to 1.5 of the other cells.
+    const std::vector<real> cellFrac     = { 0, 0.25, 0.5, 0.75, 1 };
+    const std::vector<real> load         = { 3, 1, 1, 1 };
+    const std::vector<real> expectedSize = { 0.125, 0.125, 0.375, 0.375 };
+    std::vector<real>       targetSize(load.size());
+
+    computeLoadEqualizingCellSizes(cellFrac, load, targetSize);
+
+    for (size_t i = 0; i < load.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(expectedSize[i], targetSize[i], defaultRealTolerance()) << "cell " << i;
+    }
+}
+
+TEST(LoadEqualizingCellSizes, MovesBoundariesOverRegionsWithoutLoad)
+{
+    // All load is in the third cell, as for a dense slab in vacuum
+    const std::vector<real> cellFrac = { 0, 0.25, 0.5, 0.75, 1 };
+    const std::vector<real> load     = { 0, 0, 4, 0 };
+    std::vector<real>       targetSize(load.size());
+
+    computeLoadEqualizingCellSizes(cellFrac, load, targetSize);
+
+    // The empty cells are assigned 1% of the average load, so we get
+    // total load 4.03 with density 16 in the third cell
+    const real totalLoad = 4.03;
+    const real boundary1 = 0.5 + (0.25 * totalLoad - 0.02) / 16;
+    const real boundary2 = 0.5 + (0.5 * totalLoad - 0.02) / 16;
+    const real boundary3 = 0.5 + (0.75 * totalLoad - 0.02) / 16;
+
+    const std::vector<real> expectedSize = {
+        boundary1, boundary2 - boundary1, boundary3 - boundary2, 1 - boundary3
+    };
+
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(1, 1e-5);
+    for (size_t i = 0; i < load.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(expectedSize[i], targetSize[i], tolerance) << "cell " << i;
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the cost-weighted initial DD cell sizes.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/costweightedcells.h"
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns \p numPositions positions evenly spread over [0, \p size)
+std::vector<real> evenlySpreadPositions(int numPositions, real size)
+{
+    std::vector<real> positions(numPositions);
+    for (int i = 0; i < numPositions; i++)
+    {
+        positions[i] = (i + 0.5_real) * size / numPositions;
+    }
+    return positions;
+}
+
+//! Tolerance for the cell fractions, determined by the histogram resolution
+const FloatingPointTolerance c_fractionTolerance = absoluteTolerance(1e-3);
+
+TEST(CostWeightedCellsTest, UniformCostGivesUniformCells)
+{
+    const std::vector<real> positions = evenlySpreadPositions(10000, 4);
+    const std::vector<real> costs(positions.size(), 1);
+
+    const auto fractions = cellFractionsEqualizingCost(positions, costs, 4, 0, 4, 0.125);
+
+    ASSERT_EQ(fractions.size(), 4);
+    for (const real fraction : fractions)
+    {
+        EXPECT_REAL_EQ_TOL(0.25, fraction, c_fractionTolerance);
+    }
+}
+
+TEST(CostWeightedCellsTest, ZeroCostGivesUniformCells)
+{
+    const std::vector<real> positions = evenlySpreadPositions(100, 2);
+    const std::vector<real> costs(positions.size(), 0);
+
+    const auto fractions = cellFractionsEqualizingCost(positions, costs, 2, 0, 2, 0.25);
+
+    ASSERT_EQ(fractions.size(), 2);
+    EXPECT_EQ(fractions[0], 0.5);
+    EXPECT_EQ(fractions[1], 0.5);
+}
+
+TEST(CostWeightedCellsTest, CellIsSmallerWhereCostIsHigher)
+{
+    // Three times higher cost in the first third of the range
+    const std::vector<real> positions = evenlySpreadPositions(30000, 3);
+    std::vector<real>       costs(positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        costs[i] = (positions[i] < 1 ? 3 : 1);
+    }
+
+    const auto fractions = cellFractionsEqualizingCost(positions, costs, 2, 0, 3, 0.1);
+
+    // Half the total cost of 5 is reached at 2.5/3, which is at 5/18 of the range
+    ASSERT_EQ(fractions.size(), 2);
+    EXPECT_REAL_EQ_TOL(5.0 / 18.0, fractions[0], c_fractionTolerance);
+    EXPECT_REAL_EQ_TOL(13.0 / 18.0, fractions[1], c_fractionTolerance);
+}
+
+TEST(CostWeightedCellsTest, ObeysMinimumFraction)
+{
+    // All cost in the first tenth of the range
+    const std::vector<real> positions = evenlySpreadPositions(10000, 1);
+    std::vector<real>       costs(positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        costs[i] = (positions[i] < 0.1 ? 1 : 0);
+    }
+
+    const real minFraction = 0.15;
+    const auto fractions   = cellFractionsEqualizingCost(positions, costs, 4, 0, 1, minFraction);
+
+    ASSERT_EQ(fractions.size(), 4);
+    for (const real fraction : fractions)
+    {
+        EXPECT_GE(fraction, minFraction * (1 - GMX_REAL_EPS) - GMX_REAL_EPS);
+    }
+    const real sum = std::accumulate(fractions.begin(), fractions.end(), 0.0_real);
+    EXPECT_REAL_EQ_TOL(1.0, sum, c_fractionTolerance);
+    // The last cell gets the most space, as there is no cost there
+    EXPECT_GT(fractions[3], 0.25);
+}
+
+TEST(CostWeightedCellsTest, SingleCellCoversEverything)
+{
+    const std::vector<real> positions = evenlySpreadPositions(10, 1);
+    const std::vector<real> costs(positions.size(), 1);
+
+    const auto fractions = cellFractionsEqualizingCost(positions, costs, 1, 0, 1, 1);
+
+    ASSERT_EQ(fractions.size(), 1);
+    EXPECT_EQ(fractions[0], 1);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading the DD cost profile.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/domdec_setup.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture for reading DD cost profiles
+class DDCostProfileTest : public ::testing::Test
+{
+public:
+    //! Writes \p contents to a temporary profile file and returns its name
+    std::string writeProfile(const std::string& contents)
+    {
+        const std::string fileName = fileManager_.getTemporaryFilePath("profile.dat").u8string();
+        TextWriter::writeFileFromString(fileName, contents);
+        return fileName;
+    }
+
+    //! Manages the temporary profile files
+    TestFileManager fileManager_;
+};
+
+TEST_F(DDCostProfileTest, ReadsAllFactors)
+{
+    const std::string fileName = writeProfile(
+            "# A comment\n"
+            "pbcdx-rect-factor = 0.25\n"
+            "\n"
+            "  pbcdx-tric-factor=0.5   # trailing comment\n"
+            "pme-load-factor = 1.5\n");
+
+    const DDCostModel costModel = readDDCostProfile(fileName);
+
+    EXPECT_FLOAT_EQ(0.25, costModel.pbcdxRectFactor);
+    EXPECT_FLOAT_EQ(0.5, costModel.pbcdxTricFactor);
+    EXPECT_FLOAT_EQ(1.5, costModel.pmeLoadFactor);
+}
+
+TEST_F(DDCostProfileTest, KeepsDefaultsForMissingFactors)
+{
+    const std::string fileName = writeProfile("pme-load-factor = 0.8\n");
+
+    const DDCostModel costModel = readDDCostProfile(fileName);
+    const DDCostModel defaults;
+
+    EXPECT_EQ(defaults.pbcdxRectFactor, costModel.pbcdxRectFactor);
+    EXPECT_EQ(defaults.pbcdxTricFactor, costModel.pbcdxTricFactor);
+    EXPECT_FLOAT_EQ(0.8, costModel.pmeLoadFactor);
+}
+
+TEST_F(DDCostProfileTest, ThrowsWithMissingFile)
+{
+    const std::string fileName = fileManager_.getTemporaryFilePath("missing.dat").u8string();
+
+    EXPECT_THROW(readDDCostProfile(fileName), FileIOError);
+}
+
+TEST_F(DDCostProfileTest, ThrowsWithCorruptFile)
+{
+    EXPECT_THROW(readDDCostProfile(writeProfile("pbcdx-rect-factor 0.25\n")), InvalidInputError);
+    EXPECT_THROW(readDDCostProfile(writeProfile("pbcdx-rect-factor = 0.25 = 1\n")), InvalidInputError);
+    EXPECT_THROW(readDDCostProfile(writeProfile("pbcdx-rect-factor = fast\n")), InvalidInputError);
+    EXPECT_THROW(readDDCostProfile(writeProfile("pbcdx-rect-factor = -1\n")), InvalidInputError);
+    EXPECT_THROW(readDDCostProfile(writeProfile("pme-load-factor = 0\n")), InvalidInputError);
+    EXPECT_THROW(readDDCostProfile(writeProfile("unknown-factor = 1\n")), InvalidInputError);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
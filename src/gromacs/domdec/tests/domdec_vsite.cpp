@@ -0,0 +1,102 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the virtual site communication setup with domain decomposition.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/domdec_vsite.h"
+
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture for collecting the non-home vsite atoms, parametrized by the number of threads
+class CollectNonHomeVsiteAtomsTest : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(CollectNonHomeVsiteAtomsTest, OrderIsIndependentOfTheNumberOfThreads)
+{
+    // Vsites of two types, the non-home atoms are stored as -1 - global index.
+    // The number of vsites per type differs a lot, so a split per type
+    // would give a different order than a split over all vsites.
+    InteractionLists lil;
+    std::vector<int> expectedRequests;
+    for (int v = 0; v < 1000; v++)
+    {
+        const int nonHomeAtom = 2 * v;
+        lil[F_VSITE2].push_back(0, std::array<int, 3>{ v, -1 - nonHomeAtom, v + 1 });
+        expectedRequests.push_back(nonHomeAtom);
+    }
+    for (int v = 0; v < 10; v++)
+    {
+        const int nonHomeAtom = 2 * v + 1;
+        lil[F_VSITE3].push_back(0, std::array<int, 4>{ v, v + 1, -1 - nonHomeAtom, -1 - v });
+        expectedRequests.push_back(nonHomeAtom);
+        expectedRequests.push_back(v);
+    }
+
+    std::vector<std::vector<int>> threadRequests(GetParam());
+    collectNonHomeVsiteAtoms(lil, threadRequests);
+
+    std::vector<int> requests;
+    for (const auto& requestsOfThread : threadRequests)
+    {
+        requests.insert(requests.end(), requestsOfThread.begin(), requestsOfThread.end());
+    }
+    EXPECT_EQ(requests, expectedRequests);
+}
+
+INSTANTIATE_TEST_SUITE_P(WithThreads, CollectNonHomeVsiteAtomsTest, ::testing::Values(1, 2, 3, 4));
+
+} // namespace
+} // namespace test
+} // namespace gmx
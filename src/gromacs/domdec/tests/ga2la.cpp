@@ -0,0 +1,116 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the global to local atom index mapping.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/ga2la.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! Parameters: the total number of atoms, the number of local atoms and the number of threads
+using Ga2laTestParameters = std::tuple<int, int, int>;
+
+//! Test fixture for concurrent insertion into gmx_ga2la_t
+class Ga2laTest : public ::testing::TestWithParam<Ga2laTestParameters>
+{
+};
+
+TEST_P(Ga2laTest, InsertsConcurrently)
+{
+    const int numAtomsTotal = std::get<0>(GetParam());
+    const int numAtomsLocal = std::get<1>(GetParam());
+    const int numThreads    = std::get<2>(GetParam());
+
+    gmx_ga2la_t ga2la(numAtomsTotal, numAtomsLocal);
+
+    // Use the first numAtomsLocal atoms of a random permutation as local atoms
+    std::vector<int> globalAtomIndices(numAtomsTotal);
+    std::iota(globalAtomIndices.begin(), globalAtomIndices.end(), 0);
+    std::shuffle(globalAtomIndices.begin(), globalAtomIndices.end(), std::mt19937(1234));
+
+    // Insert the first half serially and the second half concurrently,
+    // as is done for the home and halo atoms with domain decomposition
+    const int                       numHomeAtoms = numAtomsLocal / 2;
+    std::vector<gmx_ga2la_t::Entry> entries;
+    for (int a = 0; a < numAtomsLocal; a++)
+    {
+        if (a < numHomeAtoms)
+        {
+            ga2la.insert(globalAtomIndices[a], { a, 0 });
+        }
+        else
+        {
+            entries.push_back({ a, 1 + a % 7 });
+        }
+    }
+    ga2la.insertConcurrently(
+            gmx::constArrayRefFromArray(globalAtomIndices.data() + numHomeAtoms, entries.size()),
+            entries,
+            numThreads);
+
+    for (int a = 0; a < numAtomsLocal; a++)
+    {
+        const gmx_ga2la_t::Entry* entry = ga2la.find(globalAtomIndices[a]);
+        ASSERT_NE(entry, nullptr);
+        EXPECT_EQ(entry->la, a);
+        EXPECT_EQ(entry->cell, a < numHomeAtoms ? 0 : 1 + a % 7);
+    }
+    for (int a = numAtomsLocal; a < std::min(numAtomsTotal, numAtomsLocal + 1000); a++)
+    {
+        EXPECT_EQ(ga2la.find(globalAtomIndices[a]), nullptr);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(DirectAndHashed,
+                         Ga2laTest,
+                         ::testing::Combine(::testing::Values(100000, 2000000),
+                                            ::testing::Values(50000),
+                                            ::testing::Values(1, 2, 4)));
+
+} // namespace
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the reduced-precision halo coordinate codec.
+ *
+ * \ingroup module_domdec
+ */
+#include "gmxpre.h"
+
+#include "gromacs/domdec/halocoordinatecodec.h"
+
+#include <cmath>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture for the halo coordinate codec, parametrized by the number of bits
+class HaloCoordinateCodecTest : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(HaloCoordinateCodecTest, DecodesWithinMaxError)
+{
+    const HaloCoordinateCodec codec(GetParam());
+
+    // Coordinates in a range typical of a halo, offset from the origin
+    const RVec lower  = { 2.0, -1.0, 5.0 };
+    const RVec extent = { 1.5, 3.0, 0.8 };
+
+    std::mt19937                         rng(1234);
+    std::uniform_real_distribution<real> uniform(0, 1);
+    std::vector<RVec>                    x(1000);
+    for (RVec& coordinates : x)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            coordinates[d] = lower[d] + uniform(rng) * extent[d];
+        }
+    }
+
+    std::vector<uint8_t> buffer(codec.encodedSize(x.size()));
+    EXPECT_LT(buffer.size(), x.size() * sizeof(RVec));
+    codec.encode(x, buffer);
+
+    std::vector<RVec> decoded(x.size());
+    codec.decode(buffer, decoded);
+
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            // Allow for the rounding errors of the floating-point operations
+            const real tolerance =
+                    codec.maxError(extent[d]) + 4 * GMX_REAL_EPS * (std::fabs(x[i][d]) + extent[d]);
+            EXPECT_LE(std::fabs(decoded[i][d] - x[i][d]), tolerance);
+        }
+    }
+}
+
+TEST_P(HaloCoordinateCodecTest, DecodesBoundingBoxCornersExactly)
+{
+    const HaloCoordinateCodec codec(GetParam());
+
+    const std::vector<RVec> x = { { 1.0, 2.0, 3.0 }, { 1.5, 2.5, 3.0 }, { 4.0, 2.25, 3.0 } };
+
+    std::vector<uint8_t> buffer(codec.encodedSize(x.size()));
+    codec.encode(x, buffer);
+    std::vector<RVec> decoded(x.size());
+    codec.decode(buffer, decoded);
+
+    // The lower corner and equal coordinates are reproduced exactly
+    EXPECT_EQ(decoded[0][XX], x[0][XX]);
+    EXPECT_EQ(decoded[0][YY], x[0][YY]);
+    for (const RVec& coordinates : decoded)
+    {
+        EXPECT_EQ(coordinates[ZZ], 3.0);
+    }
+}
+
+TEST_P(HaloCoordinateCodecTest, HandlesNoCoordinates)
+{
+    const HaloCoordinateCodec codec(GetParam());
+
+    EXPECT_EQ(codec.encodedSize(0), 0);
+
+    std::vector<uint8_t> buffer;
+    std::vector<RVec>    x;
+    codec.encode(x, buffer);
+    codec.decode(buffer, x);
+}
+
+TEST(HaloCoordinateCompressionBitsTest, AccountsForTheNumberOfEncodings)
+{
+    const real extent = 10.0;
+    // Slightly more than the error of one encoding with 16 bits
+    const real maxError = 1.01 * HaloCoordinateCodec(16).maxError(extent);
+
+    EXPECT_EQ(haloCoordinateCompressionBits(extent, 1, maxError), 16);
+    EXPECT_EQ(haloCoordinateCompressionBits(extent, 2, maxError), 21);
+    EXPECT_EQ(haloCoordinateCompressionBits(extent, 40, maxError), 0);
+    // A larger box needs more bits
+    EXPECT_EQ(haloCoordinateCompressionBits(2 * extent, 1, maxError), 21);
+}
+
+INSTANTIATE_TEST_SUITE_P(WithBits, HaloCoordinateCodecTest, ::testing::Values(16, 21));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -42,6 +42,10 @@
 
 #include "gromacs/domdec/hashedmap.h"
 
+#include <functional>
+#include <numeric>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "testutils/testasserts.h"
@@ -162,6 +166,97 @@ TEST(HashedMap, LinkedEntries)
     checkFinds(map, 3 + 2 * largePowerOf2, 'c');
 }
 
+//! Runs the tasks for HashedMap::insertConcurrently() in reverse order, to mimic concurrency
+void runTasksInReverse(int numTasks, const std::function<void(int)>& task)
+{
+    for (int t = numTasks - 1; t >= 0; t--)
+    {
+        task(t);
+    }
+}
+
+/*! \brief Inserts keys concurrently into a map with existing entries and checks all entries
+ *
+ * Many of the keys share a hash to test linking of entries.
+ */
+void checkInsertsConcurrently(int numTasks)
+{
+    gmx::HashedMap<char> map(100);
+
+    const int largePowerOf2 = 4096;
+
+    map.insert(5, 'x');
+    map.insert(5 + largePowerOf2, 'y');
+
+    std::vector<int>  keys;
+    std::vector<char> values;
+    for (int i = 0; i < 300; i++)
+    {
+        keys.push_back((i % 3) * largePowerOf2 + 2 * (i / 3) + 7);
+        values.push_back('a' + i % 26);
+    }
+    // Add a key that is linked to the list of an existing entry
+    keys.push_back(5 + 2 * largePowerOf2);
+    values.push_back('z');
+
+    map.insertConcurrently(keys, values, numTasks, [numTasks](const auto& task) {
+        runTasksInReverse(numTasks, task);
+    });
+
+    EXPECT_EQ(map.size(), 2 + gmx::ssize(keys));
+    checkFinds(map, 5, 'x');
+    checkFinds(map, 5 + largePowerOf2, 'y');
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        checkFinds(map, keys[i], values[i]);
+    }
+    checkDoesNotFind(map, 6);
+    checkDoesNotFind(map, 3 * largePowerOf2 + 7);
+
+    // Check that erasing and inserting still works after concurrent insertion
+    map.erase(keys[1]);
+    checkDoesNotFind(map, keys[1]);
+    map.insert(keys[1], 'b');
+    map.insert(3 * largePowerOf2 + 7, 'c');
+    checkFinds(map, keys[1], 'b');
+    checkFinds(map, 3 * largePowerOf2 + 7, 'c');
+}
+
+TEST(HashedMap, InsertsConcurrentlyWithOneTask)
+{
+    checkInsertsConcurrently(1);
+}
+
+TEST(HashedMap, InsertsConcurrentlyWithMultipleTasks)
+{
+    checkInsertsConcurrently(3);
+}
+
+TEST(HashedMap, InsertsConcurrentlyWithMoreTasksThanBuckets)
+{
+    checkInsertsConcurrently(1000);
+}
+
+TEST(HashedMap, InsertsConcurrentlyAfterClear)
+{
+    gmx::HashedMap<char> map(10);
+
+    std::vector<int> keys(1000);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::vector<char> values(keys.size(), 'a');
+
+    for (int iteration = 0; iteration < 3; iteration++)
+    {
+        map.insertConcurrently(
+                keys, values, 4, [](const auto& task) { runTasksInReverse(4, task); });
+        EXPECT_EQ(map.size(), gmx::ssize(keys));
+        checkFinds(map, 0, 'a');
+        checkFinds(map, 999, 'a');
+        checkDoesNotFind(map, 1000);
+        map.clear();
+    }
+}
+
 // HashedMap only throws in debug mode, so only test in debug mode
 #ifndef NDEBUG
 
@@ -45,13 +45,18 @@
 
 #include <cstring>
 
+#include <sstream>
 #include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
 
 #include "gromacs/gmxana/gmx_ana.h"
 
 #include "testutils/cmdlinetest.h"
 #include "testutils/stdiohelper.h"
 #include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
 #include "testutils/textblockmatchers.h"
 #include "testutils/xvgtest.h"
 
@@ -163,6 +168,66 @@ TEST_F(EnergyTest, ExtractEnergyWithNumberInNameAndAlsoByNumber)
     runTest("ener_numberInName.edr", "1/Viscosity\n7\n");
 }
 
+//! Returns the average, RMSD and drift columns of the statistics table printed by gmx energy
+std::vector<std::vector<std::string>> statisticsColumns(const std::string& output)
+{
+    std::vector<std::vector<std::string>> columns;
+    std::istringstream                    stream(output.substr(output.find("-----")));
+    std::string                           line;
+    std::getline(stream, line);
+    while (std::getline(stream, line) && !line.empty())
+    {
+        std::istringstream       lineStream(line);
+        std::vector<std::string> words;
+        std::string              word;
+        while (lineStream >> word)
+        {
+            words.push_back(word);
+        }
+        if (words.size() < 5)
+        {
+            break;
+        }
+        const size_t n = words.size();
+        // The columns are Average, Err.Est., RMSD, Tot-Drift and the unit
+        columns.push_back({ words[n - 5], words[n - 3], words[n - 2] });
+    }
+    return columns;
+}
+
+class EnergyStreamTest : public CommandLineTestBase
+{
+public:
+    //! Returns the statistics output of gmx energy with the extra \p option
+    std::string runEnergy(const char* option)
+    {
+        CommandLine cmdline;
+        cmdline.append("gmx_energy");
+        cmdline.addOption("-f", TestFileManager::getInputFilePath("ener.edr").u8string());
+        cmdline.addOption("-o", fileManager().getTemporaryFilePath("energy.xvg").u8string());
+        if (option != nullptr)
+        {
+            cmdline.append(option);
+        }
+
+        StdioTestHelper stdioHelper(&fileManager());
+        stdioHelper.redirectStringToStdin("Potential\nKinetic-En.\nPressure\n");
+        testing::internal::CaptureStdout();
+        const int exitCode = gmx_energy(cmdline.argc(), cmdline.argv());
+        std::string output = testing::internal::GetCapturedStdout();
+        EXPECT_EQ(0, exitCode);
+        return output;
+    }
+};
+
+TEST_F(EnergyStreamTest, StreamingGivesSameAveragesFluctuationsAndDrifts)
+{
+    const auto reference = statisticsColumns(runEnergy(nullptr));
+    const auto streaming = statisticsColumns(runEnergy("-stream"));
+    EXPECT_EQ(3, reference.size());
+    EXPECT_EQ(reference, streaming);
+}
+
 class ViscosityTest : public CommandLineTestBase
 {
 public:
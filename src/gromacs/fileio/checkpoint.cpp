@@ -43,7 +43,10 @@
 #include <cstring>
 
 #include <array>
+#include <filesystem>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/gmxfio.h"
@@ -84,6 +87,7 @@
 #include "gromacs/utility/keyvaluetreeserializer.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/sysinfo.h"
 #include "gromacs/utility/textwriter.h"
 #include "gromacs/utility/txtdump.h"
@@ -92,6 +96,10 @@
 
 #define CPT_MAGIC1 171817
 #define CPT_MAGIC2 171819
+#define CPT_SHARD_MAGIC 171821
+
+//! The version of the checkpoint state shard file format
+static constexpr int c_stateShardVersion = 1;
 
 namespace gmx
 {
@@ -1289,6 +1297,19 @@ static void do_cpt_header(XDR* xd, gmx_bool bRead, FILE* list, CheckpointHeaderC
     {
         contents->isModularSimulatorCheckpoint = false;
     }
+
+    if (contents->file_version >= CheckPointVersion::StateShards)
+    {
+        do_cpt_int_err(xd, "number of state shards", &contents->numStateShards, list);
+        if (contents->numStateShards > 0)
+        {
+            do_cpt_string_err(xd, "state shard base name", contents->stateShardBaseName, list);
+        }
+    }
+    else
+    {
+        contents->numStateShards = 0;
+    }
 }
 
 static int do_cpt_footer(XDR* xd, CheckPointVersion file_version)
@@ -1417,6 +1438,215 @@ static int do_cpt_state(XDR* xd, int fflags, t_state* state, FILE* list)
     return ret;
 }
 
+/*! \brief Returns the state flags of the entries stored in the checkpoint file itself
+ *
+ * With state shards, the coordinates and velocities are stored in
+ * the shard files instead.
+ */
+static int stateFlagsInCheckpointFile(const CheckpointHeaderContents& headerContents)
+{
+    int flags = headerContents.flags_state;
+    if (headerContents.numStateShards > 0)
+    {
+        flags &= ~(enumValueToBitMask(StateEntry::X) | enumValueToBitMask(StateEntry::V));
+    }
+    return flags;
+}
+
+std::filesystem::path checkpointStateShardFilename(const std::filesystem::path& directory,
+                                                   const std::string&           baseName,
+                                                   int64_t                      step,
+                                                   int                          shardIndex)
+{
+    char sbuf[STEPSTRSIZE];
+
+    return directory
+           / gmx::formatString(
+                   "%s_step%s_shard%d.cpt", baseName.c_str(), gmx_step_str(step, sbuf), shardIndex);
+}
+
+void write_checkpoint_state_shard(const std::filesystem::path&   filename,
+                                  int64_t                        step,
+                                  int                            shardIndex,
+                                  int                            numShards,
+                                  gmx::ArrayRef<const int>       globalAtomIndices,
+                                  gmx::ArrayRef<const gmx::RVec> x,
+                                  gmx::ArrayRef<const gmx::RVec> v)
+{
+    GMX_RELEASE_ASSERT(x.size() == globalAtomIndices.size(), "Need coordinates for all atoms");
+    GMX_RELEASE_ASSERT(v.empty() || v.size() == globalAtomIndices.size(),
+                       "Need velocities for none or all atoms");
+
+    int magic      = CPT_SHARD_MAGIC;
+    int version    = c_stateShardVersion;
+    int doublePrec = GMX_DOUBLE;
+    int numAtoms   = globalAtomIndices.ssize();
+    int haveV      = v.empty() ? 0 : 1;
+
+    t_fileio* fp = gmx_fio_open(filename, "w");
+    bool      ok = (gmx_fio_do_int(fp, magic) && gmx_fio_do_int(fp, version)
+               && gmx_fio_do_int(fp, doublePrec) && gmx_fio_do_int64(fp, step)
+               && gmx_fio_do_int(fp, shardIndex) && gmx_fio_do_int(fp, numShards)
+               && gmx_fio_do_int(fp, numAtoms) && gmx_fio_do_int(fp, haveV)
+               && gmx_fio_ndo_int(fp, const_cast<int*>(globalAtomIndices.data()), numAtoms)
+               && gmx_fio_ndo_rvec(fp, const_cast<rvec*>(as_rvec_array(x.data())), numAtoms)
+               && (haveV == 0
+                   || gmx_fio_ndo_rvec(fp, const_cast<rvec*>(as_rvec_array(v.data())), numAtoms)));
+    if (!ok)
+    {
+        gmx_file("Cannot write checkpoint state shard; maybe you are out of disk space?");
+    }
+    /* The shard needs to be on disk before the checkpoint referring to it */
+    if (gmx_fio_fsync(fp) != 0)
+    {
+        std::string message = gmx::formatString(
+                "Cannot fsync '%s'; maybe you are out of disk space?", filename.u8string().c_str());
+        if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == nullptr)
+        {
+            gmx_file(message);
+        }
+        else
+        {
+            gmx_warning("%s", message.c_str());
+        }
+    }
+    if (gmx_fio_close(fp) != 0)
+    {
+        gmx_file("Cannot write checkpoint state shard; maybe you are out of disk space?");
+    }
+}
+
+/*! \brief Reads the coordinates and velocities from the state shard files into \p state
+ *
+ * \param[in]     directory       The directory of the checkpoint file
+ * \param[in]     headerContents  The header of the checkpoint file
+ * \param[in,out] state           The global state, only X and V are set
+ */
+static void read_checkpoint_state_shards(const std::filesystem::path&    directory,
+                                         const CheckpointHeaderContents& headerContents,
+                                         t_state*                        state)
+{
+    const int  numAtomsTotal = state->numAtoms();
+    const bool readX         = state->hasEntry(StateEntry::X);
+    const bool readV         = state->hasEntry(StateEntry::V);
+    if (readX)
+    {
+        state->x.resizeWithPadding(numAtomsTotal);
+    }
+    if (readV)
+    {
+        state->v.resizeWithPadding(numAtomsTotal);
+    }
+
+    std::vector<int>       globalAtomIndices;
+    std::vector<gmx::RVec> buffer;
+    int                    numAtomsRead = 0;
+    for (int shard = 0; shard < headerContents.numStateShards; shard++)
+    {
+        const auto filename = checkpointStateShardFilename(
+                directory, headerContents.stateShardBaseName, headerContents.step, shard);
+        if (!gmx_fexist(filename))
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' is missing",
+                      filename.u8string().c_str());
+        }
+
+        t_fileio* fp         = gmx_fio_open(filename, "r");
+        int       magic      = 0;
+        int       version    = 0;
+        int       doublePrec = 0;
+        int64_t   step       = 0;
+        int       shardIndex = 0;
+        int       numShards  = 0;
+        int       numAtoms   = 0;
+        int       haveV      = 0;
+        bool      ok = (gmx_fio_do_int(fp, magic) && magic == CPT_SHARD_MAGIC && gmx_fio_do_int(fp, version)
+                   && gmx_fio_do_int(fp, doublePrec) && gmx_fio_do_int64(fp, step)
+                   && gmx_fio_do_int(fp, shardIndex) && gmx_fio_do_int(fp, numShards)
+                   && gmx_fio_do_int(fp, numAtoms) && gmx_fio_do_int(fp, haveV));
+        if (!ok || version != c_stateShardVersion || numAtoms < 0 || numAtoms > numAtomsTotal)
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' is corrupted or not a state shard file",
+                      filename.u8string().c_str());
+        }
+        if (doublePrec != GMX_DOUBLE)
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' was written in %s precision, "
+                      "it can not be read in %s precision",
+                      filename.u8string().c_str(),
+                      doublePrec ? "double" : "mixed",
+                      GMX_DOUBLE ? "double" : "mixed");
+        }
+        if (step != headerContents.step || shardIndex != shard
+            || numShards != headerContents.numStateShards)
+        {
+            char sbuf[STEPSTRSIZE];
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' does not belong to the checkpoint "
+                      "for step %s",
+                      filename.u8string().c_str(),
+                      gmx_step_str(headerContents.step, sbuf));
+        }
+        if (readV && haveV == 0)
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' does not contain velocities",
+                      filename.u8string().c_str());
+        }
+
+        globalAtomIndices.resize(numAtoms);
+        buffer.resize(numAtoms);
+        ok = gmx_fio_ndo_int(fp, globalAtomIndices.data(), numAtoms);
+        for (const int globalAtom : globalAtomIndices)
+        {
+            if (globalAtom < 0 || globalAtom >= numAtomsTotal)
+            {
+                ok = false;
+            }
+        }
+        ok = ok && gmx_fio_ndo_rvec(fp, as_rvec_array(buffer.data()), numAtoms);
+        if (ok && readX)
+        {
+            for (int i = 0; i < numAtoms; i++)
+            {
+                state->x[globalAtomIndices[i]] = buffer[i];
+            }
+        }
+        if (ok && haveV != 0)
+        {
+            ok = gmx_fio_ndo_rvec(fp, as_rvec_array(buffer.data()), numAtoms);
+            if (ok && readV)
+            {
+                for (int i = 0; i < numAtoms; i++)
+                {
+                    state->v[globalAtomIndices[i]] = buffer[i];
+                }
+            }
+        }
+        if (!ok)
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint state shard file '%s' is corrupted",
+                      filename.u8string().c_str());
+        }
+        gmx_fio_close(fp);
+
+        numAtomsRead += numAtoms;
+    }
+
+    if (numAtomsRead != numAtomsTotal)
+    {
+        gmx_fatal(FARGS,
+                  "The checkpoint state shard files contain %d atoms, while the checkpoint is for "
+                  "%d atoms",
+                  numAtomsRead,
+                  numAtomsTotal);
+    }
+}
+
 static int do_cpt_ekinstate(XDR* xd, int fflags, ekinstate_t* ekins, FILE* list)
 {
     int ret = 0;
@@ -2432,7 +2662,7 @@ void write_checkpoint_data(t_fileio*                         fp,
 
     do_cpt_header(gmx_fio_getxdr(fp), FALSE, nullptr, &headerContents);
 
-    if ((do_cpt_state(gmx_fio_getxdr(fp), state->flags(), state, nullptr) < 0)
+    if ((do_cpt_state(gmx_fio_getxdr(fp), stateFlagsInCheckpointFile(headerContents), state, nullptr) < 0)
         || (do_cpt_ekinstate(gmx_fio_getxdr(fp), headerContents.flags_eks, &state->ekinstate, nullptr) < 0)
         || (do_cpt_enerhist(gmx_fio_getxdr(fp), FALSE, headerContents.flags_enh, enerhist, nullptr) < 0)
         || (doCptPullHist(gmx_fio_getxdr(fp), FALSE, headerContents.flagsPullHistory, pullHist, nullptr) < 0)
@@ -2750,13 +2980,17 @@ static void read_checkpoint(const std::filesystem::path&   fn,
         check_match(fplog, cr, dd_nc, *headerContents, reproducibilityRequested);
     }
 
-    ret             = do_cpt_state(gmx_fio_getxdr(fp), headerContents->flags_state, state, nullptr);
+    ret = do_cpt_state(gmx_fio_getxdr(fp), stateFlagsInCheckpointFile(*headerContents), state, nullptr);
     *init_fep_state = state->fep_state; /* there should be a better way to do this than setting it
                                            here. Investigate for 5.0. */
     if (ret)
     {
         cp_error();
     }
+    if (headerContents->numStateShards > 0)
+    {
+        read_checkpoint_state_shards(fn.parent_path(), *headerContents, state);
+    }
     ret = do_cpt_ekinstate(gmx_fio_getxdr(fp), headerContents->flags_eks, &state->ekinstate, nullptr);
     if (ret)
     {
@@ -2972,7 +3206,7 @@ static CheckpointHeaderContents read_checkpoint_data(t_fileio*
     state->nnhpres       = headerContents.nnhpres;
     state->nhchainlength = headerContents.nhchainlength;
     state->setFlags(headerContents.flags_state);
-    int ret = do_cpt_state(gmx_fio_getxdr(fp), state->flags(), state, nullptr);
+    int ret = do_cpt_state(gmx_fio_getxdr(fp), stateFlagsInCheckpointFile(headerContents), state, nullptr);
     if (ret)
     {
         cp_error();
@@ -3062,6 +3296,10 @@ void read_checkpoint_trxframe(t_fileio* fp, t_trxframe* fr)
         gmx::ModularSimulator::readCheckpointToTrxFrame(fr, &modularSimulatorCheckpointData, headerContents);
         return;
     }
+    if (headerContents.numStateShards > 0)
+    {
+        read_checkpoint_state_shards(gmx_fio_getname(fp).parent_path(), headerContents, &state);
+    }
 
     fr->natoms    = state.numAtoms();
     fr->bStep     = TRUE;
@@ -3105,7 +3343,7 @@ void list_checkpoint(const std::filesystem::path& fn, FILE* out)
     state.nnhpres       = headerContents.nnhpres;
     state.nhchainlength = headerContents.nhchainlength;
     state.setFlags(headerContents.flags_state);
-    ret = do_cpt_state(gmx_fio_getxdr(fp), state.flags(), &state, out);
+    ret = do_cpt_state(gmx_fio_getxdr(fp), stateFlagsInCheckpointFile(headerContents), &state, out);
     if (ret)
     {
         cp_error();
@@ -37,11 +37,14 @@
 
 #include <cstdio>
 
+#include <filesystem>
 #include <limits>
+#include <string>
 #include <vector>
 
 #include "gromacs/compat/pointers.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/keyvaluetreebuilder.h"
@@ -220,6 +223,8 @@ enum class CheckPointVersion : int
     ModularSimulator,
     //! Added local (per walker) weight contribution to each point in AWH.
     AwhLocalWeightSum,
+    //! Added optional storage of the atom state in per-rank shard files.
+    StateShards,
     //! The total number of checkpoint versions.
     Count,
     //! Current version
@@ -304,6 +309,10 @@ struct CheckpointHeaderContents
     SwapType eSwapCoords;
     //! Whether the checkpoint was written by modular simulator.
     bool isModularSimulatorCheckpoint = false;
+    //! The number of shard files storing the atom coordinates and velocities, 0 when stored in the checkpoint itself.
+    int numStateShards = 0;
+    //! The file name, without directory and extension, the shard file names are derived from.
+    char stateShardBaseName[CPTSTRLEN] = { 0 };
 };
 
 /*! \brief Low-level checkpoint writing function */
@@ -317,6 +326,40 @@ void write_checkpoint_data(t_fileio*                         fp,
                            std::vector<gmx_file_position_t>* outputfiles,
                            gmx::WriteCheckpointDataHolder*   modularSimulatorCheckpointData);
 
+/*! \brief Returns the name of a checkpoint state shard file
+ *
+ * \param[in] directory   The directory of the checkpoint file
+ * \param[in] baseName    The checkpoint file name without directory and extension
+ * \param[in] step        The step of the checkpoint
+ * \param[in] shardIndex  The index of the shard, normally the DD rank
+ */
+std::filesystem::path checkpointStateShardFilename(const std::filesystem::path& directory,
+                                                   const std::string&           baseName,
+                                                   int64_t                      step,
+                                                   int                          shardIndex);
+
+/*! \brief Writes the coordinates and velocities of a subset of the atoms to a shard file
+ *
+ * With sharded checkpoints, each rank writes the state of its home atoms
+ * with this function, the checkpoint file itself then only contains
+ * the number of shards and the base name of the shard files.
+ *
+ * \param[in] filename           The shard file name, see checkpointStateShardFilename()
+ * \param[in] step               The step of the checkpoint
+ * \param[in] shardIndex         The index of this shard
+ * \param[in] numShards          The total number of shards
+ * \param[in] globalAtomIndices  The global indices of the atoms in this shard
+ * \param[in] x                  The coordinates of the atoms in this shard
+ * \param[in] v                  The velocities of the atoms in this shard, can be empty
+ */
+void write_checkpoint_state_shard(const std::filesystem::path&   filename,
+                                  int64_t                        step,
+                                  int                            shardIndex,
+                                  int                            numShards,
+                                  gmx::ArrayRef<const int>       globalAtomIndices,
+                                  gmx::ArrayRef<const gmx::RVec> x,
+                                  gmx::ArrayRef<const gmx::RVec> v);
+
 /* Loads a checkpoint from fn for run continuation.
  * Generates a fatal error on system size mismatch.
  * The main node reads the file
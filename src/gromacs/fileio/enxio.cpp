@@ -90,6 +90,7 @@ struct ener_file
     t_fileio*  fio;
     int        framenr;
     real       frametime;
+    gmx_bool   bSkipBlockData; /* Skip non-string subblock data when reading */
 };
 
 static void enxsubblock_init(t_enxsubblock* sb)
@@ -956,6 +957,44 @@ static void convert_full_sums(ener_old_t* ener_old, t_enxframe* fr)
     ener_old->step_prev = fr->step;
 }
 
+/* Skips the data of a subblock of fixed-size elements in the file.
+ * All XDR items are padded to a multiple of four bytes.
+ * Instead of only seeking past the data, the last four bytes are
+ * read, so we still notice when a frame was truncated.
+ */
+static gmx_bool skip_enxsubblock_data(t_fileio* fio, const t_enxsubblock& sub)
+{
+    gmx_off_t itemSize = 0;
+    switch (sub.type)
+    {
+        case XdrDataType::Float:
+        case XdrDataType::Int:
+        case XdrDataType::Char: itemSize = 4; break;
+        case XdrDataType::Double:
+        case XdrDataType::Int64: itemSize = 8; break;
+        default:
+            gmx_incons(
+                    "Reading unknown block data type: this file is corrupted or from the "
+                    "future");
+    }
+    if (sub.nr <= 0)
+    {
+        return TRUE;
+    }
+    const gmx_off_t numBytesToSkip = sub.nr * itemSize - 4;
+    if (gmx_fio_seek(fio, gmx_fio_ftell(fio) + numBytesToSkip) != 0)
+    {
+        return FALSE;
+    }
+    int lastWord = 0;
+    return gmx_fio_do_int(fio, lastWord);
+}
+
+void enx_skip_block_data(ener_file_t ef, gmx_bool bSkip)
+{
+    ef->bSkipBlockData = bSkip;
+}
+
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
 {
     int      file_version = -1;
@@ -1082,6 +1121,12 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
         {
             t_enxsubblock* sub = &(fr->block[b].sub[i]); /* shortcut */
 
+            if (bRead && ef->bSkipBlockData && sub->type != XdrDataType::String)
+            {
+                bOK = bOK && skip_enxsubblock_data(ef->fio, *sub);
+                continue;
+            }
+
             if (bRead)
             {
                 enxsubblock_alloc(sub);
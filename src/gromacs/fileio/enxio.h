@@ -176,6 +176,14 @@ void free_enxnms(int n, gmx_enxnm_t* nms);
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr);
 /* Reads enx_frames, memory in fr is (re)allocated if necessary */
 
+void enx_skip_block_data(ener_file_t ef, gmx_bool bSkip);
+/* When bSkip is TRUE, subsequent reads with do_enx only read the energy
+ * terms and the block headers. The contents of all non-string subblocks
+ * are skipped by seeking past them in the file, so their data in the
+ * frame is not allocated or set. Useful for tools that only need the
+ * energy terms, as the block data can make up most of the file.
+ */
+
 void get_enx_state(const std::filesystem::path& fn,
                    real                         t,
                    const SimulationGroups&      groups,
@@ -36,9 +36,12 @@
 #include "gmxfio_xdr.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
+#include <array>
 #include <limits>
 
 #include "gromacs/fileio/gmxfio.h"
@@ -142,6 +145,69 @@ gmx_fio_fe(t_fileio* fio, InputOutputType eio, const char* desc, const char* src
               line);
 }
 
+/*! \brief Reads or writes \p nitem rvecs stored as \p ValueType
+ *
+ * XDR stores floating-point values as big-endian IEEE numbers, so an
+ * rvec array can be transferred in large chunks of opaque bytes that
+ * are converted in memory. This gives the same file contents as one
+ * XDR call per value, but avoids most of the per-value overhead,
+ * which dominates when reading uncompressed trajectories.
+ * When reading, \p item can be nullptr to skip over the data.
+ */
+template<typename ValueType, typename UIntType>
+static bool_t do_xdr_rvec_array(t_fileio* fio, rvec* item, std::size_t nitem)
+{
+    static_assert(sizeof(ValueType) == sizeof(UIntType), "Need an unsigned integer of the same size");
+
+    constexpr std::size_t c_valueSize = sizeof(ValueType);
+    // Number of rvecs converted per XDR call
+    constexpr std::size_t c_chunkSize = 1024;
+
+    std::array<unsigned char, c_chunkSize * DIM * c_valueSize> buffer;
+    GMX_ASSERT(item != nullptr || fio->bRead, "Can only skip data when reading");
+
+    bool_t res = 1;
+    for (std::size_t start = 0; start < nitem && res; start += c_chunkSize)
+    {
+        const std::size_t numInChunk = std::min(c_chunkSize, nitem - start);
+        const std::size_t numValues  = numInChunk * DIM;
+
+        if (!fio->bRead)
+        {
+            for (std::size_t i = 0; i < numValues; i++)
+            {
+                const ValueType value = item[start + i / DIM][i % DIM];
+                UIntType        bits;
+                std::memcpy(&bits, &value, c_valueSize);
+                for (std::size_t b = 0; b < c_valueSize; b++)
+                {
+                    buffer[i * c_valueSize + b] =
+                            static_cast<unsigned char>(bits >> (8 * (c_valueSize - 1 - b)));
+                }
+            }
+        }
+        res = xdr_opaque(fio->xdr,
+                         reinterpret_cast<char*>(buffer.data()),
+                         static_cast<unsigned int>(numValues * c_valueSize));
+        if (fio->bRead && item && res)
+        {
+            for (std::size_t i = 0; i < numValues; i++)
+            {
+                UIntType bits = 0;
+                for (std::size_t b = 0; b < c_valueSize; b++)
+                {
+                    bits = (bits << 8) | buffer[i * c_valueSize + b];
+                }
+                ValueType value;
+                std::memcpy(&value, &bits, c_valueSize);
+                item[start + i / DIM][i % DIM] = value;
+            }
+        }
+    }
+
+    return res;
+}
+
 /* This is the part that reads xdr files.  */
 static gmx_bool do_xdr(t_fileio*       fio,
                        void*           item,
@@ -159,7 +225,6 @@ static gmx_bool do_xdr(t_fileio*       fio,
     int            m, *iptr, idum;
     int32_t        s32dum;
     int64_t        s64dum;
-    real*          ptr;
     unsigned short us;
     double         d = 0;
     float          f = 0;
@@ -349,15 +414,13 @@ static gmx_bool do_xdr(t_fileio*       fio,
             }
             break;
         case InputOutputType::RVecArray:
-            ptr = nullptr;
-            res = 1;
-            for (std::size_t j = 0; j < nitem && res; j++)
+            if (fio->bDouble)
             {
-                if (item)
-                {
-                    ptr = (static_cast<rvec*>(item))[j];
-                }
-                res = static_cast<bool_t>(do_xdr(fio, ptr, 1, InputOutputType::RVec, desc, srcfile, line));
+                res = do_xdr_rvec_array<double, std::uint64_t>(fio, static_cast<rvec*>(item), nitem);
+            }
+            else
+            {
+                res = do_xdr_rvec_array<float, std::uint32_t>(fio, static_cast<rvec*>(item), nitem);
             }
             break;
         case InputOutputType::IVec:
@@ -41,10 +41,13 @@
 
 #include "gmxpre.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/utility/futil.h"
 
 #include "testutils/testfilemanager.h"
@@ -146,6 +149,44 @@ TEST_F(FileIOXdrSerializerTest, SizeIsCorrect)
     EXPECT_EQ(fileSize, 72);
 }
 
+TEST_F(FileIOXdrSerializerTest, RVecArrayMatchesSingleRVecs)
+{
+    // Use more vectors than are converted in one chunk
+    const int         numVectors = 2500;
+    std::vector<RVec> written(numVectors);
+    for (int i = 0; i < numVectors; i++)
+    {
+        written[i] = RVec(0.001_real * i, -1.5_real * i, 1.0_real / (i + 1));
+    }
+    for (const bool useDouble : { false, true })
+    {
+        file_ = gmx_fio_open(filename_.c_str(), "w");
+        gmx_fio_setprecision(file_, useDouble);
+        for (auto& v : written)
+        {
+            gmx_fio_do_rvec(file_, v.as_vec());
+        }
+        gmx_fio_ndo_rvec(file_, as_rvec_array(written.data()), numVectors);
+        gmx_fio_close(file_);
+
+        file_ = gmx_fio_open(filename_.c_str(), "r");
+        gmx_fio_setprecision(file_, useDouble);
+        std::vector<RVec> readAsArray(numVectors);
+        EXPECT_TRUE(gmx_fio_ndo_rvec(file_, as_rvec_array(readAsArray.data()), numVectors));
+        for (auto& v : readAsArray)
+        {
+            RVec readSingle;
+            EXPECT_TRUE(gmx_fio_do_rvec(file_, readSingle.as_vec()));
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_EQ(v[d], readSingle[d]);
+            }
+        }
+        gmx_fio_close(file_);
+        file_ = nullptr;
+    }
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
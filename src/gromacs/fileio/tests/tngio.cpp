@@ -42,12 +42,19 @@
 
 #include "gromacs/fileio/tngio.h"
 
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/path.h"
 
+#include "testutils/setenv.h"
 #include "testutils/simulationdatabase.h"
 #include "testutils/testfilemanager.h"
 
@@ -74,4 +81,94 @@ TEST_F(TngTest, CloseBeforeOpenIsNotFatal)
     gmx_tng_close(&tng);
 }
 
+//! Environment variable that forces reading TNG frames ahead on a separate thread or not
+const char* const c_tngReadAheadEnvironmentVariable = "GMX_TNG_READ_AHEAD";
+
+/*! \brief Test fixture for reading TNG frames with and without read-ahead
+ *
+ * Read-ahead is by default only used with more than one core,
+ * so we force it on or off.
+ */
+class TngReadAheadTest : public TngTest, public ::testing::WithParamInterface<bool>
+{
+public:
+    TngReadAheadTest()
+    {
+        const char* value = getenv(c_tngReadAheadEnvironmentVariable);
+        if (value != nullptr)
+        {
+            environmentVariableBackup_ = value;
+        }
+        gmx::test::gmxSetenv(c_tngReadAheadEnvironmentVariable, GetParam() ? "1" : "0", 1);
+    }
+    ~TngReadAheadTest() override
+    {
+        if (environmentVariableBackup_.has_value())
+        {
+            gmx::test::gmxSetenv(
+                    c_tngReadAheadEnvironmentVariable, environmentVariableBackup_->c_str(), 1);
+        }
+        else
+        {
+            gmx::test::gmxUnsetenv(c_tngReadAheadEnvironmentVariable);
+        }
+    }
+
+private:
+    //! The value of the environment variable before the test, if set
+    std::optional<std::string> environmentVariableBackup_;
+};
+
+TEST_P(TngReadAheadTest, ReadNextFrameMatchesDirectReading)
+{
+    const std::string fileName =
+            (gmx::test::TestFileManager::getTestSimulationDatabaseDirectory() / "spc2-traj.tng")
+                    .u8string();
+
+    /* Read all frames directly from the file */
+    std::vector<int64_t>                steps;
+    std::vector<std::vector<gmx::RVec>> coordinates;
+    gmx_tng_trajectory_t                tng;
+    gmx_tng_open(fileName, 'r', &tng);
+    t_trxframe frame;
+    clear_trxframe(&frame, TRUE);
+    frame.step = -1;
+    while (gmx_read_next_tng_frame(tng, &frame, nullptr, 0))
+    {
+        steps.push_back(frame.step);
+        coordinates.emplace_back(frame.x, frame.x + (frame.bX ? frame.natoms : 0));
+    }
+    gmx_tng_close(&tng);
+    done_frame(&frame);
+    ASSERT_GT(steps.size(), 1);
+
+    /* Read the frames as analysis tools do, with or without reading ahead */
+    gmx_output_env_t* oenv;
+    output_env_init_default(&oenv);
+    t_trxstatus* status;
+    clear_trxframe(&frame, TRUE);
+    ASSERT_TRUE(read_first_frame(oenv, &status, fileName, &frame, TRX_READ_X));
+    size_t numFrames = 0;
+    do
+    {
+        ASSERT_LT(numFrames, steps.size());
+        EXPECT_EQ(steps[numFrames], frame.step);
+        ASSERT_EQ(coordinates[numFrames].size(), frame.bX ? static_cast<size_t>(frame.natoms) : 0);
+        for (size_t i = 0; i < coordinates[numFrames].size(); i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_EQ(coordinates[numFrames][i][d], frame.x[i][d]);
+            }
+        }
+        numFrames++;
+    } while (read_next_frame(oenv, status, &frame));
+    EXPECT_EQ(steps.size(), numFrames);
+    close_trx(status);
+    done_frame(&frame);
+    output_env_done(oenv);
+}
+
+INSTANTIATE_TEST_SUITE_P(WithAndWithoutReadAhead, TngReadAheadTest, ::testing::Bool());
+
 } // namespace
@@ -0,0 +1,274 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2013- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for XTC file I/O routines
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+//! Test fixture parametrized on the number of atoms
+class XtcEncodedTest : public ::testing::TestWithParam<int>
+{
+public:
+    //! Writes frames with \p natoms atoms to \p fileName
+    void writeReferenceFrames(const std::string& fileName, int natoms)
+    {
+        t_fileio* fio = open_xtc(fileName, "w");
+        matrix    box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            std::vector<gmx::RVec> x(natoms);
+            for (int i = 0; i < natoms; i++)
+            {
+                x[i] = { 0.1_real * i, 0.01_real * frame * i, 1.0_real - 0.03_real * i };
+            }
+            EXPECT_EQ(1, write_xtc(fio, natoms, frame * 10, frame * 0.5_real, box, as_rvec_array(x.data()), 1000));
+        }
+        close_xtc(fio);
+    }
+
+    //! Number of frames to write
+    static constexpr int c_numFrames = 3;
+    //! Manages the temporary files
+    gmx::test::TestFileManager fileManager_;
+};
+
+TEST_P(XtcEncodedTest, CopiesFramesWithNewStepAndTime)
+{
+    const int         natoms     = GetParam();
+    const std::string refName    = fileManager_.getTemporaryFilePath("ref.xtc").u8string();
+    const std::string copyName   = fileManager_.getTemporaryFilePath("copy.xtc").u8string();
+    const int64_t     stepOffset = 1000;
+    const real        timeOffset = 100;
+
+    writeReferenceFrames(refName, natoms);
+
+    t_fileio*         in  = open_xtc(refName, "r");
+    t_fileio*         out = open_xtc(copyName, "w");
+    int               magic, n;
+    int64_t           step;
+    real              time;
+    std::vector<char> frameData;
+    gmx_bool          bOK;
+    int               numFramesCopied = 0;
+    while (read_next_xtc_encoded(in, &magic, &n, &step, &time, &frameData, &bOK))
+    {
+        EXPECT_EQ(natoms, n);
+        EXPECT_EQ(1, write_xtc_encoded(out, magic, n, step + stepOffset, time + timeOffset, frameData));
+        numFramesCopied++;
+    }
+    EXPECT_TRUE(bOK);
+    EXPECT_EQ(c_numFrames, numFramesCopied);
+    close_xtc(in);
+    close_xtc(out);
+
+    t_fileio* ref  = open_xtc(refName, "r");
+    t_fileio* copy = open_xtc(copyName, "r");
+    int       refNatoms, copyNatoms;
+    int64_t   refStep, copyStep;
+    real      refTime, copyTime, refPrec, copyPrec;
+    matrix    refBox, copyBox;
+    rvec *    refX, *copyX;
+    ASSERT_EQ(1, read_first_xtc(ref, &refNatoms, &refStep, &refTime, refBox, &refX, &refPrec, &bOK));
+    ASSERT_EQ(1, read_first_xtc(copy, &copyNatoms, &copyStep, &copyTime, copyBox, &copyX, &copyPrec, &bOK));
+    int frame = 0;
+    do
+    {
+        ASSERT_EQ(refNatoms, copyNatoms);
+        EXPECT_EQ(refStep + stepOffset, copyStep);
+        EXPECT_FLOAT_EQ(refTime + timeOffset, copyTime);
+        EXPECT_EQ(refPrec, copyPrec);
+        for (int d = 0; d < DIM; d++)
+        {
+            for (int e = 0; e < DIM; e++)
+            {
+                EXPECT_EQ(refBox[d][e], copyBox[d][e]);
+            }
+        }
+        for (int i = 0; i < refNatoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_EQ(refX[i][d], copyX[i][d]);
+            }
+        }
+        frame++;
+    } while (read_next_xtc(ref, refNatoms, &refStep, &refTime, refBox, refX, &refPrec, &bOK)
+             && read_next_xtc(copy, copyNatoms, &copyStep, &copyTime, copyBox, copyX, &copyPrec, &bOK));
+    EXPECT_EQ(c_numFrames, frame);
+    sfree(refX);
+    sfree(copyX);
+    close_xtc(ref);
+    close_xtc(copy);
+}
+
+//! Small systems are stored uncompressed, larger ones compressed
+INSTANTIATE_TEST_SUITE_P(WithAndWithoutCompression, XtcEncodedTest, ::testing::Values(5, 30));
+
+TEST(XtcFragmentTest, RoundTripsFragments)
+{
+    gmx::test::TestFileManager fileManager;
+    const std::string          fileName = fileManager.getTemporaryFilePath("traj.xtc").u8string();
+    const std::string          fragmentName = xtc_fragment_filename(fileName, 3).u8string();
+    EXPECT_NE(fragmentName.find("traj_frag3.xtc"), std::string::npos);
+    EXPECT_TRUE(xtc_is_fragment_filename(fragmentName, fileName));
+    EXPECT_FALSE(xtc_is_fragment_filename(fileName, fileName));
+    EXPECT_FALSE(xtc_is_fragment_filename(xtc_fragment_filename(fileName + ".xtc", 3), fileName));
+
+    const int              natomsTotal = 100;
+    const std::vector<int> atomIndices = { 7, 3, 99, 50, 51, 52, 53, 54, 55, 56, 0, 20 };
+    std::vector<gmx::RVec> x;
+    for (size_t i = 0; i < atomIndices.size(); i++)
+    {
+        x.emplace_back(0.25_real * i, 1.5_real, -0.5_real * i);
+    }
+    matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+
+    t_fileio* fio = open_xtc(fragmentName, "w");
+    EXPECT_EQ(1, write_xtc_fragment(fio, natomsTotal, 20, 0.5, box, atomIndices, x, 1000));
+    EXPECT_EQ(1, write_xtc_fragment(fio, natomsTotal, 40, 1.0, box, {}, {}, 1000));
+    close_xtc(fio);
+
+    EXPECT_TRUE(xtc_is_fragment_file(fragmentName));
+
+    fio = open_xtc(fragmentName, "r");
+    int                    natoms;
+    int64_t                step;
+    real                   time, prec;
+    matrix                 readBox;
+    std::vector<int>       readIndices;
+    std::vector<gmx::RVec> readX;
+    gmx_bool               bOK;
+    ASSERT_EQ(1, read_next_xtc_fragment(fio, &natoms, &step, &time, readBox, &readIndices, &readX, &prec, &bOK));
+    EXPECT_EQ(natomsTotal, natoms);
+    EXPECT_EQ(20, step);
+    EXPECT_FLOAT_EQ(0.5, time);
+    EXPECT_FLOAT_EQ(1000, prec);
+    EXPECT_EQ(atomIndices, readIndices);
+    ASSERT_EQ(x.size(), readX.size());
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_NEAR(x[i][d], readX[i][d], 0.5e-3);
+        }
+    }
+    ASSERT_EQ(1, read_next_xtc_fragment(fio, &natoms, &step, &time, readBox, &readIndices, &readX, &prec, &bOK));
+    EXPECT_EQ(40, step);
+    EXPECT_TRUE(readIndices.empty());
+    EXPECT_EQ(0, read_next_xtc_fragment(fio, &natoms, &step, &time, readBox, &readIndices, &readX, &prec, &bOK));
+    EXPECT_TRUE(bOK);
+    close_xtc(fio);
+}
+
+TEST(XtcVelocitiesForcesTest, RoundTripsVelocitiesAndForces)
+{
+    gmx::test::TestFileManager fileManager;
+    const std::string          fileName = fileManager.getTemporaryFilePath("traj_vf.xtc").u8string();
+
+    const int              natoms = 40;
+    std::vector<gmx::RVec> v, f;
+    for (int i = 0; i < natoms; i++)
+    {
+        v.emplace_back(0.01_real * i, -1.5_real, 0.3_real - 0.02_real * i);
+        f.emplace_back(-250.0_real + 11.0_real * i, 1234.5_real, 3.0_real * i);
+    }
+    matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+
+    t_fileio* fio = open_xtc(fileName, "w");
+    EXPECT_EQ(1, write_xtc_vf(fio, natoms, 0, 0, box, as_rvec_array(v.data()), 1000, as_rvec_array(f.data()), 100));
+    EXPECT_EQ(1, write_xtc_vf(fio, natoms, 10, 0.02, box, nullptr, 1000, as_rvec_array(f.data()), 100));
+    close_xtc(fio);
+
+    EXPECT_TRUE(xtc_is_vf_file(fileName));
+    EXPECT_FALSE(xtc_is_fragment_file(fileName));
+
+    fio = open_xtc(fileName, "r");
+    int      readNatoms;
+    int64_t  step;
+    real     time, vPrec, fPrec;
+    matrix   readBox;
+    rvec *   readV, *readF;
+    gmx_bool bV, bF, bOK;
+    ASSERT_EQ(1,
+              read_first_xtc_vf(
+                      fio, &readNatoms, &step, &time, readBox, &readV, &vPrec, &bV, &readF, &fPrec, &bF, &bOK));
+    EXPECT_EQ(natoms, readNatoms);
+    EXPECT_EQ(0, step);
+    EXPECT_TRUE(bV);
+    EXPECT_TRUE(bF);
+    EXPECT_FLOAT_EQ(1000, vPrec);
+    EXPECT_FLOAT_EQ(100, fPrec);
+    for (int i = 0; i < natoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_NEAR(v[i][d], readV[i][d], 0.5e-3);
+            EXPECT_NEAR(f[i][d], readF[i][d], 0.5e-2);
+        }
+    }
+    ASSERT_EQ(1,
+              read_next_xtc_vf(
+                      fio, natoms, &step, &time, readBox, readV, &vPrec, &bV, readF, &fPrec, &bF, &bOK));
+    EXPECT_EQ(10, step);
+    EXPECT_FALSE(bV);
+    EXPECT_TRUE(bF);
+    EXPECT_EQ(0,
+              read_next_xtc_vf(
+                      fio, natoms, &step, &time, readBox, readV, &vPrec, &bV, readF, &fPrec, &bF, &bOK));
+    EXPECT_TRUE(bOK);
+    sfree(readV);
+    sfree(readF);
+    close_xtc(fio);
+}
+
+} // namespace
@@ -140,6 +140,7 @@ enum tpxv
     tpxv_RemoveAtomtypes,             /**< Remove unused atomtypes parameter from mtop */
     tpxv_EnsembleTemperature,         /**< Add ensemble temperature settings */
     tpxv_AwhGrowthFactor,             /**< Add AWH growth factor */
+    tpxv_CompressedVelocitiesForces,  /**< Add compressed velocity and force output */
     tpxv_Count                        /**< the total number of tpxv versions */
 };
 
@@ -1162,6 +1163,20 @@ static void do_inputrec(gmx::ISerializer* serializer, t_inputrec* ir, int file_v
         ir->delta_t = rdum;
     }
     serializer->doReal(&ir->x_compression_precision);
+    if (file_version >= tpxv_CompressedVelocitiesForces)
+    {
+        serializer->doInt(&ir->nstvout_compressed);
+        serializer->doInt(&ir->nstfout_compressed);
+        serializer->doReal(&ir->v_compression_precision);
+        serializer->doReal(&ir->f_compression_precision);
+    }
+    else
+    {
+        ir->nstvout_compressed      = 0;
+        ir->nstfout_compressed      = 0;
+        ir->v_compression_precision = 1000;
+        ir->f_compression_precision = 100;
+    }
     if (file_version >= 81)
     {
         serializer->doReal(&ir->verletbuf_tol);
@@ -3286,9 +3301,11 @@ static void doTpxBodyBuffer(gmx::ISerializer* serializer, gmx::ArrayRef<char> bu
  * The second version is the default for the legacy tools that read the
  * coordinates and velocities separate from the state.
  *
- * After reading in the data, a separate buffer is populated from them
- * containing only \p ir and \p mtop that can be communicated directly
- * to nodes needing the information to set up a simulation.
+ * After reading in the data, when requested by \p prepareBodyForCommunication,
+ * a separate buffer is populated from them containing only \p ir and \p mtop
+ * that can be communicated directly to nodes needing the information to set up
+ * a simulation. Tools that only read the file skip this, as it serializes
+ * the whole topology a second time.
  *
  * \param[in] tpx The file header.
  * \param[in] serializer The Serialization interface used to read the TPR.
@@ -3297,8 +3314,10 @@ static void doTpxBodyBuffer(gmx::ISerializer* serializer, gmx::ArrayRef<char> bu
  * \param[out] x Coordinates to populate if needed.
  * \param[out] v Velocities to populate if needed.
  * \param[out] mtop Global topology to populate.
+ * \param[in] prepareBodyForCommunication Whether to fill the body with \p ir and \p mtop.
  *
- * \returns Partial de-serialized TPR used for communication to nodes.
+ * \returns Partial de-serialized TPR used for communication to nodes,
+ *          the body is empty when \p prepareBodyForCommunication is false.
  */
 static PartialDeserializedTprFile readTpxBody(TpxFileHeader*    tpx,
                                               gmx::ISerializer* serializer,
@@ -3306,7 +3325,8 @@ static PartialDeserializedTprFile readTpxBody(TpxFileHeader*    tpx,
                                               t_state*          state,
                                               rvec*             x,
                                               rvec*             v,
-                                              gmx_mtop_t*       mtop)
+                                              gmx_mtop_t*       mtop,
+                                              bool              prepareBodyForCommunication)
 {
     PartialDeserializedTprFile partialDeserializedTpr;
     if (tpx->fileVersion >= tpxv_AddSizeField && tpx->fileGeneration >= 27)
@@ -3322,6 +3342,12 @@ static PartialDeserializedTprFile readTpxBody(TpxFileHeader*    tpx,
     {
         partialDeserializedTpr.pbcType = do_tpx_body(serializer, tpx, ir, state, x, v, mtop);
     }
+    if (!prepareBodyForCommunication)
+    {
+        partialDeserializedTpr.body.clear();
+        partialDeserializedTpr.body.shrink_to_fit();
+        return partialDeserializedTpr;
+    }
     // Update header to system info for communication to nodes.
     // As we only need to communicate the inputrec and mtop to other nodes,
     // we prepare a new char buffer with the information we have already read
@@ -3432,7 +3458,7 @@ read_tpx_state(const std::filesystem::path& fn, t_inputrec* ir, t_state* state,
     PartialDeserializedTprFile partialDeserializedTpr;
     do_tpxheader(&serializer, &partialDeserializedTpr.header, fn, fio, ir == nullptr);
     partialDeserializedTpr =
-            readTpxBody(&partialDeserializedTpr.header, &serializer, ir, state, nullptr, nullptr, mtop);
+            readTpxBody(&partialDeserializedTpr.header, &serializer, ir, state, nullptr, nullptr, mtop, true);
     close_tpx(fio);
     return partialDeserializedTpr;
 }
@@ -3447,7 +3473,7 @@ PbcType read_tpx(const std::filesystem::path& fn, t_inputrec* ir, matrix box, in
     gmx::FileIOXdrSerializer serializer(fio);
     do_tpxheader(&serializer, &tpx, fn, fio, ir == nullptr);
     PartialDeserializedTprFile partialDeserializedTpr =
-            readTpxBody(&tpx, &serializer, ir, &state, x, v, mtop);
+            readTpxBody(&tpx, &serializer, ir, &state, x, v, mtop, false);
     close_tpx(fio);
     if (mtop != nullptr && natoms != nullptr)
     {
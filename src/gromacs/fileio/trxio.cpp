@@ -39,8 +39,11 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
+#include <thread>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/filetypes.h"
@@ -62,6 +65,7 @@
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -76,6 +80,133 @@
 #define SKIP2 100
 #define SKIP3 1000
 
+namespace
+{
+
+/*! \brief Reads and decodes the next frame of a TNG file on a separate thread
+ *
+ * TNG frame sets are decompressed as a whole when the first frame
+ * of a set is read, which is expensive. With this object the next
+ * frame is read into a private frame while the caller processes
+ * the current frame. The data is copied to the caller's frame,
+ * so the pointers in the caller's frame stay valid.
+ */
+class TngFrameReadAhead
+{
+public:
+    //! Creates the object for reading from \p tng, does not start reading
+    explicit TngFrameReadAhead(gmx_tng_trajectory_t tng) : tng_(tng)
+    {
+        clear_trxframe(&frame_, TRUE);
+    }
+
+    //! Waits for the frame being read and frees the frame data
+    ~TngFrameReadAhead()
+    {
+        waitForFrame();
+        sfree(frame_.x);
+        sfree(frame_.v);
+        sfree(frame_.f);
+    }
+
+    //! Starts reading the frame after the frame \p fr returned last
+    void startReading(const t_trxframe& fr)
+    {
+        GMX_RELEASE_ASSERT(!thread_.joinable(), "Can only read one frame ahead");
+        frame_.step = fr.step;
+        thread_     = std::thread([this]() {
+            try
+            {
+                haveFrame_ = gmx_read_next_tng_frame(tng_, &frame_, nullptr, 0);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        });
+    }
+
+    //! Waits until the frame started by startReading() has been read
+    void waitForFrame()
+    {
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    /*! \brief Copies the frame read ahead to \p fr
+     *
+     * Waits for the reading to complete. Returns whether a frame was read.
+     */
+    bool getFrame(t_trxframe* fr)
+    {
+        waitForFrame();
+        if (!haveFrame_)
+        {
+            return false;
+        }
+        fr->natoms  = frame_.natoms;
+        fr->step    = frame_.step;
+        fr->bStep   = frame_.bStep;
+        fr->time    = frame_.time;
+        fr->bTime   = frame_.bTime;
+        fr->lambda  = frame_.lambda;
+        fr->bLambda = frame_.bLambda;
+        fr->prec    = frame_.prec;
+        fr->bPrec   = frame_.bPrec;
+        fr->bBox    = frame_.bBox;
+        if (frame_.bBox)
+        {
+            copy_mat(frame_.box, fr->box);
+        }
+        fr->bX = frame_.bX;
+        if (frame_.bX)
+        {
+            srenew(fr->x, fr->natoms);
+            std::memcpy(fr->x, frame_.x, fr->natoms * sizeof(*fr->x));
+        }
+        fr->bV = frame_.bV;
+        if (frame_.bV)
+        {
+            srenew(fr->v, fr->natoms);
+            std::memcpy(fr->v, frame_.v, fr->natoms * sizeof(*fr->v));
+        }
+        fr->bF = frame_.bF;
+        if (frame_.bF)
+        {
+            srenew(fr->f, fr->natoms);
+            std::memcpy(fr->f, frame_.f, fr->natoms * sizeof(*fr->f));
+        }
+        return true;
+    }
+
+private:
+    //! The TNG file, only accessed by the reading thread while it runs
+    gmx_tng_trajectory_t tng_;
+    //! The frame read ahead
+    t_trxframe frame_;
+    //! Whether the last read returned a frame
+    bool haveFrame_ = false;
+    //! The thread reading the next frame
+    std::thread thread_;
+};
+
+/*! \brief Returns whether TNG frames should be read ahead on a separate thread
+ *
+ * This only pays off when there is a core for the extra thread.
+ * Setting GMX_TNG_READ_AHEAD to 0 or 1 overrides this choice,
+ * which is also used to test both code paths.
+ */
+bool useTngReadAhead()
+{
+    const char* env = getenv("GMX_TNG_READ_AHEAD");
+    if (env != nullptr)
+    {
+        return strtol(env, nullptr, 10) != 0;
+    }
+    return std::thread::hardware_concurrency() > 1;
+}
+
+} // namespace
+
 struct t_trxstatus
 {
     int  flags; /* flags for read_first/next_frame  */
@@ -89,6 +220,8 @@ struct t_trxstatus
     int                  natoms;
     double               BOX[3];
     char*                persistent_line; /* Persistent line for reading g96 trajectories */
+    gmx_bool             bXtcVF; /* XTC file with compressed velocities and forces */
+    TngFrameReadAhead*   tngReadAhead; /* only set when reading TNG frames ahead */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t* vmdplugin;
 #endif
@@ -172,6 +305,8 @@ static void status_init(t_trxstatus* status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->bXtcVF          = FALSE;
+    status->tngReadAhead    = nullptr;
 }
 
 
@@ -266,6 +401,11 @@ float trx_get_time_of_final_frame(t_trxstatus* status)
         {
             gmx_fatal(FARGS, "Error opening TNG file.");
         }
+        if (status->tngReadAhead)
+        {
+            /* The file should not be accessed during reading */
+            status->tngReadAhead->waitForFrame();
+        }
         lasttime = gmx_tng_get_time_of_final_frame(tng);
     }
     else
@@ -489,6 +629,11 @@ t_trxstatus* trjtools_gmx_prepare_tng_writing(const std::filesystem::path& filen
 
     if (in != nullptr)
     {
+        if (in->tngReadAhead)
+        {
+            /* The input file should not be accessed during reading */
+            in->tngReadAhead->waitForFrame();
+        }
         gmx_prepare_tng_writing(
                 filename, filemode, &in->tng, &out->tng, natoms, mtop, index, index_group_name);
     }
@@ -640,6 +785,8 @@ void close_trx(t_trxstatus* status)
     {
         return;
     }
+    /* Stop reading ahead before closing the file */
+    delete status->tngReadAhead;
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
@@ -856,6 +1003,34 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                 break;
             }
             case efXTC:
+                if (status->bXtcVF)
+                {
+                    /* Frames before the start time are skipped below,
+                     * as seeking in velocity and force files is not supported.
+                     */
+                    real vPrec, fPrec;
+                    bRet = (read_next_xtc_vf(status->fio,
+                                             fr->natoms,
+                                             &fr->step,
+                                             &fr->time,
+                                             fr->box,
+                                             fr->v,
+                                             &vPrec,
+                                             &fr->bV,
+                                             fr->f,
+                                             &fPrec,
+                                             &fr->bF,
+                                             &bOK)
+                            != 0);
+                    fr->bStep = bRet;
+                    fr->bTime = bRet;
+                    fr->bBox  = bRet;
+                    if (!bOK)
+                    {
+                        fr->not_ok = DATA_NOT_OK;
+                    }
+                    break;
+                }
                 if (startTime.has_value() && (status->tf < startTime.value()))
                 {
                     if (xtc_seek_time(status->fio, startTime.value(), fr->natoms, TRUE))
@@ -882,7 +1057,20 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                     fr->not_ok = DATA_NOT_OK;
                 }
                 break;
-            case efTNG: bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0); break;
+            case efTNG:
+                if (status->tngReadAhead)
+                {
+                    bRet = status->tngReadAhead->getFrame(fr);
+                    if (bRet)
+                    {
+                        status->tngReadAhead->startReading(*fr);
+                    }
+                }
+                else
+                {
+                    bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0);
+                }
+                break;
             case efPDB: bRet = pdb_next_x(status, gmx_fio_getfp(status->fio), fr); break;
             case efGRO: bRet = gro_next_x_or_v(gmx_fio_getfp(status->fio), fr); break;
             default:
@@ -996,6 +1184,41 @@ bool read_first_frame(const gmx_output_env_t*      oenv,
             break;
         }
         case efXTC:
+            if (xtc_is_vf_file(fn))
+            {
+                (*status)->bXtcVF = TRUE;
+                real vPrec, fPrec;
+                if (read_first_xtc_vf(fio,
+                                      &fr->natoms,
+                                      &fr->step,
+                                      &fr->time,
+                                      fr->box,
+                                      &fr->v,
+                                      &vPrec,
+                                      &fr->bV,
+                                      &fr->f,
+                                      &fPrec,
+                                      &fr->bF,
+                                      &bOK)
+                    == 0)
+                {
+                    fr->not_ok = DATA_NOT_OK;
+                }
+                if (fr->not_ok)
+                {
+                    fr->natoms = 0;
+                    printincomp(*status, fr);
+                }
+                else
+                {
+                    fr->bStep = TRUE;
+                    fr->bTime = TRUE;
+                    fr->bBox  = TRUE;
+                    printcount(*status, oenv, fr->time, FALSE);
+                }
+                bFirst = FALSE;
+                break;
+            }
             if (read_first_xtc(fio, &fr->natoms, &fr->step, &fr->time, fr->box, &fr->x, &fr->prec, &bOK) == 0)
             {
                 GMX_RELEASE_ASSERT(!bOK,
@@ -1030,6 +1253,11 @@ bool read_first_frame(const gmx_output_env_t*      oenv,
             else
             {
                 printcount(*status, oenv, fr->time, FALSE);
+                if (useTngReadAhead())
+                {
+                    (*status)->tngReadAhead = new TngFrameReadAhead((*status)->tng);
+                    (*status)->tngReadAhead->startReading(*fr);
+                }
             }
             bFirst = FALSE;
             break;
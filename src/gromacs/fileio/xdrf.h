@@ -56,6 +56,10 @@
 #define XTC_MAGIC 1995
 // New magic number used for (very) large XTC files with 64-bit data buffer size
 #define XTC_NEW_MAGIC 2023
+// Magic number for fragments of XTC frames with global atom indices, see xtcio.h
+#define XTC_FRAGMENT_MAGIC 2024
+// Magic number for XTC files with compressed velocities and/or forces, see xtcio.h
+#define XTC_VF_MAGIC 2025
 
 /* Until june 2023, the old XDR format could only store up to ~300M atoms.
  * To handle larger systems, we use a newer magic number (2023 instead of 1995).
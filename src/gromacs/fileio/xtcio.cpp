@@ -35,13 +35,18 @@
 
 #include "xtcio.h"
 
+#include <cctype>
 #include <cstring>
 
+#include <algorithm>
+#include <string>
+
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -80,6 +85,18 @@ void close_xtc(t_fileio* fio)
 
 static void check_xtc_magic(int magic)
 {
+    if (magic == XTC_FRAGMENT_MAGIC)
+    {
+        gmx_fatal(FARGS,
+                  "This is an XTC fragment file written by mdrun -xfrag, merge the fragment "
+                  "files into an XTC file with gmx trjcat first");
+    }
+    if (magic == XTC_VF_MAGIC)
+    {
+        gmx_fatal(FARGS,
+                  "This XTC file contains compressed velocities and/or forces, which can only "
+                  "be read as a trajectory frame, not as coordinates");
+    }
     if (magic != XTC_MAGIC && magic != XTC_NEW_MAGIC)
     {
         gmx_fatal(FARGS, "Magic Number Error in XTC file (read %d, should be %d or %d)", magic, XTC_MAGIC, XTC_NEW_MAGIC);
@@ -133,37 +150,34 @@ static int xtc_header(XDR* xd, int* magic, int* natoms, int64_t* step, real* tim
     return result;
 }
 
-static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, int magic_number, gmx_bool bRead)
+static int xtc_box(XDR* xd, rvec* box, gmx_bool bRead)
 {
-    int i, j, result;
-#if GMX_DOUBLE
-    float* ftmp;
-    float  fprec;
-#endif
-
-    /* box */
-    result = 1;
-    for (i = 0; ((i < DIM) && result); i++)
+    int result = 1;
+    for (int i = 0; ((i < DIM) && result); i++)
     {
-        for (j = 0; ((j < DIM) && result); j++)
+        for (int j = 0; ((j < DIM) && result); j++)
         {
             result = XTC_CHECK("box", xdr_r2f(xd, &(box[i][j]), bRead));
         }
     }
+    return result;
+}
 
-    if (!result)
-    {
-        return result;
-    }
-
+/* Reads or writes natoms vectors x with precision prec using xdr3dfcoord */
+static int xtc_vectors(XDR* xd, int* natoms, rvec* x, real* prec, int magic_number, gmx_bool gmx_unused bRead)
+{
+    int result;
 #if GMX_DOUBLE
+    float* ftmp;
+    float  fprec;
+
     /* allocate temp. single-precision array */
     snew(ftmp, (*natoms) * DIM);
 
     /* Copy data to temp. array if writing */
     if (!bRead)
     {
-        for (i = 0; (i < *natoms); i++)
+        for (int i = 0; (i < *natoms); i++)
         {
             ftmp[DIM * i + XX] = x[i][XX];
             ftmp[DIM * i + YY] = x[i][YY];
@@ -176,7 +190,7 @@ static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, int m
     /* Copy from temp. array if reading */
     if (bRead)
     {
-        for (i = 0; (i < *natoms); i++)
+        for (int i = 0; (i < *natoms); i++)
         {
             x[i][XX] = ftmp[DIM * i + XX];
             x[i][YY] = ftmp[DIM * i + YY];
@@ -192,6 +206,16 @@ static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, int m
     return result;
 }
 
+static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, int magic_number, gmx_bool bRead)
+{
+    if (!xtc_box(xd, box, bRead))
+    {
+        return 0;
+    }
+
+    return xtc_vectors(xd, natoms, x, prec, magic_number, bRead);
+}
+
 
 int write_xtc(t_fileio* fio, int natoms, int64_t step, real time, const rvec* box, const rvec* x, real prec)
 {
@@ -283,3 +307,394 @@ int read_next_xtc(t_fileio* fio, int natoms, int64_t* step, real* time, matrix b
 
     return static_cast<int>(*bOK);
 }
+
+/* Reads count bytes of XDR opaque data, in batches that fit in an unsigned int */
+static int xtc_do_opaque(XDR* xd, char* data, std::size_t count)
+{
+    int rc = 1;
+    while (rc != 0 && count > 0)
+    {
+        // Max batch size is largest 4-tuple that fits in signed 32-bit int
+        std::size_t batchSize = std::min(count, static_cast<std::size_t>(2147483644));
+        rc                    = xdr_opaque(xd, data, static_cast<unsigned int>(batchSize));
+        data += batchSize;
+        count -= batchSize;
+    }
+    return rc;
+}
+
+int read_next_xtc_encoded(t_fileio*          fio,
+                          int*               magic,
+                          int*               natoms,
+                          int64_t*           step,
+                          real*              time,
+                          std::vector<char>* frameData,
+                          gmx_bool*          bOK)
+{
+    *bOK    = TRUE;
+    XDR* xd = gmx_fio_getxdr(fio);
+
+    if (!xtc_header(xd, magic, natoms, step, time, TRUE, bOK))
+    {
+        return 0;
+    }
+    check_xtc_magic(*magic);
+
+    /* Determine the size of the encoded box and coordinates by only
+     * reading the fields of xdr3dfcoord that determine its length.
+     */
+    const gmx_off_t dataStart = gmx_fio_ftell(fio);
+    gmx_off_t       dataSize  = DIM * DIM * sizeof(float);
+    int             size      = 0;
+    int             result    = 0;
+    if (gmx_fio_seek(fio, dataStart + dataSize) == 0)
+    {
+        result = XTC_CHECK("natoms", xdr_int(xd, &size));
+    }
+    dataSize += sizeof(int);
+    if (result && size != *natoms)
+    {
+        result = 0;
+    }
+    if (result)
+    {
+        if (size <= 9)
+        {
+            /* Small systems are stored uncompressed */
+            dataSize += size * DIM * sizeof(float);
+        }
+        else
+        {
+            /* Skip precision, minint, maxint and smallidx */
+            dataSize += sizeof(float) + 7 * sizeof(int);
+            gmx_off_t byteCount = 0;
+            if (gmx_fio_seek(fio, dataStart + dataSize) != 0)
+            {
+                result = 0;
+            }
+            else if (*magic == XTC_NEW_MAGIC)
+            {
+                int64_t count = 0;
+                result        = XTC_CHECK("byte count", xdr_int64(xd, &count));
+                byteCount     = count;
+                dataSize += sizeof(int64_t);
+            }
+            else
+            {
+                int count = 0;
+                result    = XTC_CHECK("byte count", xdr_int(xd, &count));
+                byteCount = count;
+                dataSize += sizeof(int);
+            }
+            /* XDR pads opaque data to a multiple of four bytes */
+            dataSize += (byteCount + 3) / 4 * 4;
+        }
+    }
+    if (result)
+    {
+        frameData->resize(dataSize);
+        result = (gmx_fio_seek(fio, dataStart) == 0)
+                 && XTC_CHECK("frame data", xtc_do_opaque(xd, frameData->data(), dataSize));
+    }
+    *bOK = (result != 0);
+
+    return result;
+}
+
+int write_xtc_encoded(t_fileio*                 fio,
+                      int                       magic,
+                      int                       natoms,
+                      int64_t                   step,
+                      real                      time,
+                      gmx::ArrayRef<const char> frameData)
+{
+    XDR*     xd = gmx_fio_getxdr(fio);
+    gmx_bool bDum;
+
+    if (xtc_header(xd, &magic, &natoms, &step, &time, FALSE, &bDum) == 0)
+    {
+        return 0;
+    }
+    int bOK = XTC_CHECK("frame data",
+                        xtc_do_opaque(xd, const_cast<char*>(frameData.data()), frameData.size()));
+    if (bOK)
+    {
+        if (gmx_fio_flush(fio) != 0)
+        {
+            bOK = 0;
+        }
+    }
+    return bOK;
+}
+
+int write_xtc_fragment(t_fileio*                      fio,
+                       int                            natomsTotal,
+                       int64_t                        step,
+                       real                           time,
+                       const rvec*                    box,
+                       gmx::ArrayRef<const int>       atomIndices,
+                       gmx::ArrayRef<const gmx::RVec> x,
+                       real                           prec)
+{
+    GMX_RELEASE_ASSERT(atomIndices.size() == x.size(), "Need one index per coordinate");
+
+    int      magic      = XTC_FRAGMENT_MAGIC;
+    int      natoms     = x.ssize();
+    int      coordMagic = (natoms > XTC_1995_MAX_NATOMS) ? XTC_NEW_MAGIC : XTC_MAGIC;
+    XDR*     xd         = gmx_fio_getxdr(fio);
+    gmx_bool bDum;
+
+    if (xtc_header(xd, &magic, &natomsTotal, &step, &time, FALSE, &bDum) == 0)
+    {
+        return 0;
+    }
+    int bOK = XTC_CHECK("natoms", xdr_int(xd, &natoms)) && XTC_CHECK("magic", xdr_int(xd, &coordMagic))
+              && XTC_CHECK("indices",
+                           xdr_vector(xd,
+                                      reinterpret_cast<char*>(const_cast<int*>(atomIndices.data())),
+                                      natoms,
+                                      sizeof(int),
+                                      reinterpret_cast<xdrproc_t>(xdr_int)))
+              && xtc_coord(xd,
+                           &natoms,
+                           const_cast<rvec*>(box),
+                           const_cast<rvec*>(as_rvec_array(x.data())),
+                           &prec,
+                           coordMagic,
+                           FALSE);
+    if (bOK)
+    {
+        if (gmx_fio_flush(fio) != 0)
+        {
+            bOK = 0;
+        }
+    }
+    return bOK;
+}
+
+int read_next_xtc_fragment(t_fileio*               fio,
+                           int*                    natomsTotal,
+                           int64_t*                step,
+                           real*                   time,
+                           matrix                  box,
+                           std::vector<int>*       atomIndices,
+                           std::vector<gmx::RVec>* x,
+                           real*                   prec,
+                           gmx_bool*               bOK)
+{
+    int  magic;
+    int  natoms     = 0;
+    int  coordMagic = 0;
+    XDR* xd         = gmx_fio_getxdr(fio);
+
+    *bOK = TRUE;
+    if (!xtc_header(xd, &magic, natomsTotal, step, time, TRUE, bOK))
+    {
+        return 0;
+    }
+    if (magic != XTC_FRAGMENT_MAGIC)
+    {
+        gmx_fatal(FARGS,
+                  "Magic Number Error in XTC fragment file %s (read %d, should be %d)",
+                  gmx_fio_getname(fio).u8string().c_str(),
+                  magic,
+                  XTC_FRAGMENT_MAGIC);
+    }
+    int result = XTC_CHECK("natoms", xdr_int(xd, &natoms)) && XTC_CHECK("magic", xdr_int(xd, &coordMagic));
+    if (result && (natoms < 0 || natoms > *natomsTotal))
+    {
+        result = 0;
+    }
+    if (result)
+    {
+        atomIndices->resize(natoms);
+        x->resize(natoms);
+        result = XTC_CHECK("indices",
+                           xdr_vector(xd,
+                                      reinterpret_cast<char*>(atomIndices->data()),
+                                      natoms,
+                                      sizeof(int),
+                                      reinterpret_cast<xdrproc_t>(xdr_int)))
+                 && xtc_coord(xd, &natoms, box, as_rvec_array(x->data()), prec, coordMagic, TRUE);
+    }
+    *bOK = (result != 0);
+
+    return result;
+}
+
+gmx_bool xtc_is_fragment_file(const std::filesystem::path& filename)
+{
+    t_fileio* fio       = open_xtc(filename, "r");
+    int       magic     = 0;
+    gmx_bool  bFragment = (xdr_int(gmx_fio_getxdr(fio), &magic) != 0 && magic == XTC_FRAGMENT_MAGIC);
+    close_xtc(fio);
+
+    return bFragment;
+}
+
+std::filesystem::path xtc_fragment_filename(const std::filesystem::path& filename, int fragmentIndex)
+{
+    std::filesystem::path fragmentName = filename;
+    fragmentName.replace_filename(filename.stem().u8string() + "_frag" + std::to_string(fragmentIndex)
+                                  + filename.extension().u8string());
+    return fragmentName;
+}
+
+gmx_bool xtc_is_fragment_filename(const std::filesystem::path& fragmentName,
+                                  const std::filesystem::path& filename)
+{
+    const std::string prefix = filename.stem().u8string() + "_frag";
+    const std::string stem   = fragmentName.stem().u8string();
+    if (fragmentName.parent_path() != filename.parent_path()
+        || fragmentName.extension() != filename.extension() || stem.size() <= prefix.size()
+        || stem.compare(0, prefix.size(), prefix) != 0)
+    {
+        return FALSE;
+    }
+    return std::all_of(stem.begin() + prefix.size(), stem.end(), [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) != 0;
+    });
+}
+
+//! Flags for the contents of a frame in an XTC file with velocities and forces
+enum
+{
+    XTC_VF_HAS_V = (1 << 0),
+    XTC_VF_HAS_F = (1 << 1)
+};
+
+int write_xtc_vf(t_fileio*   fio,
+                 int         natoms,
+                 int64_t     step,
+                 real        time,
+                 const rvec* box,
+                 const rvec* v,
+                 real        vPrec,
+                 const rvec* f,
+                 real        fPrec)
+{
+    int      magic      = XTC_VF_MAGIC;
+    int      coordMagic = (natoms > XTC_1995_MAX_NATOMS) ? XTC_NEW_MAGIC : XTC_MAGIC;
+    int      contents   = (v ? XTC_VF_HAS_V : 0) | (f ? XTC_VF_HAS_F : 0);
+    XDR*     xd         = gmx_fio_getxdr(fio);
+    gmx_bool bDum;
+
+    if (xtc_header(xd, &magic, &natoms, &step, &time, FALSE, &bDum) == 0)
+    {
+        return 0;
+    }
+    int bOK = XTC_CHECK("contents", xdr_int(xd, &contents)) && XTC_CHECK("magic", xdr_int(xd, &coordMagic))
+              && xtc_box(xd, const_cast<rvec*>(box), FALSE);
+    if (bOK && v)
+    {
+        bOK = xtc_vectors(xd, &natoms, const_cast<rvec*>(v), &vPrec, coordMagic, FALSE);
+    }
+    if (bOK && f)
+    {
+        bOK = xtc_vectors(xd, &natoms, const_cast<rvec*>(f), &fPrec, coordMagic, FALSE);
+    }
+    if (bOK)
+    {
+        if (gmx_fio_flush(fio) != 0)
+        {
+            bOK = 0;
+        }
+    }
+    return bOK;
+}
+
+int read_next_xtc_vf(t_fileio* fio,
+                     int       natoms,
+                     int64_t*  step,
+                     real*     time,
+                     matrix    box,
+                     rvec*     v,
+                     real*     vPrec,
+                     gmx_bool* bV,
+                     rvec*     f,
+                     real*     fPrec,
+                     gmx_bool* bF,
+                     gmx_bool* bOK)
+{
+    int  magic;
+    int  n;
+    int  contents   = 0;
+    int  coordMagic = 0;
+    XDR* xd         = gmx_fio_getxdr(fio);
+
+    *bOK = TRUE;
+    *bV  = FALSE;
+    *bF  = FALSE;
+    if (!xtc_header(xd, &magic, &n, step, time, TRUE, bOK))
+    {
+        return 0;
+    }
+    if (magic != XTC_VF_MAGIC)
+    {
+        gmx_fatal(FARGS,
+                  "Magic Number Error in XTC velocity and force file %s (read %d, should be %d)",
+                  gmx_fio_getname(fio).u8string().c_str(),
+                  magic,
+                  XTC_VF_MAGIC);
+    }
+    if (n > natoms)
+    {
+        gmx_fatal(FARGS, "Frame contains more atoms (%d) than expected (%d)", n, natoms);
+    }
+    int result = XTC_CHECK("contents", xdr_int(xd, &contents))
+                 && XTC_CHECK("magic", xdr_int(xd, &coordMagic)) && xtc_box(xd, box, TRUE);
+    if (result && (contents & XTC_VF_HAS_V))
+    {
+        result = xtc_vectors(xd, &n, v, vPrec, coordMagic, TRUE);
+        *bV    = (result != 0);
+    }
+    if (result && (contents & XTC_VF_HAS_F))
+    {
+        result = xtc_vectors(xd, &n, f, fPrec, coordMagic, TRUE);
+        *bF    = (result != 0);
+    }
+    *bOK = (result != 0);
+
+    return result;
+}
+
+int read_first_xtc_vf(t_fileio* fio,
+                      int*      natoms,
+                      int64_t*  step,
+                      real*     time,
+                      matrix    box,
+                      rvec**    v,
+                      real*     vPrec,
+                      gmx_bool* bV,
+                      rvec**    f,
+                      real*     fPrec,
+                      gmx_bool* bF,
+                      gmx_bool* bOK)
+{
+    /* Peek at the number of atoms in the header, so we can allocate */
+    XDR*      xd     = gmx_fio_getxdr(fio);
+    gmx_off_t offset = gmx_fio_ftell(fio);
+    int       magic  = 0;
+    *natoms          = 0;
+    *bOK             = TRUE;
+    if (!(xdr_int(xd, &magic) && xdr_int(xd, natoms)) || gmx_fio_seek(fio, offset) != 0)
+    {
+        *bOK = FALSE;
+        return 0;
+    }
+
+    snew(*v, *natoms);
+    snew(*f, *natoms);
+
+    return read_next_xtc_vf(fio, *natoms, step, time, box, *v, vPrec, bV, *f, fPrec, bF, bOK);
+}
+
+gmx_bool xtc_is_vf_file(const std::filesystem::path& filename)
+{
+    t_fileio* fio   = open_xtc(filename, "r");
+    int       magic = 0;
+    gmx_bool  bVF   = (xdr_int(gmx_fio_getxdr(fio), &magic) != 0 && magic == XTC_VF_MAGIC);
+    close_xtc(fio);
+
+    return bVF;
+}
@@ -36,8 +36,10 @@
 #define GMX_FILEIO_XTCIO_H
 
 #include <filesystem>
+#include <vector>
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
@@ -76,4 +78,120 @@ int read_next_xtc(struct t_fileio* fio, int natoms, int64_t* step, real* time, m
 int write_xtc(struct t_fileio* fio, int natoms, int64_t step, real time, const rvec* box, const rvec* x, real prec);
 /* Write a frame to xtc file */
 
+int read_next_xtc_encoded(struct t_fileio*   fio,
+                          int*               magic,
+                          int*               natoms,
+                          int64_t*           step,
+                          real*              time,
+                          std::vector<char>* frameData,
+                          gmx_bool*          bOK);
+/* Read the next frame without decoding the box and coordinates.
+ * The header fields are returned separately, all data following the
+ * header is returned in frameData in its XDR encoding. This is much
+ * cheaper than read_next_xtc, as the coordinates are not decompressed.
+ */
+
+int write_xtc_encoded(struct t_fileio*          fio,
+                      int                       magic,
+                      int                       natoms,
+                      int64_t                   step,
+                      real                      time,
+                      gmx::ArrayRef<const char> frameData);
+/* Write a frame read with read_next_xtc_encoded, possibly with changed
+ * step and time, to an xtc file.
+ */
+
+/* XTC fragment files contain, for each output step, the compressed
+ * coordinates of a subset of the atoms of a frame together with the
+ * indices of these atoms in the full frame. They are written by each
+ * rank with mdrun -xfrag and can be merged into a normal xtc file with
+ * gmx trjcat. They use a different magic number, so they can not be
+ * read as xtc files by accident.
+ */
+
+int write_xtc_fragment(struct t_fileio*               fio,
+                       int                            natomsTotal,
+                       int64_t                        step,
+                       real                           time,
+                       const rvec*                    box,
+                       gmx::ArrayRef<const int>       atomIndices,
+                       gmx::ArrayRef<const gmx::RVec> x,
+                       real                           prec);
+/* Write the coordinates x of the atoms with indices atomIndices in a
+ * frame with natomsTotal atoms to an xtc fragment file
+ */
+
+int read_next_xtc_fragment(struct t_fileio*        fio,
+                           int*                    natomsTotal,
+                           int64_t*                step,
+                           real*                   time,
+                           matrix                  box,
+                           std::vector<int>*       atomIndices,
+                           std::vector<gmx::RVec>* x,
+                           real*                   prec,
+                           gmx_bool*               bOK);
+/* Read the next fragment from an xtc fragment file */
+
+gmx_bool xtc_is_fragment_file(const std::filesystem::path& filename);
+/* Returns whether filename starts with an xtc fragment */
+
+std::filesystem::path xtc_fragment_filename(const std::filesystem::path& filename, int fragmentIndex);
+/* Returns the name of fragment file fragmentIndex for xtc file filename,
+ * e.g. traj_comp_frag3.xtc for traj_comp.xtc
+ */
+
+gmx_bool xtc_is_fragment_filename(const std::filesystem::path& fragmentName,
+                                  const std::filesystem::path& filename);
+/* Returns whether fragmentName is the name of a fragment file for xtc file filename */
+
+/* XTC velocity and force files contain, for each output step, the
+ * velocities and/or the forces of all atoms compressed in the same way
+ * as the coordinates in an xtc file, each with its own precision.
+ * They use a different magic number and can be read with read_first_frame.
+ */
+
+int write_xtc_vf(struct t_fileio* fio,
+                 int              natoms,
+                 int64_t          step,
+                 real             time,
+                 const rvec*      box,
+                 const rvec*      v,
+                 real             vPrec,
+                 const rvec*      f,
+                 real             fPrec);
+/* Write a frame with velocities v and/or forces f, both can be nullptr */
+
+int read_first_xtc_vf(struct t_fileio* fio,
+                      int*             natoms,
+                      int64_t*         step,
+                      real*            time,
+                      matrix           box,
+                      rvec**           v,
+                      real*            vPrec,
+                      gmx_bool*        bV,
+                      rvec**           f,
+                      real*            fPrec,
+                      gmx_bool*        bF,
+                      gmx_bool*        bOK);
+/* Read the first frame of an xtc velocity and force file, allocate v and f.
+ * bV and bF tell whether the frame contains velocities and forces.
+ */
+
+int read_next_xtc_vf(struct t_fileio* fio,
+                     int              natoms,
+                     int64_t*         step,
+                     real*            time,
+                     matrix           box,
+                     rvec*            v,
+                     real*            vPrec,
+                     gmx_bool*        bV,
+                     rvec*            f,
+                     real*            fPrec,
+                     gmx_bool*        bF,
+                     gmx_bool*        bOK);
+/* Read subsequent frames of an xtc velocity and force file */
+
+gmx_bool xtc_is_vf_file(const std::filesystem::path& filename);
+/* Returns whether filename starts with a frame with velocities and/or forces */
+
 #endif
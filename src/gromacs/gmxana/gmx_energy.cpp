@@ -39,6 +39,7 @@
 
 #include <algorithm>
 #include <array>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -64,8 +65,10 @@
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
@@ -330,11 +333,36 @@ static void einstein_visco(const char*             fn,
 {
     FILE * fp0, *fp1;
     double av[4], avold[4];
-    double fac, di;
-    int    i, j, m, nf4;
+    double fac;
+    int    i, m, nf4;
 
     nf4 = nint / 4 + 1;
 
+    /* The mean square displacements of the integrals for all time lags
+     * are independent and take O(nint^2) time in total, so we compute
+     * them in parallel before writing them in order.
+     */
+    std::vector<double> msd(static_cast<size_t>(nf4) * (nsets + 1), 0.0);
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic)
+    for (int lag = 0; lag < nf4; lag++)
+    {
+        try
+        {
+            double* msdLag = msd.data() + static_cast<size_t>(lag) * (nsets + 1);
+            for (int j = 0; j < nint - lag; j++)
+            {
+                for (int m = 0; m < nsets; m++)
+                {
+                    double di = gmx::square(eneint[m][j + lag] - eneint[m][j]);
+
+                    msdLag[m] += di;
+                    msdLag[nsets] += di / nsets;
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
     for (i = 0; i <= nsets; i++)
     {
         avold[i] = 0;
@@ -344,27 +372,13 @@ static void einstein_visco(const char*             fn,
             fn, "Shear viscosity using Einstein relation", "Time (ps)", "(kg m\\S-1\\N s\\S-1\\N)", oenv);
     for (i = 0; i < nf4; i++)
     {
-        for (m = 0; m <= nsets; m++)
-        {
-            av[m] = 0;
-        }
-        for (j = 0; j < nint - i; j++)
-        {
-            for (m = 0; m < nsets; m++)
-            {
-                di = gmx::square(eneint[m][j + i] - eneint[m][j]);
-
-                av[m] += di;
-                av[nsets] += di / nsets;
-            }
-        }
         /* Convert to SI for the viscosity */
         fac = (V * gmx::c_nano * gmx::c_nano * gmx::c_nano * gmx::c_pico * 1e10)
               / (2 * gmx::c_boltzmann * T) / (nint - i);
         fprintf(fp0, "%10g", i * dt);
         for (m = 0; (m <= nsets); m++)
         {
-            av[m] = fac * av[m];
+            av[m] = fac * msd[static_cast<size_t>(i) * (nsets + 1) + m];
             fprintf(fp0, "  %10g", av[m]);
         }
         fprintf(fp0, "\n");
@@ -428,11 +442,6 @@ static double calc_ee2(int nb, ee_sum_t* ees)
 
 static void set_ee_av(ener_ee_t* eee)
 {
-    if (debug)
-    {
-        char buf[STEPSTRSIZE];
-        fprintf(debug, "Storing average for err.est.: %s steps\n", gmx_step_str(eee->nst, buf));
-    }
     add_ee_av(&eee->sum);
     eee->b++;
     if (eee->b == 1 || eee->nst < eee->nst_min)
@@ -442,184 +451,185 @@ static void set_ee_av(ener_ee_t* eee)
     eee->nst = 0;
 }
 
-static void calc_averages(int nset, enerdata_t* edat, int nbmin, int nbmax)
+/*! \brief Computes the average, fluctuation, drift and block-averaging
+ * error estimate of energy term \p ed, using \p eee as buffer for nbmax+1 blocks */
+static void calc_term_averages(const enerdata_t* edat, enerdat_t* ed, int nbmin, int nbmax, ener_ee_t* eee)
 {
-    int         nb, i, f, nee;
+    int         nb, f, nee;
     double      sum, sum2, sump, see2;
     int64_t     np, p, bound_nb;
-    enerdat_t*  ed;
     exactsum_t* es;
-    gmx_bool    bAllZero;
     double      x, sx, sy, sxx, sxy;
-    ener_ee_t*  eee;
 
-    /* Check if we have exact statistics over all points */
-    for (i = 0; i < nset; i++)
+    sum  = 0;
+    sum2 = 0;
+    np   = 0;
+    sx   = 0;
+    sy   = 0;
+    sxx  = 0;
+    sxy  = 0;
+    for (nb = nbmin; nb <= nbmax; nb++)
     {
-        ed             = &edat->s[i];
-        ed->bExactStat = FALSE;
-        if (edat->bHaveSums)
+        eee[nb].b = 0;
+        clear_ee_sum(&eee[nb].sum);
+        eee[nb].nst     = 0;
+        eee[nb].nst_min = 0;
+    }
+    for (f = 0; f < edat->nframes; f++)
+    {
+        es = &ed->es[f];
+
+        if (ed->bExactStat)
         {
-            /* All energy file sum entries 0 signals no exact sums.
-             * But if all energy values are 0, we still have exact sums.
-             */
-            bAllZero = TRUE;
-            for (f = 0; f < edat->nframes && !ed->bExactStat; f++)
-            {
-                if (ed->ener[i] != 0)
-                {
-                    bAllZero = FALSE;
-                }
-                ed->bExactStat = (ed->es[f].sum != 0);
-            }
-            if (bAllZero)
+            /* Add the sum and the sum of variances to the totals. */
+            p    = edat->points[f];
+            sump = es->sum;
+            sum2 += es->sum2;
+            if (np > 0)
             {
-                ed->bExactStat = TRUE;
+                sum2 += gmx::square(sum / np - (sum + es->sum) / (np + p)) * np * (np + p) / p;
             }
         }
-    }
+        else
+        {
+            /* Add a single value to the sum and sum of squares. */
+            p    = 1;
+            sump = ed->ener[f];
+            sum2 += gmx::square(sump);
+        }
 
-    snew(eee, nbmax + 1);
-    for (i = 0; i < nset; i++)
-    {
-        ed = &edat->s[i];
+        /* sum has to be increased after sum2 */
+        np += p;
+        sum += sump;
+
+        /* For the linear regression use variance 1/p.
+         * Note that sump is the sum, not the average, so we don't need p*.
+         */
+        x = edat->step[f] - 0.5 * (edat->steps[f] - 1);
+        sx += p * x;
+        sy += sump;
+        sxx += p * x * x;
+        sxy += x * sump;
 
-        sum  = 0;
-        sum2 = 0;
-        np   = 0;
-        sx   = 0;
-        sy   = 0;
-        sxx  = 0;
-        sxy  = 0;
         for (nb = nbmin; nb <= nbmax; nb++)
         {
-            eee[nb].b = 0;
-            clear_ee_sum(&eee[nb].sum);
-            eee[nb].nst     = 0;
-            eee[nb].nst_min = 0;
-        }
-        for (f = 0; f < edat->nframes; f++)
-        {
-            es = &ed->es[f];
-
+            /* Check if the current end step is closer to the desired
+             * block boundary than the next end step.
+             */
+            bound_nb = (edat->step[0] - 1) * nb + edat->nsteps * (eee[nb].b + 1);
+            if (eee[nb].nst > 0 && bound_nb - edat->step[f - 1] * nb < edat->step[f] * nb - bound_nb)
+            {
+                set_ee_av(&eee[nb]);
+            }
+            if (f == 0)
+            {
+                eee[nb].nst = 1;
+            }
+            else
+            {
+                eee[nb].nst += edat->step[f] - edat->step[f - 1];
+            }
             if (ed->bExactStat)
             {
-                /* Add the sum and the sum of variances to the totals. */
-                p    = edat->points[f];
-                sump = es->sum;
-                sum2 += es->sum2;
-                if (np > 0)
-                {
-                    sum2 += gmx::square(sum / np - (sum + es->sum) / (np + p)) * np * (np + p) / p;
-                }
+                add_ee_sum(&eee[nb].sum, es->sum, edat->points[f]);
             }
             else
             {
-                /* Add a single value to the sum and sum of squares. */
-                p    = 1;
-                sump = ed->ener[f];
-                sum2 += gmx::square(sump);
+                add_ee_sum(&eee[nb].sum, ed->ener[f], 1);
             }
-
-            /* sum has to be increased after sum2 */
-            np += p;
-            sum += sump;
-
-            /* For the linear regression use variance 1/p.
-             * Note that sump is the sum, not the average, so we don't need p*.
-             */
-            x = edat->step[f] - 0.5 * (edat->steps[f] - 1);
-            sx += p * x;
-            sy += sump;
-            sxx += p * x * x;
-            sxy += x * sump;
-
-            for (nb = nbmin; nb <= nbmax; nb++)
-            {
-                /* Check if the current end step is closer to the desired
-                 * block boundary than the next end step.
-                 */
-                bound_nb = (edat->step[0] - 1) * nb + edat->nsteps * (eee[nb].b + 1);
-                if (eee[nb].nst > 0 && bound_nb - edat->step[f - 1] * nb < edat->step[f] * nb - bound_nb)
-                {
-                    set_ee_av(&eee[nb]);
-                }
-                if (f == 0)
-                {
-                    eee[nb].nst = 1;
-                }
-                else
-                {
-                    eee[nb].nst += edat->step[f] - edat->step[f - 1];
-                }
-                if (ed->bExactStat)
-                {
-                    add_ee_sum(&eee[nb].sum, es->sum, edat->points[f]);
-                }
-                else
-                {
-                    add_ee_sum(&eee[nb].sum, edat->s[i].ener[f], 1);
-                }
-                bound_nb = (edat->step[0] - 1) * nb + edat->nsteps * (eee[nb].b + 1);
-                if (edat->step[f] * nb >= bound_nb)
-                {
-                    set_ee_av(&eee[nb]);
-                }
+            bound_nb = (edat->step[0] - 1) * nb + edat->nsteps * (eee[nb].b + 1);
+            if (edat->step[f] * nb >= bound_nb)
+            {
+                set_ee_av(&eee[nb]);
             }
         }
+    }
 
-        edat->s[i].av = sum / np;
-        if (ed->bExactStat)
-        {
-            edat->s[i].rmsd = std::sqrt(sum2 / np);
-        }
-        else
-        {
-            edat->s[i].rmsd = std::sqrt(std::max(sum2 / np - gmx::square(edat->s[i].av), 0.0));
-        }
+    ed->av = sum / np;
+    if (ed->bExactStat)
+    {
+        ed->rmsd = std::sqrt(sum2 / np);
+    }
+    else
+    {
+        ed->rmsd = std::sqrt(std::max(sum2 / np - gmx::square(ed->av), 0.0));
+    }
 
-        if (edat->nframes > 1)
-        {
-            edat->s[i].slope = (np * sxy - sx * sy) / (np * sxx - sx * sx);
-        }
-        else
+    if (edat->nframes > 1)
+    {
+        ed->slope = (np * sxy - sx * sy) / (np * sxx - sx * sx);
+    }
+    else
+    {
+        ed->slope = 0;
+    }
+
+    nee  = 0;
+    see2 = 0;
+    for (nb = nbmin; nb <= nbmax; nb++)
+    {
+        /* Check if we actually got nb blocks and if the smallest
+         * block is not shorter than 80% of the average.
+         */
+        if (eee[nb].b == nb && 5 * nb * eee[nb].nst_min >= 4 * edat->nsteps)
         {
-            edat->s[i].slope = 0;
+            see2 += calc_ee2(nb, &eee[nb].sum);
+            nee++;
         }
+    }
+    if (nee > 0)
+    {
+        ed->ee = std::sqrt(see2 / nee);
+    }
+    else
+    {
+        ed->ee = -1;
+    }
+}
 
-        nee  = 0;
-        see2 = 0;
-        for (nb = nbmin; nb <= nbmax; nb++)
+static void calc_averages(int nset, enerdata_t* edat, int nbmin, int nbmax)
+{
+    int        i, f;
+    enerdat_t* ed;
+    gmx_bool   bAllZero;
+
+    /* Check if we have exact statistics over all points */
+    for (i = 0; i < nset; i++)
+    {
+        ed             = &edat->s[i];
+        ed->bExactStat = FALSE;
+        if (edat->bHaveSums)
         {
-            /* Check if we actually got nb blocks and if the smallest
-             * block is not shorter than 80% of the average.
+            /* All energy file sum entries 0 signals no exact sums.
+             * But if all energy values are 0, we still have exact sums.
              */
-            if (debug)
+            bAllZero = TRUE;
+            for (f = 0; f < edat->nframes && !ed->bExactStat; f++)
             {
-                char buf1[STEPSTRSIZE], buf2[STEPSTRSIZE];
-                fprintf(debug,
-                        "Requested %d blocks, we have %d blocks, min %s nsteps %s\n",
-                        nb,
-                        eee[nb].b,
-                        gmx_step_str(eee[nb].nst_min, buf1),
-                        gmx_step_str(edat->nsteps, buf2));
+                if (ed->ener[i] != 0)
+                {
+                    bAllZero = FALSE;
+                }
+                ed->bExactStat = (ed->es[f].sum != 0);
             }
-            if (eee[nb].b == nb && 5 * nb * eee[nb].nst_min >= 4 * edat->nsteps)
+            if (bAllZero)
             {
-                see2 += calc_ee2(nb, &eee[nb].sum);
-                nee++;
+                ed->bExactStat = TRUE;
             }
         }
-        if (nee > 0)
-        {
-            edat->s[i].ee = std::sqrt(see2 / nee);
-        }
-        else
+    }
+
+    /* The terms are independent, so we process them in parallel */
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic)
+    for (int i = 0; i < nset; i++)
+    {
+        try
         {
-            edat->s[i].ee = -1;
+            std::vector<ener_ee_t> eee(nbmax + 1);
+            calc_term_averages(edat, &edat->s[i], nbmin, nbmax, eee.data());
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
-    sfree(eee);
 }
 
 static enerdata_t* calc_sum(int nset, enerdata_t* edat, int nbmin, int nbmax)
@@ -669,6 +679,201 @@ static enerdata_t* calc_sum(int nset, enerdata_t* edat, int nbmin, int nbmax)
     return esum;
 }
 
+/*! \brief Sums for the average, fluctuation and drift of an energy term
+ *
+ * The points are added one frame at a time, with the same weights as
+ * in calc_term_averages().
+ */
+struct EnergyStreamSums
+{
+    int64_t np   = 0;
+    double  sum  = 0;
+    double  sum2 = 0;
+    double  sx   = 0;
+    double  sy   = 0;
+    double  sxx  = 0;
+    double  sxy  = 0;
+};
+
+//! The block averages at one level of binary blocking
+struct EnergyBlockLevel
+{
+    bool    bPending = false;
+    double  pending  = 0;
+    int     nb       = 0;
+    double  sav      = 0;
+    double  sav2     = 0;
+};
+
+/*! \brief Single-pass statistics of an energy term
+ *
+ * The error estimate uses binary blocking (Flyvbjerg and Petersen):
+ * level k stores the averages of blocks of 2^k frames, so the memory
+ * use is logarithmic in the number of frames. The statistics are
+ * gathered both over the single frame values and over the exact sums,
+ * since we only know which ones to use after reading the whole file.
+ */
+struct EnergyStream
+{
+    EnergyStreamSums              frameSums;
+    EnergyStreamSums              exactSums;
+    std::vector<EnergyBlockLevel> frameLevels;
+    std::vector<EnergyBlockLevel> exactLevels;
+    bool                          bNonZeroSums = false;
+    bool                          bAllZero     = true;
+};
+
+//! The number of frames read before the statistics are updated with -stream
+static constexpr int c_energyStreamChunkSize = 1000;
+
+//! Adds \p value to the lowest level of \p levels, and pairs of block averages to higher levels
+static void add_block_value(std::vector<EnergyBlockLevel>* levels, double value)
+{
+    for (size_t k = 0;; k++)
+    {
+        if (k == levels->size())
+        {
+            levels->emplace_back();
+        }
+        EnergyBlockLevel& level = (*levels)[k];
+        level.nb++;
+        level.sav += value;
+        level.sav2 += value * value;
+        if (!level.bPending)
+        {
+            level.pending  = value;
+            level.bPending = true;
+            break;
+        }
+        value          = 0.5 * (level.pending + value);
+        level.bPending = false;
+    }
+}
+
+/*! \brief Returns the error estimate of the average for the largest blocks
+ * of which there are at least \p nbmin, -1 when there are too few frames */
+static double block_error_estimate(gmx::ArrayRef<const EnergyBlockLevel> levels, int nbmin)
+{
+    double ee = -1;
+    for (const EnergyBlockLevel& level : levels)
+    {
+        if (level.nb >= std::max(nbmin, 2))
+        {
+            const double av = level.sav / level.nb;
+            ee = std::sqrt(std::max(level.sav2 / level.nb - av * av, 0.0) / (level.nb - 1));
+        }
+    }
+    return ee;
+}
+
+//! Adds the data of the \p nframes frames in \p edat for term \p ed to \p stream
+static void add_stream_frames(const enerdata_t* edat, const enerdat_t& ed, int nframes, EnergyStream* stream)
+{
+    for (int f = 0; f < nframes; f++)
+    {
+        const double       e  = ed.ener[f];
+        const exactsum_t&  es = ed.es[f];
+        const int64_t      p  = edat->points[f];
+        const double       x  = edat->step[f] - 0.5 * (edat->steps[f] - 1);
+        EnergyStreamSums&  fs = stream->frameSums;
+        EnergyStreamSums&  xs = stream->exactSums;
+
+        fs.sum2 += e * e;
+        fs.np += 1;
+        fs.sum += e;
+        fs.sx += x;
+        fs.sy += e;
+        fs.sxx += x * x;
+        fs.sxy += x * e;
+        add_block_value(&stream->frameLevels, e);
+
+        if (p > 0)
+        {
+            xs.sum2 += es.sum2;
+            if (xs.np > 0)
+            {
+                xs.sum2 += gmx::square(xs.sum / xs.np - (xs.sum + es.sum) / (xs.np + p)) * xs.np
+                           * (xs.np + p) / p;
+            }
+            xs.np += p;
+            xs.sum += es.sum;
+            xs.sx += p * x;
+            xs.sy += es.sum;
+            xs.sxx += p * x * x;
+            xs.sxy += x * es.sum;
+            add_block_value(&stream->exactLevels, es.sum / p);
+        }
+
+        stream->bNonZeroSums = stream->bNonZeroSums || (es.sum != 0);
+        stream->bAllZero     = stream->bAllZero && (e == 0);
+    }
+}
+
+/*! \brief Adds the \p nframes frames stored in \p edat to the streams of all terms
+ *
+ * With \p sumStream set, the sum of all terms is also added to it,
+ * \p sumBuffer is used for storing the sums.
+ */
+static void add_energy_stream_chunk(int           nset,
+                                    enerdata_t*   edat,
+                                    int           nframes,
+                                    EnergyStream* streams,
+                                    EnergyStream* sumStream,
+                                    enerdat_t*    sumBuffer)
+{
+    /* The terms are independent, so we process them in parallel */
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic)
+    for (int i = 0; i < nset; i++)
+    {
+        try
+        {
+            add_stream_frames(edat, edat->s[i], nframes, &streams[i]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    if (sumStream)
+    {
+        for (int f = 0; f < nframes; f++)
+        {
+            sumBuffer->ener[f]    = 0;
+            sumBuffer->es[f].sum  = 0;
+            sumBuffer->es[f].sum2 = 0;
+            for (int i = 0; i < nset; i++)
+            {
+                sumBuffer->ener[f] += edat->s[i].ener[f];
+                sumBuffer->es[f].sum += edat->s[i].es[f].sum;
+            }
+        }
+        add_stream_frames(edat, *sumBuffer, nframes, sumStream);
+    }
+}
+
+//! Sets the statistics of \p ed from \p stream
+static void set_stream_averages(const enerdata_t* edat, const EnergyStream& stream, int nbmin, enerdat_t* ed)
+{
+    ed->bExactStat = (edat->bHaveSums && (stream.bNonZeroSums || stream.bAllZero));
+
+    const EnergyStreamSums& s = (ed->bExactStat ? stream.exactSums : stream.frameSums);
+    ed->av                    = s.sum / s.np;
+    if (ed->bExactStat)
+    {
+        ed->rmsd = std::sqrt(s.sum2 / s.np);
+    }
+    else
+    {
+        ed->rmsd = std::sqrt(std::max(s.sum2 / s.np - gmx::square(ed->av), 0.0));
+    }
+    if (edat->nframes > 1)
+    {
+        ed->slope = (s.np * s.sxy - s.sx * s.sy) / (s.np * s.sxx - s.sx * s.sx);
+    }
+    else
+    {
+        ed->slope = 0;
+    }
+    ed->ee = block_error_estimate(ed->bExactStat ? stream.exactLevels : stream.frameLevels, nbmin);
+}
+
 static void ee_pr(double ee, int buflen, char* buf)
 {
     snprintf(buf, buflen, "%s", "--");
@@ -880,6 +1085,8 @@ static void analyse_ener(gmx_bool                         bCorr,
                          gmx_bool                         bSum,
                          gmx_bool                         bFluct,
                          gmx_bool                         bVisco,
+                         gmx_bool                         bStream,
+                         enerdata_t*                      esumStream,
                          const char*                      visfn,
                          int                              nmol,
                          int64_t                          start_step,
@@ -928,11 +1135,19 @@ static void analyse_ener(gmx_bool                         bCorr,
                 t,
                 nset);
 
-        calc_averages(nset, edat, nbmin, nbmax);
-
-        if (bSum)
+        if (bStream)
         {
-            esum = calc_sum(nset, edat, nbmin, nbmax);
+            /* The statistics have been computed while reading */
+            esum = esumStream;
+        }
+        else
+        {
+            calc_averages(nset, edat, nbmin, nbmax);
+
+            if (bSum)
+            {
+                esum = calc_sum(nset, edat, nbmin, nbmax);
+            }
         }
 
         if (!edat->bHaveSums)
@@ -1673,6 +1888,14 @@ int gmx_energy(int argc, char* argv[])
         "file, the statistics mentioned above are simply over the single, per-frame",
         "energy values.[PAR]",
 
+        "With [TT]-stream[tt] the statistics are computed while reading the energy file,",
+        "using memory that does not grow with the number of frames. The error estimate",
+        "then uses block averages over blocks of 2^k frames and takes the largest blocks",
+        "of which there are at least [TT]-nbmin[tt], so it can differ from the default",
+        "estimate. This can not be combined with options that need the energies of all",
+        "frames: [TT]-fee[tt], [TT]-fluc[tt], [TT]-fluct_props[tt], [TT]-vis[tt] and",
+        "[TT]-f2[tt].[PAR]",
+
         "The term fluctuation gives the RMSD around the least-squares fit.[PAR]",
 
         "Some fluctuation-dependent properties can be calculated provided",
@@ -1734,6 +1957,7 @@ int gmx_energy(int argc, char* argv[])
     };
     static gmx_bool bSum = FALSE, bFee = FALSE, bPrAll = FALSE, bFluct = FALSE, bDriftCorr = FALSE;
     static gmx_bool bDp = FALSE, bMutot = FALSE, bOrinst = FALSE, bOvec = FALSE, bFluctProps = FALSE;
+    gmx_bool        bStream = FALSE;
     static int      nmol = 1, nbmin = 5, nbmax = 5;
     static real     reftemp = 300.0, ezero = 0;
     t_pargs         pa[] = {
@@ -1785,7 +2009,12 @@ int gmx_energy(int argc, char* argv[])
           { &bFluct },
           "Calculate autocorrelation of energy fluctuations rather than energy itself" },
         { "-orinst", FALSE, etBOOL, { &bOrinst }, "Analyse instantaneous orientation data" },
-        { "-ovec", FALSE, etBOOL, { &bOvec }, "Also plot the eigenvectors with [TT]-oten[tt]" }
+        { "-ovec", FALSE, etBOOL, { &bOvec }, "Also plot the eigenvectors with [TT]-oten[tt]" },
+        { "-stream",
+          FALSE,
+          etBOOL,
+          { &bStream },
+          "Compute the statistics in a single pass without storing the energies of all frames" }
     };
     static const char* setnm[] = { "Pres-XX", "Pres-XY",     "Pres-XZ", "Pres-YX",
                                    "Pres-YY", "Pres-YZ",     "Pres-ZX", "Pres-ZY",
@@ -1843,11 +2072,24 @@ int gmx_energy(int argc, char* argv[])
     snew(frame, 2);
     fp = open_enx(ftp2fn(efEDR, NFILE, fnm), "r");
     do_enxnms(fp, &nre, &enm);
+    if (!bDHDL)
+    {
+        /* Only free-energy output uses the block data, skip it otherwise */
+        enx_skip_block_data(fp, TRUE);
+    }
 
     Vaver = -1;
 
     bVisco = opt2bSet("-vis", NFILE, fnm);
 
+    bStream = bStream && !bDHDL;
+    if (bStream && (bFee || bFluct || bFluctProps || bVisco || opt2bSet("-f2", NFILE, fnm)))
+    {
+        gmx_fatal(FARGS,
+                  "Option -stream can not be combined with -fee, -fluc, -fluct_props, -vis "
+                  "or -f2");
+    }
+
     t_inputrec  irInstance;
     t_inputrec* ir = &irInstance;
 
@@ -1956,6 +2198,29 @@ int gmx_energy(int argc, char* argv[])
     edat.bHaveSums = TRUE;
     snew(edat.s, nset);
 
+    /* With -stream the frame arrays only hold the frames since the last
+     * update of the statistics.
+     */
+    std::vector<EnergyStream> streams(bStream ? nset : 0);
+    EnergyStream              sumStream;
+    enerdat_t                 sumBuffer = {};
+    if (bStream)
+    {
+        snew(edat.step, c_energyStreamChunkSize);
+        snew(edat.steps, c_energyStreamChunkSize);
+        snew(edat.points, c_energyStreamChunkSize);
+        for (i = 0; i < nset; i++)
+        {
+            snew(edat.s[i].ener, c_energyStreamChunkSize);
+            snew(edat.s[i].es, c_energyStreamChunkSize);
+        }
+        if (bSum)
+        {
+            snew(sumBuffer.ener, c_energyStreamChunkSize);
+            snew(sumBuffer.es, c_energyStreamChunkSize);
+        }
+    }
+
     /* Initiate counters */
     bFoundStart = FALSE;
     start_step  = 0;
@@ -1984,7 +2249,7 @@ int gmx_energy(int argc, char* argv[])
                 /* The frame contains energies, so update cur */
                 cur = NEXT;
 
-                if (edat.nframes % 1000 == 0)
+                if (!bStream && edat.nframes % 1000 == 0)
                 {
                     srenew(edat.step, edat.nframes + 1000);
                     std::memset(&(edat.step[edat.nframes]), 0, 1000 * sizeof(edat.step[0]));
@@ -2002,7 +2267,7 @@ int gmx_energy(int argc, char* argv[])
                     }
                 }
 
-                nfr            = edat.nframes;
+                nfr            = bStream ? edat.nframes % c_energyStreamChunkSize : edat.nframes;
                 edat.step[nfr] = fr->step;
 
                 if (!bFoundStart)
@@ -2074,12 +2339,28 @@ int gmx_energy(int argc, char* argv[])
              */
             if (!bDHDL && (fr->nre > 0))
             {
-                if (edat.nframes % 1000 == 0)
+                if (bStream)
                 {
-                    srenew(time, edat.nframes + 1000);
+                    edat.nframes++;
+                    if (edat.nframes % c_energyStreamChunkSize == 0)
+                    {
+                        add_energy_stream_chunk(nset,
+                                                &edat,
+                                                c_energyStreamChunkSize,
+                                                streams.data(),
+                                                bSum ? &sumStream : nullptr,
+                                                &sumBuffer);
+                    }
+                }
+                else
+                {
+                    if (edat.nframes % 1000 == 0)
+                    {
+                        srenew(time, edat.nframes + 1000);
+                    }
+                    time[edat.nframes] = fr->t;
+                    edat.nframes++;
                 }
-                time[edat.nframes] = fr->t;
-                edat.nframes++;
             }
             if (bDHDL)
             {
@@ -2170,6 +2451,25 @@ int gmx_energy(int argc, char* argv[])
     }
     else
     {
+        enerdata_t esumStream = edat;
+        if (bStream)
+        {
+            add_energy_stream_chunk(nset,
+                                    &edat,
+                                    edat.nframes % c_energyStreamChunkSize,
+                                    streams.data(),
+                                    bSum ? &sumStream : nullptr,
+                                    &sumBuffer);
+            for (i = 0; i < nset; i++)
+            {
+                set_stream_averages(&edat, streams[i], nbmin, &edat.s[i]);
+            }
+            esumStream.s = &sumBuffer;
+            if (bSum)
+            {
+                set_stream_averages(&edat, sumStream, nbmin, &sumBuffer);
+            }
+        }
         double dt = (frame[cur].t - start_t) / (edat.nframes - 1);
         analyse_ener(opt2bSet("-corr", NFILE, fnm),
                      opt2fn("-corr", NFILE, fnm),
@@ -2179,6 +2479,8 @@ int gmx_energy(int argc, char* argv[])
                      bSum,
                      bFluct,
                      bVisco,
+                     bStream,
+                     &esumStream,
                      opt2fn("-vis", NFILE, fnm),
                      nmol,
                      start_step,
@@ -2208,6 +2510,8 @@ int gmx_energy(int argc, char* argv[])
     }
     // Clean up!
     done_enerdata_t(nset, &edat);
+    sfree(sumBuffer.ener);
+    sfree(sumBuffer.es);
     sfree(time);
     free_enxframe(&frame[0]);
     free_enxframe(&frame[1]);
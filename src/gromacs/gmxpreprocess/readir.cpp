@@ -584,6 +584,20 @@ void check_ir(const char*                    mdparin,
         }
     }
 
+    if ((ir->nstvout_compressed > 0 && ir->v_compression_precision <= 0)
+        || (ir->nstfout_compressed > 0 && ir->f_compression_precision <= 0))
+    {
+        wi->addError("compressed-v-precision and compressed-f-precision should be positive");
+    }
+    if (!EI_DYNAMICS(ir->eI) && (ir->nstvout_compressed > 0 || ir->nstfout_compressed > 0))
+    {
+        sprintf(warn_buf,
+                "Compressed velocity and force output is only supported with dynamical "
+                "integrators, it will not be written with integrator %s",
+                enumValueToString(ir->eI));
+        wi->addNote(warn_buf);
+    }
+
     if (ir->nsteps == 0 && !ir->bContinuation)
     {
         wi->addNote(
@@ -2284,6 +2298,11 @@ void get_ir(const char*     mdparin,
     printStringNoNewline(&inp, "trajectory file. You can select multiple groups. By");
     printStringNoNewline(&inp, "default, all atoms will be written.");
     setStringEntry(&inp, "compressed-x-grps", inputrecStrings->x_compressed_groups, nullptr);
+    printStringNoNewline(&inp, "Output frequency and precision for compressed velocities and forces");
+    ir->nstvout_compressed      = get_eint(&inp, "nstvout-compressed", 0, wi);
+    ir->nstfout_compressed      = get_eint(&inp, "nstfout-compressed", 0, wi);
+    ir->v_compression_precision = get_ereal(&inp, "compressed-v-precision", 1000.0, wi);
+    ir->f_compression_precision = get_ereal(&inp, "compressed-f-precision", 100.0, wi);
     printStringNoNewline(&inp, "Selection of energy groups");
     setStringEntry(&inp, "energygrps", inputrecStrings->energy, nullptr);
 
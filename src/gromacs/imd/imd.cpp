@@ -53,6 +53,19 @@
 #include <cerrno>
 #include <cstring>
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if GMX_IMD && !GMX_NATIVE_WINDOWS
+#    include <csignal>
+
+#    include <pthread.h>
+#endif
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/domdec/ga2la.h"
@@ -139,6 +152,8 @@ typedef struct
 } IMDHeader;
 
 
+class ImdFrameSender;
+
 /*! \internal
  * \brief Implementation type for the IMD session
  *
@@ -262,6 +277,8 @@ public:
     bool bNewForces = false;
     //! Set if pulling from VMD is allowed.
     bool bForceActivated = false;
+    //! Set if frames are sent from a separate thread.
+    bool bAsyncSend = false;
 
     //! Pointer to energies we send back.
     IMDEnergyBlock* energies = nullptr;
@@ -285,6 +302,8 @@ public:
     char* energysendbuf = nullptr;
     //! Buffer to make molecules whole before sending.
     rvec* sendxbuf = nullptr;
+    //! Sends frames from a separate thread while a client is connected with bAsyncSend.
+    std::unique_ptr<ImdFrameSender> frameSender;
 
     //! Molecules block in IMD group.
     t_block mols;
@@ -552,24 +571,18 @@ void ImdSession::dd_make_local_IMD_atoms(const gmx_domdec_t* dd)
 }
 
 
-/*! \brief Send positions from rvec.
+/*! \brief Fills buffer with the positions message, returns its size.
  *
- * We need a separate send buffer and conversion to Angstrom.
+ * Does the conversion to Angstrom.
  */
-static int imd_send_rvecs(IMDSocket* socket, int nat, rvec* x, char* buffer)
+static int32_t fill_rvecs_message(int nat, const rvec* x, char* buffer)
 {
-    int32_t size;
-    int     i;
-    float   sendx[3];
-    int     tuplesize = 3 * sizeof(float);
-
-
-    /* Required size for the send buffer */
-    size = c_headerSize + 3 * sizeof(float) * nat;
+    float sendx[3];
+    int   tuplesize = 3 * sizeof(float);
 
     /* Prepare header */
     fill_header(reinterpret_cast<IMDHeader*>(buffer), IMDMessageType::FCoords, static_cast<int32_t>(nat));
-    for (i = 0; i < nat; i++)
+    for (int i = 0; i < nat; i++)
     {
         sendx[0] = static_cast<float>(x[i][0]) * gmx::c_nm2A;
         sendx[1] = static_cast<float>(x[i][1]) * gmx::c_nm2A;
@@ -577,10 +590,180 @@ static int imd_send_rvecs(IMDSocket* socket, int nat, rvec* x, char* buffer)
         memcpy(buffer + c_headerSize + i * tuplesize, sendx, tuplesize);
     }
 
+    return c_headerSize + 3 * sizeof(float) * nat;
+}
+
+
+/*! \brief Send positions from rvec.
+ *
+ * We need a separate send buffer and conversion to Angstrom.
+ */
+static int imd_send_rvecs(IMDSocket* socket, int nat, rvec* x, char* buffer)
+{
+    int32_t size = fill_rvecs_message(nat, x, buffer);
+
     return static_cast<int>(imd_write_multiple(socket, buffer, size) != size);
 }
 
 
+/*! \internal
+ * \brief Sends IMD frames to the client from a separate thread.
+ *
+ * The main rank packs the energies and positions of a frame into one of
+ * a few pre-allocated buffers, which are handed over to the sender thread
+ * through a single-producer, single-consumer ring. Only the counters are
+ * shared, so handing over a frame does not lock. When all buffers are still
+ * waiting to be sent because the client is behind, new frames are dropped,
+ * so a slow client can not throttle the simulation. The mutex is only used
+ * to let the sender thread sleep while there is nothing to send.
+ */
+class ImdFrameSender
+{
+public:
+    //! Allocates the buffers and starts the sender thread
+    ImdFrameSender(IMDSocket* socket, int nat);
+    /*! \brief Stops the sender thread, frames that have not been sent are discarded
+     *
+     * The socket should be shut down before, so a write that blocks
+     * because the client stopped reading returns.
+     */
+    ~ImdFrameSender();
+
+    /*! \brief Hands a frame over to the sender thread
+     *
+     * \returns false when the frame was dropped because the client is behind.
+     */
+    bool trySubmit(const IMDEnergyBlock& energies, int nat, const rvec* x);
+    //! Returns whether writing to the client failed
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+    //! Returns the number of frames that were handed over, including dropped frames
+    int64_t numFrames() const { return numFrames_; }
+    //! Returns the number of frames that were dropped
+    int64_t numDropped() const { return numDropped_; }
+
+private:
+    //! The loop run by the sender thread
+    void sendLoop();
+
+    //! The number of frames that can be in flight
+    static constexpr int c_numBuffers = 4;
+
+    //! The socket of the connected client
+    IMDSocket* socket_;
+    //! Buffers holding the energy and position messages of a frame
+    std::array<std::vector<char>, c_numBuffers> buffers_;
+    //! The number of bytes used in each buffer
+    std::array<int32_t, c_numBuffers> bufferSizes_;
+    //! The number of frames submitted to the ring, only modified by the main thread
+    std::atomic<int64_t> numSubmitted_ = 0;
+    //! The number of frames processed by the sender thread, only modified by that thread
+    std::atomic<int64_t> numProcessed_ = 0;
+    //! Tells the sender thread to stop
+    std::atomic<bool> stop_ = false;
+    //! Set when writing to the socket failed
+    std::atomic<bool> failed_ = false;
+    //! The number of frames handed over, main thread only
+    int64_t numFrames_ = 0;
+    //! The number of frames dropped, main thread only
+    int64_t numDropped_ = 0;
+    //! Mutex for the sender thread to wait on
+    std::mutex mutex_;
+    //! Wakes up the sender thread
+    std::condition_variable wakeUp_;
+    //! The sender thread
+    std::thread thread_;
+};
+
+ImdFrameSender::ImdFrameSender(IMDSocket* socket, int nat) : socket_(socket)
+{
+    const int32_t frameSize = c_headerSize + sizeof(IMDEnergyBlock) + c_headerSize + 3 * sizeof(float) * nat;
+    for (auto& buffer : buffers_)
+    {
+        buffer.resize(frameSize);
+    }
+    bufferSizes_.fill(0);
+
+    thread_ = std::thread([this]() { sendLoop(); });
+}
+
+ImdFrameSender::~ImdFrameSender()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true, std::memory_order_release);
+    }
+    wakeUp_.notify_one();
+    thread_.join();
+}
+
+bool ImdFrameSender::trySubmit(const IMDEnergyBlock& energies, int nat, const rvec* x)
+{
+    numFrames_++;
+
+    const int64_t numSubmitted = numSubmitted_.load(std::memory_order_relaxed);
+    if (numSubmitted - numProcessed_.load(std::memory_order_acquire) >= c_numBuffers)
+    {
+        numDropped_++;
+        return false;
+    }
+
+    /* Pack the same byte stream as imd_send_energies() followed by imd_send_rvecs() */
+    const int index  = numSubmitted % c_numBuffers;
+    char*     buffer = buffers_[index].data();
+    fill_header(reinterpret_cast<IMDHeader*>(buffer), IMDMessageType::Energies, 1);
+    memcpy(buffer + c_headerSize, &energies, sizeof(IMDEnergyBlock));
+    const int32_t energySize = c_headerSize + sizeof(IMDEnergyBlock);
+    bufferSizes_[index]      = energySize + fill_rvecs_message(nat, x, buffer + energySize);
+
+    numSubmitted_.store(numSubmitted + 1, std::memory_order_release);
+
+    /* Taking the mutex avoids a lost wake-up while the sender thread goes to sleep */
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wakeUp_.notify_one();
+
+    return true;
+}
+
+void ImdFrameSender::sendLoop()
+{
+#if GMX_IMD && !GMX_NATIVE_WINDOWS
+    /* A write to a socket that was shut down raises SIGPIPE, which would
+     * terminate mdrun. We detect the failed write from its return value. */
+    sigset_t signalSet;
+    sigemptyset(&signalSet);
+    sigaddset(&signalSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signalSet, nullptr);
+#endif
+
+    while (true)
+    {
+        const int64_t numProcessed = numProcessed_.load(std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this, numProcessed]() {
+                return stop_.load(std::memory_order_acquire)
+                       || numSubmitted_.load(std::memory_order_acquire) > numProcessed;
+            });
+        }
+        if (stop_.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        const int index = numProcessed % c_numBuffers;
+        /* After a failure we keep emptying the ring until we are stopped */
+        if (!failed_.load(std::memory_order_relaxed)
+            && imd_write_multiple(socket_, buffers_[index].data(), bufferSizes_[index]) != bufferSizes_[index])
+        {
+            failed_.store(true, std::memory_order_release);
+        }
+        numProcessed_.store(numProcessed + 1, std::memory_order_release);
+    }
+}
+
+
 void ImdSession::Impl::prepareMainSocket()
 {
     if (imdsock_winsockinit() == -1)
@@ -622,8 +805,25 @@ void ImdSession::Impl::disconnectClient()
     /* Write out any buffered pulling data */
     fflush(outf);
 
-    /* we first try to shut down the clientsocket */
+    /* we first try to shut down the clientsocket, this also makes a write
+     * of the sender thread fail when it is blocked on a client that stopped reading */
     imdsock_shutdown(clientsocket);
+
+    /* Stop sending before we close the socket */
+    if (frameSender)
+    {
+        if (frameSender->numDropped() > 0)
+        {
+            GMX_LOG(mdLog_.warning)
+                    .appendTextFormatted("%s Dropped %" PRId64 " of %" PRId64
+                                         " frames because the client was not keeping up.",
+                                         IMDstr,
+                                         frameSender->numDropped(),
+                                         frameSender->numFrames());
+        }
+        frameSender.reset();
+    }
+
     if (!imdsock_destroy(clientsocket))
     {
         GMX_LOG(mdLog_.warning).appendTextFormatted("%s Failed to destroy socket.", IMDstr);
@@ -677,6 +877,11 @@ bool ImdSession::Impl::tryConnect()
         /* IMD connected */
         bConnected = true;
 
+        if (bAsyncSend && clientsocket)
+        {
+            frameSender = std::make_unique<ImdFrameSender>(clientsocket, nat);
+        }
+
         return true;
     }
 
@@ -1071,6 +1276,14 @@ ImdSession::Impl::Impl(const MDLogger& mdlog) : mdLog_(mdlog)
 
 ImdSession::Impl::~Impl()
 {
+    /* Shut down a connection that is still open before the frame sender
+     * thread is joined, so a write to a client that stopped reading returns */
+    if (clientsocket)
+    {
+        imdsock_shutdown(clientsocket);
+        frameSender.reset();
+        imdsock_destroy(clientsocket);
+    }
     if (outf)
     {
         gmx_fio_fclose(outf);
@@ -1464,6 +1677,17 @@ std::unique_ptr<ImdSession> makeImdSession(const t_inputrec*              ir,
                             "%s Allow termination of the simulation from IMD client (-imdterm).", IMDstr);
         }
 
+        /* Shall we send from a separate thread? */
+        if (options.asyncSend)
+        {
+            impl->bAsyncSend = true;
+            GMX_LOG(mdlog.warning)
+                    .appendTextFormatted(
+                            "%s Sending frames asynchronously, frames are dropped when the client "
+                            "is behind (-imdasync).",
+                            IMDstr);
+        }
+
         /* Is pulling from IMD client allowed? */
         if (options.pull)
         {
@@ -1621,6 +1845,21 @@ void ImdSession::sendPositionsAndEnergies()
         return;
     }
 
+    if (impl_->frameSender)
+    {
+        /* Hand the frame over to the sender thread, a failed write shows up
+         * at one of the next frames. */
+        if (impl_->frameSender->failed())
+        {
+            impl_->issueFatalError("Error sending updated positions. Disconnecting client.");
+        }
+        else
+        {
+            impl_->frameSender->trySubmit(*impl_->energies, impl_->nat, impl_->xa);
+        }
+        return;
+    }
+
     if (imd_send_energies(impl_->clientsocket, impl_->energies, impl_->energysendbuf))
     {
         impl_->issueFatalError("Error sending updated energies. Disconnecting client.");
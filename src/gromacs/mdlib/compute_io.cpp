@@ -85,6 +85,8 @@ double compute_io(const t_inputrec* ir, int natoms, const SimulationGroups& grou
     cio = 80 * natoms;
     cio += (nstx + nstf + nstv) * sizeof(real) * (3.0 * natoms);
     cio += nstxtc * (14 * 4 + nxtcatoms * 5.0); /* roughly 5 bytes per atom */
+    cio += (div_nsteps(nsteps, ir->nstvout_compressed) + div_nsteps(nsteps, ir->nstfout_compressed))
+           * (14 * 4 + natoms * 6.0); /* velocities and forces compress less than coordinates */
     cio += nstlog * (nrener * 16 * 2.0);        /* 16 bytes per energy term plus header */
     /* t_energy contains doubles, but real is written to edr */
     cio += (1.0 * nste) * nrener * 3 * sizeof(real);
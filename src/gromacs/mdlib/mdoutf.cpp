@@ -37,14 +37,26 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
+#include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xtcio.h"
+#include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/energyoutput.h"
 #include "gromacs/mdrunutility/handlerestart.h"
@@ -63,12 +75,99 @@
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/baseversion.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
+namespace
+{
+
+/*! \brief Copy of the data of a trajectory frame for the writer thread
+ *
+ * The vectors keep their capacity, so buffers are recycled without
+ * reallocation after the first frames have been written.
+ */
+struct TrajectoryFrameBuffer
+{
+    //! The MDOF flags for this frame, without MDOF_CPT
+    int flags = 0;
+    //! The number of atoms in the frame
+    int natoms = 0;
+    //! The MD step
+    int64_t step = 0;
+    //! The time
+    double t = 0;
+    //! The FEP lambda value
+    real lambda = 0;
+    //! The box
+    matrix box = { { 0 } };
+    //! The coordinates of all atoms, used for full and compressed output
+    std::vector<gmx::RVec> x;
+    //! The velocities
+    std::vector<gmx::RVec> v;
+    //! The forces
+    std::vector<gmx::RVec> f;
+};
+
+/*! \brief Writes trajectory frames to file on a separate thread
+ *
+ * The main rank copies the gathered data of a frame into one of
+ * a fixed number of buffers and returns to the MD loop. The thread
+ * owned by this object encodes and writes the frames in order.
+ * When all buffers are in use, acquiring a buffer blocks until
+ * the oldest frame has been written, so memory usage is bounded.
+ */
+class TrajectoryWriterThread
+{
+public:
+    //! Starts the writer thread for output files \p of
+    explicit TrajectoryWriterThread(gmx_mdoutf* of);
+
+    //! Writes all pending frames and stops the thread
+    ~TrajectoryWriterThread();
+
+    //! Returns a free buffer, waits for a buffer to be written when none is free
+    TrajectoryFrameBuffer* acquireFrameBuffer();
+
+    //! Hands the buffer returned by the last acquireFrameBuffer() call to the writer thread
+    void submitFrameBuffer();
+
+    //! Waits until all submitted frames have been written
+    void waitForPendingFrames();
+
+private:
+    //! The function run by the writer thread
+    void threadMain();
+
+    //! The number of frame buffers, i.e. the maximum number of frames in flight
+    static constexpr int c_numFrameBuffers = 2;
+
+    //! The output files
+    gmx_mdoutf* of_;
+    //! The buffers, used as a ring
+    std::array<TrajectoryFrameBuffer, c_numFrameBuffers> frameBuffers_;
+    //! The number of frames submitted by the main thread, protected by mutex_
+    int64_t numSubmitted_ = 0;
+    //! The number of frames written by the writer thread, protected by mutex_
+    int64_t numWritten_ = 0;
+    //! Tells the writer thread to exit, protected by mutex_
+    bool stopRequested_ = false;
+    //! Mutex for the counters
+    std::mutex mutex_;
+    //! Used for signaling both submission and completion of frames
+    std::condition_variable condition_;
+    //! The writer thread
+    std::thread thread_;
+};
+
+} // namespace
+
+//! The number of atoms per block for looking up indices in the compressed output group
+static constexpr int c_xCompressedIndexBlockSize = 64;
+
 struct gmx_mdoutf
 {
     t_fileio*                      fp_trn;
@@ -93,6 +192,16 @@ struct gmx_mdoutf
     const gmx::MDModulesNotifiers* mdModulesNotifiers;
     bool                           simulationsShareState;
     MPI_Comm                       mainRanksComm;
+    TrajectoryWriterThread*        writerThread; /* only set with asynchronous writing */
+    gmx_bool                       bWriteStateShards;
+    int64_t                        stateShardStepPrev;     /* used by the _prev checkpoint */
+    int64_t                        stateShardStepPrevPrev; /* can be removed */
+    t_fileio*                      fp_xtc_fragment; /* only set with XTC fragment writing */
+    const char*                    fn_xtc_fragment_base; /* the XTC name the fragments derive from */
+    t_fileio*                      fp_xtc_vf; /* compressed velocities and forces */
+    real                           v_compression_precision;
+    real                           f_compression_precision;
+    int* x_compressed_block_start; /* compressed group atoms before each block of atoms */
 };
 
 
@@ -126,14 +235,35 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
     of->tng_low_prec = nullptr;
     of->fp_dhdl      = nullptr;
 
+    of->fp_xtc_fragment          = nullptr;
+    of->fn_xtc_fragment_base     = nullptr;
+    of->x_compressed_block_start = nullptr;
+    of->fp_xtc_vf                = nullptr;
+
     of->eIntegrator             = ir->eI;
     of->bExpanded               = ir->bExpanded;
     of->elamstats               = ir->expandedvals->elamstats;
     of->simulation_part         = ir->simulation_part;
     of->x_compression_precision = static_cast<int>(ir->x_compression_precision);
+    of->v_compression_precision = ir->v_compression_precision;
+    of->f_compression_precision = ir->f_compression_precision;
     of->wcycle                  = wcycle;
     of->f_global                = nullptr;
     of->outputProvider          = outputProvider;
+    of->writerThread            = nullptr;
+    of->bKeepAndNumCPT          = mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles;
+    of->bWriteStateShards       = mdrunOptions.checkpointOptions.writeStateShards;
+    /* After a restart, the shards of the checkpoint we started from are
+     * referred to by the _prev checkpoint after our first checkpoint,
+     * so they should be removed at our second checkpoint.
+     */
+    of->stateShardStepPrev =
+            (of->bWriteStateShards && startingBehavior != gmx::StartingBehavior::NewSimulation)
+                    ? ir->init_step
+                    : -1;
+    of->stateShardStepPrevPrev = -1;
+    /* All ranks need the checkpoint name to derive the state shard names */
+    of->fn_cpt = opt2fn("-cpo", nfile, fnm);
 
     GMX_RELEASE_ASSERT(!simulationsShareState || ms != nullptr,
                        "Need valid multisim object when simulations share state");
@@ -143,13 +273,65 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         of->mainRanksComm = ms->mainRanksComm_;
     }
 
-    if (MAIN(cr))
+    filemode = restartWithAppending ? appendMode : writeMode;
+
+    /* Set up atom counts so they can be passed to actual
+       trajectory-writing routines later. Also, XTC writing needs
+       to know what (and how many) atoms might be in the XTC
+       groups, and how to look up later which ones they are. */
+    of->natoms_global       = top_global.natoms;
+    of->groups              = &top_global.groups;
+    of->natoms_x_compressed = 0;
+    for (i = 0; (i < top_global.natoms); i++)
     {
-        of->bKeepAndNumCPT = mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles;
+        if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+        {
+            of->natoms_x_compressed++;
+        }
+    }
 
-        filemode = restartWithAppending ? appendMode : writeMode;
+    /* With XTC fragments, each PP rank writes the compressed coordinates
+     * of its home atoms, so these do not need to be collected.
+     */
+    const bool writeXtcFragments = (mdrunOptions.writeXtcFragments && havePPDomainDecomposition(cr)
+                                    && EI_DYNAMICS(ir->eI) && ir->nstxout_compressed > 0
+                                    && fn2ftp(ftp2fn(efCOMPRESSED, nfile, fnm)) == efXTC);
+    if (writeXtcFragments)
+    {
+        of->fn_xtc_fragment_base = ftp2fn(efCOMPRESSED, nfile, fnm);
+        of->fp_xtc_fragment =
+                open_xtc(xtc_fragment_filename(of->fn_xtc_fragment_base, cr->dd->rank), filemode);
+        if (of->natoms_x_compressed != of->natoms_global)
+        {
+            /* Store only the group index of the first atom in each block,
+             * as a global index array would be large on every rank.
+             */
+            snew(of->x_compressed_block_start,
+                 (of->natoms_global + c_xCompressedIndexBlockSize - 1) / c_xCompressedIndexBlockSize);
+            int j = 0;
+            for (i = 0; i < of->natoms_global; i++)
+            {
+                if (i % c_xCompressedIndexBlockSize == 0)
+                {
+                    of->x_compressed_block_start[i / c_xCompressedIndexBlockSize] = j;
+                }
+                if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                {
+                    j++;
+                }
+            }
+        }
+    }
+    else if (mdrunOptions.writeXtcFragments && fplog)
+    {
+        fprintf(fplog,
+                "\nNOTE: XTC fragments are only written with domain decomposition and XTC "
+                "output, compressed coordinates are written as usual\n");
+    }
 
-        if (EI_DYNAMICS(ir->eI) && ir->nstxout_compressed > 0)
+    if (MAIN(cr))
+    {
+        if (EI_DYNAMICS(ir->eI) && ir->nstxout_compressed > 0 && !writeXtcFragments)
         {
             const char* filename;
             filename = ftp2fn(efCOMPRESSED, nfile, fnm);
@@ -167,6 +349,13 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
                 default: gmx_incons("Invalid reduced precision file format");
             }
         }
+        if (EI_DYNAMICS(ir->eI) && (ir->nstvout_compressed > 0 || ir->nstfout_compressed > 0))
+        {
+            /* The compressed velocities and forces are written to a separate
+             * xtc file, by default named after the compressed coordinate output file.
+             */
+            of->fp_xtc_vf = open_xtc(opt2fn("-xvf", nfile, fnm), filemode);
+        }
         if ((EI_DYNAMICS(ir->eI) || EI_ENERGY_MINIMIZATION(ir->eI))
             && (!GMX_FAHCORE
                 && !(EI_DYNAMICS(ir->eI) && ir->nstxout == 0 && ir->nstvout == 0 && ir->nstfout == 0)))
@@ -200,8 +389,6 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         {
             of->fp_ene = open_enx(ftp2fn(efEDR, nfile, fnm), filemode);
         }
-        of->fn_cpt = opt2fn("-cpo", nfile, fnm);
-
         if ((ir->efep != FreeEnergyPerturbationType::No || ir->bSimTemp) && ir->fepvals->nstdhdl > 0
             && (ir->fepvals->separate_dhdl_file == SeparateDhdlFile::Yes) && EI_DYNAMICS(ir->eI))
         {
@@ -218,24 +405,24 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         outputProvider->initOutput(fplog, nfile, fnm, restartWithAppending, oenv);
         of->mdModulesNotifiers = &mdModulesNotifiers;
 
-        /* Set up atom counts so they can be passed to actual
-           trajectory-writing routines later. Also, XTC writing needs
-           to know what (and how many) atoms might be in the XTC
-           groups, and how to look up later which ones they are. */
-        of->natoms_global       = top_global.natoms;
-        of->groups              = &top_global.groups;
-        of->natoms_x_compressed = 0;
-        for (i = 0; (i < top_global.natoms); i++)
+        if ((ir->nstfout || (EI_DYNAMICS(ir->eI) && ir->nstfout_compressed)) && haveDDAtomOrdering(*cr))
         {
-            if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
-            {
-                of->natoms_x_compressed++;
-            }
+            snew(of->f_global, top_global.natoms);
         }
 
-        if (ir->nstfout && haveDDAtomOrdering(*cr))
+        /* The writer thread is not pinned and competes with the simulation
+         * threads for cores, so it is only used on request. This is most
+         * useful with TNG, which compresses a whole frame set at once when
+         * it is full.
+         */
+        if (getenv("GMX_ASYNC_TRAJECTORY_WRITING") != nullptr
+            && (of->fp_trn || of->fp_xtc || of->tng || of->tng_low_prec || of->fp_xtc_vf))
         {
-            snew(of->f_global, top_global.natoms);
+            if (fplog)
+            {
+                fprintf(fplog, "\nTrajectory frames are written by a separate thread\n");
+            }
+            of->writerThread = new TrajectoryWriterThread(of);
         }
     }
 
@@ -278,6 +465,8 @@ static void mpiBarrierBeforeRename(const bool applyMpiBarrierBeforeRename, MPI_C
  *
  * Appends the _step<step>.cpt with bNumberAndKeep, otherwise moves
  * the previous checkpoint filename with suffix _prev.cpt.
+ * The XTC fragment files of \p xtcFragmentBaseName, when set, are not
+ * stored in the list of output files.
  */
 static void write_checkpoint(const char*                     fn,
                              gmx_bool                        bNumberAndKeep,
@@ -296,7 +485,9 @@ static void write_checkpoint(const char*                     fn,
                              const gmx::MDModulesNotifiers&  mdModulesNotifiers,
                              gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
                              bool                            applyMpiBarrierBeforeRename,
-                             MPI_Comm                        mpiBarrierCommunicator)
+                             MPI_Comm                        mpiBarrierCommunicator,
+                             int                             numStateShards,
+                             const char*                     xtcFragmentBaseName)
 {
     t_fileio* fp;
     char*     fntemp; /* the temporary checkpoint file name */
@@ -337,6 +528,21 @@ static void write_checkpoint(const char*                     fn,
 
     /* Get offsets for open files */
     auto outputfiles = gmx_fio_get_output_file_positions();
+    if (xtcFragmentBaseName != nullptr)
+    {
+        /* Each rank writes its XTC fragments independently, so other ranks
+         * can be writing while we get the offsets. The fragment files are
+         * not truncated on restart, gmx trjcat replaces the frames beyond
+         * the checkpoint by those of the continuation instead.
+         */
+        outputfiles.erase(std::remove_if(outputfiles.begin(),
+                                         outputfiles.end(),
+                                         [xtcFragmentBaseName](const gmx_file_position_t& file) {
+                                             return xtc_is_fragment_filename(file.filename,
+                                                                             xtcFragmentBaseName);
+                                         }),
+                          outputfiles.end());
+    }
 
     fp = gmx_fio_open(fntemp, "w");
 
@@ -389,6 +595,18 @@ static void write_checkpoint(const char*                     fn,
     {
         copy_ivec(domdecCells, headerContents.dd_nc);
     }
+    headerContents.numStateShards = numStateShards;
+    if (numStateShards > 0)
+    {
+        const std::string baseName = std::filesystem::path(fn).stem().u8string();
+        if (baseName.size() >= CPTSTRLEN)
+        {
+            gmx_fatal(FARGS,
+                      "The checkpoint file name '%s' is too long for use with state shards",
+                      baseName.c_str());
+        }
+        std::strncpy(headerContents.stateShardBaseName, baseName.c_str(), CPTSTRLEN - 1);
+    }
 
     write_checkpoint_data(fp,
                           headerContents,
@@ -497,15 +715,24 @@ static void write_checkpoint(const char*                     fn,
 #endif /* end GMX_FAHCORE block */
 }
 
-void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
-                             FILE*                           fplog,
-                             const t_commrec*                cr,
-                             int64_t                         step,
-                             double                          t,
-                             t_state*                        state_global,
-                             ObservablesHistory*             observablesHistory,
-                             gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData)
+/*! \brief Writes the checkpoint file, with \p numStateShards > 0 the atom state is not written */
+static void write_checkpoint_for_mdoutf(gmx_mdoutf_t                    of,
+                                        FILE*                           fplog,
+                                        const t_commrec*                cr,
+                                        int64_t                         step,
+                                        double                          t,
+                                        t_state*                        state_global,
+                                        ObservablesHistory*             observablesHistory,
+                                        gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
+                                        int                             numStateShards)
 {
+    /* The checkpoint stores the positions of the output files,
+     * so all frames of earlier steps need to be written first.
+     */
+    if (of->writerThread)
+    {
+        of->writerThread->waitForPendingFrames();
+    }
     fflush_tng(of->tng);
     fflush_tng(of->tng_low_prec);
     /* Write the checkpoint file.
@@ -531,7 +758,384 @@ void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
                      *(of->mdModulesNotifiers),
                      modularSimulatorCheckpointData,
                      of->simulationsShareState,
-                     of->mainRanksComm);
+                     of->mainRanksComm,
+                     numStateShards,
+                     of->fn_xtc_fragment_base);
+}
+
+void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
+                             FILE*                           fplog,
+                             const t_commrec*                cr,
+                             int64_t                         step,
+                             double                          t,
+                             t_state*                        state_global,
+                             ObservablesHistory*             observablesHistory,
+                             gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData)
+{
+    write_checkpoint_for_mdoutf(
+            of, fplog, cr, step, t, state_global, observablesHistory, modularSimulatorCheckpointData, 0);
+}
+
+//! Waits for all PP ranks, no-op without domain decomposition
+static void stateShardBarrier(const t_commrec* cr)
+{
+    if (haveDDAtomOrdering(*cr) && cr->dd->nnodes > 1)
+    {
+        gmx_barrier(cr->dd->mpi_comm_all);
+    }
+}
+
+/*! \brief Writes the coordinates and velocities of the home atoms of this rank to a shard file
+ *
+ * Returns the number of shards. Without domain decomposition the main rank
+ * writes a single shard with all atoms. Returns after all shards are written.
+ */
+static int write_state_shard(gmx_mdoutf_t of, const t_commrec* cr, int64_t step, const t_state& state_local)
+{
+    int                      numShards;
+    int                      shardIndex;
+    gmx::ArrayRef<const int> globalAtomIndices;
+    std::vector<int>         allAtomIndices;
+    if (haveDDAtomOrdering(*cr))
+    {
+        const gmx_domdec_t& dd = *cr->dd;
+        GMX_RELEASE_ASSERT(state_local.ddp_count == dd.ddp_count,
+                           "The local state should match the current decomposition");
+        numShards         = dd.nnodes;
+        shardIndex        = dd.rank;
+        globalAtomIndices = gmx::constArrayRefFromArray(dd.globalAtomGroupIndices.data(),
+                                                        dd_numHomeAtoms(dd));
+    }
+    else
+    {
+        numShards  = 1;
+        shardIndex = 0;
+        allAtomIndices.resize(state_local.numAtoms());
+        std::iota(allAtomIndices.begin(), allAtomIndices.end(), 0);
+        globalAtomIndices = allAtomIndices;
+    }
+    const int numAtoms = globalAtomIndices.ssize();
+
+    const std::filesystem::path checkpointName(of->fn_cpt);
+    write_checkpoint_state_shard(
+            checkpointStateShardFilename(
+                    checkpointName.parent_path(), checkpointName.stem().u8string(), step, shardIndex),
+            step,
+            shardIndex,
+            numShards,
+            globalAtomIndices,
+            gmx::constArrayRefFromArray(state_local.x.data(), numAtoms),
+            state_local.hasEntry(StateEntry::V) ? gmx::constArrayRefFromArray(state_local.v.data(), numAtoms)
+                                               : gmx::ArrayRef<const gmx::RVec>());
+
+    /* The checkpoint should only refer to complete sets of shards */
+    stateShardBarrier(cr);
+
+    return numShards;
+}
+
+/*! \brief Removes the state shards that are no longer referred to by a checkpoint file
+ *
+ * The shards of the previous checkpoint are kept for the _prev checkpoint file.
+ */
+static void remove_old_state_shard(gmx_mdoutf_t of, const t_commrec* cr, int64_t step)
+{
+    /* Only remove files after the new checkpoint has been written */
+    stateShardBarrier(cr);
+
+    if (!of->bKeepAndNumCPT && of->stateShardStepPrevPrev >= 0)
+    {
+        const std::filesystem::path checkpointName(of->fn_cpt);
+        const int shardIndex = haveDDAtomOrdering(*cr) ? cr->dd->rank : 0;
+        std::error_code errorCode;
+        std::filesystem::remove(checkpointStateShardFilename(checkpointName.parent_path(),
+                                                             checkpointName.stem().u8string(),
+                                                             of->stateShardStepPrevPrev,
+                                                             shardIndex),
+                                errorCode);
+    }
+    of->stateShardStepPrevPrev = of->stateShardStepPrev;
+    of->stateShardStepPrev     = step;
+}
+
+/*! \brief Writes the trajectory frame data of one step to the open output files
+ *
+ * This is called either directly by the main rank or, with asynchronous
+ * trajectory writing, by the trajectory writer thread on a snapshot
+ * of the data. \p x should contain all atoms when \p mdof_flags contains
+ * MDOF_X_COMPRESSED, since the compressed output group is selected here.
+ */
+static void write_trajectory_frame(gmx_mdoutf_t of,
+                                   int          mdof_flags,
+                                   int          natoms,
+                                   int64_t      step,
+                                   double       t,
+                                   real         lambda,
+                                   const rvec*  box,
+                                   const rvec*  x_global,
+                                   const rvec*  v_global,
+                                   const rvec*  f_global)
+{
+    if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+    {
+        const rvec* x = (mdof_flags & MDOF_X) ? x_global : nullptr;
+        const rvec* v = (mdof_flags & MDOF_V) ? v_global : nullptr;
+        const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
+
+        if (of->fp_trn)
+        {
+            gmx_trr_write_frame(of->fp_trn, step, t, lambda, box, natoms, x, v, f);
+            if (gmx_fio_flush(of->fp_trn) != 0)
+            {
+                gmx_file("Cannot write trajectory; maybe you are out of disk space?");
+            }
+        }
+
+        /* If a TNG file is open for uncompressed coordinate output also write
+           velocities and forces to it. */
+        else if (of->tng)
+        {
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, x, v, f);
+        }
+        /* If only a TNG file is open for compressed coordinate output (no uncompressed
+           coordinate output) also write forces and velocities to it. */
+        else if (of->tng_low_prec)
+        {
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, x, v, f);
+        }
+    }
+    if (mdof_flags & MDOF_X_COMPRESSED)
+    {
+        const rvec* xxtc     = nullptr;
+        rvec*       xxtcCopy = nullptr;
+
+        if (of->natoms_x_compressed == of->natoms_global)
+        {
+            /* We are writing the positions of all of the atoms to
+               the compressed output */
+            xxtc = x_global;
+        }
+        else
+        {
+            /* We are writing the positions of only a subset of
+               the atoms to the compressed output, so we have to
+               make a copy of the subset of coordinates. */
+            int i, j;
+
+            snew(xxtcCopy, of->natoms_x_compressed);
+            for (i = 0, j = 0; (i < of->natoms_global); i++)
+            {
+                if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                {
+                    copy_rvec(x_global[i], xxtcCopy[j++]);
+                }
+            }
+            xxtc = xxtcCopy;
+        }
+        if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, box, xxtc, of->x_compression_precision)
+            == 0)
+        {
+            gmx_fatal(FARGS,
+                      "XTC error. This indicates you are out of disk space, or a "
+                      "simulation with major instabilities resulting in coordinates "
+                      "that are NaN or too large to be represented in the XTC format.\n");
+        }
+        gmx_fwrite_tng(
+                of->tng_low_prec, TRUE, step, t, lambda, box, of->natoms_x_compressed, xxtc, nullptr, nullptr);
+        sfree(xxtcCopy);
+    }
+    if ((mdof_flags & (MDOF_V_COMPRESSED | MDOF_F_COMPRESSED)) && of->fp_xtc_vf)
+    {
+        if (write_xtc_vf(of->fp_xtc_vf,
+                         natoms,
+                         step,
+                         t,
+                         box,
+                         (mdof_flags & MDOF_V_COMPRESSED) ? v_global : nullptr,
+                         of->v_compression_precision,
+                         (mdof_flags & MDOF_F_COMPRESSED) ? f_global : nullptr,
+                         of->f_compression_precision)
+            == 0)
+        {
+            gmx_fatal(FARGS,
+                      "XTC error. This indicates you are out of disk space, or a "
+                      "simulation with major instabilities resulting in velocities "
+                      "or forces that are NaN or too large to be represented in the XTC format.\n");
+        }
+    }
+    if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
+    {
+        if (of->tng)
+        {
+            gmx_fwrite_tng(of->tng,
+                           FALSE,
+                           step,
+                           t,
+                           (mdof_flags & MDOF_LAMBDA) ? lambda : -1,
+                           (mdof_flags & MDOF_BOX) ? box : nullptr,
+                           natoms,
+                           nullptr,
+                           nullptr,
+                           nullptr);
+        }
+    }
+    if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED) && !(mdof_flags & (MDOF_X_COMPRESSED)))
+    {
+        if (of->tng_low_prec)
+        {
+            gmx_fwrite_tng(of->tng_low_prec,
+                           FALSE,
+                           step,
+                           t,
+                           (mdof_flags & MDOF_LAMBDA_COMPRESSED) ? lambda : -1,
+                           (mdof_flags & MDOF_BOX_COMPRESSED) ? box : nullptr,
+                           natoms,
+                           nullptr,
+                           nullptr,
+                           nullptr);
+        }
+    }
+}
+
+TrajectoryWriterThread::TrajectoryWriterThread(gmx_mdoutf* of) :
+    of_(of), thread_([this]() { threadMain(); })
+{
+}
+
+TrajectoryWriterThread::~TrajectoryWriterThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+TrajectoryFrameBuffer* TrajectoryWriterThread::acquireFrameBuffer()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return numSubmitted_ - numWritten_ < c_numFrameBuffers; });
+
+    return &frameBuffers_[numSubmitted_ % c_numFrameBuffers];
+}
+
+void TrajectoryWriterThread::submitFrameBuffer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        numSubmitted_++;
+    }
+    condition_.notify_all();
+}
+
+void TrajectoryWriterThread::waitForPendingFrames()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return numWritten_ == numSubmitted_; });
+}
+
+void TrajectoryWriterThread::threadMain()
+{
+    try
+    {
+        while (true)
+        {
+            int64_t frameIndex;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stopRequested_ || numWritten_ < numSubmitted_; });
+                if (numWritten_ == numSubmitted_)
+                {
+                    /* Stop was requested and all frames have been written */
+                    return;
+                }
+                frameIndex = numWritten_;
+            }
+
+            /* The main thread does not touch this buffer until we have
+             * incremented numWritten_, so we can access it without lock.
+             */
+            const TrajectoryFrameBuffer& frame = frameBuffers_[frameIndex % c_numFrameBuffers];
+            write_trajectory_frame(of_,
+                                   frame.flags,
+                                   frame.natoms,
+                                   frame.step,
+                                   frame.t,
+                                   frame.lambda,
+                                   frame.box,
+                                   as_rvec_array(frame.x.data()),
+                                   as_rvec_array(frame.v.data()),
+                                   as_rvec_array(frame.f.data()));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                numWritten_++;
+            }
+            condition_.notify_all();
+        }
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+}
+
+/*! \brief Writes the compressed coordinates of the home atoms of this rank to its XTC fragment file
+ *
+ * The atoms are stored with their index in the compressed output group,
+ * so the fragments of all ranks can be merged into normal frames.
+ */
+static void write_xtc_fragment_for_mdoutf(gmx_mdoutf_t        of,
+                                          const gmx_domdec_t& dd,
+                                          int64_t             step,
+                                          double              t,
+                                          const t_state&      state_local)
+{
+    const int                      numHomeAtoms = dd_numHomeAtoms(dd);
+    gmx::ArrayRef<const int>       atomIndices =
+            gmx::constArrayRefFromArray(dd.globalAtomGroupIndices.data(), numHomeAtoms);
+    gmx::ArrayRef<const gmx::RVec> x = gmx::constArrayRefFromArray(state_local.x.data(), numHomeAtoms);
+
+    std::vector<int>       groupAtomIndices;
+    std::vector<gmx::RVec> groupX;
+    if (of->x_compressed_block_start != nullptr)
+    {
+        /* Only a subset of the atoms is in the compressed output group */
+        const auto isCompressed = [of](int a) {
+            return getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, a) == 0;
+        };
+        for (int i = 0; i < numHomeAtoms; i++)
+        {
+            const int a = atomIndices[i];
+            if (isCompressed(a))
+            {
+                const int blockStart = a - a % c_xCompressedIndexBlockSize;
+                int       groupIndex = of->x_compressed_block_start[a / c_xCompressedIndexBlockSize];
+                for (int b = blockStart; b < a; b++)
+                {
+                    groupIndex += isCompressed(b) ? 1 : 0;
+                }
+                groupAtomIndices.push_back(groupIndex);
+                groupX.push_back(x[i]);
+            }
+        }
+        atomIndices = groupAtomIndices;
+        x           = groupX;
+    }
+
+    if (write_xtc_fragment(of->fp_xtc_fragment,
+                           of->natoms_x_compressed,
+                           step,
+                           t,
+                           state_local.box,
+                           atomIndices,
+                           x,
+                           of->x_compression_precision)
+        == 0)
+    {
+        gmx_fatal(FARGS,
+                  "XTC error. This indicates you are out of disk space, or a "
+                  "simulation with major instabilities resulting in coordinates "
+                  "that are NaN or too large to be represented in the XTC format.\n");
+    }
 }
 
 void mdoutf_write_to_trajectory_files(FILE*                           fplog,
@@ -549,14 +1153,35 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
 {
     const rvec* f_global;
 
+    if ((mdof_flags & MDOF_X_COMPRESSED) && of->fp_xtc_fragment != nullptr)
+    {
+        write_xtc_fragment_for_mdoutf(of, *cr->dd, step, t, *state_local);
+        /* The compressed coordinates do not need to be collected */
+        mdof_flags &= ~MDOF_X_COMPRESSED;
+    }
+
+    /* With state shards every rank writes the coordinates and velocities
+     * of its home atoms and these are not collected for the checkpoint.
+     */
+    const bool writeStateShards = ((mdof_flags & MDOF_CPT) && of->bWriteStateShards);
+    int        numStateShards   = 0;
+    if (writeStateShards && (haveDDAtomOrdering(*cr) || MAIN(cr)))
+    {
+        numStateShards = write_state_shard(of, cr, step, *state_local);
+    }
+
     if (haveDDAtomOrdering(*cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if ((mdof_flags & MDOF_CPT) && !writeStateShards)
         {
             dd_collect_state(cr->dd, state_local, state_global);
         }
         else
         {
+            if (writeStateShards)
+            {
+                dd_collect_state_non_atom_entries(*cr->dd, state_local, state_global);
+            }
             if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED))
             {
                 auto globalXRef = MAIN(cr) ? state_global->x : gmx::ArrayRef<gmx::RVec>();
@@ -567,7 +1192,7 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
                                state_local->x,
                                globalXRef);
             }
-            if (mdof_flags & MDOF_V)
+            if (mdof_flags & (MDOF_V | MDOF_V_COMPRESSED))
             {
                 auto globalVRef = MAIN(cr) ? state_global->v : gmx::ArrayRef<gmx::RVec>();
                 dd_collect_vec(cr->dd,
@@ -579,7 +1204,7 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
             }
         }
         f_global = of->f_global;
-        if (mdof_flags & MDOF_F)
+        if (mdof_flags & (MDOF_F | MDOF_F_COMPRESSED))
         {
             auto globalFRef = MAIN(cr) ? gmx::arrayRefFromArray(
                                       reinterpret_cast<gmx::RVec*>(of->f_global), of->natoms_global)
@@ -604,148 +1229,61 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
     {
         if (mdof_flags & MDOF_CPT)
         {
-            mdoutf_write_checkpoint(
-                    of, fplog, cr, step, t, state_global, observablesHistory, modularSimulatorCheckpointData);
+            write_checkpoint_for_mdoutf(of,
+                                        fplog,
+                                        cr,
+                                        step,
+                                        t,
+                                        state_global,
+                                        observablesHistory,
+                                        modularSimulatorCheckpointData,
+                                        numStateShards);
         }
 
-        if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+        const int frameFlags = mdof_flags & ~(MDOF_CPT | MDOF_IMD);
+        const real lambda    = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
+        if (frameFlags != 0 && of->writerThread != nullptr)
         {
-            const rvec* x = (mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr;
-            const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
-            const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
-
-            if (of->fp_trn)
-            {
-                gmx_trr_write_frame(of->fp_trn,
-                                    step,
-                                    t,
-                                    state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                                    state_local->box,
-                                    natoms,
-                                    x,
-                                    v,
-                                    f);
-                if (gmx_fio_flush(of->fp_trn) != 0)
-                {
-                    gmx_file("Cannot write trajectory; maybe you are out of disk space?");
-                }
-            }
-
-            /* If a TNG file is open for uncompressed coordinate output also write
-               velocities and forces to it. */
-            else if (of->tng)
-            {
-                gmx_fwrite_tng(of->tng,
-                               FALSE,
-                               step,
-                               t,
-                               state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                               state_local->box,
-                               natoms,
-                               x,
-                               v,
-                               f);
-            }
-            /* If only a TNG file is open for compressed coordinate output (no uncompressed
-               coordinate output) also write forces and velocities to it. */
-            else if (of->tng_low_prec)
-            {
-                gmx_fwrite_tng(of->tng_low_prec,
-                               FALSE,
-                               step,
-                               t,
-                               state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                               state_local->box,
-                               natoms,
-                               x,
-                               v,
-                               f);
-            }
-        }
-        if (mdof_flags & MDOF_X_COMPRESSED)
-        {
-            rvec* xxtc = nullptr;
-
-            if (of->natoms_x_compressed == of->natoms_global)
-            {
-                /* We are writing the positions of all of the atoms to
-                   the compressed output */
-                xxtc = state_global->x.rvec_array();
-            }
-            else
-            {
-                /* We are writing the positions of only a subset of
-                   the atoms to the compressed output, so we have to
-                   make a copy of the subset of coordinates. */
-                int i, j;
-
-                snew(xxtc, of->natoms_x_compressed);
-                auto x = makeArrayRef(state_global->x);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
-                {
-                    if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
-                    {
-                        copy_rvec(x[i], xxtc[j++]);
-                    }
-                }
-            }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc, of->x_compression_precision)
-                == 0)
+            /* Copy the data to a free buffer, this blocks while the writer
+             * thread still processes all earlier frames, and let the writer
+             * thread do the encoding and writing.
+             */
+            TrajectoryFrameBuffer* frame = of->writerThread->acquireFrameBuffer();
+            frame->flags                 = frameFlags;
+            frame->natoms                = natoms;
+            frame->step                  = step;
+            frame->t                     = t;
+            frame->lambda                = lambda;
+            copy_mat(state_local->box, frame->box);
+            if (frameFlags & (MDOF_X | MDOF_X_COMPRESSED))
             {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
+                frame->x.assign(state_global->x.begin(), state_global->x.begin() + of->natoms_global);
             }
-            gmx_fwrite_tng(of->tng_low_prec,
-                           TRUE,
-                           step,
-                           t,
-                           state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                           state_local->box,
-                           of->natoms_x_compressed,
-                           xxtc,
-                           nullptr,
-                           nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
+            if (frameFlags & (MDOF_V | MDOF_V_COMPRESSED))
             {
-                sfree(xxtc);
+                frame->v.assign(state_global->v.begin(), state_global->v.begin() + natoms);
             }
-        }
-        if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
-        {
-            if (of->tng)
+            if (frameFlags & (MDOF_F | MDOF_F_COMPRESSED))
             {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA)
-                {
-                    lambda = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
-                }
-                gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, nullptr, nullptr, nullptr);
+                const gmx::RVec* f = reinterpret_cast<const gmx::RVec*>(f_global);
+                frame->f.assign(f, f + natoms);
             }
+            of->writerThread->submitFrameBuffer();
         }
-        if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED)
-            && !(mdof_flags & (MDOF_X_COMPRESSED)))
+        else if (frameFlags != 0)
         {
-            if (of->tng_low_prec)
-            {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX_COMPRESSED)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA_COMPRESSED)
-                {
-                    lambda = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
-                }
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, nullptr, nullptr, nullptr);
-            }
+            write_trajectory_frame(of,
+                                   frameFlags,
+                                   natoms,
+                                   step,
+                                   t,
+                                   lambda,
+                                   state_local->box,
+                                   state_global->x.rvec_array(),
+                                   (frameFlags & (MDOF_V | MDOF_V_COMPRESSED))
+                                           ? state_global->v.rvec_array()
+                                           : nullptr,
+                                   f_global);
         }
 
 #if GMX_FAHCORE
@@ -757,10 +1295,21 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
         }
 #endif
     }
+
+    if (writeStateShards && (haveDDAtomOrdering(*cr) || MAIN(cr)))
+    {
+        remove_old_state_shard(of, cr, step);
+    }
 }
 
 void mdoutf_tng_close(gmx_mdoutf_t of)
 {
+    if (of->writerThread)
+    {
+        wallcycle_start(of->wcycle, WallCycleCounter::Traj);
+        of->writerThread->waitForPendingFrames();
+        wallcycle_stop(of->wcycle, WallCycleCounter::Traj);
+    }
     if (of->tng || of->tng_low_prec)
     {
         wallcycle_start(of->wcycle, WallCycleCounter::Traj);
@@ -772,6 +1321,10 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    /* Write the remaining frames before closing the files */
+    delete of->writerThread;
+    of->writerThread = nullptr;
+
     if (of->fp_ene != nullptr)
     {
         done_ener_file(of->fp_ene);
@@ -780,6 +1333,15 @@ void done_mdoutf(gmx_mdoutf_t of)
     {
         close_xtc(of->fp_xtc);
     }
+    if (of->fp_xtc_fragment)
+    {
+        close_xtc(of->fp_xtc_fragment);
+    }
+    sfree(of->x_compressed_block_start);
+    if (of->fp_xtc_vf)
+    {
+        close_xtc(of->fp_xtc_vf);
+    }
     if (of->fp_trn)
     {
         gmx_trr_close(of->fp_trn);
@@ -835,3 +1397,8 @@ int mdoutf_get_tng_compressed_lambda_output_interval(gmx_mdoutf_t of)
     }
     return 0;
 }
+
+bool mdoutf_get_write_state_shards(gmx_mdoutf_t of)
+{
+    return of->bWriteStateShards;
+}
@@ -187,6 +187,12 @@ int mdoutf_get_tng_compressed_box_output_interval(gmx_mdoutf_t of);
  */
 int mdoutf_get_tng_compressed_lambda_output_interval(gmx_mdoutf_t of);
 
+/*! \brief Returns whether checkpoints write the atom state to shard files
+ *
+ * The coordinates and velocities are then not collected at checkpoint steps.
+ */
+bool mdoutf_get_write_state_shards(gmx_mdoutf_t of);
+
 #define MDOF_X (1u << 0u)
 #define MDOF_V (1u << 1u)
 #define MDOF_F (1u << 2u)
@@ -197,5 +203,7 @@ int mdoutf_get_tng_compressed_lambda_output_interval(gmx_mdoutf_t of);
 #define MDOF_LAMBDA (1u << 7u)
 #define MDOF_BOX_COMPRESSED (1u << 8u)
 #define MDOF_LAMBDA_COMPRESSED (1u << 9u)
+#define MDOF_V_COMPRESSED (1u << 10u)
+#define MDOF_F_COMPRESSED (1u << 11u)
 
 #endif
@@ -1751,6 +1751,16 @@ void do_force(FILE*                               fplog,
                                  stepWork);
     }
 
+    const bool useOrEmulateGpuNb = simulationWork.useGpuNonbonded || fr->nbv->emulateGpu();
+
+    /* With the halo exchange and all non-bonded work on the CPU, the first
+     * stage of the coordinate and force halo exchange can overlap with computation.
+     */
+    const bool useCpuHaloOverlap = simulationWork.havePpDomainDecomposition
+                                   && ddUsesCpuHaloOverlap(*cr->dd) && !useOrEmulateGpuNb
+                                   && !simulationWork.useGpuUpdate && !stepWork.useGpuXHalo
+                                   && !stepWork.useGpuXBufferOps;
+
     /* Communicate coordinates and sum dipole if necessary +
        do non-local pair search */
     if (simulationWork.havePpDomainDecomposition)
@@ -1804,7 +1814,15 @@ void do_force(FILE*                               fplog,
                         stateGpu->waitCoordinatesReadyOnHost(AtomLocality::Local);
                     }
                 }
-                dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                if (useCpuHaloOverlap)
+                {
+                    // The halo is completed after the local non-bonded computation
+                    dd_move_x_begin(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
+                else
+                {
+                    dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
             }
 
             if (stepWork.useGpuXBufferOps)
@@ -1824,7 +1842,7 @@ void do_force(FILE*                               fplog,
                 nbv->convertCoordinatesGpu(
                         AtomLocality::NonLocal, stateGpu->getCoordinates(), xReadyOnDeviceEvent);
             }
-            else
+            else if (!useCpuHaloOverlap)
             {
                 nbv->convertCoordinates(AtomLocality::NonLocal, x.unpaddedArrayRef());
             }
@@ -1995,13 +2013,20 @@ void do_force(FILE*                               fplog,
      * decomposition load balancing.
      */
 
-    const bool useOrEmulateGpuNb = simulationWork.useGpuNonbonded || fr->nbv->emulateGpu();
-
     if (!useOrEmulateGpuNb)
     {
         do_nb_verlet(fr, ic, enerd, stepWork, InteractionLocality::Local, enbvClearFYes, step, nrnb, wcycle);
     }
 
+    if (useCpuHaloOverlap && !stepWork.doNeighborSearch)
+    {
+        /* Complete the coordinate halo exchange that overlapped with the local non-bonded work */
+        wallcycle_stop(wcycle, WallCycleCounter::Force);
+        dd_move_x_finish(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+        nbv->convertCoordinates(AtomLocality::NonLocal, x.unpaddedArrayRef());
+        wallcycle_start_nocount(wcycle, WallCycleCounter::Force);
+    }
+
     if (stepWork.useGpuXHalo && domainWork.haveCpuNonLocalForceWork)
     {
         wallcycle_stop(wcycle, WallCycleCounter::Force);
@@ -2134,6 +2159,19 @@ void do_force(FILE*                               fplog,
         }
     }
 
+    /* All forces on halo atoms have now been computed. The long-range
+     * and special forces only act on home atoms, so they can be computed
+     * while the first stage of the force halo exchange is in flight.
+     */
+    const bool overlapForceHaloExchange = useCpuHaloOverlap && stepWork.computeForces
+                                          && !simulationWork.useMts && !stepWork.useGpuFHalo;
+    if (overlapForceHaloExchange)
+    {
+        wallcycle_stop(wcycle, WallCycleCounter::Force);
+        dd_move_f_begin(cr->dd, &forceOutMtsLevel0.forceWithShiftForces(), wcycle);
+        wallcycle_start_nocount(wcycle, WallCycleCounter::Force);
+    }
+
     if (stepWork.computeSlowForces)
     {
         longRangeNonbondeds->calculate(fr->pmedata,
@@ -2364,7 +2402,11 @@ void do_force(FILE*                               fplog,
 
                 // Without MTS or with MTS at slow steps with uncombined forces we need to
                 // communicate the fast forces
-                if (!simulationWork.useMts || !stepWork.combineMtsForcesBeforeHaloExchange)
+                if (overlapForceHaloExchange)
+                {
+                    dd_move_f_finish(cr->dd, &forceOutMtsLevel0.forceWithShiftForces(), wcycle);
+                }
+                else if (!simulationWork.useMts || !stepWork.combineMtsForcesBeforeHaloExchange)
                 {
                     dd_move_f(cr->dd, &forceOutMtsLevel0.forceWithShiftForces(), wcycle);
                 }
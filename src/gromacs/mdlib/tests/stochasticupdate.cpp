@@ -0,0 +1,303 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests that the SIMD and scalar code paths of the SD and BD integrators agree
+ *
+ * The SD and BD updates use SIMD for blocks of atoms that only contain
+ * normal, unfrozen particles and fall back to scalar code otherwise, as
+ * well as for SD with acceleration groups or Parrinello-Rahman coupling.
+ * These tests trigger the scalar code without changing the result for
+ * the unaffected atoms and dimensions and compare with the SIMD result.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdlib/update.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/group.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/topology/topology_enums.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/enumerationhelpers.h"
+#include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The change to the system that makes the update use the scalar code
+enum class ScalarPathTrigger
+{
+    None,               //!< Use SIMD for all atoms
+    PartiallyFrozen,    //!< Every fifth atom is frozen along y
+    Shells,             //!< Every fifth atom is a shell
+    AccelerationGroups, //!< Use acceleration groups with zero acceleration
+    ParrinelloRahman,   //!< Use Parrinello-Rahman coupling with a zero scaling matrix
+    Count
+};
+
+//! Names of the scalar path triggers
+const EnumerationArray<ScalarPathTrigger, const char*> c_scalarPathTriggerNames = {
+    { "None", "PartiallyFrozen", "Shells", "AccelerationGroups", "ParrinelloRahman" }
+};
+
+//! The number of atoms, not a multiple of the SIMD width
+constexpr int c_numAtoms = 37;
+
+//! Returns whether atom \p a is modified by \p trigger
+bool atomIsModified(ScalarPathTrigger trigger, int a)
+{
+    return (trigger == ScalarPathTrigger::PartiallyFrozen || trigger == ScalarPathTrigger::Shells)
+           && a % 5 == 0;
+}
+
+//! Returns whether dimension \p d of atom \p a is not updated with \p trigger
+bool dimensionIsFixed(ScalarPathTrigger trigger, int a, int d)
+{
+    return atomIsModified(trigger, a) && (trigger == ScalarPathTrigger::Shells || d == YY);
+}
+
+//! The coordinates before and the coordinates and velocities after an update
+struct UpdateResult
+{
+    //! The coordinates before the update
+    std::vector<RVec> x;
+    //! The updated coordinates
+    std::vector<RVec> xPrime;
+    //! The updated velocities
+    std::vector<RVec> v;
+};
+
+//! Performs one update step with \p integrator of a test system modified by \p trigger
+UpdateResult runUpdate(IntegrationAlgorithm integrator,
+                       bool                 haveConstraints,
+                       ScalarPathTrigger    trigger)
+{
+    t_inputrec ir;
+    ir.eI      = integrator;
+    ir.delta_t = 0.002;
+    ir.ld_seed = 1993;
+    ir.bd_fric = 0;
+
+    ir.opts.ngtc = 2;
+    snew(ir.opts.ref_t, ir.opts.ngtc);
+    snew(ir.opts.tau_t, ir.opts.ngtc);
+    // Needed for freeing the inputrec
+    snew(ir.opts.anneal_time, ir.opts.ngtc);
+    snew(ir.opts.anneal_temp, ir.opts.ngtc);
+    for (int g = 0; g < ir.opts.ngtc; g++)
+    {
+        ir.opts.ref_t[g] = 300 + 50 * g;
+        ir.opts.tau_t[g] = 0.5 + g;
+    }
+
+    ir.opts.ngfrz = 2;
+    snew(ir.opts.nFreeze, ir.opts.ngfrz);
+    ir.opts.nFreeze[1][YY] = 1;
+
+    ir.opts.ngacc = 1;
+    snew(ir.opts.acceleration, ir.opts.ngacc);
+
+    Matrix3x3 parrinelloRahmanM = { { 0._real } };
+    if (trigger == ScalarPathTrigger::ParrinelloRahman)
+    {
+        ir.pressureCouplingOptions.epc        = PressureCoupling::ParrinelloRahman;
+        ir.pressureCouplingOptions.nstpcouple = 1;
+    }
+
+    const std::vector<real> referenceTemperature(ir.opts.ref_t, ir.opts.ref_t + ir.opts.ngtc);
+    gmx_ekindata_t ekind(referenceTemperature, EnsembleTemperatureSetting::NotAvailable, 0, 0, 1);
+
+    std::vector<unsigned short> cFREEZE(c_numAtoms, 0);
+    std::vector<unsigned short> cTC(c_numAtoms);
+    std::vector<unsigned short> cAcceleration;
+    std::vector<ParticleType>   ptype(c_numAtoms, ParticleType::Atom);
+    // The SIMD code needs aligned and padded inverse masses
+    PaddedVector<real> invMass;
+    invMass.resizeWithPadding(c_numAtoms);
+    std::vector<RVec>           invMassPerDim(c_numAtoms);
+
+    t_state state;
+    state.x.resizeWithPadding(c_numAtoms);
+    state.v.resizeWithPadding(c_numAtoms);
+    PaddedVector<RVec> f;
+    f.resizeWithPadding(c_numAtoms);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        cTC[a]     = a % ir.opts.ngtc;
+        invMass[a] = 1.0 / (1.0 + a % 17);
+        for (int d = 0; d < DIM; d++)
+        {
+            state.x[a][d] = 0.1 * ((a * 7 + d * 3) % 23);
+            state.v[a][d] = 0.2 * ((a * 5 + d) % 11) - 1;
+            f[a][d]       = 10.0 * ((a * 3 + d * 5) % 13) - 60;
+        }
+        if (atomIsModified(trigger, a))
+        {
+            if (trigger == ScalarPathTrigger::PartiallyFrozen)
+            {
+                cFREEZE[a] = 1;
+            }
+            else
+            {
+                ptype[a]   = ParticleType::Shell;
+                invMass[a] = 0;
+            }
+        }
+        invMassPerDim[a] = { invMass[a], invMass[a], invMass[a] };
+    }
+    if (trigger == ScalarPathTrigger::AccelerationGroups)
+    {
+        cAcceleration.resize(c_numAtoms, 0);
+    }
+
+    gmx_omp_nthreads_set(ModuleMultiThread::Update, 1);
+
+    Update update(ir, ekind, nullptr);
+    update.updateAfterPartition(c_numAtoms, cFREEZE, cTC, cAcceleration);
+
+    UpdateResult result;
+    result.x.assign(state.x.begin(), state.x.begin() + c_numAtoms);
+
+    t_commrec cr;
+    update.update_coords(ir,
+                         0,
+                         c_numAtoms,
+                         trigger == ScalarPathTrigger::PartiallyFrozen,
+                         ptype,
+                         invMass,
+                         invMassPerDim,
+                         &state,
+                         f.arrayRefWithPadding(),
+                         nullptr,
+                         &ekind,
+                         parrinelloRahmanM,
+                         etrtPOSITION,
+                         &cr,
+                         haveConstraints);
+
+    const auto xPrime = makeArrayRef(*update.xp()).subArray(0, c_numAtoms);
+    result.xPrime.assign(xPrime.begin(), xPrime.end());
+    result.v.assign(state.v.begin(), state.v.begin() + c_numAtoms);
+
+    return result;
+}
+
+//! Parameters: the integrator, whether there are constraints and the scalar path trigger
+using StochasticUpdateParameters = std::tuple<IntegrationAlgorithm, bool, ScalarPathTrigger>;
+
+//! Test fixture for comparing the SIMD and scalar paths of the SD and BD updates
+class StochasticUpdateTest : public ::testing::TestWithParam<StochasticUpdateParameters>
+{
+};
+
+TEST_P(StochasticUpdateTest, ScalarPathMatchesSimdPath)
+{
+    const IntegrationAlgorithm integrator      = std::get<0>(GetParam());
+    const bool                 haveConstraints = std::get<1>(GetParam());
+    const ScalarPathTrigger    trigger         = std::get<2>(GetParam());
+
+    const UpdateResult reference = runUpdate(integrator, haveConstraints, ScalarPathTrigger::None);
+    const UpdateResult result    = runUpdate(integrator, haveConstraints, trigger);
+
+    // The SIMD code uses FMA, which changes the rounding
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(10.0, 1e-6);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            SCOPED_TRACE(formatString("Atom %d dimension %d", a, d));
+            if (dimensionIsFixed(trigger, a, d))
+            {
+                EXPECT_EQ(result.v[a][d], 0);
+                EXPECT_EQ(result.xPrime[a][d], result.x[a][d]);
+            }
+            else
+            {
+                EXPECT_REAL_EQ_TOL(reference.v[a][d], result.v[a][d], tolerance);
+                EXPECT_REAL_EQ_TOL(reference.xPrime[a][d], result.xPrime[a][d], tolerance);
+            }
+        }
+    }
+}
+
+//! Returns the name of the test with \p info
+std::string nameOfTest(const ::testing::TestParamInfo<StochasticUpdateParameters>& info)
+{
+    return formatString("%s_%s_%s",
+                        enumValueToString(std::get<0>(info.param)),
+                        std::get<1>(info.param) ? "Constraints" : "NoConstraints",
+                        c_scalarPathTriggerNames[std::get<2>(info.param)]);
+}
+
+INSTANTIATE_TEST_SUITE_P(SD,
+                         StochasticUpdateTest,
+                         ::testing::Combine(::testing::Values(IntegrationAlgorithm::SD1),
+                                            ::testing::Bool(),
+                                            ::testing::Values(ScalarPathTrigger::PartiallyFrozen,
+                                                              ScalarPathTrigger::Shells,
+                                                              ScalarPathTrigger::AccelerationGroups,
+                                                              ScalarPathTrigger::ParrinelloRahman)),
+                         nameOfTest);
+
+INSTANTIATE_TEST_SUITE_P(BD,
+                         StochasticUpdateTest,
+                         ::testing::Combine(::testing::Values(IntegrationAlgorithm::BD),
+                                            ::testing::Values(false),
+                                            ::testing::Values(ScalarPathTrigger::PartiallyFrozen,
+                                                              ScalarPathTrigger::Shells)),
+                         nameOfTest);
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -36,6 +36,7 @@
 #include "trajectory_writing.h"
 
 #include "gromacs/commandline/filenm.h"
+#include "gromacs/domdec/collect.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/math/vec.h"
@@ -97,6 +98,14 @@ void do_md_trajectory_writing(FILE*                          fplog,
     {
         mdof_flags |= MDOF_X_COMPRESSED;
     }
+    if (do_per_step(step, ir->nstvout_compressed))
+    {
+        mdof_flags |= MDOF_V_COMPRESSED;
+    }
+    if (do_per_step(step, ir->nstfout_compressed))
+    {
+        mdof_flags |= MDOF_F_COMPRESSED;
+    }
     if (bCPT)
     {
         mdof_flags |= MDOF_CPT;
@@ -148,7 +157,26 @@ void do_md_trajectory_writing(FILE*                          fplog,
         // TODO: Remove duplication asap, make sure to keep in sync in the meantime.
         mdoutf_write_to_trajectory_files(
                 fplog, cr, outf, mdof_flags, top_global.natoms, step, t, state, state_global, observablesHistory, f, &checkpointDataHolder);
-        if (bLastStep && step_rel == ir->nsteps && bDoConfOut && MAIN(cr) && !bRerunMD)
+        const bool writeConfOut = (bLastStep && step_rel == ir->nsteps && bDoConfOut && !bRerunMD);
+        if (writeConfOut && haveDDAtomOrdering(*cr) && mdoutf_get_write_state_shards(outf))
+        {
+            /* With state shards the checkpoint does not collect x and v */
+            auto globalXRef = MAIN(cr) ? state_global->x : gmx::ArrayRef<gmx::RVec>();
+            dd_collect_vec(cr->dd,
+                           state->ddp_count,
+                           state->ddp_count_cg_gl,
+                           state->cg_gl,
+                           state->x,
+                           globalXRef);
+            auto globalVRef = MAIN(cr) ? state_global->v : gmx::ArrayRef<gmx::RVec>();
+            dd_collect_vec(cr->dd,
+                           state->ddp_count,
+                           state->ddp_count_cg_gl,
+                           state->cg_gl,
+                           state->v,
+                           globalVRef);
+        }
+        if (writeConfOut && MAIN(cr))
         {
             if (fr->bMolPBC && state == state_global)
             {
@@ -171,7 +199,7 @@ void do_md_trajectory_writing(FILE*                          fplog,
 
             /* x and v have been collected in mdoutf_write_to_trajectory_files,
              * because a checkpoint file will always be written
-             * at the last step.
+             * at the last step, or above when using state shards.
              */
             fprintf(stderr, "\nWriting final coordinates.\n");
             if (fr->bMolPBC && !ir->bPeriodicMols)
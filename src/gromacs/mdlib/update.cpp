@@ -39,6 +39,7 @@
 #include <cstdio>
 
 #include <algorithm>
+#include <array>
 #include <memory>
 
 #include "gromacs/domdec/domdec_struct.h"
@@ -63,8 +64,7 @@
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pulling/pull.h"
-#include "gromacs/random/tabulatednormaldistribution.h"
-#include "gromacs/random/threefry.h"
+#include "gromacs/random/threefrysimd.h"
 #include "gromacs/simd/simd.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/atoms.h"
@@ -1069,6 +1069,178 @@ enum class SDUpdate : int
     Count
 };
 
+//! Random engine for the SD and BD integrators, handles the atoms in a SIMD register at once
+using UpdateRandomEngine = gmx::ThreeFry4x32Simd<UpdateSimdTraits::width>;
+
+/*! \brief Generates three normally distributed random numbers for each atom in a block
+ *
+ * The block starts at \p blockStart, which should be a multiple of
+ * UpdateSimdTraits::width, and has UpdateSimdTraits::width atoms.
+ * The numbers for an atom only depend on the seed, the step and the
+ * global atom index. Thus they do not depend on the number of threads
+ * or on whether the atom is updated with SIMD or scalar code.
+ * Atoms in the block beyond \p nrend get the numbers of atom \p nrend - 1.
+ *
+ * \param[in]  rng        The random engine
+ * \param[in]  step       The MD step
+ * \param[in]  blockStart The first atom in the block
+ * \param[in]  nrend      The end of the atom range to update
+ * \param[in]  gatindex   The global atom indices, can be nullptr
+ * \param[out] noise      Normally distributed numbers, aligned to SIMD width
+ */
+static inline void generateUpdateNoise(const UpdateRandomEngine& rng,
+                                       int64_t                   step,
+                                       int                       blockStart,
+                                       int                       nrend,
+                                       const int*                gatindex,
+                                       rvec*                     noise)
+{
+    std::array<int, UpdateSimdTraits::width> globalAtomIndex;
+
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t offset[UpdateSimdTraits::width];
+    for (int l = 0; l < UpdateSimdTraits::width; l++)
+    {
+        const int a        = std::min(blockStart + l, nrend - 1);
+        globalAtomIndex[l] = gatindex ? gatindex[a] : a;
+        offset[l]          = l;
+    }
+
+    UpdateSimdReal noise0, noise1, noise2, noiseUnused;
+    gmx::normalsFromRandomBits(
+            rng.generateBlock(step, globalAtomIndex), &noise0, &noise1, &noise2, &noiseUnused);
+
+    transposeScatterStoreU<DIM>(noise[0], offset, noise0, noise1, noise2);
+}
+
+/*! \brief Returns whether all atoms in the block starting at \p blockStart are normal particles
+ *
+ * Shells and (partially) frozen atoms need the scalar update code.
+ */
+static inline bool blockHasOnlyFreeParticles(int                                 blockStart,
+                                             int                                 nrend,
+                                             gmx::ArrayRef<const ivec>           nFreeze,
+                                             gmx::ArrayRef<const ParticleType>   ptype,
+                                             gmx::ArrayRef<const unsigned short> cFREEZE)
+{
+    const int blockEnd = std::min(blockStart + UpdateSimdTraits::width, nrend);
+    for (int n = blockStart; n < blockEnd; n++)
+    {
+        const int freezeGroup = !cFREEZE.empty() ? cFREEZE[n] : 0;
+        if (ptype[n] == ParticleType::Shell || nFreeze[freezeGroup][XX] || nFreeze[freezeGroup][YY]
+            || nFreeze[freezeGroup][ZZ])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! \brief SD integrator update of a block of UpdateSimdTraits::width atoms using SIMD
+ *
+ * Does the same as the scalar update in doSDUpdateGeneral() for
+ * atoms that are not shells and not frozen, without acceleration
+ * and Parrinello-Rahman scaling. Note that atoms beyond \p nrend
+ * in the last block are updated as well, which is allowed because
+ * of the padding of the coordinate and velocity buffers.
+ */
+template<SDUpdate updateType>
+static inline void doSDUpdateSimdBlock(const gmx_stochd_t&                 sd,
+                                       int                                 blockStart,
+                                       int                                 nrend,
+                                       real                                dt,
+                                       gmx::ArrayRef<const real>           invmass,
+                                       gmx::ArrayRef<const unsigned short> cTC,
+                                       const rvec* gmx_restrict            x,
+                                       rvec* gmx_restrict                  xprime,
+                                       rvec* gmx_restrict                  v,
+                                       const rvec* gmx_restrict            f,
+                                       const rvec*                         noise)
+{
+    const int a = blockStart;
+
+    UpdateSimdReal timestep(dt);
+
+    UpdateSimdReal invMassAtoms = load<UpdateSimdReal>(invmass.data() + a);
+    UpdateSimdReal invMass0, invMass1, invMass2;
+    expandScalarsToTriplets(invMassAtoms, &invMass0, &invMass1, &invMass2);
+
+    UpdateSimdReal v0, v1, v2;
+    simdLoadRvecs(v, a, &v0, &v1, &v2);
+
+    if constexpr (updateType != SDUpdate::FrictionAndNoiseOnly)
+    {
+        UpdateSimdReal f0, f1, f2;
+        simdLoadRvecs(f, a, &f0, &f1, &f2);
+
+        v0 = gmx::fma(f0 * invMass0, timestep, v0);
+        v1 = gmx::fma(f1 * invMass1, timestep, v1);
+        v2 = gmx::fma(f2 * invMass2, timestep, v2);
+    }
+
+    if constexpr (updateType == SDUpdate::ForcesOnly)
+    {
+        simdStoreRvecs(v, a, v0, v1, v2);
+
+        UpdateSimdReal x0, x1, x2;
+        simdLoadRvecs(x, a, &x0, &x1, &x2);
+        simdStoreRvecs(xprime,
+                       a,
+                       gmx::fma(v0, timestep, x0),
+                       gmx::fma(v1, timestep, x1),
+                       gmx::fma(v2, timestep, x2));
+    }
+    else
+    {
+        // Gather the friction and noise parameters of the temperature-coupling groups
+        alignas(GMX_SIMD_ALIGNMENT) real frictionFactor[UpdateSimdTraits::width];
+        alignas(GMX_SIMD_ALIGNMENT) real noiseSigma[UpdateSimdTraits::width];
+        for (int l = 0; l < UpdateSimdTraits::width; l++)
+        {
+            const int temperatureGroup = !cTC.empty() ? cTC[std::min(a + l, nrend - 1)] : 0;
+            frictionFactor[l]          = sd.sdc[temperatureGroup].em;
+            noiseSigma[l]              = sd.sdsig[temperatureGroup].V;
+        }
+        UpdateSimdReal em0, em1, em2;
+        expandScalarsToTriplets(load<UpdateSimdReal>(frictionFactor), &em0, &em1, &em2);
+        UpdateSimdReal sigma0, sigma1, sigma2;
+        expandScalarsToTriplets(
+                gmx::sqrt(invMassAtoms) * load<UpdateSimdReal>(noiseSigma), &sigma0, &sigma1, &sigma2);
+
+        UpdateSimdReal noise0, noise1, noise2;
+        simdLoadRvecs(noise, 0, &noise0, &noise1, &noise2);
+
+        UpdateSimdReal vNew0 = gmx::fma(sigma0, noise0, v0 * em0);
+        UpdateSimdReal vNew1 = gmx::fma(sigma1, noise1, v1 * em1);
+        UpdateSimdReal vNew2 = gmx::fma(sigma2, noise2, v2 * em2);
+
+        simdStoreRvecs(v, a, vNew0, vNew1, vNew2);
+
+        UpdateSimdReal halfTimestep(0.5_real * dt);
+        UpdateSimdReal xprime0, xprime1, xprime2;
+        if constexpr (updateType == SDUpdate::FrictionAndNoiseOnly)
+        {
+            // The previous phase already updated the positions with
+            // a full v*dt term that must now be half removed.
+            simdLoadRvecs(xprime, a, &xprime0, &xprime1, &xprime2);
+            xprime0 = gmx::fma(vNew0 - v0, halfTimestep, xprime0);
+            xprime1 = gmx::fma(vNew1 - v1, halfTimestep, xprime1);
+            xprime2 = gmx::fma(vNew2 - v2, halfTimestep, xprime2);
+        }
+        else
+        {
+            // Here we include half of the friction+noise update of v
+            // into the position update.
+            UpdateSimdReal x0, x1, x2;
+            simdLoadRvecs(x, a, &x0, &x1, &x2);
+            xprime0 = gmx::fma(v0 + vNew0, halfTimestep, x0);
+            xprime1 = gmx::fma(v1 + vNew1, halfTimestep, x1);
+            xprime2 = gmx::fma(v2 + vNew2, halfTimestep, x2);
+        }
+        simdStoreRvecs(xprime, a, xprime0, xprime1, xprime2);
+    }
+}
+
 /*! \brief SD integrator update
  *
  * Two phases are required in the general case of a constrained
@@ -1081,7 +1253,12 @@ enum class SDUpdate : int
  * efficiency.
  *
  * Thus three instantiations of this templated function will be made,
- * two with only one contribution, and one with both contributions. */
+ * two with only one contribution, and one with both contributions.
+ *
+ * The atoms are processed in blocks of SIMD width. Blocks that only
+ * contain normal particles are updated with SIMD when there are no
+ * acceleration groups and no Parrinello-Rahman scaling. The random
+ * numbers are the same with and without SIMD. */
 template<SDUpdate updateType>
 static void doSDUpdateGeneral(const gmx_stochd_t&                 sd,
                               int                                 start,
@@ -1122,73 +1299,95 @@ static void doSDUpdateGeneral(const gmx_stochd_t&                 sd,
     {
         GMX_ASSERT(f != nullptr, "SD update with forces and noise requires forces");
     }
+    GMX_ASSERT(start % UpdateSimdTraits::width == 0,
+               "The random numbers are generated for blocks of atoms aligned to the SIMD width");
 
-    // Even 0 bits internal counter gives 2x64 ints (more than enough for three table lookups)
-    gmx::ThreeFry2x64<0>                       rng(seed, gmx::RandomDomain::UpdateCoordinates);
-    gmx::TabulatedNormalDistribution<real, 14> dist;
+    const bool haveAcceleration =
+            (updateType != SDUpdate::FrictionAndNoiseOnly
+             && (!cAcceleration.empty() || acceleration[0][XX] != 0 || acceleration[0][YY] != 0
+                 || acceleration[0][ZZ] != 0));
+    const bool useSimd = (GMX_HAVE_SIMD_UPDATE && !haveAcceleration && dtPressureCouple == 0);
 
-    for (int n = start; n < nrend; n++)
-    {
-        int globalAtomIndex = gatindex ? gatindex[n] : n;
-        rng.restart(step, globalAtomIndex);
-        dist.reset();
-
-        real inverseMass = invmass[n];
-        real invsqrtMass = std::sqrt(inverseMass);
+    const UpdateRandomEngine rng(seed, gmx::RandomDomain::UpdateCoordinates);
 
-        int freezeGroup       = !cFREEZE.empty() ? cFREEZE[n] : 0;
-        int accelerationGroup = !cAcceleration.empty() ? cAcceleration[n] : 0;
-        int temperatureGroup  = !cTC.empty() ? cTC[n] : 0;
+    for (int blockStart = start; blockStart < nrend; blockStart += UpdateSimdTraits::width)
+    {
+        alignas(GMX_SIMD_ALIGNMENT) rvec noise[UpdateSimdTraits::width];
+        if (updateType != SDUpdate::ForcesOnly)
+        {
+            generateUpdateNoise(rng, step, blockStart, nrend, gatindex, noise);
+        }
 
-        RVec parrinelloRahmanScaledVelocity;
-        if (updateType != SDUpdate::FrictionAndNoiseOnly)
+        if (useSimd && blockHasOnlyFreeParticles(blockStart, nrend, nFreeze, ptype, cFREEZE))
         {
-            parrinelloRahmanScaledVelocity =
-                    dtPressureCouple * multiplyVectorByMatrix(parrinelloRahmanM, v[n]);
+            doSDUpdateSimdBlock<updateType>(sd, blockStart, nrend, dt, invmass, cTC, x, xprime, v, f, noise);
+            continue;
         }
-        for (int d = 0; d < DIM; d++)
+
+        const int blockEnd = std::min(blockStart + UpdateSimdTraits::width, nrend);
+        for (int n = blockStart; n < blockEnd; n++)
         {
-            if ((ptype[n] != ParticleType::Shell) && !nFreeze[freezeGroup][d])
+            real inverseMass = invmass[n];
+            real invsqrtMass = std::sqrt(inverseMass);
+
+            int freezeGroup       = !cFREEZE.empty() ? cFREEZE[n] : 0;
+            int accelerationGroup = !cAcceleration.empty() ? cAcceleration[n] : 0;
+            int temperatureGroup  = !cTC.empty() ? cTC[n] : 0;
+
+            const real* atomNoise = noise[n - blockStart];
+
+            RVec parrinelloRahmanScaledVelocity;
+            if (updateType != SDUpdate::FrictionAndNoiseOnly)
             {
-                if (updateType == SDUpdate::ForcesOnly)
-                {
-                    real vn = v[n][d] + (inverseMass * f[n][d] + acceleration[accelerationGroup][d]) * dt
-                              - parrinelloRahmanScaledVelocity[d];
-                    v[n][d] = vn;
-                    // Simple position update.
-                    xprime[n][d] = x[n][d] + v[n][d] * dt;
-                }
-                else if (updateType == SDUpdate::FrictionAndNoiseOnly)
+                parrinelloRahmanScaledVelocity =
+                        dtPressureCouple * multiplyVectorByMatrix(parrinelloRahmanM, v[n]);
+            }
+            for (int d = 0; d < DIM; d++)
+            {
+                if ((ptype[n] != ParticleType::Shell) && !nFreeze[freezeGroup][d])
                 {
-                    real vn = v[n][d];
-                    v[n][d] = (vn * sd.sdc[temperatureGroup].em
-                               + invsqrtMass * sd.sdsig[temperatureGroup].V * dist(rng));
-                    // The previous phase already updated the
-                    // positions with a full v*dt term that must
-                    // now be half removed.
-                    xprime[n][d] = xprime[n][d] + 0.5 * (v[n][d] - vn) * dt;
+                    if (updateType == SDUpdate::ForcesOnly)
+                    {
+                        real vn = v[n][d]
+                                  + (inverseMass * f[n][d] + acceleration[accelerationGroup][d]) * dt
+                                  - parrinelloRahmanScaledVelocity[d];
+                        v[n][d] = vn;
+                        // Simple position update.
+                        xprime[n][d] = x[n][d] + v[n][d] * dt;
+                    }
+                    else if (updateType == SDUpdate::FrictionAndNoiseOnly)
+                    {
+                        real vn = v[n][d];
+                        v[n][d] = (vn * sd.sdc[temperatureGroup].em
+                                   + invsqrtMass * sd.sdsig[temperatureGroup].V * atomNoise[d]);
+                        // The previous phase already updated the
+                        // positions with a full v*dt term that must
+                        // now be half removed.
+                        xprime[n][d] = xprime[n][d] + 0.5 * (v[n][d] - vn) * dt;
+                    }
+                    else
+                    {
+                        real vn = v[n][d]
+                                  + (inverseMass * f[n][d] + acceleration[accelerationGroup][d]) * dt
+                                  - parrinelloRahmanScaledVelocity[d];
+                        v[n][d] = (vn * sd.sdc[temperatureGroup].em
+                                   + invsqrtMass * sd.sdsig[temperatureGroup].V * atomNoise[d]);
+                        // Here we include half of the friction+noise
+                        // update of v into the position update.
+                        xprime[n][d] = x[n][d] + 0.5 * (vn + v[n][d]) * dt;
+                    }
                 }
                 else
                 {
-                    real vn = v[n][d] + (inverseMass * f[n][d] + acceleration[accelerationGroup][d]) * dt
-                              - parrinelloRahmanScaledVelocity[d];
-                    v[n][d] = (vn * sd.sdc[temperatureGroup].em
-                               + invsqrtMass * sd.sdsig[temperatureGroup].V * dist(rng));
-                    // Here we include half of the friction+noise
-                    // update of v into the position update.
-                    xprime[n][d] = x[n][d] + 0.5 * (vn + v[n][d]) * dt;
-                }
-            }
-            else
-            {
-                // When using constraints, the update is split into
-                // two phases, but we only need to zero the update of
-                // virtual, shell or frozen particles in at most one
-                // of the phases.
-                if (updateType != SDUpdate::FrictionAndNoiseOnly)
-                {
-                    v[n][d]      = 0.0;
-                    xprime[n][d] = x[n][d];
+                    // When using constraints, the update is split into
+                    // two phases, but we only need to zero the update of
+                    // virtual, shell or frozen particles in at most one
+                    // of the phases.
+                    if (updateType != SDUpdate::FrictionAndNoiseOnly)
+                    {
+                        v[n][d]      = 0.0;
+                        xprime[n][d] = x[n][d];
+                    }
                 }
             }
         }
@@ -1281,6 +1480,74 @@ static void do_update_sd(int                                 start,
     }
 }
 
+/*! \brief BD integrator update of a block of UpdateSimdTraits::width atoms using SIMD
+ *
+ * Does the same as the scalar update in do_update_bd() for atoms
+ * that are not shells and not frozen. Note that atoms beyond \p nrend
+ * in the last block are updated as well, which is allowed because
+ * of the padding of the coordinate and velocity buffers.
+ */
+static inline void doBDUpdateSimdBlock(int                                 blockStart,
+                                       int                                 nrend,
+                                       real                                dt,
+                                       gmx::ArrayRef<const real>           invmass,
+                                       gmx::ArrayRef<const unsigned short> cTC,
+                                       real                                friction_coefficient,
+                                       const real*                         rf,
+                                       const rvec* gmx_restrict            x,
+                                       rvec* gmx_restrict                  xprime,
+                                       rvec* gmx_restrict                  v,
+                                       const rvec* gmx_restrict            f,
+                                       const rvec*                         noise)
+{
+    const int a = blockStart;
+
+    alignas(GMX_SIMD_ALIGNMENT) real randomForceFactor[UpdateSimdTraits::width];
+    for (int l = 0; l < UpdateSimdTraits::width; l++)
+    {
+        randomForceFactor[l] = rf[!cTC.empty() ? cTC[std::min(a + l, nrend - 1)] : 0];
+    }
+
+    UpdateSimdReal forceFactor0, forceFactor1, forceFactor2;
+    UpdateSimdReal noiseFactor0, noiseFactor1, noiseFactor2;
+    if (friction_coefficient != 0)
+    {
+        forceFactor0 = UpdateSimdReal(1.0_real / friction_coefficient);
+        forceFactor1 = forceFactor0;
+        forceFactor2 = forceFactor0;
+        expandScalarsToTriplets(
+                load<UpdateSimdReal>(randomForceFactor), &noiseFactor0, &noiseFactor1, &noiseFactor2);
+    }
+    else
+    {
+        /* NOTE: invmass = 2/(mass*friction_constant*dt) */
+        UpdateSimdReal halfInvMass = UpdateSimdReal(0.5_real) * load<UpdateSimdReal>(invmass.data() + a);
+        expandScalarsToTriplets(
+                halfInvMass * UpdateSimdReal(dt), &forceFactor0, &forceFactor1, &forceFactor2);
+        expandScalarsToTriplets(gmx::sqrt(halfInvMass) * load<UpdateSimdReal>(randomForceFactor),
+                                &noiseFactor0,
+                                &noiseFactor1,
+                                &noiseFactor2);
+    }
+
+    UpdateSimdReal f0, f1, f2;
+    simdLoadRvecs(f, a, &f0, &f1, &f2);
+    UpdateSimdReal noise0, noise1, noise2;
+    simdLoadRvecs(noise, 0, &noise0, &noise1, &noise2);
+
+    UpdateSimdReal v0 = gmx::fma(noiseFactor0, noise0, forceFactor0 * f0);
+    UpdateSimdReal v1 = gmx::fma(noiseFactor1, noise1, forceFactor1 * f1);
+    UpdateSimdReal v2 = gmx::fma(noiseFactor2, noise2, forceFactor2 * f2);
+
+    simdStoreRvecs(v, a, v0, v1, v2);
+
+    UpdateSimdReal timestep(dt);
+    UpdateSimdReal x0, x1, x2;
+    simdLoadRvecs(x, a, &x0, &x1, &x2);
+    simdStoreRvecs(
+            xprime, a, gmx::fma(v0, timestep, x0), gmx::fma(v1, timestep, x1), gmx::fma(v2, timestep, x2));
+}
+
 static void do_update_bd(int                                 start,
                          int                                 nrend,
                          real                                dt,
@@ -1299,58 +1566,68 @@ static void do_update_bd(int                                 start,
                          int                                 seed,
                          const int*                          gatindex)
 {
+    GMX_ASSERT(start % UpdateSimdTraits::width == 0,
+               "The random numbers are generated for blocks of atoms aligned to the SIMD width");
+
     /* note -- these appear to be full step velocities . . .  */
     int  gf = 0, gt = 0;
     real vn;
     real invfr = 0;
     int  n, d;
-    // Use 1 bit of internal counters to give us 2*2 64-bits values per stream
-    // Each 64-bit value is enough for 4 normal distribution table numbers.
-    gmx::ThreeFry2x64<0>                       rng(seed, gmx::RandomDomain::UpdateCoordinates);
-    gmx::TabulatedNormalDistribution<real, 14> dist;
+
+    const UpdateRandomEngine rng(seed, gmx::RandomDomain::UpdateCoordinates);
 
     if (friction_coefficient != 0)
     {
         invfr = 1.0 / friction_coefficient;
     }
 
-    for (n = start; (n < nrend); n++)
+    for (int blockStart = start; blockStart < nrend; blockStart += UpdateSimdTraits::width)
     {
-        int ng = gatindex ? gatindex[n] : n;
+        alignas(GMX_SIMD_ALIGNMENT) rvec noise[UpdateSimdTraits::width];
+        generateUpdateNoise(rng, step, blockStart, nrend, gatindex, noise);
 
-        rng.restart(step, ng);
-        dist.reset();
-
-        if (!cFREEZE.empty())
-        {
-            gf = cFREEZE[n];
-        }
-        if (!cTC.empty())
+        if (GMX_HAVE_SIMD_UPDATE && blockHasOnlyFreeParticles(blockStart, nrend, nFreeze, ptype, cFREEZE))
         {
-            gt = cTC[n];
+            doBDUpdateSimdBlock(
+                    blockStart, nrend, dt, invmass, cTC, friction_coefficient, rf, x, xprime, v, f, noise);
+            continue;
         }
-        for (d = 0; (d < DIM); d++)
+
+        const int blockEnd = std::min(blockStart + UpdateSimdTraits::width, nrend);
+        for (n = blockStart; n < blockEnd; n++)
         {
-            if ((ptype[n] != ParticleType::Shell) && !nFreeze[gf][d])
+            if (!cFREEZE.empty())
+            {
+                gf = cFREEZE[n];
+            }
+            if (!cTC.empty())
+            {
+                gt = cTC[n];
+            }
+            for (d = 0; (d < DIM); d++)
             {
-                if (friction_coefficient != 0)
+                if ((ptype[n] != ParticleType::Shell) && !nFreeze[gf][d])
                 {
-                    vn = invfr * f[n][d] + rf[gt] * dist(rng);
+                    if (friction_coefficient != 0)
+                    {
+                        vn = invfr * f[n][d] + rf[gt] * noise[n - blockStart][d];
+                    }
+                    else
+                    {
+                        /* NOTE: invmass = 2/(mass*friction_constant*dt) */
+                        vn = 0.5 * invmass[n] * f[n][d] * dt
+                             + std::sqrt(0.5 * invmass[n]) * rf[gt] * noise[n - blockStart][d];
+                    }
+
+                    v[n][d]      = vn;
+                    xprime[n][d] = x[n][d] + vn * dt;
                 }
                 else
                 {
-                    /* NOTE: invmass = 2/(mass*friction_constant*dt) */
-                    vn = 0.5 * invmass[n] * f[n][d] * dt
-                         + std::sqrt(0.5 * invmass[n]) * rf[gt] * dist(rng);
+                    v[n][d]      = 0.0;
+                    xprime[n][d] = x[n][d];
                 }
-
-                v[n][d]      = vn;
-                xprime[n][d] = x[n][d] + vn * dt;
-            }
-            else
-            {
-                v[n][d]      = 0.0;
-                xprime[n][d] = x[n][d];
             }
         }
     }
@@ -47,6 +47,7 @@
 #include "legacymdrunoptions.h"
 
 #include <cstring>
+#include <filesystem>
 
 #include "gromacs/math/functions.h"
 #include "gromacs/utility/arrayref.h"
@@ -155,6 +156,23 @@ int LegacyMdrunOptions::updateFromCommandLine(int argc, char** argv, ArrayRef<co
         }
     }
 
+    // The compressed velocities and forces are by default written to
+    // a file named after the compressed coordinate output, also with
+    // -deffnm, which would otherwise give both the same name.
+    if (!opt2bSet("-xvf", ssize(filenames), filenames.data()))
+    {
+        std::filesystem::path compressedVFFileName =
+                opt2fn("-x", ssize(filenames), filenames.data());
+        compressedVFFileName.replace_filename(compressedVFFileName.stem().u8string() + "_vf.xtc");
+        for (t_filenm& fileOption : filenames)
+        {
+            if (fileOption.opt != nullptr && std::strcmp(fileOption.opt, "-xvf") == 0)
+            {
+                fileOption.filenames = { compressedVFFileName.u8string() };
+            }
+        }
+    }
+
     mdrunOptions.rerun            = opt2bSet("-rerun", ssize(filenames), filenames.data());
     mdrunOptions.ntompOptionIsSet = opt2parg_bSet("-ntomp", asize(pa), pa);
 
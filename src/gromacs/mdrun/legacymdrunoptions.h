@@ -96,6 +96,7 @@ public:
     std::vector<t_filenm> filenames = { { { efTPR, nullptr, nullptr, ffREAD },
                                           { efTRN, "-o", nullptr, ffWRITE },
                                           { efCOMPRESSED, "-x", nullptr, ffOPTWR },
+                                          { efXTC, "-xvf", "traj_comp_vf", ffOPTWR },
                                           { efCPT, "-cpi", nullptr, ffOPTRD | ffALLOW_MISSING },
                                           { efCPT, "-cpo", nullptr, ffOPTWR },
                                           { efSTO, "-c", "confout", ffWRITE },
@@ -166,7 +167,7 @@ public:
 
     ImdOptions& imdOptions = mdrunOptions.imdOptions;
 
-    t_pargs pa[48] = {
+    t_pargs pa[52] = {
 
         { "-dd", FALSE, etRVEC, { &realddxyz }, "Domain decomposition grid, 0 is optimize" },
         { "-ddorder", FALSE, etENUM, { ddrank_opt_choices }, "DD rank order" },
@@ -305,6 +306,12 @@ public:
           etBOOL,
           { &mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles },
           "Keep and number checkpoint files" },
+        { "-cptshard",
+          FALSE,
+          etBOOL,
+          { &mdrunOptions.checkpointOptions.writeStateShards },
+          "HIDDENLet each rank write the coordinates and velocities of its atoms to a separate "
+          "checkpoint shard file, avoiding collection of the state on the main rank" },
         { "-append",
           FALSE,
           etBOOL,
@@ -338,6 +345,12 @@ public:
           etINT,
           { &replExParams.randomSeed },
           "Seed for replica exchange, -1 is generate a seed" },
+        { "-replexgibbs",
+          FALSE,
+          etBOOL,
+          { &replExParams.useGibbsSampling },
+          "Use Gibbs sampling over all replica pairs for replica exchange, with -nex attempts "
+          "(number of replicas cubed when zero) on the full reduced energy matrix" },
         { "-imdport", FALSE, etINT, { &imdOptions.port }, "HIDDENIMD listening port" },
         { "-imdwait",
           FALSE,
@@ -354,6 +367,12 @@ public:
           etBOOL,
           { &imdOptions.pull },
           "HIDDENAllow pulling in the simulation from IMD client" },
+        { "-imdasync",
+          FALSE,
+          etBOOL,
+          { &imdOptions.asyncSend },
+          "HIDDENSend IMD frames from a separate thread, dropping frames when the IMD client is "
+          "behind" },
         { "-rerunvsite",
           FALSE,
           etBOOL,
@@ -365,6 +384,12 @@ public:
           { &mdrunOptions.writeConfout },
           "HIDDENWrite the last configuration with [TT]-c[tt] and force checkpointing at the last "
           "step" },
+        { "-xfrag",
+          FALSE,
+          etBOOL,
+          { &mdrunOptions.writeXtcFragments },
+          "HIDDENWith domain decomposition, let each rank write the compressed coordinates of "
+          "its atoms to a separate XTC fragment file, avoiding collection on the main rank" },
         { "-stepout",
           FALSE,
           etINT,
@@ -941,7 +941,8 @@ void gmx::LegacySimulator::do_md()
         // We only need to calculate virtual velocities if we are writing them in the current step
         const bool needVirtualVelocitiesThisStep =
                 (virtualSites_ != nullptr)
-                && (do_per_step(step, ir->nstvout) || checkpointHandler->isCheckpointingStep());
+                && (do_per_step(step, ir->nstvout) || do_per_step(step, ir->nstvout_compressed)
+                    || checkpointHandler->isCheckpointingStep());
 
         if (virtualSites_ != nullptr)
         {
@@ -1102,7 +1103,8 @@ void gmx::LegacySimulator::do_md()
         force_flags = (GMX_FORCE_STATECHANGED | ((inputrecDynamicBox(ir)) ? GMX_FORCE_DYNAMICBOX : 0)
                        | GMX_FORCE_ALLFORCES | (bCalcVir ? GMX_FORCE_VIRIAL : 0)
                        | (bCalcEner ? GMX_FORCE_ENERGY : 0) | (computeDHDL ? GMX_FORCE_DHDL : 0));
-        if (simulationWork.useMts && !do_per_step(step, ir->nstfout))
+        if (simulationWork.useMts && !do_per_step(step, ir->nstfout)
+            && !do_per_step(step, ir->nstfout_compressed))
         {
             // TODO: merge this with stepWork.useOnlyMtsCombinedForceBuffer
             force_flags |= GMX_FORCE_DO_NOT_NEED_NORMAL_FORCE;
@@ -1143,6 +1145,8 @@ void gmx::LegacySimulator::do_md()
                         && !needHalfStepKineticEnergy && !do_per_step(step, ir->nstxout)
                         && !do_per_step(step, ir->nstxout_compressed)
                         && !do_per_step(step, ir->nstvout) && !do_per_step(step, ir->nstfout)
+                        && !do_per_step(step, ir->nstvout_compressed)
+                        && !do_per_step(step, ir->nstfout_compressed)
                         && !checkpointHandler->isCheckpointingStep();
                 if (mdGraph->captureThisStep(canUseMdGpuGraphThisStep))
                 {
@@ -1344,7 +1348,8 @@ void gmx::LegacySimulator::do_md()
             // Copy velocities if needed for the output/checkpointing.
             // NOTE: Copy on the search steps is done at the beginning of the step.
             if (useGpuForUpdate && !bNS
-                && (do_per_step(step, ir->nstvout) || checkpointHandler->isCheckpointingStep()))
+                && (do_per_step(step, ir->nstvout) || do_per_step(step, ir->nstvout_compressed)
+                    || checkpointHandler->isCheckpointingStep()))
             {
                 stateGpu->copyVelocitiesFromGpu(state_->v, AtomLocality::Local);
                 stateGpu->waitVelocitiesReadyOnHost(AtomLocality::Local);
@@ -1360,7 +1365,8 @@ void gmx::LegacySimulator::do_md()
             // NOTE: The forces should not be copied here if the vsites are present, since they were modified
             //       on host after the D2H copy in do_force(...).
             if (runScheduleWork_->stepWork.useGpuFBufferOps
-                && (simulationWork.useGpuUpdate && !virtualSites_) && do_per_step(step, ir->nstfout))
+                && (simulationWork.useGpuUpdate && !virtualSites_)
+                && (do_per_step(step, ir->nstfout) || do_per_step(step, ir->nstfout_compressed)))
             {
                 stateGpu->copyForcesFromGpu(f.view().force(), AtomLocality::Local);
                 stateGpu->waitForcesReadyOnHost(AtomLocality::Local);
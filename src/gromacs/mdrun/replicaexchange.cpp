@@ -128,6 +128,8 @@ struct gmx_repl_ex
     int nst;
     //! Number of exchanges per interval
     int nex;
+    //! Whether the permutation is sampled with all-pairs Gibbs sampling
+    gmx_bool bGibbs;
     //! Random seed
     int seed;
     //! Number of even and odd replica change attempts
@@ -158,6 +160,18 @@ struct gmx_repl_ex
     real*  Vol;
     real** de;
     //! \}
+
+    //! Helper arrays for Gibbs sampling of the replica permutation.
+    //! \{
+    //! Buffer for the single reduction over the simulations: Epot, Vol and de row by row
+    real* gibbsBuffer;
+    //! Reduced energy of configuration k in state l, stored as [k * nrepl + l]
+    double* reducedEnergy;
+    //! Total number of pair swap attempts with Gibbs sampling
+    int64_t gibbsNumAttempts;
+    //! Number of accepted pair swaps with Gibbs sampling
+    int64_t gibbsNumAccepted;
+    //! \}
 };
 
 // TODO We should add Doxygen here some time.
@@ -508,6 +522,28 @@ gmx_repl_ex_t init_replica_exchange(FILE*                            fplog,
         snew(re->de[i], re->nrepl);
     }
     re->nex = replExParams.numExchanges;
+
+    re->bGibbs = replExParams.useGibbsSampling;
+    if (re->bGibbs)
+    {
+        if (re->nex == 0)
+        {
+            /* This is the number of attempts suggested by Chodera and Shirts
+             * for effectively independent sampling of the permutation. */
+            re->nex = re->nrepl * re->nrepl * re->nrepl;
+        }
+        fprintf(fplog,
+                "\nReplica exchange with Gibbs sampling: %d swap attempts between all pairs of "
+                "replicas per exchange\n",
+                re->nex);
+        please_cite(fplog, "Chodera2011");
+
+        snew(re->gibbsBuffer, re->nrepl * (re->nrepl + 2));
+        snew(re->reducedEnergy, re->nrepl * re->nrepl);
+        re->gibbsNumAttempts = 0;
+        re->gibbsNumAccepted = 0;
+    }
+
     return re;
 }
 
@@ -864,6 +900,118 @@ static real calc_delta(FILE* fplog, gmx_bool bPrint, struct gmx_repl_ex* re, int
     return delta;
 }
 
+/*! \brief Gathers the reduced energies of all configurations in all states
+ *
+ * All quantities are communicated with a single reduction over the
+ * simulations. The reduced energy of configuration k in state l is
+ * beta_l (U_l(x_k) + p_l V_k), where the energy of the configuration in its
+ * own state is only needed when the temperatures differ.
+ */
+static void gather_reduced_energies(const gmx_multisim_t* ms, struct gmx_repl_ex* re, const gmx_enerdata_t* enerd, real vol)
+{
+    const int nrepl = re->nrepl;
+    real*     Epot  = re->gibbsBuffer;
+    real*     Vol   = re->gibbsBuffer + nrepl;
+    real*     de    = re->gibbsBuffer + 2 * nrepl;
+    const bool bTemp =
+            (re->type == ReplicaExchangeType::Temperature || re->type == ReplicaExchangeType::TemperatureLambda);
+    const bool bLambda =
+            (re->type == ReplicaExchangeType::Lambda || re->type == ReplicaExchangeType::TemperatureLambda);
+
+    for (int i = 0; i < nrepl * (nrepl + 2); i++)
+    {
+        re->gibbsBuffer[i] = 0;
+    }
+    if (bTemp)
+    {
+        Epot[re->repl] = enerd->term[F_EPOT];
+    }
+    if (re->bNPT)
+    {
+        Vol[re->repl] = vol;
+    }
+    if (bLambda)
+    {
+        /* de[l*nrepl + k] is the energy of configuration k in state l
+           minus the energy of configuration k in state k */
+        for (int l = 0; l < nrepl; l++)
+        {
+            de[l * nrepl + re->repl] =
+                    enerd->foreignLambdaTerms.deltaH(re->q[ReplicaExchangeType::Lambda][l]);
+        }
+    }
+
+    gmx_sum_sim(nrepl * (nrepl + 2), re->gibbsBuffer, ms);
+
+    for (int l = 0; l < nrepl; l++)
+    {
+        re->beta[l] = 1.0
+                      / ((bTemp ? re->q[ReplicaExchangeType::Temperature][l] : re->temp) * gmx::c_boltz);
+    }
+    for (int k = 0; k < nrepl; k++)
+    {
+        for (int l = 0; l < nrepl; l++)
+        {
+            double u = static_cast<double>(Epot[k]) + de[l * nrepl + k];
+            if (re->bNPT)
+            {
+                u += re->pres[l] * static_cast<double>(Vol[k]) / gmx::c_presfac;
+            }
+            re->reducedEnergy[k * nrepl + l] = re->beta[l] * u;
+        }
+    }
+}
+
+/*! \brief Samples a new replica permutation with all-pairs Gibbs sampling
+ *
+ * Performs re->nex Metropolis swap attempts between randomly chosen,
+ * not necessarily neighboring, pairs of states using the reduced energy
+ * matrix, which costs O(1) per attempt. On return pind[l] is the replica
+ * whose configuration will be simulated in state l.
+ */
+static void sample_gibbs_permutation(struct gmx_repl_ex* re, int* pind, gmx::ThreeFry2x64<64>* rng)
+{
+    const int                          nrepl = re->nrepl;
+    const double*                      u     = re->reducedEnergy;
+    gmx::UniformRealDistribution<real> uniformRealDist;
+    gmx::UniformIntDistribution<int>   uniformFirstDist(0, nrepl - 1);
+    gmx::UniformIntDistribution<int>   uniformSecondDist(0, nrepl - 2);
+    int                                numAccepted = 0;
+
+    for (int n = 0; n < re->nex; n++)
+    {
+        uniformFirstDist.reset();
+        uniformSecondDist.reset();
+        /* Draw two distinct states directly, so no attempts are wasted on self-exchange */
+        const int i0 = uniformFirstDist(*rng);
+        int       i1 = uniformSecondDist(*rng);
+        if (i1 >= i0)
+        {
+            i1++;
+        }
+
+        const int    ka    = pind[i0];
+        const int    kb    = pind[i1];
+        const double delta = (u[kb * nrepl + i0] + u[ka * nrepl + i1])
+                             - (u[ka * nrepl + i0] + u[kb * nrepl + i1]);
+
+        bool bAccept = (delta <= 0);
+        if (!bAccept && delta <= c_probabilityCutoff)
+        {
+            uniformRealDist.reset();
+            bAccept = uniformRealDist(*rng) < std::exp(-delta);
+        }
+        if (bAccept)
+        {
+            pind[i0] = kb;
+            pind[i1] = ka;
+            numAccepted++;
+        }
+    }
+    re->gibbsNumAttempts += re->nex;
+    re->gibbsNumAccepted += numAccepted;
+}
+
 static void test_for_replica_exchange(FILE*                 fplog,
                                       const gmx_multisim_t* ms,
                                       struct gmx_repl_ex*   re,
@@ -888,6 +1036,28 @@ static void test_for_replica_exchange(FILE*                 fplog,
     bMultiEx = (re->nex > 1); /* multiple exchanges at each state */
     fprintf(fplog, "Replica exchange at step %" PRId64 " time %.5f\n", step, time);
 
+    if (re->bGibbs)
+    {
+        gather_reduced_energies(ms, re, enerd, vol);
+
+        for (i = 0; i < re->nrepl; i++)
+        {
+            pind[i] = re->ind[i];
+        }
+        rng.restart(step, 0);
+        sample_gibbs_permutation(re, pind, &rng);
+        re->nattempt[0]++;
+        print_allswitchind(fplog, re->nrepl, pind, re->allswaps, re->tmpswap);
+
+        for (i = 0; i < re->nrepl; i++)
+        {
+            re->nmoves[re->ind[i]][pind[i]] += 1;
+            re->nmoves[pind[i]][re->ind[i]] += 1;
+        }
+        fflush(fplog);
+        return;
+    }
+
     if (re->bNPT)
     {
         for (i = 0; i < re->nrepl; i++)
@@ -1358,6 +1528,14 @@ void print_replica_exchange_statistics(FILE* fplog, struct gmx_repl_ex* re)
 
     fprintf(fplog, "\nReplica exchange statistics\n");
 
+    if (re->bGibbs && re->gibbsNumAttempts > 0)
+    {
+        fprintf(fplog,
+                "Repl  Gibbs sampling: %" PRId64 " pair swap attempts, acceptance ratio %.4f\n",
+                re->gibbsNumAttempts,
+                static_cast<double>(re->gibbsNumAccepted) / re->gibbsNumAttempts);
+    }
+
     if (re->nex == 0)
     {
         fprintf(fplog,
@@ -64,6 +64,13 @@ struct ReplicaExchangeParameters
     int numExchanges = 0;
     //! The random seed, -1 means generate a seed.
     int randomSeed = -1;
+    /*! \brief Whether to sample the replica permutation by all-pairs Gibbs sampling.
+     *
+     * When true, the reduced energies of all configurations in all states are
+     * gathered once per exchange step and numExchanges (or, when zero, the number
+     * of replicas cubed) swap attempts between arbitrary pairs are performed on
+     * that matrix, which approximates independence sampling of the permutation. */
+    bool useGibbsSampling = false;
 };
 
 //! Abstract type for replica exchange
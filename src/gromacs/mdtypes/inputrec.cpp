@@ -863,6 +863,10 @@ void pr_inputrec(FILE* fp, int indent, const char* title, const t_inputrec* ir,
         PI("nstenergy", ir->nstenergy);
         PI("nstxout-compressed", ir->nstxout_compressed);
         PR("compressed-x-precision", ir->x_compression_precision);
+        PI("nstvout-compressed", ir->nstvout_compressed);
+        PI("nstfout-compressed", ir->nstfout_compressed);
+        PR("compressed-v-precision", ir->v_compression_precision);
+        PR("compressed-f-precision", ir->f_compression_precision);
 
         /* Neighborsearching parameters */
         PS("cutoff-scheme", enumValueToString(ir->cutoff_scheme));
@@ -1438,6 +1442,8 @@ void cmp_inputrec(FILE* fp, const t_inputrec* ir1, const t_inputrec* ir2, real f
     cmp_int(fp, "inputrec->nstcalcenergy", -1, ir1->nstcalcenergy, ir2->nstcalcenergy);
     cmp_int(fp, "inputrec->nstenergy", -1, ir1->nstenergy, ir2->nstenergy);
     cmp_int(fp, "inputrec->nstxout_compressed", -1, ir1->nstxout_compressed, ir2->nstxout_compressed);
+    cmp_int(fp, "inputrec->nstvout_compressed", -1, ir1->nstvout_compressed, ir2->nstvout_compressed);
+    cmp_int(fp, "inputrec->nstfout_compressed", -1, ir1->nstfout_compressed, ir2->nstfout_compressed);
     cmp_double(fp, "inputrec->init_t", -1, ir1->init_t, ir2->init_t, ftol, abstol);
     cmp_double(fp, "inputrec->delta_t", -1, ir1->delta_t, ir2->delta_t, ftol, abstol);
     cmp_real(fp,
@@ -1447,6 +1453,20 @@ void cmp_inputrec(FILE* fp, const t_inputrec* ir1, const t_inputrec* ir2, real f
              ir2->x_compression_precision,
              ftol,
              abstol);
+    cmp_real(fp,
+             "inputrec->v_compression_precision",
+             -1,
+             ir1->v_compression_precision,
+             ir2->v_compression_precision,
+             ftol,
+             abstol);
+    cmp_real(fp,
+             "inputrec->f_compression_precision",
+             -1,
+             ir1->f_compression_precision,
+             ir2->f_compression_precision,
+             ftol,
+             abstol);
     cmp_real(fp, "inputrec->fourierspacing", -1, ir1->fourier_spacing, ir2->fourier_spacing, ftol, abstol);
     cmp_int(fp, "inputrec->nkx", -1, ir1->nkx, ir2->nkx);
     cmp_int(fp, "inputrec->nky", -1, ir1->nky, ir2->nky);
@@ -70,6 +70,8 @@ struct CheckpointOptions
 {
     //! True means keep all checkpoint file and add the step number to the name
     gmx_bool keepAndNumberCheckpointFiles = FALSE;
+    //! True means every PP rank writes its home atom state to a separate shard file
+    gmx_bool writeStateShards = FALSE;
     //! The period in minutes for writing checkpoint files
     real period = 15;
 };
@@ -94,6 +96,8 @@ struct ImdOptions
     gmx_bool terminatable = FALSE;
     //! If true, allow COM pulling in the simulation from IMD client
     gmx_bool pull = FALSE;
+    //! If true, send frames from a separate thread and drop frames when the client is behind
+    gmx_bool asyncSend = FALSE;
 };
 
 //! \internal \brief Collection of all options of mdrun that are not processed separately
@@ -107,6 +111,8 @@ struct MdrunOptions
     gmx_bool reproducible = FALSE;
     //! Write confout.gro at the end of the run
     gmx_bool writeConfout = TRUE;
+    //! With DD, every PP rank writes its compressed coordinates to a separate XTC fragment file
+    gmx_bool writeXtcFragments = FALSE;
     //! User option for appending.
     AppendingBehavior appendingBehavior = AppendingBehavior::Auto;
     //! Options for checkpointing th simulation
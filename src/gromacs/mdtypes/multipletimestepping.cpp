@@ -188,6 +188,10 @@ std::vector<std::string> checkMtsRequirements(const t_inputrec& ir)
     {
         errorMessages.push_back(mesg.value());
     }
+    if ((mesg = checkMtsInterval(mtsLevels, "nstfout-compressed", ir.nstfout_compressed)))
+    {
+        errorMessages.push_back(mesg.value());
+    }
     if (ir.efep != FreeEnergyPerturbationType::No)
     {
         if ((mesg = checkMtsInterval(mtsLevels, "nstdhdl", ir.fepvals->nstdhdl)))
@@ -484,6 +484,12 @@ bool ModularSimulator::isInputCompatible(bool                             exitOn
             && conditionalAssert(!doMembed,
                                  "Membrane embedding is not supported by the modular simulator.");
 
+    isInputCompatible = isInputCompatible
+                        && conditionalAssert(inputrec->nstvout_compressed == 0
+                                                     && inputrec->nstfout_compressed == 0,
+                                             "Compressed velocity and force output is not "
+                                             "supported by the modular simulator.");
+
     isInputCompatible =
             isInputCompatible
             && conditionalAssert(
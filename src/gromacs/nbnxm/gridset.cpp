@@ -45,6 +45,10 @@
 
 #include "gridset.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/nbnxm/atomdata.h"
@@ -112,14 +116,93 @@ GridSet::GridSet(const PbcType             pbcType,
     changePinningPolicy(&gridSetData_.atomIndices, pinningPolicy);
 }
 
+int64_t hilbertCurveDistance(int numBits, int x, int y)
+{
+    const int n = 1 << numBits;
+
+    int64_t distance = 0;
+    for (int s = n / 2; s > 0; s /= 2)
+    {
+        const int rx = ((x & s) > 0) ? 1 : 0;
+        const int ry = ((y & s) > 0) ? 1 : 0;
+        distance += static_cast<int64_t>(s) * s * ((3 * rx) ^ ry);
+        /* Rotate the quadrant, so the curve is continuous */
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+
+    return distance;
+}
+
+void getHilbertCurveColumnOrder(int numColumnsX, int numColumnsY, std::vector<int>* columnOrder)
+{
+    int numBits = 0;
+    while ((1 << numBits) < std::max(numColumnsX, numColumnsY))
+    {
+        numBits++;
+    }
+
+    std::vector<std::pair<int64_t, int>> distanceAndColumn(numColumnsX * numColumnsY);
+    for (int cx = 0; cx < numColumnsX; cx++)
+    {
+        for (int cy = 0; cy < numColumnsY; cy++)
+        {
+            const int cxy          = cx * numColumnsY + cy;
+            distanceAndColumn[cxy] = { hilbertCurveDistance(numBits, cx, cy), cxy };
+        }
+    }
+    std::sort(distanceAndColumn.begin(), distanceAndColumn.end());
+
+    columnOrder->resize(distanceAndColumn.size());
+    for (size_t i = 0; i < distanceAndColumn.size(); i++)
+    {
+        (*columnOrder)[i] = distanceAndColumn[i].second;
+    }
+}
+
+gmx::ArrayRef<const int> GridSet::getLocalAtomorder() const
+{
+    if (useHilbertCurveAtomOrder_)
+    {
+        return localAtomOrder_;
+    }
+
+    /* Return the atom order for the home cell (index 0) */
+    const int numIndices = grids_[0].atomIndexEnd() - grids_[0].firstAtomInColumn(0);
+
+    return gmx::constArrayRefFromArray(atomIndices().data(), numIndices);
+}
+
+void GridSet::setHilbertCurveLocalAtomOrder()
+{
+    const Nbnxm::Grid& grid = grids_[0];
+
+    localAtomOrder_.clear();
+    for (int cxy : localColumnOrder_)
+    {
+        const auto columnBegin = gridSetData_.atomIndices.begin() + grid.firstAtomInColumn(cxy);
+        localAtomOrder_.insert(
+                localAtomOrder_.end(), columnBegin, columnBegin + grid.numAtomsInColumn(cxy));
+    }
+}
+
 void GridSet::setLocalAtomOrder()
 {
     /* Set the atom order for the home cell (index 0) */
     const Nbnxm::Grid& grid = grids_[0];
 
     int atomIndex = 0;
-    for (int cxy = 0; cxy < grid.numColumns(); cxy++)
+    for (int columnIndex = 0; columnIndex < grid.numColumns(); columnIndex++)
     {
+        const int cxy = useHilbertCurveAtomOrder_ ? localColumnOrder_[columnIndex] : columnIndex;
+
         const int numAtoms  = grid.numAtomsInColumn(cxy);
         int       cellIndex = grid.firstCellInColumn(cxy) * grid.geometry().numAtomsPerCell;
         for (int i = 0; i < numAtoms; i++)
@@ -130,6 +213,12 @@ void GridSet::setLocalAtomOrder()
             cellIndex++;
         }
     }
+
+    if (useHilbertCurveAtomOrder_)
+    {
+        /* The atom indices changed, the column order did not */
+        setHilbertCurveLocalAtomOrder();
+    }
 }
 
 static int getGridOffset(gmx::ArrayRef<const Grid> grids, int gridIndex)
@@ -235,6 +324,13 @@ void GridSet::putOnGrid(const matrix                   box,
     if (gridIndex == 0)
     {
         nbat->natoms_local = nbat->numAtoms();
+
+        if (useHilbertCurveAtomOrder_)
+        {
+            getHilbertCurveColumnOrder(
+                    grid.dimensions().numCells[XX], grid.dimensions().numCells[YY], &localColumnOrder_);
+            setHilbertCurveLocalAtomOrder();
+        }
     }
     if (gridIndex == gmx::ssize(grids_) - 1)
     {
@@ -47,6 +47,8 @@
 #ifndef GMX_NBNXM_GRIDSET_H
 #define GMX_NBNXM_GRIDSET_H
 
+#include <cstdint>
+
 #include <memory>
 #include <vector>
 
@@ -72,6 +74,26 @@ class UpdateGroupsCog;
 namespace Nbnxm
 {
 
+/*! \brief Returns the distance along a Hilbert curve of 2^numBits x 2^numBits points of point (x, y)
+ *
+ * Follows the classic iterative algorithm that rotates and reflects
+ * the quadrants going from the coarsest to the finest level.
+ */
+int64_t hilbertCurveDistance(int numBits, int x, int y);
+
+/*! \brief Returns the column indices of a grid in the order of traversal along a Hilbert curve
+ *
+ * The column index is cx * numColumnsY + cy. Columns that are close in
+ * space are then also close in the order, which improves the cache
+ * locality of the local atoms that are stored in this order for other
+ * algorithms than the non-bonded interactions.
+ *
+ * \param[in]  numColumnsX  The number of columns along x
+ * \param[in]  numColumnsY  The number of columns along y
+ * \param[out] columnOrder  The column indices in the order along the curve
+ */
+void getHilbertCurveColumnOrder(int numColumnsX, int numColumnsY, std::vector<int>* columnOrder);
+
 /*! \internal
  * \brief Holds a set of search grids for the local + non-local DD zones
  *
@@ -143,18 +165,26 @@ public:
     //! Returns the number of total real atoms, i.e. without padded atoms
     int numRealAtomsTotal() const { return numRealAtomsTotal_; }
 
-    //! Returns the atom order on the grid for the local atoms
-    gmx::ArrayRef<const int> getLocalAtomorder() const
-    {
-        /* Return the atom order for the home cell (index 0) */
-        const int numIndices = grids_[0].atomIndexEnd() - grids_[0].firstAtomInColumn(0);
-
-        return gmx::constArrayRefFromArray(atomIndices().data(), numIndices);
-    }
+    /*! \brief Returns the atom order on the grid for the local atoms
+     *
+     * Filler particles have index -1. With the Hilbert curve order,
+     * the grid columns are traversed along the curve.
+     */
+    gmx::ArrayRef<const int> getLocalAtomorder() const;
 
     //! Sets the order of the local atoms to the order grid atom ordering
     void setLocalAtomOrder();
 
+    /*! \brief Sets whether the local atom order traverses the grid columns along a Hilbert curve
+     *
+     * This should be set before putting the local atoms on the grid, as the
+     * column order is computed there.
+     */
+    void setUseHilbertCurveAtomOrder(bool useHilbertCurveAtomOrder)
+    {
+        useHilbertCurveAtomOrder_ = useHilbertCurveAtomOrder;
+    }
+
     //! Returns the list of grids
     gmx::ArrayRef<const Grid> grids() const { return grids_; }
 
@@ -177,6 +207,9 @@ public:
     void setNumColumnsMax(int numColumnsMax) { numColumnsMax_ = numColumnsMax; }
 
 private:
+    //! Sets the local atom order from the current atom indices and the column order along the Hilbert curve
+    void setHilbertCurveLocalAtomOrder();
+
     /* Data members */
     //! The domain setup
     DomainSetup domainSetup_;
@@ -196,6 +229,12 @@ private:
     std::vector<GridWork> gridWork_;
     //! Maximum number of columns across all grids
     int numColumnsMax_;
+    //! Whether the local atoms are ordered with the grid columns along a Hilbert curve
+    bool useHilbertCurveAtomOrder_ = false;
+    //! The order of the columns of the local grid along the Hilbert curve
+    std::vector<int> localColumnOrder_;
+    //! Buffer for the local atom order along the Hilbert curve
+    std::vector<int> localAtomOrder_;
 };
 
 } // namespace Nbnxm
@@ -124,12 +124,7 @@ bool nonbonded_verlet_t::isDynamicPruningStepGpu(int64_t step) const
 
 gmx::ArrayRef<const int> nonbonded_verlet_t::getLocalAtomOrder() const
 {
-    /* Return the atom order for the home cell (index 0) */
-    const Nbnxm::Grid& grid = pairSearch_->gridSet().grids()[0];
-
-    const int numIndices = grid.atomIndexEnd() - grid.firstAtomInColumn(0);
-
-    return gmx::constArrayRefFromArray(pairSearch_->gridSet().atomIndices().data(), numIndices);
+    return pairSearch_->getLocalAtomOrder();
 }
 
 void nonbonded_verlet_t::setLocalAtomOrder() const
@@ -137,6 +132,11 @@ void nonbonded_verlet_t::setLocalAtomOrder() const
     pairSearch_->setLocalAtomOrder();
 }
 
+void nonbonded_verlet_t::setUseHilbertCurveAtomOrder(bool useHilbertCurveAtomOrder) const
+{
+    pairSearch_->setUseHilbertCurveAtomOrder(useHilbertCurveAtomOrder);
+}
+
 void nonbonded_verlet_t::setAtomProperties(gmx::ArrayRef<const int>     atomTypes,
                                            gmx::ArrayRef<const real>    atomCharges,
                                            gmx::ArrayRef<const int64_t> atomInfo) const
@@ -319,6 +319,14 @@ public:
     //! Sets the order of the local atoms to the order grid atom ordering
     void setLocalAtomOrder() const;
 
+    /*! \brief Sets whether the local atom order traverses the grid columns along a Hilbert curve
+     *
+     * By default the columns are traversed in index order. Along a Hilbert
+     * curve atoms that are close in space are also closer in memory, which
+     * benefits the bonded interactions, constraints and update.
+     */
+    void setUseHilbertCurveAtomOrder(bool useHilbertCurveAtomOrder) const;
+
     //! Returns the index position of the atoms on the search grid
     gmx::ArrayRef<const int> getGridIndices() const;
 
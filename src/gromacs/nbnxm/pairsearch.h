@@ -227,9 +227,18 @@ public:
                int                       maxNumThreads,
                gmx::PinningPolicy        pinningPolicy);
 
+    //! Returns the order of the local atoms on the grid
+    gmx::ArrayRef<const int> getLocalAtomOrder() const { return gridSet_.getLocalAtomorder(); }
+
     //! Sets the order of the local atoms to the order grid atom ordering
     void setLocalAtomOrder() { gridSet_.setLocalAtomOrder(); }
 
+    //! Sets whether the local atom order traverses the grid columns along a Hilbert curve
+    void setUseHilbertCurveAtomOrder(bool useHilbertCurveAtomOrder)
+    {
+        gridSet_.setUseHilbertCurveAtomOrder(useHilbertCurveAtomOrder);
+    }
+
     //! Returns the set of search grids
     const Nbnxm::GridSet& gridSet() const { return gridSet_; }
 
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the Hilbert curve order of the grid columns
+ *
+ * \ingroup module_nbnxm
+ */
+#include "gmxpre.h"
+
+#include "gromacs/nbnxm/gridset.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+TEST(HilbertCurveTest, DistanceOnTwoByTwoGrid)
+{
+    EXPECT_EQ(0, Nbnxm::hilbertCurveDistance(1, 0, 0));
+    EXPECT_EQ(1, Nbnxm::hilbertCurveDistance(1, 0, 1));
+    EXPECT_EQ(2, Nbnxm::hilbertCurveDistance(1, 1, 1));
+    EXPECT_EQ(3, Nbnxm::hilbertCurveDistance(1, 1, 0));
+}
+
+TEST(HilbertCurveTest, CurveVisitsAllPointsWithUnitSteps)
+{
+    const int numBits = 3;
+    const int n       = 1 << numBits;
+
+    // The point at each distance along the curve
+    std::vector<int> pointX(n * n, -1);
+    std::vector<int> pointY(n * n, -1);
+    for (int x = 0; x < n; x++)
+    {
+        for (int y = 0; y < n; y++)
+        {
+            const int64_t distance = Nbnxm::hilbertCurveDistance(numBits, x, y);
+            ASSERT_GE(distance, 0);
+            ASSERT_LT(distance, n * n);
+            EXPECT_EQ(-1, pointX[distance]) << "distance " << distance << " is visited twice";
+            pointX[distance] = x;
+            pointY[distance] = y;
+        }
+    }
+
+    for (int i = 1; i < n * n; i++)
+    {
+        EXPECT_EQ(1, std::abs(pointX[i] - pointX[i - 1]) + std::abs(pointY[i] - pointY[i - 1]))
+                << "between distance " << i - 1 << " and " << i;
+    }
+}
+
+TEST(HilbertCurveTest, ColumnOrderOnSquareGridHasNeighboringColumns)
+{
+    const int        numColumnsX = 4;
+    const int        numColumnsY = 4;
+    std::vector<int> columnOrder;
+    Nbnxm::getHilbertCurveColumnOrder(numColumnsX, numColumnsY, &columnOrder);
+
+    ASSERT_EQ(numColumnsX * numColumnsY, columnOrder.size());
+    EXPECT_EQ(0, columnOrder[0]);
+    for (size_t i = 1; i < columnOrder.size(); i++)
+    {
+        const int dx = columnOrder[i] / numColumnsY - columnOrder[i - 1] / numColumnsY;
+        const int dy = columnOrder[i] % numColumnsY - columnOrder[i - 1] % numColumnsY;
+        EXPECT_EQ(1, std::abs(dx) + std::abs(dy)) << "between position " << i - 1 << " and " << i;
+    }
+}
+
+TEST(HilbertCurveTest, ColumnOrderOnRectangularGridIsPermutation)
+{
+    const int        numColumnsX = 3;
+    const int        numColumnsY = 5;
+    std::vector<int> columnOrder;
+    Nbnxm::getHilbertCurveColumnOrder(numColumnsX, numColumnsY, &columnOrder);
+
+    ASSERT_EQ(numColumnsX * numColumnsY, columnOrder.size());
+    std::vector<int> sortedColumns = columnOrder;
+    std::sort(sortedColumns.begin(), sortedColumns.end());
+    std::vector<int> allColumns(numColumnsX * numColumnsY);
+    std::iota(allColumns.begin(), allColumns.end(), 0);
+    EXPECT_EQ(allColumns, sortedColumns);
+
+    // The columns are ordered along the curve for the enclosing 8x8 grid
+    for (size_t i = 1; i < columnOrder.size(); i++)
+    {
+        EXPECT_LT(Nbnxm::hilbertCurveDistance(
+                          3, columnOrder[i - 1] / numColumnsY, columnOrder[i - 1] % numColumnsY),
+                  Nbnxm::hilbertCurveDistance(3, columnOrder[i] / numColumnsY, columnOrder[i] % numColumnsY));
+    }
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
@@ -2416,6 +2416,7 @@ struct pull_t* init_pull(FILE*                     fplog,
 
     comm->pbcAtomBuffer.resize(pull->group.size());
     comm->comBuffer.resize(pull->group.size() * c_comBufferStride);
+    comm->packedComBuffer.reserve(pull->group.size() * c_comBufferStride * DIM);
     if (pull->bCylinder)
     {
         comm->cylinderBuffer.resize(pull->coord.size() * c_cylinderBufferStride);
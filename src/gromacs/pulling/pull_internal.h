@@ -241,6 +241,7 @@ struct pull_comm_t
     std::vector<gmx::RVec>                pbcAtomBuffer; /* COM calculation buffer */
     std::vector<gmx::BasicVector<double>> comBuffer;     /* COM calculation buffer */
     std::vector<double> cylinderBuffer; /* cylinder ref. groups calculation buffer */
+    std::vector<double> packedComBuffer; /* Packed sums of active groups for a single reduction */
 };
 
 // The COM pull force calculation data structure
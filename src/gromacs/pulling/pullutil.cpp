@@ -38,6 +38,8 @@
 #include <cassert>
 #include <cstdlib>
 
+#include <vector>
+
 #include "gromacs/fileio/confio.h"
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/math/functions.h"
@@ -115,6 +117,85 @@ static void pullAllReduce(const t_commrec* cr, pull_comm_t* comm, int n, T* data
     }
 }
 
+/*! \brief Calls \p func for each COM buffer element that is used by the groups selected by \p includeGroup
+ *
+ * Group buffers have c_comBufferStride*DIM elements, but only 5 of these
+ * are used without xp and 7 or 8 with xp. The elements are always visited
+ * in the same order, so this can be used for packing and unpacking.
+ */
+template<typename GroupSelector, typename Func>
+static void forEachUsedComBufferElement(pull_t* pull, bool haveXp, GroupSelector includeGroup, Func func)
+{
+    for (size_t g = 0; g < pull->group.size(); g++)
+    {
+        if (!includeGroup(g))
+        {
+            continue;
+        }
+
+        auto comBuffer = gmx::arrayRefFromArray(pull->comm.comBuffer.data() + g * c_comBufferStride,
+                                                c_comBufferStride);
+        if (pull->group[g].epgrppbc == epgrppbcCOS)
+        {
+            func(comBuffer[0][0]);
+            func(comBuffer[0][1]);
+            for (int d = 0; d < DIM; d++)
+            {
+                func(comBuffer[1][d]);
+            }
+            if (haveXp)
+            {
+                func(comBuffer[2][0]);
+                func(comBuffer[2][1]);
+            }
+        }
+        else
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                func(comBuffer[0][d]);
+            }
+            func(comBuffer[2][0]);
+            func(comBuffer[2][1]);
+            if (haveXp)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    func(comBuffer[1][d]);
+                }
+            }
+        }
+    }
+}
+
+/*! \brief Reduces the COM sums of the groups selected by \p includeGroup over the ranks
+ *
+ * Only the used sums of the selected groups are packed into a contiguous
+ * buffer, so all groups are reduced with a single, compact reduction.
+ * This matters with many pull coordinates and groups.
+ */
+template<typename GroupSelector>
+static void pullAllReduceComSums(const t_commrec* cr, pull_t* pull, bool haveXp, GroupSelector includeGroup)
+{
+    if (cr == nullptr || !PAR(cr))
+    {
+        return;
+    }
+
+    std::vector<double>& packedBuffer = pull->comm.packedComBuffer;
+    packedBuffer.clear();
+    forEachUsedComBufferElement(
+            pull, haveXp, includeGroup, [&packedBuffer](const double& value) { packedBuffer.push_back(value); });
+
+    pullAllReduce(cr, &pull->comm, gmx::ssize(packedBuffer), packedBuffer.data());
+
+    size_t index = 0;
+    forEachUsedComBufferElement(
+            pull, haveXp, includeGroup, [&packedBuffer, &index](double& value) {
+                value = packedBuffer[index++];
+            });
+}
+
 /* Copies the coordinates of the PBC atom of pgrp to x_pbc.
  * When those coordinates are not available on this rank, clears x_pbc.
  */
@@ -180,7 +261,8 @@ static void make_cyl_refgrps(const t_commrec*     cr,
 
     double inv_cyl_r2 = 1.0 / gmx::square(pull->params.cylinder_r);
 
-    /* loop over all groups to make a reference group for each*/
+    /* loop over all groups to make a reference group for each,
+     * only cylinder coordinates are packed into the reduction buffer */
     int bufferOffset = 0;
     for (pull_coord_work_t& pcrd : pull->coord)
     {
@@ -281,29 +363,29 @@ static void make_cyl_refgrps(const t_commrec*     cr,
                     pdyna.localWeights[indexInSet] = 0;
                 }
             }
-        }
 
-        auto buffer = gmx::arrayRefFromArray(comm->cylinderBuffer.data() + bufferOffset,
-                                             c_cylinderBufferStride);
-        bufferOffset += c_cylinderBufferStride;
+            auto buffer = gmx::arrayRefFromArray(comm->cylinderBuffer.data() + bufferOffset,
+                                                 c_cylinderBufferStride);
+            bufferOffset += c_cylinderBufferStride;
 
-        buffer[0] = wmass;
-        buffer[1] = wwmass;
-        buffer[2] = sum_a;
+            buffer[0] = wmass;
+            buffer[1] = wwmass;
+            buffer[2] = sum_a;
 
-        buffer[3] = radf_fac0[XX];
-        buffer[4] = radf_fac0[YY];
-        buffer[5] = radf_fac0[ZZ];
+            buffer[3] = radf_fac0[XX];
+            buffer[4] = radf_fac0[YY];
+            buffer[5] = radf_fac0[ZZ];
 
-        buffer[6] = radf_fac1[XX];
-        buffer[7] = radf_fac1[YY];
-        buffer[8] = radf_fac1[ZZ];
+            buffer[6] = radf_fac1[XX];
+            buffer[7] = radf_fac1[YY];
+            buffer[8] = radf_fac1[ZZ];
+        }
     }
 
     if (cr != nullptr && PAR(cr))
     {
         /* Sum the contributions over the ranks */
-        pullAllReduce(cr, comm, pull->coord.size() * c_cylinderBufferStride, comm->cylinderBuffer.data());
+        pullAllReduce(cr, comm, bufferOffset, comm->cylinderBuffer.data());
     }
 
     bufferOffset = 0;
@@ -364,74 +446,80 @@ static double atan2_0_2pi(double y, double x)
     return a;
 }
 
-static void sum_com_part(const pull_group_work_t* pgrp,
-                         int                      ind_start,
-                         int                      ind_end,
-                         ArrayRef<const RVec>     x,
-                         ArrayRef<const RVec>     xp,
-                         ArrayRef<const real>     mass,
-                         const t_pbc&             pbc,
-                         const rvec               x_pbc,
-                         ComSums*                 sum_com)
+/*! \brief Sums the weighted coordinates of local atoms ind_start to ind_end of a group
+ *
+ * The kernel is templated on the properties that are constant over a group,
+ * so the inner loop is free of branches and can be vectorized by the compiler.
+ * The order of summation is the same for all instantiations.
+ */
+template<bool haveWeights, bool usePbcReference, bool haveXp>
+static void sum_com_part_kernel(const pull_group_work_t* pgrp,
+                                int                      ind_start,
+                                int                      ind_end,
+                                ArrayRef<const RVec>     x,
+                                ArrayRef<const RVec>     xp,
+                                ArrayRef<const real>     mass,
+                                const t_pbc&             pbc,
+                                const rvec               x_pbc,
+                                ComSums*                 sum_com)
 {
     double sum_wm   = 0;
     double sum_wwm  = 0;
     dvec   sum_wmx  = { 0, 0, 0 };
     dvec   sum_wmxp = { 0, 0, 0 };
 
-    auto localAtomIndices = pgrp->atomSet_.localIndex();
+    const int* gmx_restrict  localAtomIndices = pgrp->atomSet_.localIndex().data();
+    const real* gmx_restrict localWeights     = pgrp->localWeights.data();
     for (int i = ind_start; i < ind_end; i++)
     {
-        int  ii = localAtomIndices[i];
-        real wm;
-        if (pgrp->localWeights.empty())
+        const int ii = localAtomIndices[i];
+        real      wm;
+        if constexpr (haveWeights)
         {
-            wm = mass[ii];
+            const real w = localWeights[i];
+            wm           = w * mass[ii];
             sum_wm += wm;
+            sum_wwm += wm * w;
         }
         else
         {
-            real w;
-
-            w  = pgrp->localWeights[i];
-            wm = w * mass[ii];
+            wm = mass[ii];
             sum_wm += wm;
-            sum_wwm += wm * w;
         }
-        if (pgrp->epgrppbc == epgrppbcNONE)
+        if constexpr (usePbcReference)
         {
-            /* Plain COM: sum the coordinates */
+            rvec dx;
+
+            /* Sum the difference with the reference atom */
+            pbc_dx(&pbc, x[ii], x_pbc, dx);
             for (int d = 0; d < DIM; d++)
             {
-                sum_wmx[d] += wm * x[ii][d];
+                sum_wmx[d] += wm * dx[d];
             }
-            if (!xp.empty())
+            if constexpr (haveXp)
             {
+                /* For xp add the difference between xp and x to dx,
+                 * such that we use the same periodic image,
+                 * also when xp has a large displacement.
+                 */
                 for (int d = 0; d < DIM; d++)
                 {
-                    sum_wmxp[d] += wm * xp[ii][d];
+                    sum_wmxp[d] += wm * (dx[d] + xp[ii][d] - x[ii][d]);
                 }
             }
         }
         else
         {
-            rvec dx;
-
-            /* Sum the difference with the reference atom */
-            pbc_dx(&pbc, x[ii], x_pbc, dx);
+            /* Plain COM: sum the coordinates */
             for (int d = 0; d < DIM; d++)
             {
-                sum_wmx[d] += wm * dx[d];
+                sum_wmx[d] += wm * x[ii][d];
             }
-            if (!xp.empty())
+            if constexpr (haveXp)
             {
-                /* For xp add the difference between xp and x to dx,
-                 * such that we use the same periodic image,
-                 * also when xp has a large displacement.
-                 */
                 for (int d = 0; d < DIM; d++)
                 {
-                    sum_wmxp[d] += wm * (dx[d] + xp[ii][d] - x[ii][d]);
+                    sum_wmxp[d] += wm * xp[ii][d];
                 }
             }
         }
@@ -440,12 +528,73 @@ static void sum_com_part(const pull_group_work_t* pgrp,
     sum_com->sum_wm  = sum_wm;
     sum_com->sum_wwm = sum_wwm;
     copy_dvec(sum_wmx, sum_com->sum_wmx);
-    if (!xp.empty())
+    if (haveXp)
     {
         copy_dvec(sum_wmxp, sum_com->sum_wmxp);
     }
 }
 
+//! Helper for dispatching to sum_com_part_kernel() with the last template parameter
+template<bool haveWeights, bool usePbcReference>
+static void sum_com_part_dispatch(const pull_group_work_t* pgrp,
+                                  int                      ind_start,
+                                  int                      ind_end,
+                                  ArrayRef<const RVec>     x,
+                                  ArrayRef<const RVec>     xp,
+                                  ArrayRef<const real>     mass,
+                                  const t_pbc&             pbc,
+                                  const rvec               x_pbc,
+                                  ComSums*                 sum_com)
+{
+    if (xp.empty())
+    {
+        sum_com_part_kernel<haveWeights, usePbcReference, false>(
+                pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+    }
+    else
+    {
+        sum_com_part_kernel<haveWeights, usePbcReference, true>(
+                pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+    }
+}
+
+static void sum_com_part(const pull_group_work_t* pgrp,
+                         int                      ind_start,
+                         int                      ind_end,
+                         ArrayRef<const RVec>     x,
+                         ArrayRef<const RVec>     xp,
+                         ArrayRef<const real>     mass,
+                         const t_pbc&             pbc,
+                         const rvec               x_pbc,
+                         ComSums*                 sum_com)
+{
+    const bool haveWeights     = !pgrp->localWeights.empty();
+    const bool usePbcReference = (pgrp->epgrppbc != epgrppbcNONE);
+
+    if (haveWeights)
+    {
+        if (usePbcReference)
+        {
+            sum_com_part_dispatch<true, true>(pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+        }
+        else
+        {
+            sum_com_part_dispatch<true, false>(pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+        }
+    }
+    else
+    {
+        if (usePbcReference)
+        {
+            sum_com_part_dispatch<false, true>(pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+        }
+        else
+        {
+            sum_com_part_dispatch<false, false>(pgrp, ind_start, ind_end, x, xp, mass, pbc, x_pbc, sum_com);
+        }
+    }
+}
+
 static void sum_com_part_cosweight(const pull_group_work_t* pgrp,
                                    int                      ind_start,
                                    int                      ind_end,
@@ -697,10 +846,8 @@ void pull_calc_coms(const t_commrec*     cr,
         }
     }
 
-    pullAllReduce(cr,
-                  comm,
-                  pull->group.size() * c_comBufferStride * DIM,
-                  static_cast<double*>(comm->comBuffer[0]));
+    pullAllReduceComSums(
+            cr, pull, !xp.empty(), [pull](size_t g) { return pull->group[g].needToCalcCom; });
 
     for (size_t g = 0; g < pull->group.size(); g++)
     {
@@ -1146,7 +1293,9 @@ void initPullComFromPrevStep(const t_commrec*     cr,
         }
     }
 
-    pullAllReduce(cr, comm, ngroup * c_comBufferStride * DIM, static_cast<double*>(comm->comBuffer[0]));
+    pullAllReduceComSums(cr, pull, false, [pull](size_t g) {
+        return pull->group[g].needToCalcCom && pull->group[g].epgrppbc == epgrppbcPREVSTEPCOM;
+    });
 
     for (size_t g = 0; g < ngroup; g++)
     {
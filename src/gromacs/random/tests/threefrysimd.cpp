@@ -0,0 +1,216 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the vectorized ThreeFry4x32 random engine
+ *
+ * \ingroup module_random
+ */
+#include "gmxpre.h"
+
+#include "gromacs/random/threefrysimd.h"
+
+#include <cmath>
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Lanes and key for one known answer test, values from the Random123 distribution
+struct ThreeFry4x32KnownAnswer
+{
+    //! The four key words
+    std::array<uint32_t, 4> key;
+    //! The four counter words
+    std::array<uint32_t, 4> counter;
+    //! The expected result
+    std::array<uint32_t, 4> result;
+};
+
+class ThreeFry4x32SimdTest : public ::testing::TestWithParam<ThreeFry4x32KnownAnswer>
+{
+};
+
+TEST_P(ThreeFry4x32SimdTest, KnownAnswer)
+{
+    const ThreeFry4x32KnownAnswer& input = GetParam();
+
+    // Use several lanes to check that all lanes give the same result
+    constexpr int                    c_width = 4;
+    ThreeFry4x32Simd<c_width>        rng(input.key);
+    ThreeFry4x32Simd<c_width>::Block counter;
+    for (int i = 0; i < 4; i++)
+    {
+        counter[i].fill(input.counter[i]);
+    }
+
+    const ThreeFry4x32Simd<c_width>::Block result = rng.generateBlock(counter);
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int l = 0; l < c_width; l++)
+        {
+            EXPECT_EQ(result[i][l], input.result[i]) << "word " << i << " lane " << l;
+        }
+    }
+}
+
+//! Known answers for all bits zero, all bits one and the bits of pi
+const ThreeFry4x32KnownAnswer knownAnswers[] = {
+    { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0x9c6ca96a, 0xe17eae66, 0xfc10ecd4, 0x5256a7d8 } },
+    { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+      { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+      { 0x2a881696, 0x57012287, 0xf6c7446e, 0xa16a6732 } },
+    { { 0xa4093822, 0x299f31d0, 0x082efa98, 0xec4e6c89 },
+      { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+      { 0x59cd1dbb, 0xb8879579, 0x86b5d00c, 0xac8b6d84 } }
+};
+
+INSTANTIATE_TEST_SUITE_P(KnownAnswersTest, ThreeFry4x32SimdTest, ::testing::ValuesIn(knownAnswers));
+
+TEST(ThreeFry4x32SimdLanesTest, LanesAreIndependent)
+{
+    const ThreeFry4x32Simd<8> rngWide(123456, RandomDomain::UpdateCoordinates);
+    const ThreeFry4x32Simd<1> rngNarrow(123456, RandomDomain::UpdateCoordinates);
+
+    const uint64_t     step = 0x100000007ULL;
+    std::array<int, 8> index{ { 3, 1, 4, 1, 5, 9, 2, 6 } };
+
+    const ThreeFry4x32Simd<8>::Block resultWide = rngWide.generateBlock(step, index);
+
+    for (int l = 0; l < 8; l++)
+    {
+        const ThreeFry4x32Simd<1>::Block resultNarrow =
+                rngNarrow.generateBlock(step, std::array<int, 1>{ { index[l] } });
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT_EQ(resultWide[i][l], resultNarrow[i][0]) << "word " << i << " lane " << l;
+        }
+    }
+    // Equal counters should give equal numbers, different counters different ones
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(resultWide[i][1], resultWide[i][3]);
+        EXPECT_NE(resultWide[i][0], resultWide[i][1]);
+    }
+}
+
+TEST(ThreeFry4x32SimdLanesTest, DomainAndStepChangeOutput)
+{
+    const ThreeFry4x32Simd<1> rngA(123456, RandomDomain::UpdateCoordinates);
+    const ThreeFry4x32Simd<1> rngB(123456, RandomDomain::Thermostat);
+    const std::array<int, 1>  index{ { 42 } };
+
+    EXPECT_NE(rngA.generateBlock(10, index)[0][0], rngB.generateBlock(10, index)[0][0]);
+    EXPECT_NE(rngA.generateBlock(10, index)[0][0], rngA.generateBlock(11, index)[0][0]);
+    // Steps that only differ in the high 32 bits
+    EXPECT_NE(rngA.generateBlock(10, index)[0][0],
+              rngA.generateBlock(10 + (uint64_t(1) << 32), index)[0][0]);
+}
+
+TEST(ThreeFry4x32SimdNormalTest, HasUnitVariance)
+{
+    const ThreeFry4x32Simd<1> rng(123456, RandomDomain::Other);
+
+    const int numSamples = 100000;
+    double    sum        = 0;
+    double    sumSquares = 0;
+    for (int i = 0; i < numSamples / 4; i++)
+    {
+        std::array<real, 4> n;
+        normalsFromRandomBits(rng.generateBlock(0, std::array<int, 1>{ { i } }), &n[0], &n[1], &n[2], &n[3]);
+        for (const real value : n)
+        {
+            sum += value;
+            sumSquares += value * value;
+        }
+    }
+
+    // The expected error is 1/sqrt(numSamples) for the mean and
+    // sqrt(2/numSamples) for the variance, allow 4 times this
+    const double mean     = sum / numSamples;
+    const double variance = sumSquares / numSamples - mean * mean;
+    EXPECT_NEAR(0.0, mean, 4 / std::sqrt(numSamples));
+    EXPECT_NEAR(1.0, variance, 4 * std::sqrt(2.0 / numSamples));
+}
+
+#if GMX_SIMD_HAVE_REAL
+TEST(ThreeFry4x32SimdNormalTest, SimdMatchesScalar)
+{
+    const ThreeFry4x32Simd<GMX_SIMD_REAL_WIDTH> rngSimd(123456, RandomDomain::Other);
+    const ThreeFry4x32Simd<1>                   rngScalar(123456, RandomDomain::Other);
+
+    std::array<int, GMX_SIMD_REAL_WIDTH> index;
+    for (int l = 0; l < GMX_SIMD_REAL_WIDTH; l++)
+    {
+        index[l] = 1000 + 7 * l;
+    }
+
+    std::array<SimdReal, 4> normalSimd;
+    normalsFromRandomBits(rngSimd.generateBlock(5, index),
+                          &normalSimd[0],
+                          &normalSimd[1],
+                          &normalSimd[2],
+                          &normalSimd[3]);
+
+    // The SIMD math functions differ by a few ulp from the standard library
+    const auto tolerance = gmx::test::relativeToleranceAsFloatingPoint(1.0, 1e-5);
+    for (int i = 0; i < 4; i++)
+    {
+        alignas(GMX_SIMD_ALIGNMENT) real normal[GMX_SIMD_REAL_WIDTH];
+        store(normal, normalSimd[i]);
+        for (int l = 0; l < GMX_SIMD_REAL_WIDTH; l++)
+        {
+            std::array<real, 4> normalScalar;
+            normalsFromRandomBits(rngScalar.generateBlock(5, std::array<int, 1>{ { index[l] } }),
+                                  &normalScalar[0],
+                                  &normalScalar[1],
+                                  &normalScalar[2],
+                                  &normalScalar[3]);
+            EXPECT_REAL_EQ_TOL(normalScalar[i], normal[l], tolerance) << "value " << i << " lane " << l;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+} // namespace gmx
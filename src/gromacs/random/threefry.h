@@ -91,6 +91,12 @@
  * table gives us 16,384 unique values, but this has been thoroughly tested to
  * be sufficient for all integration usage.
  *
+ * <H3>Random numbers for many atoms at once</H3>
+ *
+ * Integrators that need a few normally distributed numbers for every atom
+ * can use gmx::ThreeFry4x32Simd, which encrypts the counters of all atoms
+ * in a SIMD register at once, together with gmx::normalsFromRandomBits().
+ *
  * \author Erik Lindahl <erik.lindahl@gmail.com>
  */
 /*! \file
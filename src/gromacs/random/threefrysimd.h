@@ -0,0 +1,248 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+
+/*! \file
+ * \brief Implementation of a ThreeFry4x32 random engine that evaluates several counters at once
+ *
+ * \inpublicapi
+ * \ingroup module_random
+ */
+
+#ifndef GMX_RANDOM_THREEFRYSIMD_H
+#define GMX_RANDOM_THREEFRYSIMD_H
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "gromacs/random/seed.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \brief ThreeFry4x32 counter-based random engine for multiple counters
+ *
+ *  This engine encrypts \p width independent 4x32-bit counters with
+ *  20 rounds of ThreeFry4x32, as described by Salmon et al. (SC11,
+ *  2011). It is meant for integrators that need a few random numbers
+ *  per atom for many atoms at once. By using the global atom index as
+ *  one of the counter words, each atom gets random numbers that only
+ *  depend on the key and the counter, and thus not on the parallelization
+ *  or on the position of the atom in the SIMD register.
+ *
+ *  The GROMACS SIMD layer does not provide integer shifts, so the rounds
+ *  operate on arrays of \p width 32-bit words, which compilers vectorize.
+ *  Use normalsFromRandomBits() to turn the output into SIMD registers
+ *  with normally distributed values.
+ *
+ *  \tparam width  The number of counters encrypted at once.
+ */
+template<int width>
+class ThreeFry4x32Simd
+{
+public:
+    //! One 32-bit word for each of the \p width counters
+    typedef std::array<uint32_t, width> Lanes;
+    //! The four words of the \p width counters
+    typedef std::array<Lanes, 4> Block;
+
+    /*! \brief Construct random engine with a 64-bit seed and a random domain
+     *
+     *  \param key0   Random seed, 64-bit.
+     *  \param domain Random domain, used to get different streams for
+     *                different applications of the engine.
+     */
+    ThreeFry4x32Simd(uint64_t key0 = 0, RandomDomain domain = RandomDomain::Other) :
+        ThreeFry4x32Simd(std::array<uint32_t, 4>{ { static_cast<uint32_t>(key0),
+                                                    static_cast<uint32_t>(key0 >> 32),
+                                                    static_cast<uint32_t>(domain),
+                                                    0 } })
+    {
+    }
+
+    /*! \brief Construct random engine from the four raw 32-bit key words
+     *
+     *  This is meant for the case when you want full control over the key,
+     *  for instance to compare with reference values of the ThreeFry
+     *  function during testing.
+     */
+    explicit ThreeFry4x32Simd(const std::array<uint32_t, 4>& key)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            keySchedule_[i] = key[i];
+        }
+        keySchedule_[4] = 0x1bd11bda ^ key[0] ^ key[1] ^ key[2] ^ key[3];
+    }
+
+    /*! \brief Returns the encrypted counters
+     *
+     *  \param counter  The four counter words for each of the \p width lanes
+     */
+    Block generateBlock(const Block& counter) const
+    {
+        Block x;
+        for (int i = 0; i < 4; i++)
+        {
+            for (int l = 0; l < width; l++)
+            {
+                x[i][l] = counter[i][l] + keySchedule_[i];
+            }
+        }
+
+        // Five groups of four rounds, each followed by a key injection
+        constexpr int c_rotations[8][2] = { { 10, 26 }, { 11, 21 }, { 13, 27 }, { 23, 5 },
+                                            { 6, 20 },  { 17, 11 }, { 25, 10 }, { 18, 20 } };
+        for (int injection = 1; injection <= 5; injection++)
+        {
+            const int(*rotations)[2] = c_rotations + ((injection - 1) % 2) * 4;
+
+            mix(&x[0], &x[1], &x[2], &x[3], rotations[0]);
+            mix(&x[0], &x[3], &x[2], &x[1], rotations[1]);
+            mix(&x[0], &x[1], &x[2], &x[3], rotations[2]);
+            mix(&x[0], &x[3], &x[2], &x[1], rotations[3]);
+
+            for (int i = 0; i < 4; i++)
+            {
+                const uint32_t key = keySchedule_[(injection + i) % 5] + (i == 3 ? injection : 0);
+                for (int l = 0; l < width; l++)
+                {
+                    x[i][l] += key;
+                }
+            }
+        }
+
+        return x;
+    }
+
+    /*! \brief Returns the encrypted counters { index[lane], low and high word of \p ctr, 0 }
+     *
+     *  \param ctr    Counter value shared by all lanes, e.g. the step
+     *  \param index  Counter values per lane, e.g. global atom indices
+     */
+    Block generateBlock(uint64_t ctr, const std::array<int, width>& index) const
+    {
+        Block counter;
+        for (int l = 0; l < width; l++)
+        {
+            counter[0][l] = static_cast<uint32_t>(index[l]);
+            counter[1][l] = static_cast<uint32_t>(ctr);
+            counter[2][l] = static_cast<uint32_t>(ctr >> 32);
+            counter[3][l] = 0;
+        }
+
+        return generateBlock(counter);
+    }
+
+private:
+    //! Performs one ThreeFry round on the two word pairs (a,b) and (c,d)
+    static void mix(Lanes* a, Lanes* b, Lanes* c, Lanes* d, const int rotation[2])
+    {
+        for (int l = 0; l < width; l++)
+        {
+            (*a)[l] += (*b)[l];
+            (*b)[l] = rotateLeft((*b)[l], rotation[0]) ^ (*a)[l];
+            (*c)[l] += (*d)[l];
+            (*d)[l] = rotateLeft((*d)[l], rotation[1]) ^ (*c)[l];
+        }
+    }
+
+    //! Rotates \p i left by \p bits
+    static uint32_t rotateLeft(uint32_t i, int bits) { return (i << bits) | (i >> (32 - bits)); }
+
+    //! The four key words and their parity word
+    std::array<uint32_t, 5> keySchedule_;
+};
+
+/*! \brief Converts random bits to four normally distributed values per lane
+ *
+ *  Uses the Box-Muller transform on uniform values that use as many bits
+ *  of each word as the mantissa of \p real can hold, up to 32. This
+ *  limits the values to about 5.8 standard deviations in single and
+ *  6.8 in double precision.
+ *
+ *  \tparam    RealType  SIMD or scalar real type with \p width elements
+ *  \tparam    width     The number of lanes
+ *  \param[in] bits      Random bits, typically from ThreeFry4x32Simd
+ *  \param[out] n0       The first normally distributed values
+ *  \param[out] n1       The second normally distributed values
+ *  \param[out] n2       The third normally distributed values
+ *  \param[out] n3       The fourth normally distributed values
+ */
+template<typename RealType, std::size_t width>
+static inline void normalsFromRandomBits(const std::array<std::array<uint32_t, width>, 4>& bits,
+                                         RealType*                                        n0,
+                                         RealType*                                        n1,
+                                         RealType*                                        n2,
+                                         RealType*                                        n3)
+{
+    // We take the uniform values as the centers of 2^numBits bins in (0,1).
+    // This avoids 0 as argument for the logarithm and is exact in real.
+    constexpr int  c_numBits = std::min(std::numeric_limits<real>::digits - 1, 32);
+    constexpr real c_scale   = 1.0 / (static_cast<double>(uint64_t(1) << c_numBits) * 2);
+
+    alignas(GMX_SIMD_ALIGNMENT) real uniform[4][width];
+    for (int i = 0; i < 4; i++)
+    {
+        for (std::size_t l = 0; l < width; l++)
+        {
+            uniform[i][l] = (static_cast<real>(bits[i][l] >> (32 - c_numBits)) * 2 + 1) * c_scale;
+        }
+    }
+
+    const RealType minusTwo(-2.0_real);
+    const RealType twoPi(2.0_real * M_PI);
+
+    RealType radius, sinValue, cosValue;
+
+    radius = sqrt(minusTwo * log(load<RealType>(uniform[0])));
+    sincos(twoPi * load<RealType>(uniform[1]), &sinValue, &cosValue);
+    *n0 = radius * cosValue;
+    *n1 = radius * sinValue;
+
+    radius = sqrt(minusTwo * log(load<RealType>(uniform[2])));
+    sincos(twoPi * load<RealType>(uniform[3]), &sinValue, &cosValue);
+    *n2 = radius * cosValue;
+    *n3 = radius * sinValue;
+}
+
+} // namespace gmx
+
+#endif // GMX_RANDOM_THREEFRYSIMD_H
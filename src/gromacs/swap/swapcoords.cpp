@@ -46,6 +46,7 @@
 #include <cstdlib>
 #include <ctime>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -58,6 +59,7 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/groupcoord.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -158,6 +160,10 @@ typedef struct swap_compartment
                           normally the center layer of the compartment  */
     int nalloc;      /**< Allocation size for ind array.                */
     int inflow_net;  /**< Net inflow of ions into this compartment.     */
+    std::vector<int> swapCandidates; /**< Binary min-heap on dist of the indices in
+                                          ind that can still be swapped this step  */
+    bool swapCandidatesValid;        /**< Whether swapCandidates has been built
+                                          for the current lists                    */
 } t_compartment;
 
 
@@ -195,6 +201,10 @@ typedef struct swap_group
     gmx::EnumerationArray<Channel, int>      fluxfromAtoB; /**< Net flux of ions per channel */
     gmx::EnumerationArray<Channel, int> nCyl; /**< Number of ions residing in a channel         */
     int nCylBoth = 0; /**< Ions assigned to cyl0 and cyl1. Not good.             */
+    std::vector<int>  molInCompartment; /**< Work array: whether each molecule is in the
+                                             compartment under consideration (size nMol) */
+    std::vector<real> molDistance; /**< Work array: distance of each molecule to the
+                                        bulk layer of that compartment (size nMol) */
 } t_swapgrp;
 
 t_swapgrp::swap_group(const gmx::LocalAtomSet& atomset) : atomSet{ atomset }
@@ -719,30 +729,47 @@ static void sortMoleculesIntoCompartments(t_swapgrp*          g,
     /* Get us a counter that cycles in the range of [0 ... sc->nAverage[ */
     int replace = (step / sc->nstswap) % sc->nAverage;
 
+    const int numMolecules = static_cast<int>(g->atomSet.numAtomsGlobal() / g->apm);
+    g->molInCompartment.resize(numMolecules);
+    g->molDistance.resize(numMolecules);
+    const int numThreads = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+
     for (auto comp : gmx::EnumerationWrapper<Compartment>{})
     {
         real left, right;
+        int  sd = s->swapdim;
 
         /* Get lists of atoms that match criteria for this compartment */
         get_compartment_boundaries(comp, s, box, &left, &right);
 
         /* First clear the ion molecule lists */
-        g->comp[comp].nMol  = 0;
-        nMolNotInComp[comp] = 0; /* consistency check */
-
-        /* Loop over the molecules and atoms of this group */
-        for (int iMol = 0, iAtom = 0; iAtom < static_cast<int>(g->atomSet.numAtomsGlobal());
-             iAtom += g->apm, iMol++)
+        g->comp[comp].nMol                = 0;
+        g->comp[comp].swapCandidatesValid = false;
+        nMolNotInComp[comp]               = 0; /* consistency check */
+
+        /* Check for all molecules in parallel whether the first atom of the
+         * molecule is in the compartment that we look at. With many solvent
+         * molecules this is the expensive part, the list updates below are cheap.
+         */
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int iMol = 0; iMol < numMolecules; iMol++)
         {
-            real dist;
-            int  sd = s->swapdim;
+            g->molInCompartment[iMol] = static_cast<int>(
+                    compartment_contains_atom(left,
+                                              right,
+                                              g->xc[iMol * g->apm][sd],
+                                              box[sd][sd],
+                                              sc->bulkOffset[comp],
+                                              &g->molDistance[iMol]));
+        }
 
-            /* Is this first atom of the molecule in the compartment that we look at? */
-            if (compartment_contains_atom(
-                        left, right, g->xc[iAtom][sd], box[sd][sd], sc->bulkOffset[comp], &dist))
+        /* Loop over the molecules and atoms of this group in order */
+        for (int iMol = 0, iAtom = 0; iMol < numMolecules; iAtom += g->apm, iMol++)
+        {
+            if (g->molInCompartment[iMol])
             {
                 /* Add the first atom of this molecule to the list of molecules in this compartment */
-                add_to_list(iAtom, &g->comp[comp], dist);
+                add_to_list(iAtom, &g->comp[comp], g->molDistance[iMol]);
 
                 /* Main also checks for ion groups through which channel each ion has passed */
                 if (MAIN(cr) && (g->comp_now != nullptr) && !bIsSolvent)
@@ -809,7 +836,6 @@ static void sortMoleculesIntoCompartments(t_swapgrp*          g,
     }
 
     /* Consistency checks */
-    const auto numMolecules = static_cast<int>(g->atomSet.numAtomsGlobal() / g->apm);
     if (nMolNotInComp[Compartment::A] + nMolNotInComp[Compartment::B] != numMolecules)
     {
         fprintf(stderr,
@@ -1944,24 +1970,34 @@ static gmx_bool need_swap(const t_swapcoords* sc, t_swap* s)
  */
 static int get_index_of_distant_atom(t_compartment* comp, const char molname[])
 {
-    int  ibest = -1;
-    real d     = GMX_REAL_MAX;
-
-
-    /* comp->nat contains the original number of atoms in this compartment
-     * prior to doing any swaps. Some of these atoms may already have been
-     * swapped out, but then they are marked with a distance of GMX_REAL_MAX
+    /* Orders on distance, with ties broken by list order, such that the choice
+     * is independent of how the heap is organized. The heap top is the minimum.
+     */
+    const auto isFartherFromBulk = [comp](int a, int b) {
+        return comp->dist[a] > comp->dist[b] || (comp->dist[a] == comp->dist[b] && a > b);
+    };
+
+    /* comp->nMolBefore contains the original number of molecules in this compartment
+     * prior to doing any swaps. The candidates are put in a heap once per swap step,
+     * so each subsequent request costs O(log(nMolBefore)) instead of a full search.
+     * Molecules that have already been swapped out are removed from the heap and
+     * marked with a distance of GMX_REAL_MAX.
      */
-    for (int iMol = 0; iMol < comp->nMolBefore; iMol++)
+    if (!comp->swapCandidatesValid)
     {
-        if (comp->dist[iMol] < d)
+        comp->swapCandidates.clear();
+        for (int iMol = 0; iMol < comp->nMolBefore; iMol++)
         {
-            ibest = iMol;
-            d     = comp->dist[ibest];
+            if (comp->dist[iMol] < GMX_REAL_MAX)
+            {
+                comp->swapCandidates.push_back(iMol);
+            }
         }
+        std::make_heap(comp->swapCandidates.begin(), comp->swapCandidates.end(), isFartherFromBulk);
+        comp->swapCandidatesValid = true;
     }
 
-    if (ibest < 0)
+    if (comp->swapCandidates.empty())
     {
         gmx_fatal(FARGS,
                   "Could not get index of %s atom. Compartment contains %d %s molecules before "
@@ -1971,6 +2007,10 @@ static int get_index_of_distant_atom(t_compartment* comp, const char molname[])
                   molname);
     }
 
+    std::pop_heap(comp->swapCandidates.begin(), comp->swapCandidates.end(), isFartherFromBulk);
+    const int ibest = comp->swapCandidates.back();
+    comp->swapCandidates.pop_back();
+
     /* Set the distance of this index to infinity such that it won't get selected again in
      * this time step
      */
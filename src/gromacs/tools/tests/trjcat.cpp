@@ -0,0 +1,171 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for merging XTC fragment files with gmx trjcat.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/tools/trjcat.h"
+
+#include <string>
+#include <vector>
+
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/textblockmatchers.h"
+#include "testutils/trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of atoms in the test frames
+constexpr int c_numAtoms = 10;
+
+//! Returns the coordinate of \p atom at \p step, with \p offset for a run that is replaced
+RVec referencePosition(int atom, int64_t step, real offset = 0)
+{
+    return { 0.1_real * atom + offset, 0.01_real * step, 1.0_real };
+}
+
+//! Writes the fragment of \p atoms at \p step to \p fio
+void writeFragment(t_fileio* fio, int64_t step, const std::vector<int>& atoms, real offset = 0)
+{
+    const matrix     box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    std::vector<RVec> x;
+    for (int a : atoms)
+    {
+        x.push_back(referencePosition(a, step, offset));
+    }
+    ASSERT_EQ(1, write_xtc_fragment(fio, c_numAtoms, step, 0.002 * step, box, atoms, x, 1000));
+}
+
+class TrjcatXtcFragmentsTest : public CommandLineTestBase
+{
+public:
+    //! Merges the fragment files and checks that exactly \p steps are present with their reference coordinates
+    void mergeAndCheck(const std::vector<std::string>& fragmentFileNames, const std::vector<int64_t>& steps)
+    {
+        auto& cmdline = commandLine();
+        cmdline.append("-f");
+        for (const std::string& fileName : fragmentFileNames)
+        {
+            cmdline.append(fileName);
+        }
+        const std::string outputFile = setOutputFile("-o", "merged.xtc", NoTextMatch());
+        ASSERT_EQ(0, gmx_trjcat(cmdline.argc(), cmdline.argv()));
+
+        TrajectoryFrameReader reader(outputFile);
+        for (int64_t step : steps)
+        {
+            ASSERT_TRUE(reader.readNextFrame()) << "Missing frame for step " << step;
+            TrajectoryFrame frame = reader.frame();
+            EXPECT_EQ(step, frame.step());
+            ASSERT_EQ(c_numAtoms, frame.x().ssize());
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                const RVec reference = referencePosition(a, step);
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(reference[d], frame.x()[a][d], absoluteTolerance(1e-3))
+                            << "atom " << a << " at step " << step;
+                }
+            }
+        }
+        EXPECT_FALSE(reader.readNextFrame()) << "The merged trajectory has extra frames";
+    }
+};
+
+TEST_F(TrjcatXtcFragmentsTest, MergesFragmentsWithChangingDecomposition)
+{
+    const std::string fileName0 = fileManager().getTemporaryFilePath("traj_frag0.xtc").u8string();
+    const std::string fileName1 = fileManager().getTemporaryFilePath("traj_frag1.xtc").u8string();
+    t_fileio*         fio0      = open_xtc(fileName0, "w");
+    t_fileio*         fio1      = open_xtc(fileName1, "w");
+    writeFragment(fio0, 0, { 0, 1, 2, 3, 4 });
+    writeFragment(fio1, 0, { 5, 6, 7, 8, 9 });
+    writeFragment(fio0, 10, { 9, 0, 1 });
+    writeFragment(fio1, 10, { 2, 3, 4, 5, 6, 7, 8 });
+    writeFragment(fio0, 20, {});
+    writeFragment(fio1, 20, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    close_xtc(fio0);
+    close_xtc(fio1);
+
+    mergeAndCheck({ fileName0, fileName1 }, { 0, 10, 20 });
+}
+
+/* After an appending restart, the file of a rank whose output was not
+ * truncated contains frames beyond the checkpoint at step 20, followed
+ * by the continuation from step 20 with a different decomposition.
+ * The continuation should replace those frames and no frame should be lost.
+ */
+TEST_F(TrjcatXtcFragmentsTest, MergesFragmentsAfterAppendingRestart)
+{
+    const std::string fileName0 = fileManager().getTemporaryFilePath("traj_frag0.xtc").u8string();
+    const std::string fileName1 = fileManager().getTemporaryFilePath("traj_frag1.xtc").u8string();
+    t_fileio*         fio0      = open_xtc(fileName0, "w");
+    t_fileio*         fio1      = open_xtc(fileName1, "w");
+    for (int64_t step = 0; step < 20; step += 10)
+    {
+        writeFragment(fio0, step, { 0, 1, 2, 3, 4 });
+        writeFragment(fio1, step, { 5, 6, 7, 8, 9 });
+    }
+    // Frames of the first run after the checkpoint, only present for rank 1
+    for (int64_t step = 20; step <= 40; step += 10)
+    {
+        writeFragment(fio1, step, { 5, 6, 7, 8, 9 }, 0.5);
+    }
+    for (int64_t step = 20; step <= 50; step += 10)
+    {
+        writeFragment(fio0, step, { 0, 1, 2 });
+        writeFragment(fio1, step, { 3, 4, 5, 6, 7, 8, 9 });
+    }
+    close_xtc(fio0);
+    close_xtc(fio1);
+
+    mergeAndCheck({ fileName0, fileName1 }, { 0, 10, 20, 30, 40, 50 });
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
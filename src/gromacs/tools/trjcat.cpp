@@ -40,7 +40,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
@@ -56,8 +58,10 @@
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -69,6 +73,332 @@
 #endif
 #define FLAGS (TRX_READ_X | TRX_READ_V | TRX_READ_F)
 
+/*! \brief An XTC frame with its box and coordinates still in the encoded file format
+ *
+ * When XTC frames are only concatenated or reordered, they can be copied
+ * without the costly decompression and compression of the coordinates.
+ * Only the step and time in the frame header can be changed.
+ */
+struct XtcEncodedFrame
+{
+    int               magic  = 0;
+    int               natoms = 0;
+    int64_t           step   = 0;
+    real              time   = 0;
+    std::vector<char> data;
+};
+
+static bool readXtcEncodedFrame(t_fileio* fio, XtcEncodedFrame* frame)
+{
+    gmx_bool bOK = TRUE;
+    if (!read_next_xtc_encoded(fio, &frame->magic, &frame->natoms, &frame->step, &frame->time, &frame->data, &bOK))
+    {
+        if (!bOK)
+        {
+            fprintf(stderr,
+                    "\nWARNING: Incomplete frame after time %g in %s\n",
+                    frame->time,
+                    gmx_fio_getname(fio).u8string().c_str());
+        }
+        return false;
+    }
+    return true;
+}
+
+//! Reads the next encoded frame and sets the step and time in \p fr
+static bool readXtcEncodedFrame(t_fileio* fio, XtcEncodedFrame* frame, t_trxframe* fr)
+{
+    if (!readXtcEncodedFrame(fio, frame))
+    {
+        return false;
+    }
+    fr->natoms = frame->natoms;
+    fr->bStep  = TRUE;
+    fr->step   = frame->step;
+    fr->bTime  = TRUE;
+    fr->time   = frame->time;
+    return true;
+}
+
+static bool writeXtcEncodedFrame(t_fileio* fio, const XtcEncodedFrame& frame, int64_t step, real time)
+{
+    return write_xtc_encoded(fio, frame.magic, frame.natoms, step, time, frame.data) != 0;
+}
+
+//! A fragment of a frame read from an XTC fragment file
+struct XtcFragment
+{
+    t_fileio*              fio         = nullptr;
+    bool                   bValid      = false;
+    int                    natomsTotal = 0;
+    int64_t                step        = 0;
+    real                   time        = 0;
+    matrix                 box         = { { 0 } };
+    std::vector<int>       atomIndices;
+    std::vector<gmx::RVec> x;
+    real                   prec = 0;
+};
+
+static bool readXtcFragment(XtcFragment* fragment)
+{
+    gmx_bool bOK     = TRUE;
+    fragment->bValid = (read_next_xtc_fragment(fragment->fio,
+                                               &fragment->natomsTotal,
+                                               &fragment->step,
+                                               &fragment->time,
+                                               fragment->box,
+                                               &fragment->atomIndices,
+                                               &fragment->x,
+                                               &fragment->prec,
+                                               &bOK)
+                        != 0);
+    if (!bOK)
+    {
+        fprintf(stderr,
+                "\nWARNING: Incomplete fragment after time %g in %s\n",
+                fragment->time,
+                gmx_fio_getname(fragment->fio).u8string().c_str());
+    }
+    return fragment->bValid;
+}
+
+//! A frame that is being assembled from XTC fragments
+struct PendingXtcFrame
+{
+    std::vector<gmx::RVec> x;
+    std::vector<bool>      bSet;
+    int                    numSet = 0;
+    real                   time   = 0;
+    real                   prec   = 0;
+    matrix                 box    = { { 0 } };
+};
+
+//! The maximum number of incomplete frames kept while merging XTC fragments
+static constexpr int c_maxNumIncompleteXtcFrames = 100;
+
+/*! \brief Merges the XTC fragment files written by mdrun -xfrag into complete frames
+ *
+ * The fragments are read in order of increasing step over the heads of
+ * all files and collected per step. A frame is written when it is complete
+ * and none of the files can provide more fragments at a lower step, unless
+ * its step has already been written. After an appending restart a file can
+ * contain frames beyond the checkpoint followed by a continuation starting
+ * at the checkpoint step. The step then goes back in that file, so frames
+ * that are incomplete are kept until the fragments of the continuation
+ * arrive. Fragments read later replace the coordinates of earlier ones.
+ * Frames that stay incomplete are skipped with a warning.
+ */
+static void merge_xtc_fragments(gmx::ArrayRef<const std::string> inFiles,
+                                const char*                      outFile,
+                                int                              isize,
+                                const int                        index[],
+                                real                             begin,
+                                real                             end,
+                                real                             dt)
+{
+    std::vector<XtcFragment> fragments(inFiles.size());
+    for (size_t f = 0; f < inFiles.size(); f++)
+    {
+        fragments[f].fio = open_xtc(inFiles[f], "r");
+        if (!readXtcFragment(&fragments[f]))
+        {
+            gmx_fatal(FARGS, "Could not read a fragment from %s", inFiles[f].c_str());
+        }
+        if (fragments[f].natomsTotal != fragments[0].natomsTotal)
+        {
+            gmx_fatal(FARGS,
+                      "Fragment file %s has frames with %d atoms while previous files had %d atoms",
+                      inFiles[f].c_str(),
+                      fragments[f].natomsTotal,
+                      fragments[0].natomsTotal);
+        }
+    }
+    const int natoms = fragments[0].natomsTotal;
+    for (int i = 0; i < isize; i++)
+    {
+        if (index[i] >= natoms)
+        {
+            gmx_fatal(FARGS, "Not enough atoms (%d) for index group (%d)", natoms, index[i]);
+        }
+    }
+
+    std::map<int64_t, PendingXtcFrame> pendingFrames;
+    t_trxstatus*                       trxout           = open_trx(outFile, "w");
+    bool                               bWritten         = false;
+    bool                               bEndReached      = false;
+    int64_t                            lastStep         = 0;
+    real                               firstTime        = 0;
+    int                                numFramesWritten = 0;
+    while (!bEndReached)
+    {
+        bool    bFound = false;
+        int64_t step   = 0;
+        for (const XtcFragment& fragment : fragments)
+        {
+            if (fragment.bValid && (!bFound || fragment.step < step))
+            {
+                step   = fragment.step;
+                bFound = true;
+            }
+        }
+
+        if (bFound)
+        {
+            PendingXtcFrame& frame = pendingFrames[step];
+            if (frame.x.empty())
+            {
+                frame.x.resize(natoms);
+                frame.bSet.resize(natoms, false);
+            }
+            for (XtcFragment& fragment : fragments)
+            {
+                while (fragment.bValid && fragment.step == step)
+                {
+                    for (size_t i = 0; i < fragment.atomIndices.size(); i++)
+                    {
+                        const int a = fragment.atomIndices[i];
+                        range_check(a, 0, natoms);
+                        frame.numSet += frame.bSet[a] ? 0 : 1;
+                        frame.bSet[a] = true;
+                        frame.x[a]    = fragment.x[i];
+                    }
+                    frame.time = fragment.time;
+                    /* Fragments with few atoms are stored without precision */
+                    if (fragment.prec > 0)
+                    {
+                        frame.prec = fragment.prec;
+                    }
+                    copy_mat(fragment.box, frame.box);
+                    readXtcFragment(&fragment);
+                }
+            }
+        }
+
+        /* Only frames below the lowest step that any file can still
+         * provide are final, all frames are final when all files are read.
+         */
+        bool    bMoreFragments = false;
+        int64_t nextStep       = 0;
+        for (const XtcFragment& fragment : fragments)
+        {
+            if (fragment.bValid && (!bMoreFragments || fragment.step < nextStep))
+            {
+                nextStep       = fragment.step;
+                bMoreFragments = true;
+            }
+        }
+
+        const auto skipIncompleteFrame = [natoms](const PendingXtcFrame& frame) {
+            fprintf(stderr,
+                    "\nWARNING: Skipping frame at time %g, the fragments contain only %d of %d "
+                    "atoms\n",
+                    frame.time,
+                    frame.numSet,
+                    natoms);
+        };
+        /* Incomplete frames are kept, as the fragments of the continuation
+         * after a restart can still complete them, until a later frame
+         * is written.
+         */
+        auto firstIncomplete = pendingFrames.end();
+        int  numIncomplete   = 0;
+        for (auto it = pendingFrames.begin(); it != pendingFrames.end();)
+        {
+            const int64_t          frameStep = it->first;
+            const PendingXtcFrame& frame     = it->second;
+            if (bMoreFragments && frameStep >= nextStep)
+            {
+                break;
+            }
+            if (bWritten && frameStep <= lastStep)
+            {
+                fprintf(stderr,
+                        "\nWARNING: Skipping fragments at time %g, this step was already written\n",
+                        frame.time);
+                it = pendingFrames.erase(it);
+                continue;
+            }
+            if (frame.numSet != natoms)
+            {
+                if (numIncomplete == 0)
+                {
+                    firstIncomplete = it;
+                }
+                numIncomplete++;
+                ++it;
+                continue;
+            }
+            if ((end > 0) && (frame.time > end + GMX_REAL_EPS))
+            {
+                bEndReached = true;
+                break;
+            }
+            for (; numIncomplete > 0; numIncomplete--)
+            {
+                skipIncompleteFrame(firstIncomplete->second);
+                firstIncomplete = pendingFrames.erase(firstIncomplete);
+            }
+            if (frame.time >= begin)
+            {
+                if (!bWritten)
+                {
+                    firstTime = frame.time;
+                }
+                bWritten = true;
+                lastStep = frameStep;
+                if (dt == 0 || bRmod(frame.time, firstTime, dt))
+                {
+                    t_trxframe fr;
+                    clear_trxframe(&fr, TRUE);
+                    fr.natoms = natoms;
+                    fr.bX     = TRUE;
+                    fr.x      = as_rvec_array(it->second.x.data());
+                    fr.bBox   = TRUE;
+                    copy_mat(frame.box, fr.box);
+                    fr.bStep = TRUE;
+                    fr.step  = frameStep;
+                    fr.bTime = TRUE;
+                    fr.time  = frame.time;
+                    fr.bPrec = (frame.prec > 0);
+                    fr.prec  = frame.prec;
+                    if (isize > 0)
+                    {
+                        write_trxframe_indexed(trxout, &fr, isize, index, nullptr);
+                    }
+                    else
+                    {
+                        write_trxframe(trxout, &fr, nullptr);
+                    }
+                    numFramesWritten++;
+                }
+            }
+            it = pendingFrames.erase(it);
+        }
+        /* Limit the memory used when fragments are missing altogether */
+        for (; numIncomplete > (bMoreFragments && !bEndReached ? c_maxNumIncompleteXtcFrames : 0);
+             numIncomplete--)
+        {
+            skipIncompleteFrame(firstIncomplete->second);
+            firstIncomplete = pendingFrames.erase(firstIncomplete);
+        }
+
+        if (!bMoreFragments)
+        {
+            break;
+        }
+    }
+    close_trx(trxout);
+    for (XtcFragment& fragment : fragments)
+    {
+        close_xtc(fragment.fio);
+    }
+    fprintf(stderr,
+            "\nMerged %d frames from %td fragment files into %s\n",
+            numFramesWritten,
+            inFiles.ssize(),
+            outFile);
+}
+
 static void scan_trj_files(gmx::ArrayRef<const std::string> files,
                            real*                            readtime,
                            real*                            timestep,
@@ -423,6 +753,119 @@ static void do_demux(gmx::ArrayRef<const std::string> inFiles,
     }
 }
 
+/*! \brief Demultiplexes XTC files by copying the encoded frames
+ *
+ * Does the same as do_demux() without index group, but does not decode
+ * the frames. As each input file is written to a different output file
+ * at each time, the files are processed in parallel.
+ */
+static void do_demux_xtc_encoded(gmx::ArrayRef<const std::string> inFiles,
+                                 gmx::ArrayRef<const std::string> outFiles,
+                                 int                              nval,
+                                 real**                           value,
+                                 real*                            time,
+                                 real                             dt_remd,
+                                 real                             dt)
+{
+    const int                    numFiles = inFiles.ssize();
+    std::vector<t_fileio*>       fp_in(numFiles);
+    std::vector<t_fileio*>       fp_out(numFiles);
+    std::vector<XtcEncodedFrame> frames(numFiles);
+    std::vector<int>             outIndex(numFiles);
+    std::vector<bool>            bSet(numFiles);
+    std::vector<char>            readOK(numFiles);
+    std::vector<char>            writeOK(numFiles);
+
+    for (int i = 0; i < numFiles; i++)
+    {
+        fp_in[i] = open_xtc(inFiles[i], "r");
+        if (!readXtcEncodedFrame(fp_in[i], &frames[i]))
+        {
+            gmx_fatal(FARGS, "Could not read a frame from %s", inFiles[i].c_str());
+        }
+        if (frames[i].natoms != frames[0].natoms)
+        {
+            gmx_fatal(FARGS,
+                      "Trajectory file %s has %d atoms while previous trajs had %d atoms",
+                      inFiles[i].c_str(),
+                      frames[i].natoms,
+                      frames[0].natoms);
+        }
+        if (frames[i].time != frames[0].time)
+        {
+            gmx_fatal(FARGS,
+                      "Trajectory file %s has time %f while previous trajs had time %f",
+                      inFiles[i].c_str(),
+                      frames[i].time,
+                      frames[0].time);
+        }
+    }
+    const real first_time = frames[0].time;
+
+    for (int i = 0; i < numFiles; i++)
+    {
+        fp_out[i] = open_xtc(outFiles[i], "w");
+    }
+    int k = 0;
+    if (std::round(time[k] - first_time) != 0)
+    {
+        gmx_fatal(FARGS, "First time in demuxing table does not match trajectories");
+    }
+    const int numThreads = std::min(numFiles, gmx_omp_get_max_threads());
+    bool      bCont;
+    do
+    {
+        while ((k + 1 < nval) && ((frames[0].time - time[k + 1]) > dt_remd * 0.1))
+        {
+            k++;
+        }
+        std::fill(bSet.begin(), bSet.end(), false);
+        for (int i = 0; i < numFiles; i++)
+        {
+            int j = gmx::roundToInt(value[i][k]);
+            range_check(j, 0, numFiles);
+            if (bSet[j])
+            {
+                gmx_fatal(FARGS, "Demuxing the same replica %d twice at time %f", j, frames[0].time);
+            }
+            bSet[j]     = true;
+            outIndex[i] = j;
+        }
+
+        bCont = (k < nval);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int i = 0; i < numFiles; i++)
+        {
+            try
+            {
+                writeOK[i] = true;
+                if (dt == 0 || bRmod(frames[i].time, first_time, dt))
+                {
+                    writeOK[i] = writeXtcEncodedFrame(
+                            fp_out[outIndex[i]], frames[i], frames[i].step, frames[i].time);
+                }
+                readOK[i] = bCont && readXtcEncodedFrame(fp_in[i], &frames[i]);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+
+        for (int i = 0; i < numFiles; i++)
+        {
+            if (!writeOK[i])
+            {
+                gmx_fatal(FARGS, "Error writing frame to %s", outFiles[outIndex[i]].c_str());
+            }
+            bCont = bCont && readOK[i];
+        }
+    } while (bCont);
+
+    for (int i = 0; i < numFiles; i++)
+    {
+        close_xtc(fp_in[i]);
+        close_xtc(fp_out[i]);
+    }
+}
+
 int gmx_trjcat(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -450,7 +893,14 @@ int gmx_trjcat(int argc, char* argv[])
         "The frames corresponding to the numbers present at the first line",
         "are collected into the output trajectory. If the number of frames in",
         "the trajectory does not match that in the [REF].xvg[ref] file then the program",
-        "tries to be smart. Beware."
+        "tries to be smart. Beware.[PAR]",
+        "XTC fragment files written by each rank with the hidden [TT]gmx mdrun -xfrag[tt]",
+        "option can be merged into complete frames by passing all fragment files",
+        "of a run with [TT]-f[tt].[PAR]",
+        "When both the input and output files are [REF].xtc[ref] files and no index",
+        "group is selected, the compressed frames are copied without decompressing",
+        "them, which is much faster. Demultiplexing then processes the files",
+        "in parallel."
     };
     static gmx_bool bCat            = FALSE;
     static gmx_bool bSort           = TRUE;
@@ -608,7 +1058,22 @@ int gmx_trjcat(int argc, char* argv[])
                   nset,
                   outFiles.ssize());
     }
-    if (bDeMux)
+    if (ftpin == efXTC && xtc_is_fragment_file(inFiles[0]))
+    {
+        for (const std::string& inFile : inFiles)
+        {
+            if (!xtc_is_fragment_file(inFile))
+            {
+                gmx_fatal(FARGS, "Can not mix XTC fragment files and other trajectory files");
+            }
+        }
+        if (bDeMux || fn2ftp(outFiles[0].c_str()) == efTNG)
+        {
+            gmx_fatal(FARGS, "XTC fragment files can only be merged to a single non-TNG output file");
+        }
+        merge_xtc_fragments(inFiles, outFiles[0].c_str(), isize, index, begin, end, dt);
+    }
+    else if (bDeMux)
     {
         auto outFilesDemux = gmx::copyOf(outFiles);
         if (gmx::ssize(outFilesDemux) != nset)
@@ -620,7 +1085,19 @@ int gmx_trjcat(int argc, char* argv[])
                 outFilesDemux[i] = gmx::formatString("%d_%s", i, name.c_str());
             }
         }
-        do_demux(inFiles, outFilesDemux, n, val, t, dt_remd, isize, index, dt, oenv);
+        bool bEncoded = (ftpin == efXTC && !bIndex);
+        for (const std::string& outFile : outFilesDemux)
+        {
+            bEncoded = bEncoded && (fn2ftp(outFile.c_str()) == efXTC);
+        }
+        if (bEncoded)
+        {
+            do_demux_xtc_encoded(inFiles, outFilesDemux, n, val, t, dt_remd, dt);
+        }
+        else
+        {
+            do_demux(inFiles, outFilesDemux, n, val, t, dt_remd, isize, index, dt, oenv);
+        }
     }
     else
     {
@@ -781,6 +1258,11 @@ int gmx_trjcat(int argc, char* argv[])
             }
             frout = fr;
         }
+        /* XTC frames can be copied without decoding them */
+        const bool      bEncoded = (ftpin == efXTC && ftpout == efXTC && !bIndex);
+        t_fileio*       xtcIn    = nullptr;
+        XtcEncodedFrame encodedFrame;
+
         /* Lets stitch up some files */
         timestep = timest[0];
         for (size_t i = n_append + 1; i < inFilesEdited.size(); i++)
@@ -840,7 +1322,19 @@ int gmx_trjcat(int argc, char* argv[])
             {
                 timestep = timest[i];
             }
-            read_first_frame(oenv, &status, inFilesEdited[i].c_str(), &fr, FLAGS);
+            if (bEncoded)
+            {
+                xtcIn = open_xtc(inFilesEdited[i], "r");
+                clear_trxframe(&fr, TRUE);
+                if (!readXtcEncodedFrame(xtcIn, &encodedFrame, &fr))
+                {
+                    gmx_fatal(FARGS, "Could not read a frame from %s", inFilesEdited[i].c_str());
+                }
+            }
+            else
+            {
+                read_first_frame(oenv, &status, inFilesEdited[i].c_str(), &fr, FLAGS);
+            }
             if (!fr.bTime)
             {
                 fr.time = 0;
@@ -928,7 +1422,15 @@ int gmx_trjcat(int argc, char* argv[])
                             bNewFile = FALSE;
                         }
 
-                        if (bIndex)
+                        if (bEncoded)
+                        {
+                            if (!writeXtcEncodedFrame(
+                                        trx_get_fileio(trxout), encodedFrame, frout.step, frout.time))
+                            {
+                                gmx_fatal(FARGS, "Error writing frame to %s", out_file);
+                            }
+                        }
+                        else if (bIndex)
                         {
                             write_trxframe_indexed(trxout, &frout, isize, index, nullptr);
                         }
@@ -936,7 +1438,7 @@ int gmx_trjcat(int argc, char* argv[])
                         {
                             write_trxframe(trxout, &frout, nullptr);
                         }
-                        if (trxio_should_print_count(oenv, status))
+                        if (bEncoded ? (frame_out % 100 == 0) : trxio_should_print_count(oenv, status))
                         {
                             fprintf(stderr,
                                     " ->  frame %6d time %8.3f %s     \r",
@@ -947,9 +1449,17 @@ int gmx_trjcat(int argc, char* argv[])
                         }
                     }
                 }
-            } while (read_next_frame(oenv, status, &fr));
+            } while (bEncoded ? readXtcEncodedFrame(xtcIn, &encodedFrame, &fr)
+                              : read_next_frame(oenv, status, &fr));
 
-            close_trx(status);
+            if (bEncoded)
+            {
+                close_xtc(xtcIn);
+            }
+            else
+            {
+                close_trx(status);
+            }
         }
         if (trxout)
         {
@@ -320,6 +320,14 @@ void please_cite(FILE* fp, const char* key)
           335,
           2001,
           "435-439" },
+        { "Chodera2011",
+          "J. D. Chodera and M. R. Shirts",
+          "Replica exchange and expanded ensemble simulations as {G}ibbs sampling: {S}imple "
+          "improvements for enhanced mixing",
+          "J. Chem. Phys.",
+          135,
+          2011,
+          "194110" },
         { "Hukushima96a",
           "K. Hukushima and K. Nemoto",
           "Exchange Monte Carlo Method and Application to Spin Glass Simulations",
@@ -0,0 +1,224 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that asynchronous trajectory writing gives the same output as synchronous writing
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/checkpoint.h"
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/setenv.h"
+#include "testutils/testasserts.h"
+#include "testutils/trajectoryreader.h"
+
+#include "moduletest.h"
+
+namespace gmx::test
+{
+namespace
+{
+
+//! The environment variable that enables asynchronous trajectory writing
+const char* const c_asyncWritingEnvironmentVariable = "GMX_ASYNC_TRAJECTORY_WRITING";
+
+//! The file names for the output of one run
+struct OutputFileNames
+{
+    //! Full-precision trajectory
+    std::string trr;
+    //! Compressed coordinate trajectory
+    std::string xtc;
+    //! Compressed velocity and force trajectory
+    std::string xtcVF;
+    //! Checkpoint
+    std::string cpt;
+};
+
+//! Returns the contents of the binary file \p fileName
+std::string readBinaryFile(const std::string& fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+//! Returns the output file sizes and checksums stored in the checkpoint \p fileName
+std::vector<gmx_file_position_t> readCheckpointOutputFiles(const std::string& fileName)
+{
+    std::vector<gmx_file_position_t> outputFiles;
+    // This also closes the file
+    read_checkpoint_simulation_part_and_filenames(gmx_fio_open(fileName, "r"), &outputFiles);
+    return outputFiles;
+}
+
+using AsyncTrajectoryWritingTest = MdrunTestFixture;
+
+/* Runs with full precision and compressed output, once with
+ * synchronous and once with asynchronous writing, and checks that
+ * the trajectories and the checkpoints are identical.
+ */
+TEST_F(AsyncTrajectoryWritingTest, MatchesSynchronousWriting)
+{
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(
+            "integrator         = md\n"
+            "nsteps             = 20\n"
+            "nstxout            = 5\n"
+            "nstvout            = 5\n"
+            "nstfout            = 5\n"
+            "nstxout-compressed = 5\n"
+            "nstvout-compressed = 5\n"
+            "nstfout-compressed = 5\n"
+            "nstcalcenergy      = 5\n"
+            "cutoff-scheme      = verlet\n"
+            "coulombtype        = reaction-field\n"
+            "rcoulomb           = 0.7\n"
+            "rvdw               = 0.7\n");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    // With -reprod the synchronous and asynchronous runs give the same frames
+    CommandLine caller;
+    caller.append("-reprod");
+    caller.addOption("-nb", "cpu");
+
+    const char*       environmentVariableValue = getenv(c_asyncWritingEnvironmentVariable);
+    const std::string environmentVariableBackup =
+            (environmentVariableValue != nullptr) ? environmentVariableValue : "";
+
+    OutputFileNames fileNames[2];
+    for (int useAsync = 0; useAsync < 2; useAsync++)
+    {
+        const std::string prefix = useAsync ? "async" : "sync";
+        SCOPED_TRACE("Running with " + prefix + "hronous trajectory writing");
+        OutputFileNames& names = fileNames[useAsync];
+        names.trr   = fileManager_.getTemporaryFilePath(prefix + ".trr").u8string();
+        names.xtc   = fileManager_.getTemporaryFilePath(prefix + ".xtc").u8string();
+        names.xtcVF = fileManager_.getTemporaryFilePath(prefix + "_vf.xtc").u8string();
+        names.cpt   = fileManager_.getTemporaryFilePath(prefix + ".cpt").u8string();
+        runner_.fullPrecisionTrajectoryFileName_    = names.trr;
+        runner_.reducedPrecisionTrajectoryFileName_ = names.xtc;
+        runner_.cptOutputFileName_                  = names.cpt;
+        if (useAsync)
+        {
+            gmxSetenv(c_asyncWritingEnvironmentVariable, "1", 1);
+        }
+        else
+        {
+            gmxUnsetenv(c_asyncWritingEnvironmentVariable);
+        }
+        ASSERT_EQ(0, runner_.callMdrun(caller));
+
+        const std::string logFileContents = TextReader::readFileToString(runner_.logFileName_);
+        EXPECT_EQ(useAsync == 1,
+                  logFileContents.find("Trajectory frames are written by a separate thread")
+                          != std::string::npos)
+                << "the asynchronous writing was not used as requested";
+    }
+
+    if (environmentVariableValue != nullptr)
+    {
+        gmxSetenv(c_asyncWritingEnvironmentVariable, environmentVariableBackup.c_str(), 1);
+    }
+    else
+    {
+        gmxUnsetenv(c_asyncWritingEnvironmentVariable);
+    }
+
+    // The trajectory files should be identical, as the same data is written in the same order
+    for (const auto& trajectory : { std::make_pair(fileNames[0].trr, fileNames[1].trr),
+                                    std::make_pair(fileNames[0].xtc, fileNames[1].xtc),
+                                    std::make_pair(fileNames[0].xtcVF, fileNames[1].xtcVF) })
+    {
+        const std::string syncContents  = readBinaryFile(trajectory.first);
+        const std::string asyncContents = readBinaryFile(trajectory.second);
+        EXPECT_FALSE(syncContents.empty()) << trajectory.first << " was not written";
+        EXPECT_TRUE(syncContents == asyncContents)
+                << trajectory.first << " and " << trajectory.second << " differ";
+    }
+
+    // All frames should have been written before the checkpoint, so the
+    // checkpoints should record the same output file sizes and checksums.
+    // The log files differ, as they contain timings.
+    const auto syncOutputFiles  = readCheckpointOutputFiles(fileNames[0].cpt);
+    const auto asyncOutputFiles = readCheckpointOutputFiles(fileNames[1].cpt);
+    ASSERT_EQ(syncOutputFiles.size(), asyncOutputFiles.size());
+    for (size_t i = 0; i < syncOutputFiles.size(); i++)
+    {
+        if (fn2ftp(syncOutputFiles[i].filename) == efLOG)
+        {
+            continue;
+        }
+        SCOPED_TRACE(std::string("Comparing checkpoint entry for ") + syncOutputFiles[i].filename);
+        EXPECT_EQ(syncOutputFiles[i].offset, asyncOutputFiles[i].offset);
+        EXPECT_EQ(syncOutputFiles[i].checksumSize, asyncOutputFiles[i].checksumSize);
+        EXPECT_TRUE(syncOutputFiles[i].checksum == asyncOutputFiles[i].checksum);
+    }
+
+    // The state in the checkpoints should be identical
+    TrajectoryFrameReader syncReader(fileNames[0].cpt);
+    TrajectoryFrameReader asyncReader(fileNames[1].cpt);
+    ASSERT_TRUE(syncReader.readNextFrame());
+    ASSERT_TRUE(asyncReader.readNextFrame());
+    const TrajectoryFrame syncFrame  = syncReader.frame();
+    const TrajectoryFrame asyncFrame = asyncReader.frame();
+    EXPECT_EQ(syncFrame.step(), asyncFrame.step());
+    ASSERT_EQ(syncFrame.x().size(), asyncFrame.x().size());
+    ASSERT_EQ(syncFrame.v().size(), asyncFrame.v().size());
+    for (size_t i = 0; i < syncFrame.x().size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(syncFrame.x()[i][d], asyncFrame.x()[i][d]) << "coordinate of atom " << i;
+            EXPECT_EQ(syncFrame.v()[i][d], asyncFrame.v()[i][d]) << "velocity of atom " << i;
+        }
+    }
+}
+
+} // namespace
+} // namespace gmx::test
@@ -63,7 +63,9 @@ class CheckpointCoordinatesSanityChecks :
     public ::testing::WithParamInterface<std::tuple<std::string, std::string, std::string, std::string>>
 {
 public:
-    void runSimulation(MdpFieldValues mdpFieldValues, int numSteps)
+    void runSimulation(MdpFieldValues                            mdpFieldValues,
+                       int                                       numSteps,
+                       const std::vector<SimulationOptionTuple>& mdrunOptions = {})
     {
         mdpFieldValues["nsteps"] = toString(numSteps);
         // Trajectories have the initial and the last frame
@@ -76,7 +78,7 @@ public:
         runGrompp(&runner_);
 
         // Do first mdrun
-        runMdrun(&runner_, {});
+        runMdrun(&runner_, mdrunOptions);
     }
 
     static void compareCptAndTrr(const std::string&          trrFileName,
@@ -150,6 +152,48 @@ TEST_P(CheckpointCoordinatesSanityChecks, WithinTolerances)
                      { trajectoryMatchSettings, trajectoryTolerances });
 }
 
+TEST_P(CheckpointCoordinatesSanityChecks, WithinTolerancesWithStateShards)
+{
+    const auto& params              = GetParam();
+    const auto& simulationName      = std::get<0>(params);
+    const auto& integrator          = std::get<1>(params);
+    const auto& temperatureCoupling = std::get<2>(params);
+    const auto& pressureCoupling    = std::get<3>(params);
+
+    TrajectoryFrameMatchSettings trajectoryMatchSettings{ true,
+                                                          true,
+                                                          true,
+                                                          ComparisonConditions::MustCompare,
+                                                          ComparisonConditions::MustCompare,
+                                                          ComparisonConditions::NoComparison,
+                                                          MaxNumFrames::compareAllFrames() };
+    if (integrator == "md-vv")
+    {
+        trajectoryMatchSettings.velocitiesComparison = ComparisonConditions::NoComparison;
+    }
+    const TrajectoryTolerances trajectoryTolerances{
+        defaultRealTolerance(), defaultRealTolerance(), defaultRealTolerance(), defaultRealTolerance()
+    };
+
+    const auto mdpFieldValues =
+            prepareMdpFieldValues(simulationName, integrator, temperatureCoupling, pressureCoupling);
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+
+    SCOPED_TRACE(formatString(
+            "Checking the sanity of the coordinates in checkpoint state shards using system '%s' "
+            "with integrator '%s', '%s' temperature coupling, and '%s' pressure coupling ",
+            simulationName.c_str(),
+            integrator.c_str(),
+            temperatureCoupling.c_str(),
+            pressureCoupling.c_str()));
+
+    // Reading the checkpoint as a frame assembles the state from the shards
+    runSimulation(mdpFieldValues, 16, { { "-cptshard", "yes" } });
+    compareCptAndTrr(runner_.fullPrecisionTrajectoryFileName_,
+                     runner_.cptOutputFileName_,
+                     { trajectoryMatchSettings, trajectoryTolerances });
+}
+
 #if !GMX_GPU_OPENCL
 INSTANTIATE_TEST_SUITE_P(CheckpointCoordinatesAreSane,
                          CheckpointCoordinatesSanityChecks,
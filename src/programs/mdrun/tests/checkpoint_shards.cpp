@@ -0,0 +1,123 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests checkpointing with state shards written by all ranks
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/trajectoryanalysis/topologyinformation.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
+#include "testutils/testmatchers.h"
+
+#include "moduletest.h"
+
+namespace gmx::test
+{
+namespace
+{
+
+//! Returns the coordinates and velocities in a configuration file
+std::pair<std::vector<RVec>, std::vector<RVec>> readConfiguration(const std::string& fileName)
+{
+    TopologyInformation configuration;
+    configuration.fillFromInputFile(fileName);
+    return { std::vector<RVec>(configuration.x().begin(), configuration.x().end()),
+             std::vector<RVec>(configuration.v().begin(), configuration.v().end()) };
+}
+
+using CheckpointStateShardsTest = MdrunTestFixture;
+
+/* With state shards the checkpoint at the last step does not collect the
+ * coordinates and velocities. This checks that the final configuration
+ * is still collected and identical to that of a run without shards,
+ * also when no trajectory output happens at the last step.
+ */
+TEST_F(CheckpointStateShardsTest, FinalConfigurationMatchesRunWithoutShards)
+{
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(
+            "integrator    = md\n"
+            "nsteps        = 20\n"
+            "nstxout       = 0\n"
+            "nstvout       = 0\n"
+            "nstcalcenergy = 10\n"
+            "cutoff-scheme = verlet\n"
+            "coulombtype   = reaction-field\n"
+            "rcoulomb      = 0.7\n"
+            "rvdw          = 0.7\n"
+            "tcoupl        = v-rescale\n"
+            "tc-grps       = System\n"
+            "tau-t         = 0.1\n"
+            "ref-t         = 300\n");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    CommandLine caller;
+    caller.append("-reprod");
+    caller.addOption("-nb", "cpu");
+    const std::string referenceConfOutFileName =
+            fileManager_.getTemporaryFilePath("reference.gro").u8string();
+    runner_.groOutputFileName_ = referenceConfOutFileName;
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    caller.append("-cptshard");
+    runner_.groOutputFileName_ = fileManager_.getTemporaryFilePath("shards.gro").u8string();
+    runner_.cptOutputFileName_ = fileManager_.getTemporaryFilePath("shards.cpt").u8string();
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    const auto [initialX, initialV]     = readConfiguration(runner_.groFileName_);
+    const auto [referenceX, referenceV] = readConfiguration(referenceConfOutFileName);
+    const auto [shardsX, shardsV]       = readConfiguration(runner_.groOutputFileName_);
+
+    // Make sure that we do not compare two copies of the initial configuration
+    EXPECT_THAT(referenceX, testing::Not(testing::Pointwise(RVecEq(ulpTolerance(0)), initialX)));
+
+    EXPECT_THAT(shardsX, testing::Pointwise(RVecEq(ulpTolerance(0)), referenceX));
+    EXPECT_THAT(shardsV, testing::Pointwise(RVecEq(ulpTolerance(0)), referenceV));
+}
+
+} // namespace
+} // namespace gmx::test
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests the compressed velocity and force output with appending restarts
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/path.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
+#include "testutils/trajectoryreader.h"
+
+#include "moduletest.h"
+
+namespace gmx::test
+{
+namespace
+{
+
+using CompressedVFOutputTest = MdrunTestFixture;
+
+//! Returns the name of the compressed v/f output that mdrun derives from \p xtcFileName
+std::string compressedVFFileName(const std::string& xtcFileName)
+{
+    std::filesystem::path fileName(xtcFileName);
+    fileName.replace_filename(fileName.stem().u8string() + "_vf.xtc");
+    return fileName.u8string();
+}
+
+/* Runs with compressed velocity and force output in two parts with an
+ * appending restart in between and checks that the output matches
+ * that of a run without restart.
+ */
+TEST_F(CompressedVFOutputTest, AppendingRestartMatchesSingleRun)
+{
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(
+            "integrator         = md\n"
+            "nsteps             = 20\n"
+            "nstvout-compressed = 5\n"
+            "nstfout-compressed = 5\n"
+            "nstcalcenergy      = 5\n"
+            "cutoff-scheme      = verlet\n"
+            "coulombtype        = reaction-field\n"
+            "rcoulomb           = 0.7\n"
+            "rvdw               = 0.7\n"
+            "tcoupl             = v-rescale\n"
+            "tc-grps            = System\n"
+            "tau-t              = 0.1\n"
+            "ref-t              = 300\n");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    CommandLine caller;
+    caller.append("-reprod");
+    caller.addOption("-nb", "cpu");
+    const std::string referenceFileName =
+            fileManager_.getTemporaryFilePath("reference.xtc").u8string();
+    runner_.reducedPrecisionTrajectoryFileName_ = referenceFileName;
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    // Use the default name for the first part and set -xvf for the
+    // continuation, so we check that both refer to the same file
+    const std::string appendedFileName =
+            fileManager_.getTemporaryFilePath("appended.xtc").u8string();
+    runner_.reducedPrecisionTrajectoryFileName_ = appendedFileName;
+    runner_.cptOutputFileName_ = fileManager_.getTemporaryFilePath("appended.cpt").u8string();
+    {
+        SCOPED_TRACE("Running the first part");
+        runner_.nsteps_ = 10;
+        ASSERT_EQ(0, runner_.callMdrun(caller));
+    }
+    {
+        SCOPED_TRACE("Running the second part with appending");
+        runner_.nsteps_ = -2;
+        CommandLine restartCaller(caller);
+        restartCaller.addOption("-cpi", runner_.cptOutputFileName_);
+        restartCaller.addOption("-xvf", compressedVFFileName(appendedFileName));
+        ASSERT_EQ(0, runner_.callMdrun(restartCaller));
+    }
+
+    const std::string referenceVFFileName = compressedVFFileName(referenceFileName);
+    const std::string appendedVFFileName  = compressedVFFileName(appendedFileName);
+    ASSERT_TRUE(File::exists(referenceVFFileName, File::returnFalseOnError));
+    ASSERT_TRUE(File::exists(appendedVFFileName, File::returnFalseOnError));
+
+    TrajectoryFrameReader referenceReader(referenceVFFileName);
+    TrajectoryFrameReader appendedReader(appendedVFFileName);
+    int                   numFrames = 0;
+    while (referenceReader.readNextFrame())
+    {
+        ASSERT_TRUE(appendedReader.readNextFrame()) << "Appended output lacks frame " << numFrames;
+        const TrajectoryFrame referenceFrame = referenceReader.frame();
+        const TrajectoryFrame appendedFrame  = appendedReader.frame();
+        EXPECT_EQ(referenceFrame.step(), appendedFrame.step());
+        ASSERT_EQ(referenceFrame.v().size(), appendedFrame.v().size());
+        ASSERT_EQ(referenceFrame.f().size(), appendedFrame.f().size());
+        /* The continuation writes the frame at the checkpoint step again,
+         * after truncating the file. The restart changes the force
+         * summation order, so after it the compressed velocities can
+         * differ by one unit of the precision and the much larger
+         * forces by a few units.
+         */
+        const bool  isBeforeRestart = (referenceFrame.step() < 10);
+        const float forceTolerance  = isBeforeRestart ? 1.01e-2 : 2.0;
+        for (size_t i = 0; i < referenceFrame.v().size(); i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(referenceFrame.v()[i][d],
+                                   appendedFrame.v()[i][d],
+                                   absoluteTolerance(1.01e-3))
+                        << "velocity of atom " << i << " in frame " << numFrames;
+                EXPECT_REAL_EQ_TOL(referenceFrame.f()[i][d],
+                                   appendedFrame.f()[i][d],
+                                   absoluteTolerance(forceTolerance))
+                        << "force on atom " << i << " in frame " << numFrames;
+            }
+        }
+        numFrames++;
+    }
+    EXPECT_FALSE(appendedReader.readNextFrame()) << "Appended output has extra frames";
+    EXPECT_EQ(5, numFrames);
+}
+
+} // namespace
+} // namespace gmx::test
@@ -0,0 +1,178 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that overlapping the CPU halo exchange with computation does not change the results
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/mpitest.h"
+#include "testutils/setenv.h"
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "moduletest.h"
+#include "simulatorcomparison.h"
+#include "trajectorycomparison.h"
+
+namespace gmx::test
+{
+namespace
+{
+
+//! Environment variable that enables the overlap of the CPU halo exchange
+const char* const c_haloOverlapEnvironmentVariable = "GMX_DD_HALO_OVERLAP";
+
+/*! \brief Test fixture comparing runs with and without overlapping the halo exchange
+ *
+ * The parameter is the electrostatics type. With PME, the long-range
+ * forces are computed while the force halo is in flight.
+ */
+class HaloOverlapTest : public MdrunTestFixture, public ::testing::WithParamInterface<std::string>
+{
+};
+
+TEST_P(HaloOverlapTest, EnergiesAndForcesMatchBlockingExchange)
+{
+    if (getNumberOfTestMpiRanks() < 2)
+    {
+        GTEST_SKIP() << "The halo exchange is only used with domain decomposition";
+    }
+    const std::string coulombType = GetParam();
+
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(formatString(
+            "integrator         = md\n"
+            "nsteps             = 20\n"
+            "nstcalcenergy      = 5\n"
+            "nstenergy          = 5\n"
+            "nstfout            = 5\n"
+            "cutoff-scheme      = verlet\n"
+            "coulombtype        = %s\n"
+            "rcoulomb           = 0.7\n"
+            "rvdw               = 0.7\n"
+            "tcoupl             = v-rescale\n"
+            "tc-grps            = System\n"
+            "tau-t              = 0.1\n"
+            "ref-t              = 300\n",
+            coulombType.c_str()));
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    // The overlap is only used with the non-bonded interactions on the CPU
+    CommandLine caller;
+    caller.append("-reprod");
+    caller.addOption("-nb", "cpu");
+
+    const char*       environmentVariableValue = getenv(c_haloOverlapEnvironmentVariable);
+    const std::string environmentVariableBackup =
+            (environmentVariableValue != nullptr) ? environmentVariableValue : "";
+
+    const std::string blockingEdrFileName =
+            fileManager_.getTemporaryFilePath("blocking.edr").u8string();
+    const std::string blockingTrrFileName =
+            fileManager_.getTemporaryFilePath("blocking.trr").u8string();
+    {
+        SCOPED_TRACE("Running with the blocking halo exchange");
+        gmxUnsetenv(c_haloOverlapEnvironmentVariable);
+        runner_.edrFileName_                     = blockingEdrFileName;
+        runner_.fullPrecisionTrajectoryFileName_ = blockingTrrFileName;
+        ASSERT_EQ(0, runner_.callMdrun(caller));
+    }
+
+    const std::string overlapEdrFileName =
+            fileManager_.getTemporaryFilePath("overlap.edr").u8string();
+    const std::string overlapTrrFileName =
+            fileManager_.getTemporaryFilePath("overlap.trr").u8string();
+    {
+        SCOPED_TRACE("Running with the overlapping halo exchange");
+        gmxSetenv(c_haloOverlapEnvironmentVariable, "1", 1);
+        runner_.edrFileName_                     = overlapEdrFileName;
+        runner_.fullPrecisionTrajectoryFileName_ = overlapTrrFileName;
+        ASSERT_EQ(0, runner_.callMdrun(caller));
+
+        const std::string logFileContents = TextReader::readFileToString(runner_.logFileName_);
+        EXPECT_NE(std::string::npos, logFileContents.find("Will overlap the first stage"))
+                << "the overlapping halo exchange was not used";
+    }
+
+    if (environmentVariableValue != nullptr)
+    {
+        gmxSetenv(c_haloOverlapEnvironmentVariable, environmentVariableBackup.c_str(), 1);
+    }
+    else
+    {
+        gmxUnsetenv(c_haloOverlapEnvironmentVariable);
+    }
+
+    // With -reprod, only the order of the work changes, so the results should be
+    // identical up to rounding
+    const auto           tolerance = relativeToleranceAsPrecisionDependentUlp(10.0, 4, 4);
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_EPOT].longname, tolerance },
+            { interaction_function[F_EKIN].longname, tolerance },
+            { interaction_function[F_PRES].longname, tolerance },
+    } };
+    compareEnergies(blockingEdrFileName, overlapEdrFileName, energyTermsToCompare);
+
+    // Only forces are written to the trajectory
+    const TrajectoryFrameMatchSettings trajectoryMatchSettings{ true,
+                                                                true,
+                                                                true,
+                                                                ComparisonConditions::NoComparison,
+                                                                ComparisonConditions::NoComparison,
+                                                                ComparisonConditions::MustCompare,
+                                                                MaxNumFrames::compareAllFrames() };
+    const TrajectoryComparison trajectoryComparison{
+        trajectoryMatchSettings, TrajectoryComparison::s_defaultTrajectoryTolerances
+    };
+    compareTrajectories(blockingTrrFileName, overlapTrrFileName, trajectoryComparison);
+}
+
+INSTANTIATE_TEST_SUITE_P(WithReactionFieldAndPme,
+                         HaloOverlapTest,
+                         ::testing::Values("reaction-field", "pme"));
+
+} // namespace
+} // namespace gmx::test
@@ -41,6 +41,25 @@
  */
 #include "gmxpre.h"
 
+#include "config.h"
+
+#include <cstdint>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if GMX_IMD && !GMX_NATIVE_WINDOWS
+#    include <csignal>
+
+#    include <arpa/inet.h>
+#    include <pthread.h>
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+#include "gromacs/mdlib/sighandler.h"
 #include "gromacs/utility/stringutil.h"
 
 #include "moduletest.h"
@@ -105,6 +124,237 @@ TEST_P(ImdTest, ImdCanRun)
     ASSERT_EQ(0, runner_.callMdrun(imdCaller));
 }
 
+/* This test checks that mdrun understands -imdasync and finishes without
+ * error when frames would be sent from a separate thread.
+ */
+TEST_P(ImdTest, ImdCanRunWithAsyncSending)
+{
+    runner_.useTopGroAndNdxFromDatabase("glycine_vacuo");
+    const std::string mdpContents = R"(
+        dt            = 0.002
+        nsteps        = 2
+        tcoupl        = v-rescale
+        tc-grps       = System
+        tau-t         = 0.5
+        ref-t         = 300
+        cutoff-scheme = Verlet
+        IMD-group     = Heavy_Atoms
+        integrator    = %s
+    )";
+    runner_.useStringAsMdpFile(formatString(mdpContents.c_str(), GetParam()));
+
+    EXPECT_EQ(0, runner_.callGrompp());
+
+    ::gmx::test::CommandLine imdCaller;
+    imdCaller.addOption("-imdport", 0); // automatically assign a free port
+    imdCaller.append("-imdpull");
+    imdCaller.append("-noimdwait");
+    imdCaller.append("-imdasync");
+
+    ASSERT_EQ(0, runner_.callMdrun(imdCaller));
+}
+
+/* The client below runs in the test process, with library MPI each rank
+ * would start one, so we only test with thread-MPI or without MPI.
+ */
+#if GMX_IMD && !GMX_NATIVE_WINDOWS && !GMX_LIB_MPI
+
+namespace
+{
+
+//! Returns a TCP port on the local host that was free at the time of the call
+int findFreePort()
+{
+    const int   fd      = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = 0;
+    socklen_t length        = sizeof(address);
+    int       port          = 0;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0
+        && getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0)
+    {
+        port = ntohs(address.sin_port);
+    }
+    close(fd);
+
+    return port;
+}
+
+//! Reads \p size bytes from \p fd, returns false when the connection was closed
+bool readAll(int fd, char* buffer, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t numRead = read(fd, buffer, size);
+        if (numRead <= 0)
+        {
+            return false;
+        }
+        buffer += numRead;
+        size -= numRead;
+    }
+
+    return true;
+}
+
+//! Writes an IMD message header with \p type and \p length to \p fd
+void writeHeader(int fd, int32_t type, int32_t length)
+{
+    const int32_t header[2] = { static_cast<int32_t>(htonl(type)), static_cast<int32_t>(htonl(length)) };
+    if (write(fd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+    {
+        ADD_FAILURE() << "Could not send an IMD message to mdrun";
+    }
+}
+
+/*! \brief A minimal IMD client
+ *
+ * Connects to mdrun on \p port, receives up to \p numFramesToReceive
+ * coordinate frames, asks mdrun to terminate and disconnects.
+ *
+ * \returns The number of coordinate frames received.
+ */
+int runImdClient(int port, int numFramesToReceive)
+{
+    /* Let writes after mdrun closed the connection fail instead of terminating the test */
+    sigset_t signalSet;
+    sigemptyset(&signalSet);
+    sigaddset(&signalSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signalSet, nullptr);
+
+    /* The message types and sizes as used by the IMD protocol */
+    constexpr int32_t c_typeDisconnect     = 0;
+    constexpr int32_t c_typeEnergies       = 1;
+    constexpr int32_t c_typeCoordinates    = 2;
+    constexpr int32_t c_typeGo             = 3;
+    constexpr int32_t c_typeKill           = 5;
+    constexpr size_t  c_energyBlockSize    = 10 * sizeof(int32_t);
+    constexpr int     c_maxConnectAttempts = 600;
+
+    sockaddr_in address     = {};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(port);
+
+    /* mdrun only starts listening after reading the input, so retry connecting */
+    int fd = -1;
+    for (int attempt = 0; attempt < c_maxConnectAttempts && fd < 0; attempt++)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    if (fd < 0)
+    {
+        ADD_FAILURE() << "Could not connect to mdrun on port " << port;
+        return 0;
+    }
+
+    /* Let the test fail instead of hang when mdrun does not respond */
+    timeval timeout = {};
+    timeout.tv_sec  = 60;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int  numFrames = 0;
+    char handshake[8];
+    if (readAll(fd, handshake, sizeof(handshake)))
+    {
+        writeHeader(fd, c_typeGo, 0);
+
+        int32_t header[2];
+        while (numFrames < numFramesToReceive && readAll(fd, reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            const int32_t type   = ntohl(header[0]);
+            const int32_t length = ntohl(header[1]);
+            size_t        size   = 0;
+            if (type == c_typeEnergies)
+            {
+                size = c_energyBlockSize;
+            }
+            else if (type == c_typeCoordinates)
+            {
+                size = 3 * sizeof(float) * length;
+                numFrames++;
+            }
+            std::vector<char> payload(size);
+            if (!readAll(fd, payload.data(), size))
+            {
+                break;
+            }
+        }
+
+        writeHeader(fd, c_typeKill, 0);
+        writeHeader(fd, c_typeDisconnect, 0);
+
+        /* Read until mdrun closes the connection, so mdrun never writes to a closed socket */
+        char buffer[1024];
+        while (read(fd, buffer, sizeof(buffer)) > 0) {}
+    }
+    close(fd);
+
+    return numFrames;
+}
+
+} // namespace
+
+/* This test checks that a client connected to mdrun with -imdasync
+ * receives frames sent from the separate thread and that mdrun
+ * finishes after the client disconnects.
+ */
+TEST_P(ImdTest, ImdClientReceivesAsyncFrames)
+{
+    runner_.useTopGroAndNdxFromDatabase("glycine_vacuo");
+    const std::string mdpContents = R"(
+        dt             = 0.002
+        nsteps         = 1000
+        nstcalcenergy  = 1
+        tcoupl         = v-rescale
+        tc-grps        = System
+        tau-t          = 0.5
+        ref-t          = 300
+        cutoff-scheme  = Verlet
+        IMD-group      = Heavy_Atoms
+        integrator     = %s
+    )";
+    runner_.useStringAsMdpFile(formatString(mdpContents.c_str(), GetParam()));
+
+    EXPECT_EQ(0, runner_.callGrompp());
+
+    const int port = findFreePort();
+    ASSERT_GT(port, 0);
+
+    const int   numFramesToReceive = 3;
+    int         numFramesReceived  = 0;
+    std::thread client([port, &numFramesReceived]() {
+        numFramesReceived = runImdClient(port, numFramesToReceive);
+    });
+
+    ::gmx::test::CommandLine imdCaller;
+    imdCaller.addOption("-imdport", port);
+    imdCaller.append("-imdwait"); // the client connects before the first step
+    imdCaller.append("-imdterm");
+    imdCaller.append("-imdasync");
+
+    const int exitCode = runner_.callMdrun(imdCaller);
+    client.join();
+    /* The stop condition set by the client would affect later runs in this process */
+    gmx_reset_stop_condition();
+
+    /* mdrun reports that it was stopped by the client in its exit code,
+     * but a short run can finish before it reads the request to stop */
+    EXPECT_TRUE(exitCode == 0 || exitCode == static_cast<int>(StopCondition::Next))
+            << "mdrun exited with " << exitCode;
+    EXPECT_EQ(numFramesToReceive, numFramesReceived);
+}
+
+#endif
+
 // Check a dynamical integrator and an energy minimizer. No need to
 // cover the whole space.
 INSTANTIATE_TEST_SUITE_P(WithIntegrator, ImdTest, ::testing::Values("md", "steep"));
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the updated local topology of a single domain matches a full generation
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/mpitest.h"
+#include "testutils/setenv.h"
+#include "testutils/simulationdatabase.h"
+
+#include "moduletest.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Sets an environment variable for the lifetime of the object
+ *
+ * The previous value is restored on destruction.
+ */
+class ScopedEnvironmentVariable
+{
+public:
+    //! Sets \p name to \p value
+    ScopedEnvironmentVariable(const char* name, const char* value) : name_(name)
+    {
+        const char* previousValue = getenv(name);
+        wasSet_                   = (previousValue != nullptr);
+        if (wasSet_)
+        {
+            previousValue_ = previousValue;
+        }
+        gmxSetenv(name, value, 1);
+    }
+    ~ScopedEnvironmentVariable()
+    {
+        if (wasSet_)
+        {
+            gmxSetenv(name_.c_str(), previousValue_.c_str(), 1);
+        }
+        else
+        {
+            gmxUnsetenv(name_.c_str());
+        }
+    }
+
+private:
+    //! The name of the environment variable
+    std::string name_;
+    //! Whether the variable was set before
+    bool wasSet_;
+    //! The value before we set it
+    std::string previousValue_;
+};
+
+/*! \brief Test fixture for the local topology update with a single domain
+ *
+ * With a single domain, the local topology is renumbered at each
+ * partitioning instead of generated again. With the check enabled,
+ * mdrun generates the local topology after every update and stops
+ * with a fatal error when the two differ. The test systems cover
+ * virtual sites, constraints, settles and perturbed interactions.
+ */
+class LocalTopologyUpdateTest : public MdrunTestFixture, public ::testing::WithParamInterface<std::string>
+{
+};
+
+TEST_P(LocalTopologyUpdateTest, MatchesGeneratedTopology)
+{
+    const std::string simulationName = GetParam();
+    SCOPED_TRACE(formatString("Checking the local topology update for '%s'", simulationName.c_str()));
+
+    const int numRanks = getNumberOfTestMpiRanks();
+    if (!isNumberOfPpRanksSupported(simulationName, numRanks))
+    {
+        fprintf(stdout,
+                "Test system '%s' cannot run with %d ranks.\n"
+                "The supported numbers are: %s\n",
+                simulationName.c_str(),
+                numRanks,
+                reportNumbersOfPpRanksSupported(simulationName).c_str());
+        return;
+    }
+
+    // Partition every other step, so the local topology is updated many times
+    auto mdpFieldValues       = prepareMdpFieldValues(simulationName, "md", "no", "no");
+    mdpFieldValues["nsteps"]  = "20";
+    mdpFieldValues["nstlist"] = "2";
+    if (simulationName == "nonanol_vacuo")
+    {
+        // Use a lambda state with both perturbed and unperturbed interactions
+        mdpFieldValues["init-lambda-state"] = "3";
+    }
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    {
+        CommandLine caller;
+        ASSERT_EQ(0, runner_.callGrompp(caller));
+    }
+
+    {
+        // Use the domain decomposition machinery also with a single rank
+        // and check each update of the local topology
+        ScopedEnvironmentVariable useSingleRankDD("GMX_DD_SINGLE_RANK", "1");
+        ScopedEnvironmentVariable checkUpdate("GMX_DD_CHECK_LOCAL_TOPOLOGY_UPDATE", "1");
+        CommandLine               caller;
+        EXPECT_EQ(0, runner_.callMdrun(caller));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(WithVsitesConstraintsAndPerturbations,
+                         LocalTopologyUpdateTest,
+                         ::testing::Values("alanine_vsite_solvated", "vsite_test", "nonanol_vacuo"));
+
+} // namespace
+} // namespace test
+} // namespace gmx
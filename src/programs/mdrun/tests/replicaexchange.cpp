@@ -75,6 +75,13 @@ TEST_P(ReplicaExchangeEnsembleTest, ExitsNormally)
     runExitsNormallyTest();
 }
 
+TEST_P(ReplicaExchangeEnsembleTest, ExitsNormallyWithGibbsSampling)
+{
+    mdrunCaller_->addOption("-replex", 1);
+    mdrunCaller_->addOption("-replexgibbs");
+    runExitsNormallyTest();
+}
+
 /* Note, not all preprocessor implementations nest macro expansions
    the same way / at all, if we would try to duplicate less code. */
 
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2024- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests XTC fragment output written by all ranks and merging it with gmx trjcat
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/tools/trjcat.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/path.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+#include "testutils/trajectoryreader.h"
+
+#include "moduletest.h"
+
+namespace gmx::test
+{
+namespace
+{
+
+using XtcFragmentsTest = MdrunTestFixture;
+
+/* Runs with XTC fragments in two parts with an appending restart in
+ * between, merges the fragments and checks that all frames are present
+ * and match the compressed coordinates of a run without fragments.
+ * The fragments of the checkpoint step are present twice.
+ */
+TEST_F(XtcFragmentsTest, MergedFragmentsMatchNormalOutputWithAppendingRestart)
+{
+    const int numRanks = getNumberOfTestMpiRanks();
+    if (numRanks < 2)
+    {
+        GTEST_SKIP() << "XTC fragments are only written with domain decomposition";
+    }
+
+    runner_.useTopGroAndNdxFromDatabase("spc216");
+    runner_.useStringAsMdpFile(
+            "integrator         = md\n"
+            "nsteps             = 20\n"
+            "nstxout-compressed = 5\n"
+            "nstcalcenergy      = 5\n"
+            "cutoff-scheme      = verlet\n"
+            "coulombtype        = reaction-field\n"
+            "rcoulomb           = 0.7\n"
+            "rvdw               = 0.7\n"
+            "tcoupl             = v-rescale\n"
+            "tc-grps            = System\n"
+            "tau-t              = 0.1\n"
+            "ref-t              = 300\n");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    CommandLine caller;
+    caller.append("-reprod");
+    caller.addOption("-nb", "cpu");
+    const std::string referenceFileName =
+            fileManager_.getTemporaryFilePath("reference.xtc").u8string();
+    runner_.reducedPrecisionTrajectoryFileName_ = referenceFileName;
+    ASSERT_EQ(0, runner_.callMdrun(caller));
+
+    const std::string fragmentedFileName =
+            fileManager_.getTemporaryFilePath("fragmented.xtc").u8string();
+    runner_.reducedPrecisionTrajectoryFileName_ = fragmentedFileName;
+    runner_.cptOutputFileName_ = fileManager_.getTemporaryFilePath("fragmented.cpt").u8string();
+    caller.append("-xfrag");
+    {
+        SCOPED_TRACE("Running the first part with XTC fragments");
+        runner_.nsteps_ = 10;
+        ASSERT_EQ(0, runner_.callMdrun(caller));
+    }
+    {
+        SCOPED_TRACE("Running the second part with XTC fragments and appending");
+        runner_.nsteps_ = -2;
+        CommandLine restartCaller(caller);
+        restartCaller.addOption("-cpi", runner_.cptOutputFileName_);
+        ASSERT_EQ(0, runner_.callMdrun(restartCaller));
+    }
+
+    CommandLine trjcatCaller;
+    trjcatCaller.append("trjcat");
+    trjcatCaller.append("-f");
+    for (int rank = 0; rank < numRanks; rank++)
+    {
+        const std::string fragmentFileName =
+                xtc_fragment_filename(fragmentedFileName, rank).u8string();
+        ASSERT_TRUE(File::exists(fragmentFileName, File::returnFalseOnError)) << fragmentFileName;
+        trjcatCaller.append(fragmentFileName);
+    }
+    const std::string mergedFileName = fileManager_.getTemporaryFilePath("merged.xtc").u8string();
+    trjcatCaller.addOption("-o", mergedFileName);
+    ASSERT_EQ(0, gmx_trjcat(trjcatCaller.argc(), trjcatCaller.argv()));
+
+    TrajectoryFrameReader referenceReader(referenceFileName);
+    TrajectoryFrameReader mergedReader(mergedFileName);
+    int                   numFrames = 0;
+    while (referenceReader.readNextFrame())
+    {
+        ASSERT_TRUE(mergedReader.readNextFrame()) << "Merged trajectory lacks frame " << numFrames;
+        const TrajectoryFrame referenceFrame = referenceReader.frame();
+        const TrajectoryFrame mergedFrame    = mergedReader.frame();
+        EXPECT_EQ(referenceFrame.step(), mergedFrame.step());
+        ASSERT_EQ(referenceFrame.x().size(), mergedFrame.x().size());
+        for (size_t i = 0; i < referenceFrame.x().size(); i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                /* The restart puts the atoms in the box, so we compare
+                 * modulo the (rectangular) box and allow for one unit
+                 * of the XTC precision.
+                 */
+                const real boxLength = referenceFrame.box()[d][d];
+                real       diff      = mergedFrame.x()[i][d] - referenceFrame.x()[i][d];
+                diff -= boxLength * std::round(diff / boxLength);
+                EXPECT_REAL_EQ_TOL(0, diff, absoluteTolerance(1.01e-3))
+                        << "atom " << i << " in frame " << numFrames;
+            }
+        }
+        numFrames++;
+    }
+    EXPECT_FALSE(mergedReader.readNextFrame()) << "Merged trajectory has extra frames";
+    EXPECT_EQ(5, numFrames);
+}
+
+} // namespace
+} // namespace gmx::test